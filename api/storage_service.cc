@@ -765,6 +765,22 @@ void set_storage_service(http_context& ctx, routes& r, sharded<service::storage_
         co_return json::json_return_type(0);
     }));
 
+    ss::perform_keyspace_tombstone_gc.set(r, wrap_ks_cf(ctx, [] (http_context& ctx, std::unique_ptr<request> req, sstring keyspace, std::vector<table_info> table_infos) -> future<json::json_return_type> {
+        apilog.info("perform_keyspace_tombstone_gc: keyspace={} tables={}", keyspace, table_infos);
+        try {
+            co_await ctx.db.invoke_on_all([&] (replica::database& db) -> future<> {
+                co_await run_on_existing_tables("perform_keyspace_tombstone_gc", db, keyspace, table_infos, [] (replica::table& t) {
+                    return t.get_compaction_manager().perform_tombstone_gc(t.as_table_state());
+                });
+            });
+        } catch (...) {
+            apilog.error("perform_keyspace_tombstone_gc: keyspace={} tables={} failed: {}", keyspace, table_infos, std::current_exception());
+            throw;
+        }
+
+        co_return json_void();
+    }));
+
     ss::force_keyspace_flush.set(r, [&ctx](std::unique_ptr<request> req) -> future<json::json_return_type> {
         auto keyspace = validate_keyspace(ctx, req->param);
         auto column_families = parse_tables(keyspace, ctx, req->query_parameters, "cf");
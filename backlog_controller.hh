@@ -13,6 +13,7 @@
 #include <seastar/core/file.hh>
 #include <chrono>
 #include <cmath>
+#include <functional>
 
 #include "seastarx.hh"
 
@@ -125,16 +126,63 @@ class flush_controller : public backlog_controller {
     {}
 };
 
+// compaction CPU and I/O controller.
+//
+// The shares follow the compaction backlog. If a foreground latency target is set, they are
+// further scaled down by a factor while the latency of foreground reads is above it: the factor
+// is cut multiplicatively whenever the target is missed, and recovers additively once it is met
+// again, unless reads start queueing up for admission, which precedes latency going up.
+//
+// The scaled shares never drop below shares * (shares / maximum shares), so the more backlog,
+// the less compaction is slowed down, and at the maximum output of the control points it isn't
+// slowed down at all. This keeps the backlog bounded regardless of the foreground latency.
 class compaction_controller : public backlog_controller {
 public:
     static constexpr unsigned normalization_factor = 30;
     static constexpr float disable_backlog = std::numeric_limits<double>::infinity();
     static constexpr float backlog_disabled(float backlog) { return std::isinf(backlog); }
-    compaction_controller(backlog_controller::scheduling_group sg, float static_shares, std::chrono::milliseconds interval, std::function<float()> current_backlog)
+
+    struct foreground_load {
+        // 99th percentile latency of the reads since the previous sample
+        std::chrono::microseconds read_latency{0};
+        // Number of reads waiting for admission
+        size_t queued_reads = 0;
+    };
+    using foreground_load_probe = std::function<foreground_load()>;
+private:
+    static constexpr float latency_backoff = 0.7f;
+    static constexpr float latency_recovery = 0.05f;
+    static constexpr float min_latency_factor = 0.05f;
+
+    // Returns 0 if compaction isn't to be slowed down for foreground latency
+    std::function<std::chrono::milliseconds()> _latency_target;
+    foreground_load_probe _foreground_load;
+    float _latency_factor = 1.0f;
+    size_t _last_queued_reads = 0;
+public:
+    compaction_controller(backlog_controller::scheduling_group sg, float static_shares, std::chrono::milliseconds interval, std::function<float()> current_backlog,
+            std::function<std::chrono::milliseconds()> latency_target = {})
         : backlog_controller(std::move(sg), std::move(interval),
           std::vector<backlog_controller::control_point>({{0.0, 50}, {1.5, 100} , {normalization_factor, 1000}}),
           std::move(current_backlog),
           static_shares
         )
+        , _latency_target(std::move(latency_target))
     {}
+
+    // The probe is called at every adjustment while a latency target is set.
+    void set_foreground_load_probe(foreground_load_probe probe) {
+        _foreground_load = std::move(probe);
+    }
+
+    float latency_factor() const noexcept {
+        return _latency_factor;
+    }
+
+    // Adjusts the shares right away, instead of waiting for the timer. For testing.
+    void adjust_now() {
+        adjust();
+    }
+protected:
+    virtual void update_controller(float shares) override;
 };
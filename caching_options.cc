@@ -8,12 +8,19 @@
 
 #include "caching_options.hh"
 #include <boost/lexical_cast.hpp>
+#include <algorithm>
 #include <map>
 #include "exceptions/exceptions.hh"
 #include "utils/rjson.hh"
 
-caching_options::caching_options(sstring k, sstring r, bool enabled)
-        : _key_cache(k), _row_cache(r), _enabled(enabled) {
+static const std::map<caching_options::priority_class, sstring> priority_names = {
+    {caching_options::priority_class::low, "low"},
+    {caching_options::priority_class::normal, "normal"},
+    {caching_options::priority_class::high, "high"},
+};
+
+caching_options::caching_options(sstring k, sstring r, bool enabled, uint64_t max_partitions, priority_class priority)
+        : _key_cache(k), _row_cache(r), _enabled(enabled), _max_partitions(max_partitions), _priority(priority) {
     if ((k != "ALL") && (k != "NONE")) {
         throw exceptions::configuration_exception("Invalid key value: " + k); 
     }
@@ -40,6 +47,12 @@ caching_options::to_map() const {
     if (!_enabled) {
         res.insert({"enabled", "false"});
     }
+    if (_max_partitions) {
+        res.insert({"max_partitions", std::to_string(_max_partitions)});
+    }
+    if (_priority != priority_class::normal) {
+        res.insert({"priority", priority_names.at(_priority)});
+    }
     return res;
 }
 
@@ -58,6 +71,8 @@ caching_options::from_map(const std::map<sstring, sstring>& map) {
     sstring k = default_key;
     sstring r = default_row;
     bool e = true;
+    uint64_t max_partitions = 0;
+    priority_class priority = priority_class::normal;
 
     for (auto& p : map) {
         if (p.first == "keys") {
@@ -66,11 +81,23 @@ caching_options::from_map(const std::map<sstring, sstring>& map) {
             r = p.second;
         } else if (p.first == "enabled") {
             e = p.second == "true";
+        } else if (p.first == "max_partitions") {
+            try {
+                max_partitions = boost::lexical_cast<uint64_t>(p.second);
+            } catch (boost::bad_lexical_cast&) {
+                throw exceptions::configuration_exception("Invalid max_partitions value: " + p.second);
+            }
+        } else if (p.first == "priority") {
+            auto it = std::find_if(priority_names.begin(), priority_names.end(), [&] (auto& name) { return name.second == p.second; });
+            if (it == priority_names.end()) {
+                throw exceptions::configuration_exception("Invalid priority value: " + p.second);
+            }
+            priority = it->first;
         } else {
             throw exceptions::configuration_exception(format("Invalid caching option: {}", p.first));
         }
     }
-    return caching_options(k, r, e);
+    return caching_options(k, r, e, max_partitions, priority);
 }
 
 caching_options
@@ -81,7 +108,8 @@ caching_options::from_sstring(const sstring& str) {
 bool
 caching_options::operator==(const caching_options& other) const {
     return _key_cache == other._key_cache && _row_cache == other._row_cache
-        && _enabled == other._enabled;
+        && _enabled == other._enabled && _max_partitions == other._max_partitions
+        && _priority == other._priority;
 }
 
 bool
@@ -14,6 +14,14 @@
 class schema;
 
 class caching_options {
+public:
+    // How the row cache treats the table's partitions once it is full.
+    enum class priority_class {
+        low,    // not inserted while the cache evicts
+        normal, // inserted according to the cache admission policy
+        high,   // always inserted
+    };
+private:
     // For Origin, the default value for the row is "NONE". However, since our
     // row_cache will cache both keys and rows, we will default to ALL.
     //
@@ -25,7 +33,10 @@ class caching_options {
     sstring _key_cache;
     sstring _row_cache;
     bool _enabled = true;
-    caching_options(sstring k, sstring r, bool enabled);
+    // Maximum number of the table's partitions in the row cache, 0 if unlimited.
+    uint64_t _max_partitions = 0;
+    priority_class _priority = priority_class::normal;
+    caching_options(sstring k, sstring r, bool enabled, uint64_t max_partitions = 0, priority_class priority = priority_class::normal);
 
     friend class schema;
     caching_options();
@@ -34,6 +45,14 @@ class caching_options {
         return _enabled;
     }
 
+    uint64_t max_partitions() const {
+        return _max_partitions;
+    }
+
+    priority_class priority() const {
+        return _priority;
+    }
+
     std::map<sstring, sstring> to_map() const;
 
     sstring to_sstring() const;
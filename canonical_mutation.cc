@@ -24,14 +24,18 @@ canonical_mutation::canonical_mutation(bytes_ostream data)
 { }
 
 canonical_mutation::canonical_mutation(const mutation& m)
+    : canonical_mutation(*m.schema(), m.key(), m.partition())
+{ }
+
+canonical_mutation::canonical_mutation(const schema& s, const partition_key& key, const mutation_partition& mp)
 {
-    mutation_partition_serializer part_ser(*m.schema(), m.partition());
+    mutation_partition_serializer part_ser(s, mp);
 
     ser::writer_of_canonical_mutation<bytes_ostream> wr(_data);
-    std::move(wr).write_table_id(m.schema()->id())
-                 .write_schema_version(m.schema()->version())
-                 .write_key(m.key())
-                 .write_mapping(m.schema()->get_column_mapping())
+    std::move(wr).write_table_id(s.id())
+                 .write_schema_version(s.version())
+                 .write_key(key)
+                 .write_mapping(s.get_column_mapping())
                  .partition([&] (auto wr) {
                      part_ser.write(std::move(wr));
                  }).end_canonical_mutation();
@@ -22,6 +22,8 @@ class canonical_mutation {
 public:
     explicit canonical_mutation(bytes_ostream);
     explicit canonical_mutation(const mutation&);
+    // Serializes the partition in place, without copying it into a mutation.
+    canonical_mutation(const schema&, const partition_key&, const mutation_partition&);
 
     canonical_mutation(canonical_mutation&&) = default;
     canonical_mutation(const canonical_mutation&) = default;
@@ -45,6 +45,7 @@
 #include "dht/partition_filter.hh"
 #include "mutation_writer/shard_based_splitting_writer.hh"
 #include "mutation_writer/partition_based_splitting_writer.hh"
+#include "mutation_writer/token_group_based_splitting_writer.hh"
 #include "mutation_source_metadata.hh"
 #include "mutation_fragment_stream_validator.hh"
 #include "utils/UUID_gen.hh"
@@ -203,6 +204,53 @@ static std::vector<shared_sstable> get_uncompacting_sstables(const table_state&
     return not_compacted_sstables;
 }
 
+// Splits the token span of the sstables into at most count disjoint partition
+// ranges of about the same token width, which together cover the whole ring.
+static dht::partition_range_vector split_into_sub_ranges(const sstable_set& sstables, unsigned count) {
+    std::optional<dht::token> first, last;
+    sstables.for_each_sstable([&] (const shared_sstable& sst) {
+        auto& sst_first = sst->get_first_decorated_key().token();
+        auto& sst_last = sst->get_last_decorated_key().token();
+        first = first ? std::min(*first, sst_first) : sst_first;
+        last = last ? std::max(*last, sst_last) : sst_last;
+    });
+    dht::partition_range_vector ranges;
+    if (!first || *first == *last) {
+        return ranges;
+    }
+    auto width = __int128(last->raw()) - first->raw();
+    std::optional<dht::partition_range::bound> start;
+    for (unsigned i = 1; i < count; ++i) {
+        auto t = dht::token::from_int64(int64_t(first->raw() + width * i / count));
+        if (start && start->value().token() == t) {
+            continue;
+        }
+        auto end = dht::partition_range::bound(dht::ring_position::starting_at(t), false);
+        ranges.push_back(start ? dht::partition_range::make(*start, end) : dht::partition_range::make_ending_with(end));
+        start = dht::partition_range::bound(dht::ring_position::starting_at(t), true);
+    }
+    if (start) {
+        ranges.push_back(dht::partition_range::make_starting_with(*start));
+    }
+    return ranges;
+}
+
+// Returns the number of token groups (see dht::token_group_of()) which the partitions
+// of the sstables may belong to, out of the groups_per_shard groups of this shard.
+static uint64_t token_groups_spanned(const sstable_set& sstables, const dht::sharder& sharder, unsigned groups_per_shard) {
+    std::optional<dht::token> first, last;
+    sstables.for_each_sstable([&] (const shared_sstable& sst) {
+        auto& sst_first = sst->get_first_decorated_key().token();
+        auto& sst_last = sst->get_last_decorated_key().token();
+        first = first ? std::min(*first, sst_first) : sst_first;
+        last = last ? std::max(*last, sst_last) : sst_last;
+    });
+    if (!first) {
+        return 1;
+    }
+    return dht::token_groups_spanned(sharder.shard_count(), sharder.sharding_ignore_msb(), groups_per_shard, *first, *last);
+}
+
 class compaction;
 
 class compaction_write_monitor final : public sstables::write_monitor, public backlog_write_progress_manager {
@@ -345,29 +393,61 @@ class compacted_fragments_writer {
 };
 
 struct compaction_read_monitor_generator final : public read_monitor_generator {
-    class compaction_read_monitor final : public  sstables::read_monitor, public backlog_read_progress_manager {
+    // Tracks the compaction progress of an input sstable for the backlog tracker.
+    // When the compaction is split into sub-ranges, the sstable is read by one
+    // reader for each sub-range it overlaps, so the progress is the sum of theirs.
+    class compaction_read_monitor final : public backlog_read_progress_manager {
+        class sub_range_read final : public sstables::read_monitor {
+            compaction_read_monitor& _monitor;
+            const sstables::reader_position_tracker* _tracker = nullptr;
+            // A sub-range read starts somewhere in the middle of the data file.
+            uint64_t _start_position = 0;
+            uint64_t _last_position_seen = 0;
+        public:
+            explicit sub_range_read(compaction_read_monitor& monitor) : _monitor(monitor) { }
+
+            virtual void on_read_started(const sstables::reader_position_tracker& tracker) override {
+                _tracker = &tracker;
+                _start_position = tracker.position;
+                _last_position_seen = tracker.position;
+                _monitor.on_read_started();
+            }
+
+            virtual void on_read_completed() override {
+                if (_tracker) {
+                    _last_position_seen = _tracker->position;
+                    _tracker = nullptr;
+                }
+            }
+
+            uint64_t compacted() const {
+                return (_tracker ? _tracker->position : _last_position_seen) - _start_position;
+            }
+        };
+
         sstables::shared_sstable _sst;
         table_state& _table_s;
-        const sstables::reader_position_tracker* _tracker = nullptr;
-        uint64_t _last_position_seen = 0;
-    public:
-        virtual void on_read_started(const sstables::reader_position_tracker& tracker) override {
-            _tracker = &tracker;
-            _table_s.get_backlog_tracker().register_compacting_sstable(_sst, *this);
-        }
-
-        virtual void on_read_completed() override {
-            if (_tracker) {
-                _last_position_seen = _tracker->position;
-                _tracker = nullptr;
+        // Reads of the sstable, by sub-range.
+        std::unordered_map<size_t, sub_range_read> _reads;
+        bool _registered = false;
+
+        void on_read_started() {
+            if (_sst && !_registered) {
+                _table_s.get_backlog_tracker().register_compacting_sstable(_sst, *this);
+                _registered = true;
             }
         }
-
+    public:
         virtual uint64_t compacted() const override {
-            if (_tracker) {
-                return _tracker->position;
+            uint64_t compacted = 0;
+            for (auto& [sub_range, read] : _reads) {
+                compacted += read.compacted();
             }
-            return _last_position_seen;
+            return compacted;
+        }
+
+        sstables::read_monitor& read_of(size_t sub_range) {
+            return _reads.try_emplace(sub_range, *this).first->second;
         }
 
         void remove_sstable() {
@@ -380,6 +460,9 @@ struct compaction_read_monitor_generator final : public read_monitor_generator {
         compaction_read_monitor(sstables::shared_sstable sst, table_state& table_s)
             : _sst(std::move(sst)), _table_s(table_s) { }
 
+        compaction_read_monitor(const compaction_read_monitor&) = delete;
+        compaction_read_monitor& operator=(const compaction_read_monitor&) = delete;
+
         ~compaction_read_monitor() {
             // We failed to finish handling this SSTable, so we have to update the backlog_tracker
             // about it.
@@ -391,9 +474,25 @@ struct compaction_read_monitor_generator final : public read_monitor_generator {
         friend class compaction_read_monitor_generator;
     };
 
+    // Generates the monitors of the readers of a single sub-range.
+    class sub_range_monitor_generator final : public read_monitor_generator {
+        compaction_read_monitor_generator& _generator;
+        size_t _sub_range;
+    public:
+        sub_range_monitor_generator(compaction_read_monitor_generator& generator, size_t sub_range)
+            : _generator(generator), _sub_range(sub_range) { }
+
+        virtual sstables::read_monitor& operator()(sstables::shared_sstable sst) override {
+            return _generator.monitor_for(std::move(sst), _sub_range);
+        }
+    };
+
     virtual sstables::read_monitor& operator()(sstables::shared_sstable sst) override {
-        auto p = _generated_monitors.emplace(sst->generation(), compaction_read_monitor(sst, _table_s));
-        return p.first->second;
+        return monitor_for(std::move(sst), 0);
+    }
+
+    read_monitor_generator& for_sub_range(size_t sub_range) {
+        return _sub_range_generators.try_emplace(sub_range, *this, sub_range).first->second;
     }
 
     explicit compaction_read_monitor_generator(table_state& table_s)
@@ -408,8 +507,14 @@ struct compaction_read_monitor_generator final : public read_monitor_generator {
         }
     }
 private:
+    sstables::read_monitor& monitor_for(sstables::shared_sstable sst, size_t sub_range) {
+        auto gen = sst->generation();
+        return _generated_monitors.try_emplace(gen, std::move(sst), _table_s).first->second.read_of(sub_range);
+    }
+
     table_state& _table_s;
     std::unordered_map<generation_type, compaction_read_monitor> _generated_monitors;
+    std::unordered_map<size_t, sub_range_monitor_generator> _sub_range_generators;
 };
 
 class formatted_sstables_list {
@@ -473,7 +578,16 @@ class compaction {
     // optional clone of sstable set to be used for expiration purposes, so it will be set if expiration is enabled.
     std::optional<sstable_set> _sstable_set;
     // used to incrementally calculate max purgeable timestamp, as we iterate through decorated keys.
-    std::optional<sstable_set::incremental_selector> _selector;
+    // There is one for each sub-range, since sub-ranges are read concurrently.
+    std::vector<std::optional<sstable_set::incremental_selector>> _selectors;
+    unsigned _sub_range_count;
+    // Disjoint ranges of the input which are compacted concurrently, empty if not split.
+    dht::partition_range_vector _sub_ranges;
+    // Input sstables overlapping each sub-range, so that a sub-range reader
+    // doesn't open the sstables it has nothing to read from.
+    std::vector<lw_shared_ptr<sstable_set>> _sub_range_sstables;
+    // Number of token groups the output is split into, see table_state::token_ranges_per_shard().
+    uint64_t _token_groups = 1;
     std::unordered_set<shared_sstable> _compacting_for_max_purgeable_func;
     // Garbage collected sstables that are sealed but were not added to SSTable set yet.
     std::vector<shared_sstable> _unused_garbage_collected_sstables;
@@ -501,7 +615,7 @@ class compaction {
         , _run_identifier(descriptor.run_identifier)
         , _io_priority(descriptor.io_priority)
         , _sstable_set(std::move(descriptor.all_sstables_snapshot))
-        , _selector(_sstable_set ? _sstable_set->make_incremental_selector() : std::optional<sstable_set::incremental_selector>{})
+        , _sub_range_count(descriptor.sub_ranges)
         , _compacting_for_max_purgeable_func(std::unordered_set<shared_sstable>(_sstables.begin(), _sstables.end()))
     {
         for (auto& sst : _sstables) {
@@ -517,8 +631,11 @@ class compaction {
         // some tests use _max_sstable_size == 0 for force many one partition per sstable
         auto max_sstable_size = std::max<uint64_t>(_max_sstable_size, 1);
         uint64_t estimated_sstables = std::max(1UL, uint64_t(ceil(double(_start_size) / max_sstable_size)));
-        return std::min(uint64_t(ceil(double(_estimated_partitions) / estimated_sstables)),
+        auto estimate = std::min(uint64_t(ceil(double(_estimated_partitions) / estimated_sstables)),
                         _table_s.get_compaction_strategy().adjust_partition_estimate(_ms_metadata, _estimated_partitions));
+        // The output is split at the boundaries of both sub-ranges and token groups.
+        auto outputs = std::max<size_t>(_sub_ranges.size(), 1) + _token_groups - 1;
+        return std::max(uint64_t(1), estimate / outputs);
     }
 
     void setup_new_sstable(shared_sstable& sst) {
@@ -545,7 +662,8 @@ class compaction {
         sstable_writer_config cfg = _table_s.configure_writer(std::move(s));
         cfg.max_sstable_size = _max_sstable_size;
         cfg.monitor = &default_write_monitor();
-        cfg.run_identifier = _run_identifier;
+        // Every token group is written to an sstable of its own, which overlaps the others.
+        cfg.run_identifier = token_ranges_per_shard() ? run_id::create_random_id() : _run_identifier;
         cfg.replay_position = _rp;
         cfg.sstable_level = _sstable_level;
         return cfg;
@@ -618,6 +736,14 @@ class compaction {
         return _used_garbage_collected_sstables;
     }
 
+    // Number of token groups the output of every shard is split into, see
+    // table_state::token_ranges_per_shard(). The groups of a shard interleave in
+    // token order, so their sstables overlap. Jobs which write runs of disjoint
+    // sstables, those of leveled and incremental strategies, aren't split.
+    unsigned token_ranges_per_shard() const noexcept {
+        return _max_sstable_size == compaction_descriptor::default_max_sstable_bytes ? _table_s.token_ranges_per_shard() : 0;
+    }
+
     bool enable_garbage_collected_sstable_writer() const noexcept {
         return _contains_multi_fragment_runs && _max_sstable_size != std::numeric_limits<uint64_t>::max();
     }
@@ -631,8 +757,14 @@ class compaction {
     virtual ~compaction() {
     }
 private:
-    // Default range sstable reader that will only return mutation that belongs to current shard.
-    virtual flat_mutation_reader_v2 make_sstable_reader() const = 0;
+    // Range sstable reader that will only return mutation that belongs to current shard.
+    // sub_range is the index of range in _sub_ranges, or 0 if the input is not split.
+    virtual flat_mutation_reader_v2 make_sstable_reader(const dht::partition_range& range, size_t sub_range) const = 0;
+
+    // Whether the input can be compacted as disjoint sub-ranges, in parallel.
+    virtual bool can_split_into_sub_ranges() const {
+        return false;
+    }
 
     virtual sstables::sstable_set make_sstable_set_for_input() const {
         return _table_s.get_compaction_strategy().make_sstable_set(_schema);
@@ -687,6 +819,41 @@ class compaction {
 
         _compacting = std::move(ssts);
 
+        // Input sstables can only be released before the end if the output is
+        // written in token order, which is not the case when split into sub-ranges.
+        // So jobs which release exhausted input fragments early, those of run-based
+        // strategies, are never split.
+        if (_sub_range_count > 1 && can_split_into_sub_ranges() && !enable_garbage_collected_sstable_writer()) {
+            _sub_ranges = split_into_sub_ranges(*_compacting, _sub_range_count);
+            if (_sub_ranges.size() > 1) {
+                log_debug("Compacting {} sub-ranges in parallel", _sub_ranges.size());
+            } else {
+                _sub_ranges.clear();
+            }
+        }
+        if (auto ranges_per_shard = token_ranges_per_shard()) {
+            _token_groups = token_groups_spanned(*_compacting, _schema->get_sharder(), ranges_per_shard);
+        }
+        auto cmp = dht::ring_position_comparator(*_schema);
+        for (auto& range : _sub_ranges) {
+            co_await coroutine::maybe_yield();
+            auto sub_range_ssts = make_lw_shared<sstables::sstable_set>(make_sstable_set_for_input());
+            _compacting->for_each_sstable([&] (const shared_sstable& sst) {
+                auto sst_range = dht::partition_range::make(dht::ring_position(sst->get_first_decorated_key()),
+                        dht::ring_position(sst->get_last_decorated_key()));
+                if (range.overlaps(sst_range, cmp)) {
+                    sub_range_ssts->insert(sst);
+                }
+            });
+            _sub_range_sstables.push_back(std::move(sub_range_ssts));
+        }
+        _selectors.resize(std::max<size_t>(_sub_ranges.size(), 1));
+        if (_sstable_set) {
+            for (auto& selector : _selectors) {
+                selector.emplace(_sstable_set->make_incremental_selector());
+            }
+        }
+
         _ms_metadata.min_timestamp = timestamp_tracker.min();
         _ms_metadata.max_timestamp = timestamp_tracker.max();
     }
@@ -694,7 +861,7 @@ class compaction {
     // This consumer will perform mutation compaction on producer side using
     // compacting_reader. It's useful for allowing data from different buckets
     // to be compacted together.
-    future<> consume_without_gc_writer(gc_clock::time_point compaction_time) {
+    future<> consume_without_gc_writer(gc_clock::time_point compaction_time, const dht::partition_range& range, size_t sub_range) {
         auto consumer = make_interposer_consumer([this] (flat_mutation_reader_v2 reader) mutable {
             return seastar::async([this, reader = std::move(reader)] () mutable {
                 auto close_reader = deferred_close(reader);
@@ -703,26 +870,35 @@ class compaction {
             });
         });
         const auto& gc_state = _table_s.get_tombstone_gc_state();
-        return consumer(make_compacting_reader(make_sstable_reader(), compaction_time, max_purgeable_func(), gc_state));
+        return consumer(make_compacting_reader(make_sstable_reader(range, sub_range), compaction_time, max_purgeable_func(sub_range), gc_state));
     }
 
     future<> consume() {
         auto now = gc_clock::now();
+        if (_sub_ranges.empty()) {
+            return consume(now, query::full_partition_range, 0);
+        }
+        return parallel_for_each(boost::irange(size_t(0), _sub_ranges.size()), [this, now] (size_t i) {
+            return consume(now, _sub_ranges[i], i);
+        });
+    }
+
+    future<> consume(gc_clock::time_point now, const dht::partition_range& range, size_t sub_range) {
         // consume_without_gc_writer(), which uses compacting_reader, is ~3% slower.
         // let's only use it when GC writer is disabled and interposer consumer is enabled, as we
         // wouldn't like others to pay the penalty for something they don't need.
         if (!enable_garbage_collected_sstable_writer() && use_interposer_consumer()) {
-            return consume_without_gc_writer(now);
+            return consume_without_gc_writer(now, range, sub_range);
         }
-        auto consumer = make_interposer_consumer([this, now] (flat_mutation_reader_v2 reader) mutable
+        auto consumer = make_interposer_consumer([this, now, sub_range] (flat_mutation_reader_v2 reader) mutable
         {
-            return seastar::async([this, reader = std::move(reader), now] () mutable {
+            return seastar::async([this, reader = std::move(reader), now, sub_range] () mutable {
                 auto close_reader = deferred_close(reader);
 
                 if (enable_garbage_collected_sstable_writer()) {
                     using compact_mutations = compact_for_compaction_v2<compacted_fragments_writer, compacted_fragments_writer>;
                     auto cfc = compact_mutations(*schema(), now,
-                        max_purgeable_func(),
+                        max_purgeable_func(sub_range),
                         _table_s.get_tombstone_gc_state(),
                         get_compacted_fragments_writer(),
                         get_gc_compacted_fragments_writer());
@@ -732,22 +908,25 @@ class compaction {
                 }
                 using compact_mutations = compact_for_compaction_v2<compacted_fragments_writer, noop_compacted_fragments_consumer>;
                 auto cfc = compact_mutations(*schema(), now,
-                    max_purgeable_func(),
+                    max_purgeable_func(sub_range),
                     _table_s.get_tombstone_gc_state(),
                     get_compacted_fragments_writer(),
                     noop_compacted_fragments_consumer());
                 reader.consume_in_thread(std::move(cfc));
             });
         });
-        return consumer(make_sstable_reader());
+        return consumer(make_sstable_reader(range, sub_range));
     }
 
     virtual reader_consumer_v2 make_interposer_consumer(reader_consumer_v2 end_consumer) {
+        if (auto ranges_per_shard = token_ranges_per_shard()) {
+            end_consumer = mutation_writer::make_token_range_aligning_consumer(_schema->get_sharder(), ranges_per_shard, std::move(end_consumer));
+        }
         return _table_s.get_compaction_strategy().make_interposer_consumer(_ms_metadata, std::move(end_consumer));
     }
 
     virtual bool use_interposer_consumer() const {
-        return _table_s.get_compaction_strategy().use_interposer_consumer();
+        return token_ranges_per_shard() || _table_s.get_compaction_strategy().use_interposer_consumer();
     }
 protected:
     virtual compaction_result finish(std::chrono::time_point<db_clock> started_at, std::chrono::time_point<db_clock> ended_at) {
@@ -790,14 +969,14 @@ class compaction {
     virtual std::string_view report_start_desc() const = 0;
     virtual std::string_view report_finish_desc() const = 0;
 
-    std::function<api::timestamp_type(const dht::decorated_key&)> max_purgeable_func() {
+    std::function<api::timestamp_type(const dht::decorated_key&)> max_purgeable_func(size_t sub_range) {
         if (!tombstone_expiration_enabled()) {
             return [] (const dht::decorated_key& dk) {
                 return api::min_timestamp;
             };
         }
-        return [this] (const dht::decorated_key& dk) {
-            return get_max_purgeable_timestamp(_table_s, *_selector, _compacting_for_max_purgeable_func, dk);
+        return [this, sub_range] (const dht::decorated_key& dk) {
+            return get_max_purgeable_timestamp(_table_s, *_selectors[sub_range], _compacting_for_max_purgeable_func, dk);
         };
     }
 
@@ -1007,10 +1186,10 @@ class reshape_compaction : public compaction {
         return sstables::make_partitioned_sstable_set(_schema, false);
     }
 
-    flat_mutation_reader_v2 make_sstable_reader() const override {
+    flat_mutation_reader_v2 make_sstable_reader(const dht::partition_range& range, size_t) const override {
         return _compacting->make_local_shard_sstable_reader(_schema,
                 _permit,
-                query::full_partition_range,
+                range,
                 _schema->full_slice(),
                 _io_priority,
                 tracing::trace_state_ptr(),
@@ -1053,16 +1232,21 @@ class regular_compaction : public compaction {
     {
     }
 
-    flat_mutation_reader_v2 make_sstable_reader() const override {
-        return _compacting->make_local_shard_sstable_reader(_schema,
+    flat_mutation_reader_v2 make_sstable_reader(const dht::partition_range& range, size_t sub_range) const override {
+        auto& input = _sub_range_sstables.empty() ? _compacting : _sub_range_sstables[sub_range];
+        return input->make_local_shard_sstable_reader(_schema,
                 _permit,
-                query::full_partition_range,
+                range,
                 _schema->full_slice(),
                 _io_priority,
                 tracing::trace_state_ptr(),
                 ::streamed_mutation::forwarding::no,
                 ::mutation_reader::forwarding::no,
-                _monitor_generator);
+                _monitor_generator.for_sub_range(sub_range));
+    }
+
+    bool can_split_into_sub_ranges() const override {
+        return true;
     }
 
     std::string_view report_start_desc() const override {
@@ -1169,14 +1353,15 @@ class regular_compaction : public compaction {
                 _sstable_set->insert(sst);
             }
         }
-        _selector.emplace(_sstable_set->make_incremental_selector());
+        for (auto& selector : _selectors) {
+            selector.emplace(_sstable_set->make_incremental_selector());
+        }
         _cdata.pending_replacements.clear();
     }
 };
 
 class cleanup_compaction final : public regular_compaction {
     owned_ranges_ptr _owned_ranges;
-    mutable dht::incremental_owned_ranges_checker _owned_ranges_checker;
 private:
     // Called in a seastar thread
     dht::partition_range_vector
@@ -1203,7 +1388,6 @@ class cleanup_compaction final : public regular_compaction {
     cleanup_compaction(table_state& table_s, compaction_descriptor descriptor, compaction_data& cdata, owned_ranges_ptr owned_ranges)
         : regular_compaction(table_s, std::move(descriptor), cdata)
         , _owned_ranges(std::move(owned_ranges))
-        , _owned_ranges_checker(*_owned_ranges)
     {
     }
 
@@ -1213,8 +1397,8 @@ class cleanup_compaction final : public regular_compaction {
     cleanup_compaction(table_state& table_s, compaction_descriptor descriptor, compaction_data& cdata, compaction_type_options::upgrade opts)
         : cleanup_compaction(table_s, std::move(descriptor), cdata, std::move(opts.owned_ranges)) {}
 
-    flat_mutation_reader_v2 make_sstable_reader() const override {
-        return make_filtering_reader(regular_compaction::make_sstable_reader(), make_partition_filter());
+    flat_mutation_reader_v2 make_sstable_reader(const dht::partition_range& range, size_t sub_range) const override {
+        return make_filtering_reader(regular_compaction::make_sstable_reader(range, sub_range), make_partition_filter());
     }
 
     std::string_view report_start_desc() const override {
@@ -1225,14 +1409,15 @@ class cleanup_compaction final : public regular_compaction {
         return "Cleaned";
     }
 
+    // The checker expects increasing tokens, so every reader gets its own.
     flat_mutation_reader_v2::filter make_partition_filter() const {
-        return [this] (const dht::decorated_key& dk) {
+        return [this, owned_ranges_checker = dht::incremental_owned_ranges_checker(*_owned_ranges)] (const dht::decorated_key& dk) mutable {
 #ifdef SEASTAR_DEBUG
             // sstables should never be shared with other shards at this point.
             assert(dht::shard_of(*_schema, dk.token()) == this_shard_id());
 #endif
 
-            if (!_owned_ranges_checker.belongs_to_current_node(dk.token())) {
+            if (!owned_ranges_checker.belongs_to_current_node(dk.token())) {
                 log_trace("Token {} does not belong to this node, skipping", dk.token());
                 return false;
             }
@@ -1242,6 +1427,9 @@ class cleanup_compaction final : public regular_compaction {
 };
 
 class scrub_compaction final : public regular_compaction {
+    bool can_split_into_sub_ranges() const override {
+        return false;
+    }
 public:
     static void report_invalid_partition(compaction_type type, mutation_fragment_stream_validator& validator, const dht::decorated_key& new_key,
             std::string_view action = "") {
@@ -1523,7 +1711,8 @@ class scrub_compaction final : public regular_compaction {
         return _scrub_finish_description;
     }
 
-    flat_mutation_reader_v2 make_sstable_reader() const override {
+    // Scrub is never split into sub-ranges, it crawls through all of the input.
+    flat_mutation_reader_v2 make_sstable_reader(const dht::partition_range&, size_t) const override {
         auto crawling_reader = _compacting->make_crawling_reader(_schema, _permit, _io_priority, nullptr);
         return make_flat_mutation_reader_v2<reader>(std::move(crawling_reader), _options.operation_mode, _validation_errors);
     }
@@ -1589,8 +1778,10 @@ class resharding_compaction final : public compaction {
     // return estimated partitions per sstable for a given shard
     uint64_t partitions_per_sstable(shard_id s) const {
         uint64_t estimated_sstables = std::max(uint64_t(1), uint64_t(ceil(double(_estimation_per_shard[s].estimated_size) / _max_sstable_size)));
-        return std::min(uint64_t(ceil(double(_estimation_per_shard[s].estimated_partitions) / estimated_sstables)),
+        auto estimate = std::min(uint64_t(ceil(double(_estimation_per_shard[s].estimated_partitions) / estimated_sstables)),
                 _table_s.get_compaction_strategy().adjust_partition_estimate(_ms_metadata, _estimation_per_shard[s].estimated_partitions));
+        // The output of every shard is split into its token groups.
+        return std::max(uint64_t(1), estimate / std::max(token_ranges_per_shard(), 1U));
     }
 public:
     resharding_compaction(table_state& table_s, sstables::compaction_descriptor descriptor, compaction_data& cdata)
@@ -1615,10 +1806,10 @@ class resharding_compaction final : public compaction {
     ~resharding_compaction() { }
 
     // Use reader that makes sure no non-local mutation will not be filtered out.
-    flat_mutation_reader_v2 make_sstable_reader() const override {
+    flat_mutation_reader_v2 make_sstable_reader(const dht::partition_range& range, size_t) const override {
         return _compacting->make_range_sstable_reader(_schema,
                 _permit,
-                query::full_partition_range,
+                range,
                 _schema->full_slice(),
                 _io_priority,
                 nullptr,
@@ -1628,6 +1819,9 @@ class resharding_compaction final : public compaction {
     }
 
     reader_consumer_v2 make_interposer_consumer(reader_consumer_v2 end_consumer) override {
+        if (auto ranges_per_shard = token_ranges_per_shard()) {
+            end_consumer = mutation_writer::make_token_range_aligning_consumer(_schema->get_sharder(), ranges_per_shard, std::move(end_consumer));
+        }
         return [this, end_consumer = std::move(end_consumer)] (flat_mutation_reader_v2 reader) mutable -> future<> {
             return mutation_writer::segregate_by_shard(std::move(reader), std::move(end_consumer));
         };
@@ -1651,8 +1845,11 @@ class resharding_compaction final : public compaction {
         setup_new_sstable(sst);
 
         auto cfg = make_sstable_writer_config(compaction_type::Reshard);
-        // sstables generated for a given shard will share the same run identifier.
-        cfg.run_identifier = _run_identifiers.at(shard);
+        // sstables generated for a given shard will share the same run identifier,
+        // unless split into token groups.
+        if (!token_ranges_per_shard()) {
+            cfg.run_identifier = _run_identifiers.at(shard);
+        }
         return compaction_writer{sst->get_writer(*_schema, partitions_per_sstable(shard), cfg, get_encoding_stats(), _io_priority, shard), sst};
     }
 
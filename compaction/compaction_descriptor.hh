@@ -155,6 +155,9 @@ struct compaction_descriptor {
     uint64_t max_sstable_bytes;
     // Can split large partitions at clustering boundary.
     bool can_split_large_partition = false;
+    // Number of disjoint token sub-ranges the input is split into, to be compacted in parallel.
+    // Only regular compaction and cleanup are split.
+    unsigned sub_ranges = 1;
     // Run identifier of output sstables.
     sstables::run_id run_identifier;
     // The options passed down to the compaction code.
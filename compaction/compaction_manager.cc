@@ -385,6 +385,7 @@ class compaction_manager::major_compaction_task : public compaction_manager::tas
         compaction::table_state* t = _compacting_table;
         sstables::compaction_strategy cs = t->get_compaction_strategy();
         sstables::compaction_descriptor descriptor = cs.get_major_compaction_job(*t, _cm.get_candidates(*t));
+        descriptor.sub_ranges = _cm.parallel_sub_ranges();
         auto compacting = compacting_sstable_registration(_cm, descriptor.sstables);
         auto release_exhausted = [&compacting] (const std::vector<sstables::shared_sstable>& exhausted_sstables) {
             compacting.release_compacting(exhausted_sstables);
@@ -526,8 +527,9 @@ std::ostream& operator<<(std::ostream& os, const compaction_manager::task& task)
     return os << task.describe();
 }
 
-inline compaction_controller make_compaction_controller(const compaction_manager::scheduling_group& csg, uint64_t static_shares, std::function<double()> fn) {
-    return compaction_controller(csg, static_shares, 250ms, std::move(fn));
+inline compaction_controller make_compaction_controller(const compaction_manager::scheduling_group& csg, uint64_t static_shares, std::function<double()> fn,
+        std::function<std::chrono::milliseconds()> latency_target = {}) {
+    return compaction_controller(csg, static_shares, 250ms, std::move(fn), std::move(latency_target));
 }
 
 compaction_manager::compaction_state::~compaction_state() {
@@ -657,6 +659,8 @@ compaction_manager::compaction_manager(config cfg, abort_source& as)
             return compaction_controller::normalization_factor;
         }
         return b;
+    }, [this] {
+        return std::chrono::milliseconds(_cfg.read_latency_target_ms());
     }))
     , _backlog_manager(_compaction_controller)
     , _early_abort_subscription(as.subscribe([this] () noexcept {
@@ -731,6 +735,8 @@ void compaction_manager::register_metrics() {
                        sm::description("Holds the sum of normalized compaction backlog for all tables in the system. Backlog is normalized by dividing backlog by shard's available memory.")),
         sm::make_counter("validation_errors", [this] { return _validation_errors; },
                        sm::description("Holds the number of encountered validation errors.")),
+        sm::make_gauge("latency_factor", [this] { return _compaction_controller.latency_factor(); },
+                       sm::description("Holds the fraction of the backlog-based shares given to compaction, lowered while foreground read latency is above target.")),
     });
 }
 
@@ -1425,6 +1431,7 @@ class compaction_manager::cleanup_sstables_compaction_task : public compaction_m
         while (!_pending_cleanup_jobs.empty() && can_proceed()) {
             auto active_job = std::move(_pending_cleanup_jobs.back());
             active_job.options = _cleanup_options;
+            active_job.sub_ranges = _cm.parallel_sub_ranges();
             co_await run_cleanup_job(std::move(active_job));
             _pending_cleanup_jobs.pop_back();
             _cm._stats.pending_tasks--;
@@ -1516,6 +1523,84 @@ future<> compaction_manager::perform_cleanup(owned_ranges_ptr sorted_owned_range
                                                                          std::move(get_sstables));
 }
 
+class compaction_manager::tombstone_gc_compaction_task : public compaction_manager::task {
+    compacting_sstable_registration _compacting;
+    std::vector<sstables::compaction_descriptor> _pending_jobs;
+public:
+    tombstone_gc_compaction_task(compaction_manager& mgr, compaction::table_state* t, sstables::compaction_type_options options,
+                                 std::vector<sstables::shared_sstable> candidates, compacting_sstable_registration compacting)
+            : task(mgr, t, options.type(), "Tombstone GC")
+            , _compacting(std::move(compacting))
+            , _pending_jobs(t->get_compaction_strategy().get_tombstone_gc_compaction_jobs(*t, candidates))
+    {
+        // Candidates left out of every job are not compacted, so let regular compaction have them.
+        std::unordered_set<sstables::shared_sstable> in_jobs;
+        for (auto& job : _pending_jobs) {
+            in_jobs.insert(job.sstables.begin(), job.sstables.end());
+        }
+        std::erase_if(candidates, [&in_jobs] (const sstables::shared_sstable& sst) { return in_jobs.contains(sst); });
+        _compacting.release_compacting(candidates);
+        // Like cleanup, run smaller jobs first.
+        std::ranges::sort(_pending_jobs, std::ranges::greater(), std::mem_fn(&sstables::compaction_descriptor::sstables_size));
+        _cm._stats.pending_tasks += _pending_jobs.size();
+    }
+
+    virtual ~tombstone_gc_compaction_task() {
+        _cm._stats.pending_tasks -= _pending_jobs.size();
+    }
+protected:
+    virtual future<compaction_stats_opt> do_run() override {
+        switch_state(state::pending);
+        auto maintenance_permit = co_await acquire_semaphore(_cm._maintenance_ops_sem);
+
+        while (!_pending_jobs.empty() && can_proceed()) {
+            co_await run_job(std::move(_pending_jobs.back()));
+            _pending_jobs.pop_back();
+            _cm._stats.pending_tasks--;
+        }
+
+        co_return std::nullopt;
+    }
+private:
+    void release_exhausted(std::vector<sstables::shared_sstable> exhausted_sstables) {
+        _compacting.release_compacting(exhausted_sstables);
+    }
+
+    future<> run_job(sstables::compaction_descriptor descriptor) {
+        co_await coroutine::switch_to(_cm.compaction_sg().cpu);
+
+        for (;;) {
+            compaction_backlog_tracker user_initiated(std::make_unique<user_initiated_backlog_tracker>(_cm._compaction_controller.backlog_of_shares(200), _cm.available_memory()));
+            _cm.register_backlog_tracker(user_initiated);
+
+            std::exception_ptr ex;
+            try {
+                setup_new_compaction(descriptor.run_identifier);
+                co_await compact_sstables_and_update_history(descriptor, _compaction_data,
+                                          std::bind(&tombstone_gc_compaction_task::release_exhausted, this, std::placeholders::_1));
+                finish_compaction();
+                _cm.reevaluate_postponed_compactions();
+                co_return;  // done with current job
+            } catch (...) {
+                ex = std::current_exception();
+            }
+
+            finish_compaction(state::failed);
+            // retry current job or rethrows exception
+            if ((co_await maybe_retry(std::move(ex))) == stop_iteration::yes) {
+                co_return;
+            }
+        }
+    }
+};
+
+future<> compaction_manager::perform_tombstone_gc(compaction::table_state& t) {
+    auto get_sstables = [this, &t] {
+        return make_ready_future<std::vector<sstables::shared_sstable>>(get_candidates(t));
+    };
+    co_await perform_task_on_all_files<tombstone_gc_compaction_task>(t, sstables::compaction_type_options::make_regular(), std::move(get_sstables));
+}
+
 // Submit a table to be upgraded and wait for its termination.
 future<> compaction_manager::perform_sstable_upgrade(owned_ranges_ptr sorted_owned_ranges, compaction::table_state& t, bool exclude_current_version) {
     auto get_sstables = [this, &t, exclude_current_version] {
@@ -1698,6 +1783,14 @@ void compaction_manager::unplug_system_keyspace() noexcept {
     _sys_ks = nullptr;
 }
 
+void compaction_manager::plug_foreground_load_probe(compaction_controller::foreground_load_probe probe) noexcept {
+    _compaction_controller.set_foreground_load_probe(std::move(probe));
+}
+
+void compaction_manager::unplug_foreground_load_probe() noexcept {
+    _compaction_controller.set_foreground_load_probe({});
+}
+
 double compaction_backlog_tracker::backlog() const {
     return disabled() ? compaction_controller::disable_backlog : _impl->backlog(_ongoing_writes, _ongoing_compactions);
 }
@@ -67,6 +67,8 @@ class compaction_manager {
         size_t available_memory = 0;
         utils::updateable_value<float> static_shares = utils::updateable_value<float>(0);
         utils::updateable_value<uint32_t> throughput_mb_per_sec = utils::updateable_value<uint32_t>(0);
+        utils::updateable_value<uint32_t> parallel_sub_ranges = utils::updateable_value<uint32_t>(1);
+        utils::updateable_value<uint32_t> read_latency_target_ms = utils::updateable_value<uint32_t>(0);
     };
 private:
     struct compaction_state {
@@ -240,6 +242,7 @@ class compaction_manager {
     class offstrategy_compaction_task;
     class rewrite_sstables_compaction_task;
     class cleanup_sstables_compaction_task;
+    class tombstone_gc_compaction_task;
     class validate_sstables_compaction_task;
     class compaction_manager_test_task;
 
@@ -406,6 +409,11 @@ class compaction_manager {
         return _cfg.throughput_mb_per_sec.get();
     }
 
+    // Number of sub-ranges major compaction and cleanup jobs are split into.
+    unsigned parallel_sub_ranges() const noexcept {
+        return std::max(_cfg.parallel_sub_ranges.get(), uint32_t(1));
+    }
+
     void register_metrics();
 
     // enable the compaction manager.
@@ -443,6 +451,13 @@ class compaction_manager {
     // of a newly added node.
     future<> perform_cleanup(owned_ranges_ptr sorted_owned_ranges, compaction::table_state& t);
 
+    // Submit a table for tombstone garbage collection and wait for its termination.
+    //
+    // Rewrites only the sstables with enough droppable tombstones, each along
+    // with the sstables it overlaps with, to purge expired tombstones without
+    // a major compaction.
+    future<> perform_tombstone_gc(compaction::table_state& t);
+
     // Submit a table to be upgraded and wait for its termination.
     future<> perform_sstable_upgrade(owned_ranges_ptr sorted_owned_ranges, compaction::table_state& t, bool exclude_current_version);
 
@@ -493,6 +508,11 @@ class compaction_manager {
     void plug_system_keyspace(db::system_keyspace& sys_ks) noexcept;
     void unplug_system_keyspace() noexcept;
 
+    // Provides the foreground load the compaction controller keeps
+    // the read latency target against.
+    void plug_foreground_load_probe(compaction_controller::foreground_load_probe probe) noexcept;
+    void unplug_foreground_load_probe() noexcept;
+
     // Adds a table to the compaction manager.
     // Creates a compaction_state structure that can be used for submitting
     // compaction jobs of all types.
@@ -26,6 +26,7 @@
 #include "date_tiered_compaction_strategy.hh"
 #include "leveled_compaction_strategy.hh"
 #include "time_window_compaction_strategy.hh"
+#include "incremental_compaction_strategy.hh"
 #include "backlog_controller.hh"
 #include "compaction_backlog_manager.hh"
 #include "size_tiered_backlog_tracker.hh"
@@ -50,6 +51,64 @@ std::vector<compaction_descriptor> compaction_strategy_impl::get_cleanup_compact
     }));
 }
 
+std::vector<compaction_descriptor> compaction_strategy_impl::get_tombstone_gc_compaction_jobs(table_state& table_s, std::vector<shared_sstable> candidates) const {
+    return make_tombstone_gc_compaction_jobs(table_s, std::move(candidates), with_overlapping::yes);
+}
+
+std::vector<compaction_descriptor> compaction_strategy_impl::make_tombstone_gc_compaction_jobs(table_state& table_s,
+        std::vector<shared_sstable> candidates, with_overlapping overlapping) const {
+    auto compaction_time = gc_clock::now();
+    auto& gc_state = table_s.get_tombstone_gc_state();
+    auto& schema = *table_s.schema();
+
+    std::vector<std::pair<shared_sstable, double>> worth;
+    for (auto& sst : candidates) {
+        auto ratio = sst->estimate_droppable_tombstone_ratio(sst->get_gc_before_for_drop_estimation(compaction_time, gc_state));
+        if (ratio >= _tombstone_threshold) {
+            worth.emplace_back(sst, ratio);
+        }
+    }
+    // Start with the sstables with most droppable tombstones, so they get the
+    // overlapping sstables they need before those are taken by other jobs.
+    std::ranges::sort(worth, std::ranges::greater(), [] (const auto& p) { return p.second; });
+
+    auto overlaps = [&schema] (const shared_sstable& a, const shared_sstable& b) {
+        return a->get_first_decorated_key().tri_compare(schema, b->get_last_decorated_key()) <= 0
+            && b->get_first_decorated_key().tri_compare(schema, a->get_last_decorated_key()) <= 0;
+    };
+
+    std::unordered_set<shared_sstable> taken;
+    std::vector<compaction_descriptor> jobs;
+    for (auto& [sst, ratio] : worth) {
+        if (taken.contains(sst)) {
+            continue;
+        }
+        // A tombstone can only be purged if no other sstable may hold older data it shadows,
+        // so rewrite such overlapping sstables along with it. Whether each tombstone is
+        // actually purgeable is decided by the compaction itself.
+        std::vector<shared_sstable> job = { sst };
+        for (auto& other : candidates) {
+            if (overlapping && other != sst && !taken.contains(other) && overlaps(sst, other)
+                    && other->get_stats_metadata().min_timestamp <= sst->get_stats_metadata().max_timestamp) {
+                job.push_back(other);
+            }
+        }
+        if (job.size() > size_t(schema.max_compaction_threshold())) {
+            clogger.debug("Skipping tombstone GC of {} (droppable tombstone ratio {}): overlaps with {} sstables",
+                    sst->get_filename(), ratio, job.size() - 1);
+            continue;
+        }
+        taken.insert(job.begin(), job.end());
+        if (job.size() == 1) {
+            jobs.emplace_back(std::move(job), service::get_local_compaction_priority(), sst->get_sstable_level(),
+                    compaction_descriptor::default_max_sstable_bytes, sst->run_identifier());
+        } else {
+            jobs.emplace_back(std::move(job), service::get_local_compaction_priority());
+        }
+    }
+    return jobs;
+}
+
 bool compaction_strategy_impl::worth_dropping_tombstones(const shared_sstable& sst, gc_clock::time_point compaction_time, const tombstone_gc_state& gc_state) {
     if (_disable_tombstone_compaction) {
         return false;
@@ -723,6 +782,10 @@ std::vector<compaction_descriptor> compaction_strategy::get_cleanup_compaction_j
     return _compaction_strategy_impl->get_cleanup_compaction_jobs(table_s, std::move(candidates));
 }
 
+std::vector<compaction_descriptor> compaction_strategy::get_tombstone_gc_compaction_jobs(table_state& table_s, std::vector<shared_sstable> candidates) const {
+    return _compaction_strategy_impl->get_tombstone_gc_compaction_jobs(table_s, std::move(candidates));
+}
+
 void compaction_strategy::notify_completion(const std::vector<shared_sstable>& removed, const std::vector<shared_sstable>& added) {
     _compaction_strategy_impl->notify_completion(removed, added);
 }
@@ -779,6 +842,9 @@ compaction_strategy make_compaction_strategy(compaction_strategy_type strategy,
     case compaction_strategy_type::time_window:
         impl = ::make_shared<time_window_compaction_strategy>(options);
         break;
+    case compaction_strategy_type::incremental:
+        impl = ::make_shared<incremental_compaction_strategy>(options);
+        break;
     default:
         throw std::runtime_error("strategy not supported");
     }
@@ -42,6 +42,12 @@ class compaction_strategy_impl {
 protected:
     compaction_strategy_impl() = default;
     explicit compaction_strategy_impl(const std::map<sstring, sstring>& options);
+    using with_overlapping = bool_class<class with_overlapping_tag>;
+    // Jobs rewriting the candidates with enough droppable tombstones, along with
+    // the overlapping sstables which may hold data they shadow if overlapping is set,
+    // or alone otherwise.
+    std::vector<compaction_descriptor> make_tombstone_gc_compaction_jobs(table_state& table_s,
+            std::vector<shared_sstable> candidates, with_overlapping overlapping) const;
     static compaction_descriptor make_major_compaction_job(std::vector<sstables::shared_sstable> candidates,
             int level = compaction_descriptor::default_level,
             uint64_t max_sstable_bytes = compaction_descriptor::default_max_sstable_bytes);
@@ -52,6 +58,7 @@ class compaction_strategy_impl {
         return make_major_compaction_job(std::move(candidates));
     }
     virtual std::vector<compaction_descriptor> get_cleanup_compaction_jobs(table_state& table_s, std::vector<shared_sstable> candidates) const;
+    virtual std::vector<compaction_descriptor> get_tombstone_gc_compaction_jobs(table_state& table_s, std::vector<shared_sstable> candidates) const;
     virtual void notify_completion(const std::vector<shared_sstable>& removed, const std::vector<shared_sstable>& added) { }
     virtual compaction_strategy_type type() const = 0;
     virtual bool parallel_compaction() const {
@@ -0,0 +1,246 @@
+/*
+ * Copyright (C) 2022-present ScyllaDB
+ */
+
+/*
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "sstables/sstables.hh"
+#include "incremental_compaction_strategy.hh"
+#include "size_tiered_backlog_tracker.hh"
+
+#include <boost/range/adaptor/reversed.hpp>
+#include <boost/range/algorithm/remove_if.hpp>
+
+extern logging::logger clogger;
+
+namespace sstables {
+
+static std::vector<shared_sstable> sstables_of(const std::vector<sstable_run>& runs) {
+    std::vector<shared_sstable> ret;
+    for (auto& run : runs) {
+        ret.insert(ret.end(), run.all().begin(), run.all().end());
+    }
+    return ret;
+}
+
+incremental_compaction_strategy::incremental_compaction_strategy(const std::map<sstring, sstring>& options)
+    : compaction_strategy_impl(options)
+    , _stcs_options(options)
+{
+    using namespace cql3::statements;
+
+    auto size_in_mb = property_definitions::to_int(FRAGMENT_SIZE_OPTION, get_value(options, FRAGMENT_SIZE_OPTION), DEFAULT_MAX_FRAGMENT_SIZE_IN_MB);
+    if (size_in_mb <= 0) {
+        throw exceptions::configuration_exception(format("{} must be greater than 0, but was {}", FRAGMENT_SIZE_OPTION, size_in_mb));
+    }
+    _fragment_size = uint64_t(size_in_mb) * 1024 * 1024;
+
+    auto goal = get_value(options, SPACE_AMPLIFICATION_GOAL_OPTION);
+    if (goal) {
+        _space_amplification_goal = property_definitions::to_double(SPACE_AMPLIFICATION_GOAL_OPTION, goal, 0);
+        if (*_space_amplification_goal <= 1.0) {
+            throw exceptions::configuration_exception(format("{} must be greater than 1.0, but was {}",
+                    SPACE_AMPLIFICATION_GOAL_OPTION, *_space_amplification_goal));
+        }
+    }
+}
+
+std::vector<sstable_run> incremental_compaction_strategy::get_runs(const std::vector<shared_sstable>& sstables) {
+    std::unordered_map<run_id, sstable_run> runs;
+    std::vector<sstable_run> ret;
+    for (auto& sst : sstables) {
+        if (!runs[sst->run_identifier()].insert(sst)) {
+            // Fragments of a run are disjoint, one which is not is treated as a run of its own.
+            sstable_run run;
+            run.insert(sst);
+            ret.push_back(std::move(run));
+        }
+    }
+    for (auto& [id, run] : runs) {
+        ret.push_back(std::move(run));
+    }
+    return ret;
+}
+
+std::vector<incremental_compaction_strategy::bucket_type>
+incremental_compaction_strategy::get_buckets(std::vector<sstable_run> runs) const {
+    std::vector<std::pair<sstable_run, uint64_t>> sorted_runs;
+    sorted_runs.reserve(runs.size());
+    for (auto& run : runs) {
+        auto size = run.data_size();
+        sorted_runs.emplace_back(std::move(run), size);
+    }
+    std::sort(sorted_runs.begin(), sorted_runs.end(), [] (auto& i, auto& j) {
+        return i.second < j.second;
+    });
+
+    std::vector<bucket_type> buckets;
+    // Average and smallest run size of each bucket
+    std::vector<std::pair<double, uint64_t>> bucket_sizes;
+
+    for (auto& [run, size] : sorted_runs) {
+        // Same rules as in size-tiered compaction, see size_tiered_compaction_strategy::get_buckets().
+        if (!buckets.empty()) {
+            auto& [average, smallest] = bucket_sizes.back();
+            if ((size > average * _stcs_options.bucket_low && size < average * _stcs_options.bucket_high) ||
+                    (size < _stcs_options.min_sstable_size && average < _stcs_options.min_sstable_size)) {
+                auto& bucket = buckets.back();
+                auto new_average = (bucket.size() * average + size) / (bucket.size() + 1);
+                if (size < _stcs_options.min_sstable_size || smallest > new_average * _stcs_options.bucket_low) {
+                    bucket.push_back(std::move(run));
+                    average = new_average;
+                    continue;
+                }
+            }
+        }
+        buckets.push_back(bucket_type{std::move(run)});
+        bucket_sizes.emplace_back(size, size);
+    }
+    return buckets;
+}
+
+incremental_compaction_strategy::bucket_type
+incremental_compaction_strategy::most_interesting_bucket(const std::vector<bucket_type>& buckets, size_t min_threshold, size_t max_threshold) {
+    const bucket_type* max = nullptr;
+    for (auto& bucket : buckets) {
+        if (bucket.size() >= min_threshold && (!max || bucket.size() > max->size())) {
+            max = &bucket;
+        }
+    }
+    if (!max) {
+        return {};
+    }
+    // Runs are sorted by size, so the smallest of them are compacted first.
+    auto n = std::min(max->size(), max_threshold);
+    return bucket_type(max->begin(), max->begin() + n);
+}
+
+std::vector<shared_sstable> incremental_compaction_strategy::find_space_amplification_job(const std::vector<bucket_type>& buckets) const {
+    if (!_space_amplification_goal || buckets.size() < 2) {
+        return {};
+    }
+    std::vector<std::pair<uint64_t, const bucket_type*>> tiers;
+    tiers.reserve(buckets.size());
+    for (auto& bucket : buckets) {
+        uint64_t size = 0;
+        for (auto& run : bucket) {
+            size += run.data_size();
+        }
+        tiers.emplace_back(size, &bucket);
+    }
+    std::partial_sort(tiers.begin(), tiers.begin() + 2, tiers.end(), [] (auto& i, auto& j) {
+        return i.first > j.first;
+    });
+    auto [largest, largest_bucket] = tiers[0];
+    auto [second, second_bucket] = tiers[1];
+    if (!largest || double(largest + second) / largest <= *_space_amplification_goal) {
+        return {};
+    }
+    clogger.debug("Space amplification of the two largest tiers ({} and {} bytes) is above the goal of {}", largest, second, *_space_amplification_goal);
+    auto ret = sstables_of(*largest_bucket);
+    auto second_sstables = sstables_of(*second_bucket);
+    ret.insert(ret.end(), second_sstables.begin(), second_sstables.end());
+    return ret;
+}
+
+compaction_descriptor incremental_compaction_strategy::make_descriptor(std::vector<shared_sstable> sstables) const {
+    return compaction_descriptor(std::move(sstables), service::get_local_compaction_priority(),
+            compaction_descriptor::default_level, _fragment_size);
+}
+
+compaction_descriptor
+incremental_compaction_strategy::get_sstables_for_compaction(table_state& table_s, strategy_control& control, std::vector<sstables::shared_sstable> candidates) {
+    // make local copies so they can't be changed out from under us mid-method
+    size_t min_threshold = table_s.min_compaction_threshold();
+    size_t max_threshold = table_s.schema()->max_compaction_threshold();
+    auto compaction_time = gc_clock::now();
+
+    auto buckets = get_buckets(get_runs(candidates));
+
+    auto bucket = most_interesting_bucket(buckets, min_threshold, max_threshold);
+    // If we are not enforcing min_threshold explicitly, try any pair of runs in the same tier.
+    if (bucket.empty() && !table_s.compaction_enforce_min_threshold()) {
+        bucket = most_interesting_bucket(buckets, 2, max_threshold);
+    }
+    if (!bucket.empty()) {
+        return make_descriptor(sstables_of(bucket));
+    }
+
+    auto sstables = find_space_amplification_job(buckets);
+    if (!sstables.empty()) {
+        return make_descriptor(std::move(sstables));
+    }
+
+    // As in size-tiered compaction, try compacting the oldest fragment whose droppable
+    // tombstone ratio is greater than threshold, preferring the biggest tiers.
+    for (auto& bucket : buckets | boost::adaptors::reversed) {
+        auto sstables = sstables_of(bucket);
+        auto e = boost::range::remove_if(sstables, [this, compaction_time, &table_s] (const sstables::shared_sstable& sst) -> bool {
+            return !worth_dropping_tombstones(sst, compaction_time, table_s.get_tombstone_gc_state());
+        });
+        sstables.erase(e, sstables.end());
+        if (sstables.empty()) {
+            continue;
+        }
+        auto it = std::min_element(sstables.begin(), sstables.end(), [] (auto& i, auto& j) {
+            return i->get_stats_metadata().min_timestamp < j->get_stats_metadata().min_timestamp;
+        });
+        return make_descriptor({ *it });
+    }
+    return compaction_descriptor();
+}
+
+compaction_descriptor incremental_compaction_strategy::get_major_compaction_job(table_state& table_s, std::vector<sstables::shared_sstable> candidates) {
+    if (candidates.empty()) {
+        return compaction_descriptor();
+    }
+    return make_major_compaction_job(std::move(candidates), compaction_descriptor::default_level, _fragment_size);
+}
+
+std::vector<compaction_descriptor>
+incremental_compaction_strategy::get_cleanup_compaction_jobs(table_state& table_s, std::vector<shared_sstable> candidates) const {
+    // One job per run, so that cleanup releases fragments as it goes, like any other compaction.
+    std::vector<compaction_descriptor> ret;
+    for (auto& run : get_runs(candidates)) {
+        ret.push_back(make_descriptor(std::vector<shared_sstable>(run.all().begin(), run.all().end())));
+    }
+    return ret;
+}
+
+int64_t incremental_compaction_strategy::estimated_pending_compactions(table_state& table_s) const {
+    size_t min_threshold = table_s.min_compaction_threshold();
+    size_t max_threshold = table_s.schema()->max_compaction_threshold();
+    auto all_sstables = table_s.main_sstable_set().all();
+    std::vector<shared_sstable> sstables(all_sstables->begin(), all_sstables->end());
+
+    int64_t n = 0;
+    for (auto& bucket : get_buckets(get_runs(sstables))) {
+        if (bucket.size() >= min_threshold) {
+            n += std::ceil(double(bucket.size()) / max_threshold);
+        }
+    }
+    return n;
+}
+
+std::unique_ptr<compaction_backlog_tracker::impl> incremental_compaction_strategy::make_backlog_tracker() {
+    return std::make_unique<size_tiered_backlog_tracker>(_stcs_options);
+}
+
+compaction_descriptor
+incremental_compaction_strategy::get_reshaping_job(std::vector<shared_sstable> input, schema_ptr schema, const ::io_priority_class& iop, reshape_mode mode) {
+    // Runs of many fragments were written by this strategy, only the single
+    // sstables among the input are reshaped, the same way size-tiered does it.
+    std::vector<shared_sstable> single_sstables;
+    for (auto& run : get_runs(input)) {
+        if (run.all().size() == 1) {
+            single_sstables.push_back(*run.all().begin());
+        }
+    }
+    auto desc = size_tiered_compaction_strategy(_stcs_options).get_reshaping_job(std::move(single_sstables), std::move(schema), iop, mode);
+    desc.max_sstable_bytes = _fragment_size;
+    return desc;
+}
+
+}
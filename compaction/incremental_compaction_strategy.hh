@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2022-present ScyllaDB
+ */
+
+/*
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <optional>
+#include <vector>
+#include <map>
+
+#include <seastar/core/sstring.hh>
+
+#include "compaction_strategy_impl.hh"
+#include "size_tiered_compaction_strategy.hh"
+#include "sstables/shared_sstable.hh"
+#include "sstables/sstable_set.hh"
+
+namespace sstables {
+
+// Size-tiered compaction of sstable runs, rather than of single sstables.
+//
+// Compactions write their output as a run of fragments of at most
+// sstable_size_in_mb each. Once the output has moved past the last key of
+// an input fragment, the fragment is replaced by the output written so far
+// and released, so a compaction of large runs needs temporary space for a
+// few fragments rather than for its whole input.
+class incremental_compaction_strategy : public compaction_strategy_impl {
+    static constexpr int32_t DEFAULT_MAX_FRAGMENT_SIZE_IN_MB = 1000;
+    const sstring FRAGMENT_SIZE_OPTION = "sstable_size_in_mb";
+    const sstring SPACE_AMPLIFICATION_GOAL_OPTION = "space_amplification_goal";
+
+    uint64_t _fragment_size;
+    std::optional<double> _space_amplification_goal;
+    size_tiered_compaction_strategy_options _stcs_options;
+public:
+    using bucket_type = std::vector<sstable_run>;
+private:
+    // Groups sstables into the runs they belong to.
+    static std::vector<sstable_run> get_runs(const std::vector<shared_sstable>& sstables);
+
+    // Groups runs of similar size into buckets, by the rules of size-tiered compaction.
+    std::vector<bucket_type> get_buckets(std::vector<sstable_run> runs) const;
+
+    static bucket_type most_interesting_bucket(const std::vector<bucket_type>& buckets, size_t min_threshold, size_t max_threshold);
+
+    // Returns the runs of the two largest tiers if together they exceed the
+    // size of the largest one by more than the space amplification goal.
+    std::vector<shared_sstable> find_space_amplification_job(const std::vector<bucket_type>& buckets) const;
+
+    compaction_descriptor make_descriptor(std::vector<shared_sstable> sstables) const;
+public:
+    incremental_compaction_strategy(const std::map<sstring, sstring>& options);
+
+    virtual compaction_descriptor get_sstables_for_compaction(table_state& table_s, strategy_control& control, std::vector<sstables::shared_sstable> candidates) override;
+
+    virtual compaction_descriptor get_major_compaction_job(table_state& table_s, std::vector<sstables::shared_sstable> candidates) override;
+
+    virtual std::vector<compaction_descriptor> get_cleanup_compaction_jobs(table_state& table_s, std::vector<shared_sstable> candidates) const override;
+
+    virtual int64_t estimated_pending_compactions(table_state& table_s) const override;
+
+    virtual compaction_strategy_type type() const override {
+        return compaction_strategy_type::incremental;
+    }
+
+    virtual std::unique_ptr<sstable_set_impl> make_sstable_set(schema_ptr schema) const override;
+
+    virtual std::unique_ptr<compaction_backlog_tracker::impl> make_backlog_tracker() override;
+
+    virtual compaction_descriptor get_reshaping_job(std::vector<shared_sstable> input, schema_ptr schema, const ::io_priority_class& iop, reshape_mode mode) override;
+
+    uint64_t fragment_size() const noexcept {
+        return _fragment_size;
+    }
+};
+
+}
@@ -228,6 +228,15 @@ leveled_compaction_strategy::get_cleanup_compaction_jobs(table_state& table_s, s
     return ret;
 }
 
+std::vector<compaction_descriptor>
+leveled_compaction_strategy::get_tombstone_gc_compaction_jobs(table_state& table_s, std::vector<shared_sstable> candidates) const {
+    // Sstables rewritten along with overlapping ones from other levels would produce output
+    // overlapping the sstables of its level which aren't part of the job. Rewriting every
+    // sstable alone, into its own level, keeps the levels disjoint. The tombstones which
+    // shadow data of other sstables are left to the compactions between levels.
+    return make_tombstone_gc_compaction_jobs(table_s, std::move(candidates), with_overlapping::no);
+}
+
 unsigned leveled_compaction_strategy::ideal_level_for_input(const std::vector<sstables::shared_sstable>& input, uint64_t max_sstable_size) {
     auto log_fanout = [fanout = leveled_manifest::leveled_fan_out] (double x) {
         double inv_log_fanout = 1.0f / std::log(fanout);
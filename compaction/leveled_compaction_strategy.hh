@@ -44,6 +44,8 @@ class leveled_compaction_strategy : public compaction_strategy_impl {
 
     virtual std::vector<compaction_descriptor> get_cleanup_compaction_jobs(table_state& table_s, std::vector<shared_sstable> candidates) const override;
 
+    virtual std::vector<compaction_descriptor> get_tombstone_gc_compaction_jobs(table_state& table_s, std::vector<shared_sstable> candidates) const override;
+
     virtual compaction_descriptor get_major_compaction_job(table_state& table_s, std::vector<sstables::shared_sstable> candidates) override;
 
     virtual void notify_completion(const std::vector<shared_sstable>& removed, const std::vector<shared_sstable>& added) override;
@@ -60,6 +60,18 @@ std::map<sstring, sstring> compressor::options() const {
     return {};
 }
 
+size_t compressor::dictionary_size() const {
+    return 0;
+}
+
+bytes compressor::train_dictionary(const char* samples, const std::vector<size_t>& sample_sizes) const {
+    return bytes();
+}
+
+compressor::ptr_type compressor::with_dictionary(bytes_view dict) const {
+    throw std::runtime_error(fmt::format("{} does not support dictionaries", name()));
+}
+
 compressor::ptr_type compressor::create(const sstring& name, const opt_getter& opts) {
     if (name.empty()) {
         return {};
@@ -10,11 +10,13 @@
 
 #include <map>
 #include <set>
+#include <vector>
 
 #include <seastar/core/future.hh>
 #include <seastar/core/shared_ptr.hh>
 #include <seastar/core/sstring.hh>
 
+#include "bytes.hh"
 #include "exceptions/exceptions.hh"
 
 
@@ -51,6 +53,24 @@ class compressor {
      */
     virtual std::map<sstring, sstring> options() const;
 
+    /**
+     * Returns the size of the dictionary this compressor wants to be trained
+     * for each sstable, or 0 if it doesn't use one.
+     */
+    virtual size_t dictionary_size() const;
+    /**
+     * Trains a dictionary of up to dictionary_size() bytes on the concatenated
+     * samples in "samples", whose sizes are given by "sample_sizes".
+     * Returns an empty dictionary if training is not possible.
+     */
+    virtual bytes train_dictionary(const char* samples, const std::vector<size_t>& sample_sizes) const;
+    /**
+     * Returns a compressor with the same options which compresses and
+     * uncompresses using the given dictionary. Data compressed with it can
+     * only be uncompressed with the same dictionary.
+     */
+    virtual shared_ptr<compressor> with_dictionary(bytes_view dict) const;
+
     /**
      * Compressor class name.
      */
@@ -355,6 +355,7 @@ scylla_tests = set([
     'test/boost/auth_test',
     'test/boost/batchlog_manager_test',
     'test/boost/big_decimal_test',
+    'test/boost/bloom_filter_test',
     'test/boost/broken_sstable_test',
     'test/boost/bytes_ostream_test',
     'test/boost/cache_flat_mutation_reader_test',
@@ -459,6 +460,9 @@ scylla_tests = set([
     'test/boost/sstable_datafile_test',
     'test/boost/sstable_mutation_test',
     'test/boost/sstable_partition_index_cache_test',
+    'test/boost/sstable_partition_trie_test',
+    'test/boost/sstable_row_trie_test',
+    'test/boost/sstable_zone_map_test',
     'test/boost/schema_changes_test',
     'test/boost/sstable_conforms_to_mutation_source_test',
     'test/boost/sstable_compaction_test',
@@ -723,6 +727,10 @@ scylla_core = (['message/messaging_service.cc',
                 'sstables/mx/reader.cc',
                 'sstables/mx/writer.cc',
                 'sstables/kl/reader.cc',
+                'sstables/partition_trie.cc',
+                'sstables/row_trie.cc',
+                'sstables/zone_map.cc',
+                'sstables/trie.cc',
                 'sstables/sstable_version.cc',
                 'sstables/compress.cc',
                 'sstables/sstable_mutation_reader.cc',
@@ -731,6 +739,7 @@ scylla_core = (['message/messaging_service.cc',
                 'compaction/size_tiered_compaction_strategy.cc',
                 'compaction/leveled_compaction_strategy.cc',
                 'compaction/time_window_compaction_strategy.cc',
+                'compaction/incremental_compaction_strategy.cc',
                 'compaction/compaction_manager.cc',
                 'sstables/integrity_checked_file_impl.cc',
                 'sstables/prepended_input_stream.cc',
@@ -889,6 +898,7 @@ scylla_core = (['message/messaging_service.cc',
                 'db/large_data_handler.cc',
                 'db/marshal/type_parser.cc',
                 'db/batchlog_manager.cc',
+                'db/cache_warmer.cc',
                 'db/tags/utils.cc',
                 'db/view/view.cc',
                 'db/view/view_update_generator.cc',
@@ -897,11 +907,13 @@ scylla_core = (['message/messaging_service.cc',
                 'db/snapshot-ctl.cc',
                 'db/rate_limiter.cc',
                 'db/per_partition_rate_limit_options.cc',
+                'db/sstable_filter_options.cc',
                 'index/secondary_index_manager.cc',
                 'index/secondary_index.cc',
                 'utils/UUID_gen.cc',
                 'utils/i_filter.cc',
                 'utils/bloom_filter.cc',
+                'utils/xor_filter.cc',
                 'utils/bloom_calculations.cc',
                 'utils/rate_limiter.cc',
                 'utils/file_lock.cc',
@@ -1022,6 +1034,7 @@ scylla_core = (['message/messaging_service.cc',
                 'mutation_writer/timestamp_based_splitting_writer.cc',
                 'mutation_writer/shard_based_splitting_writer.cc',
                 'mutation_writer/partition_based_splitting_writer.cc',
+                'mutation_writer/token_group_based_splitting_writer.cc',
                 'mutation_writer/feed_writers.cc',
                 'lang/lua.cc',
                 'lang/wasm.cc',
@@ -20,6 +20,7 @@
 #include "tombstone_gc.hh"
 #include "db/per_partition_rate_limit_extension.hh"
 #include "db/per_partition_rate_limit_options.hh"
+#include "db/sstable_filter_extension.hh"
 #include "utils/bloom_calculations.hh"
 
 #include <boost/algorithm/string/predicate.hpp>
@@ -108,6 +109,9 @@ void cf_prop_defs::validate(const data_dictionary::database db, sstring ks_name,
         }
         _compaction_strategy_class = sstables::compaction_strategy::type(strategy->second);
         remove_from_map_if_exists(KW_COMPACTION, COMPACTION_STRATEGY_CLASS_KEY);
+        if (*_compaction_strategy_class == sstables::compaction_strategy_type::incremental && !db.features().incremental_compaction_strategy) {
+            throw exceptions::configuration_exception("IncrementalCompactionStrategy is not supported yet by the whole cluster");
+        }
 
 #if 0
        CFMetaData.validateCompactionOptions(compactionStrategyClass, compactionOptions);
@@ -122,11 +126,18 @@ void cf_prop_defs::validate(const data_dictionary::database db, sstring ks_name,
         }
         compression_parameters cp(*compression_options);
         cp.validate();
+        if (cp.get_compressor() && cp.get_compressor()->dictionary_size() && !db.features().compression_dictionary) {
+            throw exceptions::configuration_exception("Compression dictionaries are not supported yet by the whole cluster");
+        }
     }
 
     if (auto caching_options = get_caching_options(); caching_options && !caching_options->enabled() && !db.features().per_table_caching) {
         throw exceptions::configuration_exception(KW_CACHING + " can't contain \"'enabled':false\" unless whole cluster supports it");
     }
+    if (auto caching_options = get_caching_options(); caching_options && !db.features().row_cache_quotas
+            && (caching_options->max_partitions() || caching_options->priority() != ::caching_options::priority_class::normal)) {
+        throw exceptions::configuration_exception(KW_CACHING + " can't contain 'max_partitions' or 'priority' unless whole cluster supports it");
+    }
 
     auto cdc_options = get_cdc_options(schema_extensions);
     if (cdc_options && cdc_options->enabled() && !db.features().cdc) {
@@ -141,6 +152,14 @@ void cf_prop_defs::validate(const data_dictionary::database db, sstring ks_name,
     auto tombstone_gc_options = get_tombstone_gc_options(schema_extensions);
     validate_tombstone_gc_options(tombstone_gc_options, db, ks_name);
 
+    auto sstable_filter_options = get_sstable_filter_options(schema_extensions);
+    if (sstable_filter_options && sstable_filter_options->type() == db::sstable_filter_type::split_block_bloom && !db.features().split_block_bloom_filter) {
+        throw exceptions::configuration_exception("Split-block bloom filters are not supported yet by the whole cluster");
+    }
+    if (sstable_filter_options && sstable_filter_options->type() == db::sstable_filter_type::xor_filter && !db.features().xor_sstable_filter) {
+        throw exceptions::configuration_exception("Xor filters are not supported yet by the whole cluster");
+    }
+
     validate_minimum_int(KW_DEFAULT_TIME_TO_LIVE, 0, DEFAULT_DEFAULT_TIME_TO_LIVE);
     validate_minimum_int(KW_PAXOSGRACESECONDS, 0, DEFAULT_GC_GRACE_SECONDS);
 
@@ -254,6 +273,16 @@ const db::per_partition_rate_limit_options* cf_prop_defs::get_per_partition_rate
     return &ext->get_options();
 }
 
+const db::sstable_filter_options* cf_prop_defs::get_sstable_filter_options(const schema::extensions_map& schema_exts) const {
+    auto it = schema_exts.find(db::sstable_filter_extension::NAME);
+    if (it == schema_exts.end()) {
+        return nullptr;
+    }
+
+    auto ext = dynamic_pointer_cast<db::sstable_filter_extension>(it->second);
+    return &ext->get_options();
+}
+
 void cf_prop_defs::apply_to_builder(schema_builder& builder, schema::extensions_map schema_extensions) const {
     if (has_property(KW_COMMENT)) {
         builder.set_comment(get_string(KW_COMMENT, ""));
@@ -45,6 +45,7 @@
 #include "utils/result.hh"
 #include "utils/result_combinators.hh"
 #include "utils/result_loop.hh"
+#include "utils/overloaded_functor.hh"
 
 template<typename T = void>
 using coordinator_result = cql3::statements::select_statement::coordinator_result<T>;
@@ -263,7 +264,57 @@ select_statement::make_partition_slice(const query_options& options) const
         ++_stats.reverse_queries;
     }
     return query::partition_slice(std::move(bounds),
-        std::move(static_columns), std::move(regular_columns), _opts, nullptr, options.get_cql_serialization_format(), get_per_partition_limit(options));
+        std::move(static_columns), std::move(regular_columns), _opts, nullptr, options.get_cql_serialization_format(), get_per_partition_limit(options),
+        make_value_ranges(options));
+}
+
+// Value ranges which filtered rows have to match, for replicas to skip
+// rows which cannot (see query::column_value_range).
+//
+// Replicas which skip rows return less than those which don't, so their
+// results are only comparable with each other at consistency level ONE,
+// where a single replica answers.
+std::vector<query::column_value_range>
+select_statement::make_value_ranges(const query_options& options) const {
+    std::vector<query::column_value_range> ranges;
+    auto cl = options.get_consistency();
+    if (!_restrictions_need_filtering || (cl != db::consistency_level::ONE && cl != db::consistency_level::LOCAL_ONE)) {
+        return ranges;
+    }
+    for (auto&& [cdef, restriction] : _restrictions->get_non_pk_restriction()) {
+        if (!cdef->is_regular() || !cdef->is_atomic()) {
+            continue;
+        }
+        bool unsupported = expr::find_binop(restriction, [cdef] (const expr::binary_operator& op) {
+            auto col = expr::as_if<expr::column_value>(&op.lhs);
+            return !col || col->col != cdef || !(op.op == expr::oper_t::EQ || op.op == expr::oper_t::IN || expr::is_slice(op.op));
+        });
+        if (unsupported) {
+            continue;
+        }
+        std::optional<nonwrapping_range<bytes>> range = std::visit(overloaded_functor{
+            [] (const expr::value_list& values) -> std::optional<nonwrapping_range<bytes>> {
+                // Lists are sorted, an empty one leaves it to the filtering to drop all rows.
+                if (values.empty()) {
+                    return std::nullopt;
+                }
+                if (values.size() == 1) {
+                    return nonwrapping_range<bytes>::make_singular(to_bytes(values.front()));
+                }
+                return nonwrapping_range<bytes>({to_bytes(values.front())}, {to_bytes(values.back())});
+            },
+            [] (const nonwrapping_range<managed_bytes>& r) -> std::optional<nonwrapping_range<bytes>> {
+                if (!r.start() && !r.end()) {
+                    return std::nullopt;
+                }
+                return r.transform([] (const managed_bytes& v) { return to_bytes(v); });
+            }
+        }, expr::possible_lhs_values(cdef, restriction, options));
+        if (range) {
+            ranges.push_back(query::column_value_range{cdef->id, std::move(*range)});
+        }
+    }
+    return ranges;
 }
 
 uint64_t select_statement::do_get_limit(const query_options& options,
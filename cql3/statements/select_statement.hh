@@ -134,6 +134,8 @@ protected :
 
     query::partition_slice make_partition_slice(const query_options& options) const;
 
+    std::vector<query::column_value_range> make_value_ranges(const query_options& options) const;
+
     const ::shared_ptr<const restrictions::statement_restrictions> get_restrictions() const;
 
     bool has_group_by() const { return _group_by_cell_indices && !_group_by_cell_indices->empty(); }
@@ -9,15 +9,27 @@
 #pragma once
 
 #include "utils/lru.hh"
+#include "utils/frequency_sketch.hh"
 #include "utils/logalloc.hh"
 #include "partition_version.hh"
 #include "mutation_cleaner.hh"
+#include "caching_options.hh"
+#include "schema_fwd.hh"
 
 #include <seastar/core/metrics_registration.hh>
+#include <seastar/core/shared_ptr.hh>
+
+#include <boost/intrusive/list.hpp>
 
 #include <stdint.h>
+#include <unordered_map>
 
 class cache_entry;
+class absent_partition_keys;
+
+namespace dht {
+class decorated_key;
+}
 
 namespace cache {
 
@@ -30,6 +42,22 @@ class lsa_manager;
 }
 
 // Tracks accesses and performs eviction of cache entries.
+// Links an entry of absent_partition_keys (see row_cache.hh) into the list of
+// the entries of all caches of a tracker, in the order of insertion.
+class absent_partition_key_link {
+    using hook_type = boost::intrusive::list_member_hook<boost::intrusive::link_mode<boost::intrusive::auto_unlink>>;
+    hook_type _link;
+    absent_partition_keys* _owner;
+    friend class absent_partition_keys;
+    friend class cache_tracker;
+public:
+    using list_type = boost::intrusive::list<absent_partition_key_link,
+        boost::intrusive::member_hook<absent_partition_key_link, hook_type, &absent_partition_key_link::_link>,
+        boost::intrusive::constant_time_size<false>>;
+
+    explicit absent_partition_key_link(absent_partition_keys* owner) noexcept : _owner(owner) {}
+};
+
 class cache_tracker final {
 public:
     friend class row_cache;
@@ -66,12 +94,31 @@ class cache_tracker final {
         uint64_t pinned_dirty_memory_overload;
         uint64_t range_tombstone_reads;
         uint64_t row_tombstone_reads;
+        uint64_t admission_rejects;
+        uint64_t absent_partition_hits;
+        uint64_t partition_demotions;
+        uint64_t partition_promotions;
 
         uint64_t active_reads() const {
             return reads - reads_done;
         }
     };
+    // Decides which partitions missing in cache are inserted by the reads which miss them.
+    enum class admission_policy {
+        all,     // every partition
+        tinylfu, // while the cache evicts, only partitions read recently enough (see utils::frequency_sketch)
+    };
+    // Occupancy of the cache by the partitions of a single table.
+    // Shared by the table's row_cache and the tracker, which needs it on eviction.
+    struct table_stats {
+        uint64_t partitions = 0;
+        uint64_t quota_rejects = 0;
+    };
 private:
+    // Counters per row of the access sketch of the tinylfu policy
+    static constexpr size_t sketch_counters = 1 << 17;
+    // Partition accesses per sample when there is no sketch to age
+    static constexpr uint64_t accesses_per_sample = 10 * sketch_counters;
     stats _stats{};
     seastar::metrics::metric_groups _metrics;
     logalloc::region _region;
@@ -79,8 +126,26 @@ class cache_tracker final {
     mutation_cleaner _garbage;
     mutation_cleaner _memtable_cleaner;
     mutation_application_stats& _app_stats;
+    admission_policy _admission_policy = admission_policy::all;
+    std::unique_ptr<utils::frequency_sketch> _sketch;
+    // Row evictions at the start of the current sample of accesses (the
+    // sample of the sketch with tinylfu), and whether there were any during
+    // the previous one.
+    uint64_t _row_evictions_at_sample_start = 0;
+    bool _evicted_in_previous_sample = false;
+    uint64_t _accesses_in_sample = 0;
+    std::unordered_map<table_id, lw_shared_ptr<table_stats>> _tables;
+    // Memory of the keys which caches remember as absent, see absent_partition_keys.
+    size_t _max_absent_keys_memory = 0;
+    size_t _absent_keys_memory = 0;
+    absent_partition_key_link::list_type _absent_keys;
+    // Memory of the partitions which caches keep in their cold tier, see cold_partitions.
+    size_t _max_cold_tier_memory = 0;
+    size_t _cold_tier_memory = 0;
 private:
     void setup_metrics();
+    void record_access(const dht::decorated_key&) noexcept;
+    table_stats* find_table_stats(const cache_entry&) noexcept;
 public:
     using register_metrics = bool_class<class register_metrics_tag>;
     cache_tracker(mutation_application_stats&, register_metrics);
@@ -94,11 +159,47 @@ class cache_tracker final {
     void insert(rows_entry&) noexcept;
     void remove(rows_entry&) noexcept;
     void clear_continuity(cache_entry& ce) noexcept;
-    void on_partition_erase() noexcept;
+    void on_partition_erase(const cache_entry&) noexcept;
     void on_partition_merge() noexcept;
-    void on_partition_hit() noexcept;
-    void on_partition_miss() noexcept;
-    void on_partition_eviction() noexcept;
+    void on_partition_hit(const dht::decorated_key&) noexcept;
+    void on_partition_miss(const dht::decorated_key&) noexcept;
+    // Tells whether a read which missed the partition of a table with given
+    // priority should insert it.
+    // Call after on_partition_miss() for the same partition.
+    bool admit(const dht::decorated_key&, caching_options::priority_class = caching_options::priority_class::normal) noexcept;
+    void set_admission_policy(admission_policy);
+    admission_policy get_admission_policy() const noexcept { return _admission_policy; }
+    // Estimated number of recent reads of the partition, 0 unless the
+    // admission policy counts them.
+    unsigned reads_of(const dht::decorated_key&) const noexcept;
+    // Whether rows were evicted recently, i.e. whether inserting evicts.
+    bool evicting() const noexcept;
+    // Starts accounting partitions of the table with given id in the returned object.
+    // Caches of the same table share it.
+    lw_shared_ptr<table_stats> register_table(table_id);
+    // Stops accounting partitions of the table unless other caches of it
+    // still hold its table_stats.
+    void unregister_table(table_id) noexcept;
+    // Limits the memory of the keys of partitions known to be absent from
+    // the underlying source which all caches remember, 0 disables them.
+    void set_max_absent_keys_memory(size_t bytes) noexcept { _max_absent_keys_memory = bytes; }
+    size_t max_absent_keys_memory() const noexcept { return _max_absent_keys_memory; }
+    size_t absent_keys_memory() const noexcept { return _absent_keys_memory; }
+    // Accounts an entry taking given memory as the newest one, and erases
+    // the oldest entries of any cache to stay within max_absent_keys_memory().
+    void on_absent_key_insert(absent_partition_key_link&, size_t bytes) noexcept;
+    void on_absent_key_erase(absent_partition_key_link&, size_t bytes) noexcept;
+    void on_absent_partition_hit() noexcept { ++_stats.absent_partition_hits; }
+    // Limits the memory of the cold partitions which all caches keep
+    // compressed instead of evicting them, 0 disables the cold tier.
+    void set_max_cold_tier_memory(size_t bytes) noexcept { _max_cold_tier_memory = bytes; }
+    size_t max_cold_tier_memory() const noexcept { return _max_cold_tier_memory; }
+    size_t cold_tier_memory() const noexcept { return _cold_tier_memory; }
+    void on_cold_tier_insert(size_t bytes) noexcept { _cold_tier_memory += bytes; }
+    void on_cold_tier_erase(size_t bytes) noexcept { _cold_tier_memory -= bytes; }
+    void on_partition_demotion() noexcept { ++_stats.partition_demotions; }
+    void on_partition_promotion() noexcept { ++_stats.partition_promotions; }
+    void on_partition_eviction(const cache_entry&) noexcept;
     void on_row_eviction() noexcept;
     void on_row_hit() noexcept;
     void on_dummy_row_hit() noexcept;
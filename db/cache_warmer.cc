@@ -0,0 +1,296 @@
+/*
+ * Copyright (C) 2022-present ScyllaDB
+ */
+
+/*
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include <charconv>
+
+#include <seastar/core/coroutine.hh>
+#include <seastar/core/fstream.hh>
+#include <seastar/core/seastar.hh>
+#include <seastar/core/sleep.hh>
+
+#include "db/cache_warmer.hh"
+#include "replica/database.hh"
+#include "service/priority_manager.hh"
+#include "utils/lister.hh"
+#include "log.hh"
+
+static logging::logger cwlogger("cache_warmer");
+
+namespace db {
+
+static constexpr auto file_prefix = "row_cache_keys-";
+
+cache_warmer::cache_warmer(replica::database& db, config cfg)
+    : _db(db)
+    , _cfg(std::move(cfg))
+{ }
+
+sstring cache_warmer::file_name(unsigned shard) const {
+    return format("{}/{}{}.txt", _cfg.directory, file_prefix, shard);
+}
+
+future<> cache_warmer::start() {
+    if (_cfg.save_period.count()) {
+        _done = with_scheduling_group(_cfg.scheduling_group, [this] { return run(); });
+    }
+    return make_ready_future<>();
+}
+
+future<> cache_warmer::stop() {
+    if (!_cfg.save_period.count()) {
+        co_return;
+    }
+    _as.request_abort();
+    co_await std::exchange(_done, make_ready_future<>());
+    // Save the freshest keys for the restart which likely follows.
+    try {
+        co_await with_scheduling_group(_cfg.scheduling_group, [this] { return save(); });
+    } catch (...) {
+        cwlogger.warn("Failed to save row cache keys on shutdown: {}", std::current_exception());
+    }
+}
+
+future<> cache_warmer::run() {
+    try {
+        auto loaded = co_await load();
+        cwlogger.info("Read {} saved partitions into the row cache", loaded);
+    } catch (const seastar::sleep_aborted&) {
+        co_return;
+    } catch (const seastar::abort_requested_exception&) {
+        co_return;
+    } catch (...) {
+        cwlogger.warn("Failed to read saved partitions into the row cache: {}", std::current_exception());
+    }
+    while (!_as.abort_requested()) {
+        try {
+            co_await sleep_abortable(_cfg.save_period, _as);
+            co_await save();
+        } catch (const seastar::sleep_aborted&) {
+        } catch (...) {
+            cwlogger.warn("Failed to save row cache keys: {}", std::current_exception());
+        }
+    }
+}
+
+future<> cache_warmer::save() {
+    std::vector<lw_shared_ptr<replica::table>> tables;
+    for (auto& [id, t] : _db.get_column_families()) {
+        if (t->cache_enabled()) {
+            tables.push_back(t);
+        }
+    }
+
+    auto name = file_name(this_shard_id());
+    auto tmp_name = name + ".tmp";
+    co_await touch_directory(_cfg.directory);
+    auto f = co_await open_file_dma(tmp_name, open_flags::wo | open_flags::create | open_flags::truncate);
+    auto out = co_await make_file_output_stream(std::move(f));
+    size_t saved = 0;
+    std::exception_ptr ex;
+    try {
+        for (auto& t : tables) {
+            auto keys = co_await t->get_row_cache().hot_keys(_cfg.keys_to_save);
+            auto id = t->schema()->id().to_sstring();
+            for (auto& dk : keys) {
+                co_await out.write(format("{} {}\n", id, to_hex(dk.key().representation())));
+            }
+            saved += keys.size();
+        }
+        co_await out.flush();
+    } catch (...) {
+        ex = std::current_exception();
+    }
+    co_await out.close();
+    if (ex) {
+        co_await remove_file(tmp_name);
+        std::rethrow_exception(std::move(ex));
+    }
+    co_await rename_file(tmp_name, name);
+    co_await sync_directory(_cfg.directory);
+    cwlogger.debug("Saved {} row cache keys to {}", saved, name);
+}
+
+struct cache_warmer::saved_key {
+    table_id table;
+    dht::decorated_key key;
+};
+
+// Calls func on every non-empty line of in, without the line terminator,
+// reading the stream a buffer at a time.
+static future<> for_each_line(input_stream<char>& in, noncopyable_function<future<> (std::string_view)> func) {
+    sstring partial;
+    while (true) {
+        auto buf = co_await in.read();
+        if (buf.empty()) {
+            break;
+        }
+        std::string_view data(buf.get(), buf.size());
+        for (auto nl = data.find('\n'); nl != std::string_view::npos; nl = data.find('\n')) {
+            auto line = data.substr(0, nl);
+            data.remove_prefix(nl + 1);
+            if (!partial.empty()) {
+                partial.append(line.data(), line.size());
+                auto whole = std::exchange(partial, sstring());
+                co_await func(whole);
+            } else if (!line.empty()) {
+                co_await func(line);
+            }
+        }
+        partial.append(data.data(), data.size());
+    }
+    if (!partial.empty()) {
+        co_await func(partial);
+    }
+}
+
+future<size_t> cache_warmer::load() {
+    if (!co_await file_exists(_cfg.directory)) {
+        co_return 0;
+    }
+    // The file of shard N is read by shard N modulo the shard count, so the
+    // files of shards which no longer exist are read exactly once too.
+    std::vector<std::pair<unsigned, sstring>> files;
+    co_await lister::scan_dir(fs::path(_cfg.directory), lister::dir_entry_types::of<directory_entry_type::regular>(),
+            [&files] (fs::path dir, directory_entry de) {
+        std::string_view name(de.name);
+        if (name.starts_with(file_prefix) && name.ends_with(".txt")) {
+            name.remove_prefix(std::string_view(file_prefix).size());
+            name.remove_suffix(std::string_view(".txt").size());
+            unsigned shard;
+            auto [end, ec] = std::from_chars(name.data(), name.data() + name.size(), shard);
+            if (ec == std::errc() && end == name.data() + name.size() && shard % smp::count == this_shard_id()) {
+                files.emplace_back(shard, (dir / de.name.c_str()).native());
+            }
+        }
+        return make_ready_future<>();
+    });
+
+    size_t loaded = 0;
+    for (auto& [shard, file] : files) {
+        loaded += co_await load_file(file);
+        if (_as.abort_requested()) {
+            co_return loaded;
+        }
+        if (shard >= smp::count) {
+            co_await remove_file(file);
+            co_await sync_directory(_cfg.directory);
+            cwlogger.info("Removed {}, left by a shard which no longer exists", file);
+        }
+    }
+    co_return loaded;
+}
+
+future<size_t> cache_warmer::load_file(sstring name) {
+    static constexpr size_t batch_size = 128;
+
+    std::vector<std::vector<saved_key>> batches(smp::count);
+    size_t loaded = 0;
+    auto flush = [this, &batches, &loaded] (unsigned shard) -> future<> {
+        auto batch = std::exchange(batches[shard], {});
+        loaded += co_await container().invoke_on(shard, [batch = std::move(batch)] (cache_warmer& w) mutable {
+            return with_scheduling_group(w._cfg.scheduling_group, [&w, batch = std::move(batch)] () mutable {
+                return w.populate(std::move(batch));
+            });
+        });
+    };
+
+    auto f = co_await open_file_dma(name, open_flags::ro);
+    auto in = make_file_input_stream(std::move(f));
+    std::exception_ptr ex;
+    try {
+        co_await for_each_line(in, [&] (std::string_view line) -> future<> {
+            if (_as.abort_requested()) {
+                return make_ready_future<>();
+            }
+            auto sep = line.find(' ');
+            if (sep == std::string_view::npos) {
+                return make_ready_future<>();
+            }
+            std::optional<saved_key> sk;
+            unsigned owner;
+            try {
+                auto& tables = _db.get_column_families();
+                auto it = tables.find(table_id(utils::UUID(line.substr(0, sep))));
+                if (it == tables.end() || !it->second->cache_enabled()) {
+                    return make_ready_future<>();
+                }
+                auto& s = *it->second->schema();
+                auto dk = dht::decorate_key(s, partition_key::from_bytes(from_hex(line.substr(sep + 1))));
+                owner = s.get_sharder().shard_of(dk.token());
+                sk.emplace(saved_key{it->first, std::move(dk)});
+            } catch (...) {
+                cwlogger.debug("Skipping invalid line in {}: {}", name, std::current_exception());
+                return make_ready_future<>();
+            }
+            batches[owner].push_back(std::move(*sk));
+            if (batches[owner].size() < batch_size) {
+                return make_ready_future<>();
+            }
+            return flush(owner);
+        });
+        for (unsigned shard = 0; shard < smp::count; ++shard) {
+            if (!batches[shard].empty() && !_as.abort_requested()) {
+                co_await flush(shard);
+            }
+        }
+    } catch (...) {
+        ex = std::current_exception();
+    }
+    co_await in.close();
+    if (ex) {
+        std::rethrow_exception(std::move(ex));
+    }
+    co_return loaded;
+}
+
+future<size_t> cache_warmer::populate(std::vector<saved_key> keys) {
+    using clock = lowres_clock;
+    if (!_loaded) {
+        _load_start = clock::now();
+    }
+    size_t loaded = 0;
+    for (auto& [id, dk] : keys) {
+        // Throws, so that the shard reading the file does not take it as read.
+        _as.check();
+        auto& tables = _db.get_column_families();
+        auto it = tables.find(id);
+        if (it == tables.end()) {
+            continue;
+        }
+        auto t = it->second;
+        auto s = t->schema();
+        auto permit = co_await _db.streaming_read_concurrency_semaphore().obtain_permit(s.get(), "cache-warmer",
+                t->estimate_read_memory_cost(), db::no_timeout);
+        auto pr = dht::partition_range::make_singular(dk);
+        // Reading the partition through the cache populates it.
+        auto reader = t->make_reader_v2(s, std::move(permit), pr, s->full_slice(), service::get_local_streaming_priority());
+        std::exception_ptr ex;
+        try {
+            co_await reader.consume_pausable([] (mutation_fragment_v2) { return stop_iteration::no; });
+        } catch (...) {
+            ex = std::current_exception();
+        }
+        co_await reader.close();
+        if (ex) {
+            cwlogger.debug("Failed to read partition {} of {}.{}: {}", dk, s->ks_name(), s->cf_name(), ex);
+            continue;
+        }
+        ++loaded;
+        ++_loaded;
+
+        if (_cfg.load_rate) {
+            auto due = _load_start + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(double(_loaded) / _cfg.load_rate));
+            if (due > clock::now()) {
+                co_await sleep_abortable(due - clock::now(), _as);
+            }
+        }
+    }
+    co_return loaded;
+}
+
+}
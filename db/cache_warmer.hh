@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2022-present ScyllaDB
+ */
+
+/*
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <seastar/core/abort_source.hh>
+#include <seastar/core/future.hh>
+#include <seastar/core/lowres_clock.hh>
+#include <seastar/core/scheduling.hh>
+#include <seastar/core/sharded.hh>
+#include <seastar/core/sstring.hh>
+
+#include <chrono>
+#include <vector>
+
+#include "seastarx.hh"
+
+namespace replica {
+class database;
+}
+
+namespace db {
+
+// Keeps the row cache of a restarted node from starting out empty.
+//
+// Every save period, each shard writes the keys of the partitions in the
+// row caches of its tables to a file in the saved caches directory. On start,
+// the partitions of the saved keys are read through the cache in the
+// background, at a limited rate. Every shard reads its own file, and the files
+// of shards which no longer exist, and forwards each key to the shard that owns
+// it, so the number of shards may change across restarts.
+class cache_warmer : public peering_sharded_service<cache_warmer> {
+public:
+    struct config {
+        sstring directory;
+        // 0 disables saving and loading
+        std::chrono::seconds save_period;
+        // Per table, 0 for all
+        size_t keys_to_save = 0;
+        // Partitions per second and shard, 0 for unlimited
+        uint32_t load_rate = 0;
+        seastar::scheduling_group scheduling_group;
+    };
+private:
+    replica::database& _db;
+    config _cfg;
+    seastar::abort_source _as;
+    future<> _done = make_ready_future<>();
+    // Rate limiting of the partitions read by this shard.
+    lowres_clock::time_point _load_start;
+    size_t _loaded = 0;
+public:
+    cache_warmer(replica::database&, config);
+
+    // Starts loading the saved partitions, and then saving the keys
+    // periodically, in the background.
+    future<> start();
+    future<> stop();
+
+    // Saves the keys of the partitions cached by this shard.
+    future<> save();
+    // Reads the saved keys of the files assigned to this shard, and the
+    // partitions of those keys into the row caches of the owning shards.
+    // Resolves to the number of partitions read. The files of shards which
+    // no longer exist are removed once read.
+    future<size_t> load();
+private:
+    struct saved_key;
+
+    sstring file_name(unsigned shard) const;
+    future<> run();
+    future<size_t> load_file(sstring name);
+    // Reads the partitions of keys owned by this shard into the row cache.
+    future<size_t> populate(std::vector<saved_key>);
+};
+
+}
@@ -24,6 +24,7 @@
 #include "cdc/cdc_extension.hh"
 #include "tombstone_gc_extension.hh"
 #include "db/per_partition_rate_limit_extension.hh"
+#include "db/sstable_filter_extension.hh"
 #include "config.hh"
 #include "extensions.hh"
 #include "log.hh"
@@ -283,6 +284,12 @@ db::config::config(std::shared_ptr<db::extensions> exts)
         "If set to higher than 0, ignore the controller's output and set the compaction shares statically. Do not set this unless you know what you are doing and suspect a problem in the controller. This option will be retired when the controller reaches more maturity")
     , compaction_enforce_min_threshold(this, "compaction_enforce_min_threshold", liveness::LiveUpdate, value_status::Used, false,
         "If set to true, enforce the min_threshold option for compactions strictly. If false (default), Scylla may decide to compact even if below min_threshold")
+    , compaction_parallel_sub_ranges(this, "compaction_parallel_sub_ranges", liveness::LiveUpdate, value_status::Used, 1,
+        "Major compactions and cleanups split their input into this many disjoint token ranges, which are compacted in parallel, each to its own sstables. Values above 1 keep more reads and writes in flight, which speeds up such compactions on fast disks, at the cost of releasing input sstables only at the end of the compaction. Compactions of run-based strategies (leveled, incremental) release exhausted input sstables as they go, so they are never split.")
+    , sstable_token_ranges_per_shard(this, "sstable_token_ranges_per_shard", liveness::LiveUpdate, value_status::Used, 0,
+        "If set above 0, the range a shard owns in each of the 2^murmur3_partitioner_ignore_msb_bits round trips around the shards is split into this many parts of the same width, and the parts at the same position in all round trips form a group. sstables written by flushes, and by compactions which don't write runs of disjoint sstables (all but those of LeveledCompactionStrategy and IncrementalCompactionStrategy), never span two groups, so a flush writes up to this many sstables per shard at a time. When the number of shards changes to N, at most N - 1 of all groups overlap more than one shard, so most sstables still belong to a single shard and are moved to their new owner instead of being resharded. 0 (default) disables the splitting.")
+    , compaction_read_latency_target_in_ms(this, "compaction_read_latency_target_in_ms", liveness::LiveUpdate, value_status::Used, 0,
+        "If set above 0, compaction shares are lowered while the 99th percentile latency of the reads a shard serves to queries (data, digest and mutation reads, but not those of streaming, repair or view building) is above this target, or reads start queueing up for admission, and are restored gradually once it is met again. The more compaction backlog, the less compaction is slowed down, so the backlog stays bounded. Ignored when compaction_static_shares is set. 0 (default) disables it.")
     /* Initialization properties */
     /* The minimal properties needed for configuring a cluster. */
     , cluster_name(this, "cluster_name", value_status::Used, "",
@@ -309,7 +316,7 @@ db::config::config(std::shared_ptr<db::extensions> exts)
         "The directory where hints files are stored if hinted handoff is enabled.")
     , view_hints_directory(this, "view_hints_directory", value_status::Used, "",
         "The directory where materialized-view updates are stored while a view replica is unreachable.")
-    , saved_caches_directory(this, "saved_caches_directory", value_status::Unused, "",
+    , saved_caches_directory(this, "saved_caches_directory", value_status::Used, "",
         "The directory location where table key and row caches are stored.")
     /* Commonly used properties */
     /* Properties most frequently used when configuring Scylla. */
@@ -535,12 +542,14 @@ db::config::config(std::shared_ptr<db::extensions> exts)
     , key_cache_size_in_mb(this, "key_cache_size_in_mb", value_status::Unused, 100,
         "A global cache setting for tables. It is the maximum size of the key cache in memory. To disable set to 0.\n"
         "Related information: nodetool setcachecapacity.")
-    , row_cache_keys_to_save(this, "row_cache_keys_to_save", value_status::Unused, 0,
-        "Number of keys from the row cache to save.")
+    , row_cache_keys_to_save(this, "row_cache_keys_to_save", value_status::Used, 0,
+        "Number of keys from the row cache to save, per table and shard. The most often read partitions are saved first when cache_admission_policy is 'tinylfu'. (0: all)")
     , row_cache_size_in_mb(this, "row_cache_size_in_mb", value_status::Unused, 0,
         "Maximum size of the row cache in memory. Row cache can save more time than key_cache_size_in_mb, but is space-intensive because it contains the entire row. Use the row cache only for hot rows or static rows. If you reduce the size, you may not get you hottest keys loaded on start up.")
-    , row_cache_save_period(this, "row_cache_save_period", value_status::Unused, 0,
-        "Duration in seconds that rows are saved in cache. Caches are saved to saved_caches_directory.")
+    , row_cache_save_period(this, "row_cache_save_period", value_status::Used, 0,
+        "Interval in seconds between saves of the keys of partitions in the row cache to saved_caches_directory. On startup, the saved partitions are read back into the row cache in the background. (0: disabled)")
+    , row_cache_load_rate(this, "row_cache_load_rate", value_status::Used, 1000,
+        "Maximum number of saved partitions per second each shard reads into the row cache on startup. (0: unlimited)")
     , memory_allocator(this, "memory_allocator", value_status::Invalid, "NativeAllocator",
         "The off-heap memory allocator. In addition to caches, this property affects storage engine meta data. Supported values:\n"
         "\tNativeAllocator\n"
@@ -778,6 +787,14 @@ db::config::config(std::shared_ptr<db::extensions> exts)
         "The SSL port for encrypted communication. Unused unless enabled in encryption_options.")
     , enable_in_memory_data_store(this, "enable_in_memory_data_store", value_status::Used, false, "Enable in memory mode (system tables are always persisted)")
     , enable_cache(this, "enable_cache", value_status::Used, true, "Enable cache")
+    , cache_admission_policy(this, "cache_admission_policy", value_status::Used, "all", "Which partitions missing in the row cache are inserted by the reads which miss them."
+        " 'all' inserts every partition. 'tinylfu' inserts, once the cache is full, only partitions read at least twice recently,"
+        " so that scans and repair reads do not evict the working set.", {"all", "tinylfu"})
+    , cache_absent_partition_keys_size_in_mb(this, "cache_absent_partition_keys_size_in_mb", value_status::Used, 1, "Memory per shard, in MB, in which the row cache remembers the keys of partitions absent from sstables,"
+        " when it does not insert them because of the admission policy or the table's quota, so that reading them again does not go to sstables."
+        " The oldest keys of any table are dropped first. (0: disabled)")
+    , cache_cold_tier_size_in_mb(this, "cache_cold_tier_size_in_mb", value_status::Used, 0, "Memory per shard, in MB, in which the row cache keeps least recently used partitions compressed"
+        " when it needs room for new ones, instead of evicting them, so that reading them again does not go to sstables. (0: disabled)")
     , enable_commitlog(this, "enable_commitlog", value_status::Used, true, "Enable commitlog")
     , volatile_system_keyspace_for_testing(this, "volatile_system_keyspace_for_testing", value_status::Used, false, "Don't persist system keyspace - testing only!")
     , api_port(this, "api_port", value_status::Used, 10000, "Http Rest API port")
@@ -805,6 +822,14 @@ db::config::config(std::shared_ptr<db::extensions> exts)
     , experimental(this, "experimental", value_status::Used, false, "[Deprecated] Set to true to unlock all experimental features (except 'raft' feature, which should be enabled explicitly via 'experimental-features' option). Please use 'experimental-features', instead.")
     , experimental_features(this, "experimental_features", value_status::Used, {}, experimental_features_help_string())
     , lsa_reclamation_step(this, "lsa_reclamation_step", value_status::Used, 1, "Minimum number of segments to reclaim in a single step")
+    , lsa_huge_pages(this, "lsa_huge_pages", value_status::Used, false, "Advise the kernel to back the memory of LSA segments (the row cache and memtables) with transparent huge pages, to reduce TLB misses."
+        " In release builds, which use the seastar allocator, only this advice applies: the shard's memory is mapped by seastar,"
+        " so the segments can't be mapped from reserved huge pages. Use the --hugepages option to back all memory, segments included,"
+        " with huge pages reserved in advance."
+        " In builds using the standard allocator (debug, sanitize), maps the segments from reserved huge pages when there are enough of them.")
+    , lsa_background_reclaim_free_memory_in_mb(this, "lsa_background_reclaim_free_memory_in_mb", value_status::Used, 60, "Amount of free memory per shard which background reclaim keeps by compacting and evicting LSA memory."
+        " More absorbs bigger allocation spikes without stalling allocations on reclaim, at the cost of memory for the row cache.")
+    , lsa_background_reclaim_step_budget_in_us(this, "lsa_background_reclaim_step_budget_in_us", value_status::Used, 0, "Time a background reclaim step may take before yielding to other work. (0: until the task quota runs out)")
     , prometheus_port(this, "prometheus_port", value_status::Used, 9180, "Prometheus port, set to zero to disable")
     , prometheus_address(this, "prometheus_address", value_status::Used, {/* listen_address */}, "Prometheus listening address, defaulting to listen_address if not explicitly set")
     , prometheus_prefix(this, "prometheus_prefix", value_status::Used, "scylla", "Set the prefix of the exported Prometheus metrics. Changing this will break Scylla's dashboard compatibility, do not change unless you know what you are doing.")
@@ -820,6 +845,19 @@ db::config::config(std::shared_ptr<db::extensions> exts)
         " Performance is affected to some extent as a result. Useful to help debugging problems that may arise at another layers.")
     , enable_sstable_key_validation(this, "enable_sstable_key_validation", value_status::Used, ENABLE_SSTABLE_KEY_VALIDATION, "Enable validation of partition and clustering keys monotonicity"
         " Performance is affected to some extent as a result. Useful to help debugging problems that may arise at another layers.")
+    , sstable_partition_trie_index(this, "sstable_partition_trie_index", value_status::Used, false, "Write a trie-based partition index (Partitions.db) with new sstables."
+        " Single-partition lookups use it instead of the summary, which makes them independent of sstable_summary_ratio."
+        " Sstables written with this option cannot be read by versions which do not support it.")
+    , sstable_row_trie_index(this, "sstable_row_trie_index", value_status::Used, false, "Embed a trie-based row index in the promoted index of large partitions written to new sstables."
+        " Reads into such partitions find their clustering position in fewer index reads than the binary search over promoted index blocks."
+        " Only applies to tables whose clustering columns are all of fixed-size numeric, boolean, text, blob or inet types.")
+    , sstable_zone_maps(this, "sstable_zone_maps", value_status::Used, false, "Record the smallest and greatest value of fixed-size regular columns in each promoted index block of new sstables."
+        " Single-partition queries with ALLOW FILTERING at consistency level ONE skip the blocks which cannot have matching rows.")
+    , sstable_data_write_behind(this, "sstable_data_write_behind", value_status::Used, 10, "The number of buffers of the Data component of an sstable being written which may be in flight to disk at the same time.")
+    , sstable_index_write_behind(this, "sstable_index_write_behind", value_status::Used, 10, "The number of buffers of the Index and Partitions components of an sstable being written which may be in flight to disk at the same time.")
+    , sstable_decompressed_chunk_cache(this, "sstable_decompressed_chunk_cache", value_status::Used, false, "Cache the uncompressed contents of compressed sstable data files, so that reads of hot chunks do not uncompress them again."
+        " Only single-partition reads which don't bypass the cache use it; scans, compaction and streaming read the data files directly."
+        " The cached pages are evicted together with the row cache and the index caches. Applies to sstables opened after the option is set.")
     , cpu_scheduler(this, "cpu_scheduler", value_status::Used, true, "Enable cpu scheduling")
     , view_building(this, "view_building", value_status::Used, true, "Enable view building; should only be set to false when the node is experience issues due to view building")
     , enable_sstables_mc_format(this, "enable_sstables_mc_format", value_status::Unused, true, "Enable SSTables 'mc' format to be used as the default file format.  Deprecated, please use \"sstable_format\" instead.")
@@ -931,6 +969,10 @@ void db::config::add_per_partition_rate_limit_extension() {
     _extensions->add_schema_extension<db::per_partition_rate_limit_extension>(db::per_partition_rate_limit_extension::NAME);
 }
 
+void db::config::add_sstable_filter_extension() {
+    _extensions->add_schema_extension<db::sstable_filter_extension>(db::sstable_filter_extension::NAME);
+}
+
 void db::config::setup_directories() {
     maybe_in_workdir(commitlog_directory, "commitlog");
     maybe_in_workdir(data_file_directories, "data");
@@ -110,6 +110,7 @@ class config : public utils::config_file {
     // For testing only
     void add_cdc_extension();
     void add_per_partition_rate_limit_extension();
+    void add_sstable_filter_extension();
 
     /// True iff the feature is enabled.
     bool check_experimental(experimental_features_t::feature f) const;
@@ -142,6 +143,9 @@ class config : public utils::config_file {
     named_value<float> memtable_flush_static_shares;
     named_value<float> compaction_static_shares;
     named_value<bool> compaction_enforce_min_threshold;
+    named_value<uint32_t> compaction_parallel_sub_ranges;
+    named_value<uint32_t> sstable_token_ranges_per_shard;
+    named_value<uint32_t> compaction_read_latency_target_in_ms;
     named_value<sstring> cluster_name;
     named_value<sstring> listen_address;
     named_value<sstring> listen_interface;
@@ -222,6 +226,7 @@ class config : public utils::config_file {
     named_value<uint32_t> row_cache_keys_to_save;
     named_value<uint32_t> row_cache_size_in_mb;
     named_value<uint32_t> row_cache_save_period;
+    named_value<uint32_t> row_cache_load_rate;
     named_value<sstring> memory_allocator;
     named_value<uint32_t> counter_cache_size_in_mb;
     named_value<uint32_t> counter_cache_save_period;
@@ -286,6 +291,9 @@ class config : public utils::config_file {
     named_value<uint32_t> ssl_storage_port;
     named_value<bool> enable_in_memory_data_store;
     named_value<bool> enable_cache;
+    named_value<sstring> cache_admission_policy;
+    named_value<uint32_t> cache_absent_partition_keys_size_in_mb;
+    named_value<uint32_t> cache_cold_tier_size_in_mb;
     named_value<bool> enable_commitlog;
     named_value<bool> volatile_system_keyspace_for_testing;
     named_value<uint16_t> api_port;
@@ -313,6 +321,9 @@ class config : public utils::config_file {
     named_value<bool> experimental;
     named_value<std::vector<enum_option<experimental_features_t>>> experimental_features;
     named_value<size_t> lsa_reclamation_step;
+    named_value<bool> lsa_huge_pages;
+    named_value<uint32_t> lsa_background_reclaim_free_memory_in_mb;
+    named_value<uint32_t> lsa_background_reclaim_step_budget_in_us;
     named_value<uint16_t> prometheus_port;
     named_value<sstring> prometheus_address;
     named_value<sstring> prometheus_prefix;
@@ -325,6 +336,12 @@ class config : public utils::config_file {
     named_value<bool> enable_keyspace_column_family_metrics;
     named_value<bool> enable_sstable_data_integrity_check;
     named_value<bool> enable_sstable_key_validation;
+    named_value<bool> sstable_partition_trie_index;
+    named_value<bool> sstable_row_trie_index;
+    named_value<bool> sstable_zone_maps;
+    named_value<uint32_t> sstable_data_write_behind;
+    named_value<uint32_t> sstable_index_write_behind;
+    named_value<bool> sstable_decompressed_chunk_cache;
     named_value<bool> cpu_scheduler;
     named_value<bool> view_building;
     named_value<bool> enable_sstables_mc_format;
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2022-present ScyllaDB
+ */
+
+/*
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include <boost/range/adaptor/map.hpp>
+
+#include "db/sstable_filter_options.hh"
+#include "exceptions/exceptions.hh"
+#include "to_string.hh"
+
+namespace db {
+
+const char* sstable_filter_options::type_key = "type";
+
+static const std::map<sstring, sstable_filter_type> filter_type_names = {
+    {"bloom", sstable_filter_type::bloom},
+    {"split_block_bloom", sstable_filter_type::split_block_bloom},
+    {"xor", sstable_filter_type::xor_filter},
+};
+
+sstable_filter_options::sstable_filter_options(std::map<sstring, sstring> map) {
+    if (auto it = map.find(type_key); it != map.end()) {
+        auto type = filter_type_names.find(it->second);
+        if (type == filter_type_names.end()) {
+            throw exceptions::configuration_exception(format(
+                    "Invalid value for {} option: expected one of {}",
+                    type_key, ::join(", ", filter_type_names | boost::adaptors::map_keys)));
+        }
+        _type = type->second;
+        map.erase(it);
+    }
+
+    if (!map.empty()) {
+        throw exceptions::configuration_exception(format(
+                "Unknown keys in map for sstable_filter extension: {}",
+                ::join(", ", map | boost::adaptors::map_keys)));
+    }
+}
+
+std::map<sstring, sstring> sstable_filter_options::to_map() const {
+    return {{type_key, format("{}", _type)}};
+}
+
+std::ostream& operator<<(std::ostream& os, sstable_filter_type t) {
+    for (auto& [name, type] : filter_type_names) {
+        if (type == t) {
+            return os << name;
+        }
+    }
+    return os << "unknown";
+}
+
+}
@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 2022-present ScyllaDB
+ */
+
+/*
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <map>
+
+#include <seastar/core/sstring.hh>
+
+using namespace seastar;
+
+namespace db {
+
+// Kind of membership filter written to the Filter component of new sstables.
+enum class sstable_filter_type : uint8_t {
+    bloom,              // classic bloom filter, readable by Cassandra
+    split_block_bloom,  // cache-line blocked bloom filter, Scylla-only
+    xor_filter,         // static xor filter, smaller than bloom, Scylla-only
+};
+
+class sstable_filter_options final {
+private:
+    static const char* type_key;
+
+    sstable_filter_type _type = sstable_filter_type::bloom;
+public:
+    sstable_filter_options() = default;
+    explicit sstable_filter_options(std::map<sstring, sstring> map);
+
+    std::map<sstring, sstring> to_map() const;
+
+    sstable_filter_type type() const {
+        return _type;
+    }
+    void set_type(sstable_filter_type type) {
+        _type = type;
+    }
+
+    bool operator==(const sstable_filter_options&) const = default;
+};
+
+std::ostream& operator<<(std::ostream& os, sstable_filter_type t);
+
+}
@@ -21,6 +21,21 @@ std::vector<uint64_t> init_zero_based_shard_start(unsigned shards, unsigned shar
 
 unsigned shard_of(unsigned shard_count, unsigned sharding_ignore_msb_bits, const token& t);
 
+// Splits the range a shard owns in each round trip around the shards into
+// groups_per_shard parts of the same width, and returns the index of the group
+// of the token. Group g of shard s, numbered s * groups_per_shard + g, holds the
+// g-th part of the shard's range in every round trip. The shards of any shard
+// count own the same share of every round trip, so a group overlaps the same
+// shards of another shard count, with the same sharding_ignore_msb_bits, in all
+// round trips. Changing the shard count to n thus splits at most n - 1 of all
+// groups. Groups are in token order only within a round trip.
+uint64_t token_group_of(unsigned shard_count, unsigned sharding_ignore_msb_bits, unsigned groups_per_shard, const token& t);
+
+// Returns the number of groups (see token_group_of()) the tokens in [first, last]
+// may belong to, which is groups_per_shard unless both are in the range of the
+// same shard in the same round trip.
+uint64_t token_groups_spanned(unsigned shard_count, unsigned sharding_ignore_msb_bits, unsigned groups_per_shard, const token& first, const token& last);
+
 token token_for_next_shard(const std::vector<uint64_t>& shard_start, unsigned shard_count, unsigned sharding_ignore_msb_bits, const token& t, shard_id shard, unsigned spans);
 
 class sharder {
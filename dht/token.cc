@@ -199,6 +199,44 @@ shard_of(unsigned shard_count, unsigned sharding_ignore_msb_bits, const token& t
     abort();
 }
 
+uint64_t
+token_group_of(unsigned shard_count, unsigned sharding_ignore_msb_bits, unsigned groups_per_shard, const token& t) {
+    switch (t._kind) {
+        case token::kind::before_all_keys:
+            return 0;
+        case token::kind::after_all_keys:
+            return uint64_t(shard_count) * groups_per_shard - 1;
+        case token::kind::key:
+            // Same as zero_based_shard_of(), the fractional part is the position of the token
+            // in the range of its shard in its round trip.
+            auto scaled = uint128_t(unbias(t) << sharding_ignore_msb_bits) * shard_count;
+            uint64_t shard = scaled >> 64;
+            uint64_t position_in_shard = scaled;
+            return shard * groups_per_shard + ((uint128_t(position_in_shard) * groups_per_shard) >> 64);
+    }
+    abort();
+}
+
+uint64_t
+token_groups_spanned(unsigned shard_count, unsigned sharding_ignore_msb_bits, unsigned groups_per_shard, const token& first, const token& last) {
+    if (first._kind != token::kind::key || last._kind != token::kind::key || last < first) {
+        return groups_per_shard;
+    }
+    auto first_zero_based = unbias(first);
+    auto last_zero_based = unbias(last);
+    auto round_trip = [&] (uint64_t zero_based) -> uint64_t {
+        return sharding_ignore_msb_bits ? zero_based >> (64 - sharding_ignore_msb_bits) : 0;
+    };
+    if (round_trip(first_zero_based) != round_trip(last_zero_based)) {
+        return groups_per_shard;
+    }
+    if (zero_based_shard_of(first_zero_based, shard_count, sharding_ignore_msb_bits) != zero_based_shard_of(last_zero_based, shard_count, sharding_ignore_msb_bits)) {
+        return groups_per_shard;
+    }
+    return token_group_of(shard_count, sharding_ignore_msb_bits, groups_per_shard, last)
+            - token_group_of(shard_count, sharding_ignore_msb_bits, groups_per_shard, first) + 1;
+}
+
 token
 token_for_next_shard(const std::vector<uint64_t>& shard_start, unsigned shard_count, unsigned sharding_ignore_msb_bits, const token& t, shard_id shard, unsigned spans) {
     uint64_t n = 0;
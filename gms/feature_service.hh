@@ -113,6 +113,11 @@ class feature_service final {
     gms::feature collection_indexing { *this, "COLLECTION_INDEXING"sv };
     gms::feature large_collection_detection { *this, "LARGE_COLLECTION_DETECTION"sv };
     gms::feature secondary_indexes_on_static_columns { *this, "SECONDARY_INDEXES_ON_STATIC_COLUMNS"sv };
+    gms::feature split_block_bloom_filter { *this, "SPLIT_BLOCK_BLOOM_FILTER"sv };
+    gms::feature xor_sstable_filter { *this, "XOR_SSTABLE_FILTER"sv };
+    gms::feature compression_dictionary { *this, "COMPRESSION_DICTIONARY"sv };
+    gms::feature row_cache_quotas { *this, "ROW_CACHE_QUOTAS"sv };
+    gms::feature incremental_compaction_strategy { *this, "INCREMENTAL_COMPACTION_STRATEGY"sv };
 
 public:
 
@@ -31,6 +31,7 @@
 #include "db/system_keyspace.hh"
 #include "db/system_distributed_keyspace.hh"
 #include "db/batchlog_manager.hh"
+#include "db/cache_warmer.hh"
 #include "db/commitlog/commitlog.hh"
 #include "db/hints/manager.hh"
 #include "db/commitlog/commitlog_replayer.hh"
@@ -87,6 +88,7 @@
 #include "alternator/ttl.hh"
 #include "tools/entry_point.hh"
 #include "db/per_partition_rate_limit_extension.hh"
+#include "db/sstable_filter_extension.hh"
 #include "lang/wasm_instance_cache.hh"
 
 #include "service/raft/raft_address_map.hh"
@@ -465,6 +467,7 @@ To start the scylla server proper, simply invoke as: scylla server (or just scyl
     ext->add_schema_extension<db::paxos_grace_seconds_extension>(db::paxos_grace_seconds_extension::NAME);
     ext->add_schema_extension<tombstone_gc_extension>(tombstone_gc_extension::NAME);
     ext->add_schema_extension<db::per_partition_rate_limit_extension>(db::per_partition_rate_limit_extension::NAME);
+    ext->add_schema_extension<db::sstable_filter_extension>(db::sstable_filter_extension::NAME);
 
     auto cfg = make_lw_shared<db::config>(ext);
     auto init = app.get_options_description().add_options();
@@ -582,6 +585,12 @@ To start the scylla server proper, simply invoke as: scylla server (or just scyl
                 sighup_handler.stop().get();
             });
 
+#ifdef SEASTAR_DEFAULT_ALLOCATOR
+            if (cfg->lsa_huge_pages()) {
+                // Segments are otherwise allocated one by one, which huge pages can't back.
+                logalloc::use_standard_allocator_segment_pool_backend(memory::stats().total_memory(), true).get();
+            }
+#endif
             logalloc::prime_segment_pool(memory::stats().total_memory(), memory::min_free_memory()).get();
             logging::apply_settings(cfg->logging_settings(app.options().log_opts));
 
@@ -641,6 +650,9 @@ To start the scylla server proper, simply invoke as: scylla server (or just scyl
                 st_cfg.lsa_reclamation_step = cfg->lsa_reclamation_step();
                 st_cfg.background_reclaim_sched_group = background_reclaim_scheduling_group;
                 st_cfg.sanitizer_report_backtrace = cfg->sanitizer_report_backtrace();
+                st_cfg.huge_pages = cfg->lsa_huge_pages();
+                st_cfg.background_reclaim_free_memory = size_t(cfg->lsa_background_reclaim_free_memory_in_mb()) << 20;
+                st_cfg.background_reclaim_step_budget = std::chrono::microseconds(cfg->lsa_background_reclaim_step_budget_in_us());
                 logalloc::shard_tracker().configure(st_cfg);
             }).get();
 
@@ -803,6 +815,7 @@ To start the scylla server proper, simply invoke as: scylla server (or just scyl
             dbcfg.memtable_scheduling_group = make_sched_group("memtable", 1000);
             dbcfg.memtable_to_cache_scheduling_group = make_sched_group("memtable_to_cache", 200);
             dbcfg.gossip_scheduling_group = make_sched_group("gossip", 1000);
+            auto cache_warmer_scheduling_group = make_sched_group("cache_warmer", 100);
             dbcfg.available_memory = memory::stats().total_memory();
 
             netw::messaging_service::config mscfg;
@@ -972,6 +985,9 @@ To start the scylla server proper, simply invoke as: scylla server (or just scyl
             utils::directories::set dir_set;
             dir_set.add(cfg->data_file_directories());
             dir_set.add(cfg->commitlog_directory());
+            if (cfg->row_cache_save_period()) {
+                dir_set.add(cfg->saved_caches_directory());
+            }
             dirs.emplace(cfg->developer_mode());
             dirs->create_and_verify(std::move(dir_set)).get();
 
@@ -1013,6 +1029,8 @@ To start the scylla server proper, simply invoke as: scylla server (or just scyl
                     .available_memory = dbcfg.available_memory,
                     .static_shares = cfg->compaction_static_shares,
                     .throughput_mb_per_sec = cfg->compaction_throughput_mb_per_sec,
+                    .parallel_sub_ranges = cfg->compaction_parallel_sub_ranges,
+                    .read_latency_target_ms = cfg->compaction_read_latency_target_in_ms,
                 };
             });
             cm.start(std::move(get_cm_cfg), std::ref(stop_signal.as_sharded_abort_source())).get();
@@ -1282,6 +1300,22 @@ To start the scylla server proper, simply invoke as: scylla server (or just scyl
                     cf.trigger_compaction();
                 }
             }).get();
+
+            supervisor::notify("starting cache warmer");
+            static sharded<db::cache_warmer> cache_warmer;
+            cache_warmer.start(std::ref(db), sharded_parameter([&] {
+                return db::cache_warmer::config{
+                    .directory = cfg->saved_caches_directory(),
+                    .save_period = std::chrono::seconds(cfg->row_cache_save_period()),
+                    .keys_to_save = cfg->row_cache_keys_to_save(),
+                    .load_rate = cfg->row_cache_load_rate(),
+                    .scheduling_group = cache_warmer_scheduling_group,
+                };
+            })).get();
+            cache_warmer.invoke_on_all(&db::cache_warmer::start).get();
+            auto stop_cache_warmer = defer_verbose_shutdown("cache warmer", [] {
+                cache_warmer.stop().get();
+            });
             api::set_server_gossip(ctx, gossiper).get();
             api::set_server_snitch(ctx, snitch).get();
             auto stop_snitch_api = defer_verbose_shutdown("snitch API", [&ctx] {
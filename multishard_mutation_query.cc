@@ -879,8 +879,12 @@ future<std::tuple<foreign_ptr<lw_shared_ptr<query::result>>, cache_temperature>>
         db::timeout_clock::time_point timeout) {
     schema_ptr query_schema = cmd.slice.is_reversed() ? table_schema->make_reversed() : table_schema;
 
-    return do_query_on_all_shards<data_query_result_builder>(db, query_schema, cmd, ranges, std::move(trace_state), timeout,
-            [table_schema, &cmd, opts] (query::result_memory_accounter&& accounter, const compact_for_query_state_v2& compaction_state) {
-        return data_query_result_builder(*table_schema, cmd.slice, opts, std::move(accounter), compaction_state, cmd.tombstone_limit);
+    // The rows only feed the query result, see skip_unselected_values.
+    auto data_cmd = cmd;
+    data_cmd.slice.options.set<query::partition_slice::option::skip_unselected_values>();
+
+    co_return co_await do_query_on_all_shards<data_query_result_builder>(db, query_schema, data_cmd, ranges, std::move(trace_state), timeout,
+            [table_schema, &data_cmd, opts] (query::result_memory_accounter&& accounter, const compact_for_query_state_v2& compaction_state) {
+        return data_query_result_builder(*table_schema, data_cmd.slice, opts, std::move(accounter), compaction_state, data_cmd.tombstone_limit);
     });
 }
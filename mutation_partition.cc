@@ -404,6 +404,13 @@ stop_iteration mutation_partition::apply_monotonically(const schema& s, mutation
 
     auto p_i = p._rows.begin();
     auto i = _rows.begin();
+    // Writes of time series usually only add rows after all the existing ones.
+    // Detect that with a single comparison against the last row, so that
+    // the rows are appended at the rightmost position without searching.
+    bool appending = p_i != p._rows.end() && !_rows.empty() && cmp(*_rows.rbegin(), *p_i) < 0;
+    if (appending) {
+        i = _rows.end();
+    }
     while (p_i != p._rows.end()) {
       try {
         rows_entry& src_e = *p_i;
@@ -437,6 +444,7 @@ stop_iteration mutation_partition::apply_monotonically(const schema& s, mutation
             if (insert) {
                 rows_type::key_grabber pi_kg(p_i);
                 _rows.insert_before(i, std::move(pi_kg));
+                app_stats.rows_appended += appending;
             }
         } else {
             auto continuous = i->continuous() || src_e.continuous();
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2022-present ScyllaDB
+ */
+
+/*
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "mutation_writer/token_group_based_splitting_writer.hh"
+
+#include <map>
+
+namespace mutation_writer {
+
+class token_group_based_splitting_mutation_writer {
+    schema_ptr _schema;
+    reader_permit _permit;
+    classify_by_token_group _classifier;
+    reader_consumer_v2 _consumer;
+    std::map<uint64_t, bucket_writer_v2> _groups;
+    bucket_writer_v2* _current_writer = nullptr;
+
+private:
+    future<> write(mutation_fragment_v2&& mf) {
+        return _current_writer->consume(std::move(mf));
+    }
+public:
+    token_group_based_splitting_mutation_writer(schema_ptr schema, reader_permit permit, classify_by_token_group classifier, reader_consumer_v2 consumer)
+        : _schema(std::move(schema))
+        , _permit(std::move(permit))
+        , _classifier(std::move(classifier))
+        , _consumer(std::move(consumer))
+    {}
+
+    future<> consume(partition_start&& ps) {
+        auto group = _classifier(ps.key().token());
+        _current_writer = &_groups.try_emplace(group, _schema, _permit, _consumer).first->second;
+        return write(mutation_fragment_v2(*_schema, _permit, std::move(ps)));
+    }
+
+    future<> consume(static_row&& sr) {
+        return write(mutation_fragment_v2(*_schema, _permit, std::move(sr)));
+    }
+
+    future<> consume(clustering_row&& cr) {
+        return write(mutation_fragment_v2(*_schema, _permit, std::move(cr)));
+    }
+
+    future<> consume(range_tombstone_change&& rtc) {
+        return write(mutation_fragment_v2(*_schema, _permit, std::move(rtc)));
+    }
+
+    future<> consume(partition_end&& pe) {
+        return write(mutation_fragment_v2(*_schema, _permit, std::move(pe)));
+    }
+
+    void consume_end_of_stream() {
+        for (auto& [group, writer] : _groups) {
+            writer.consume_end_of_stream();
+        }
+    }
+    void abort(std::exception_ptr ep) {
+        for (auto& [group, writer] : _groups) {
+            writer.abort(ep);
+        }
+    }
+    future<> close() noexcept {
+        return parallel_for_each(_groups, [] (auto& group_and_writer) {
+            return group_and_writer.second.close();
+        });
+    }
+};
+
+future<> segregate_by_token_group(flat_mutation_reader_v2 producer, classify_by_token_group classifier, reader_consumer_v2 consumer) {
+    auto schema = producer.schema();
+    auto permit = producer.permit();
+    return feed_writer(
+        std::move(producer),
+        token_group_based_splitting_mutation_writer(std::move(schema), std::move(permit), std::move(classifier), std::move(consumer)));
+}
+
+reader_consumer_v2 make_token_range_aligning_consumer(const dht::sharder& sharder, unsigned ranges_per_shard, reader_consumer_v2 consumer) {
+    return [shard_count = sharder.shard_count(), ignore_msb = sharder.sharding_ignore_msb(), ranges_per_shard,
+            consumer = make_lw_shared<reader_consumer_v2>(std::move(consumer))] (flat_mutation_reader_v2 reader) {
+        auto classifier = [=] (const dht::token& t) {
+            return dht::token_group_of(shard_count, ignore_msb, ranges_per_shard, t);
+        };
+        return segregate_by_token_group(std::move(reader), std::move(classifier), [consumer] (flat_mutation_reader_v2 rd) {
+            return (*consumer)(std::move(rd));
+        });
+    };
+}
+
+} // namespace mutation_writer
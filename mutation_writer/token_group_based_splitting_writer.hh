@@ -0,0 +1,32 @@
+/*
+ * Copyright (C) 2022-present ScyllaDB
+ */
+
+/*
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <seastar/util/noncopyable_function.hh>
+
+#include "feed_writers.hh"
+#include "dht/token-sharding.hh"
+
+namespace mutation_writer {
+
+// Given a producer, segregate its partitions into one output stream per group
+// the classifier puts their token into. Groups may come back in token order,
+// so an output stream is kept open for every group seen so far.
+// This is useful for writing sstables which are aligned to fixed token ranges.
+using classify_by_token_group = noncopyable_function<uint64_t(const dht::token&)>;
+future<> segregate_by_token_group(flat_mutation_reader_v2 producer, classify_by_token_group classifier, reader_consumer_v2 consumer);
+
+// Returns a consumer which splits every stream it is given at the boundaries of
+// the ranges_per_shard token groups of each shard (see dht::token_group_of()), such
+// that each stream passed to consumer stays within a single one of them.
+// The streams it is given must only contain partitions of a single shard, so
+// at most ranges_per_shard streams are passed to consumer at a time.
+reader_consumer_v2 make_token_range_aligning_consumer(const dht::sharder& sharder, unsigned ranges_per_shard, reader_consumer_v2 consumer);
+
+} // namespace mutation_writer
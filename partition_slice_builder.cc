@@ -17,6 +17,7 @@ partition_slice_builder::partition_slice_builder(const schema& schema, query::pa
     , _static_columns(std::move(slice.static_columns))
     , _row_ranges(std::move(slice._row_ranges))
     , _specific_ranges(std::move(slice._specific_ranges))
+    , _value_ranges(std::move(slice.value_ranges))
     , _schema(schema)
     , _options(std::move(slice.options))
 {
@@ -64,6 +65,7 @@ partition_slice_builder::build() {
         std::move(_specific_ranges),
         cql_serialization_format::internal(),
         _partition_row_limit,
+        std::move(_value_ranges),
     };
 }
 
@@ -156,6 +158,12 @@ partition_slice_builder::reversed() {
     return *this;
 }
 
+partition_slice_builder&
+partition_slice_builder::with_value_range(query::column_value_range range) {
+    _value_ranges.push_back(std::move(range));
+    return *this;
+}
+
 partition_slice_builder&
 partition_slice_builder::without_partition_key_columns() {
     _options.remove<query::partition_slice::option::send_partition_key>();
@@ -28,6 +28,7 @@ class partition_slice_builder {
     std::optional<query::column_id_vector> _static_columns;
     std::optional<std::vector<query::clustering_range>> _row_ranges;
     std::unique_ptr<query::specific_ranges> _specific_ranges;
+    std::vector<query::column_value_range> _value_ranges;
     const schema& _schema;
     query::partition_slice::option_set _options;
     uint64_t _partition_row_limit = query::partition_max_rows;
@@ -45,6 +46,7 @@ class partition_slice_builder {
     partition_slice_builder& mutate_ranges(std::function<void(std::vector<query::clustering_range>&)>);
     // noop if no specific ranges have been set yet
     partition_slice_builder& mutate_specific_ranges(std::function<void(query::specific_ranges&)>);
+    partition_slice_builder& with_value_range(query::column_value_range);
     partition_slice_builder& without_partition_key_columns();
     partition_slice_builder& without_clustering_key_columns();
     partition_slice_builder& reversed();
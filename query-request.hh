@@ -134,6 +134,19 @@ class specific_ranges {
     clustering_row_ranges _ranges;
 };
 
+// Restricts a regular column to a range of values, which rows have to
+// match to be selected by a query with filtering.
+//
+// Replicas may use it to avoid reading rows which cannot match, but are
+// not required to, so the restriction still has to be applied to the
+// results. Values are compared using the type of the column.
+struct column_value_range {
+    column_id column;
+    nonwrapping_range<bytes> range;
+
+    friend std::ostream& operator<<(std::ostream& out, const column_value_range& r);
+};
+
 constexpr auto max_rows = std::numeric_limits<uint64_t>::max();
 constexpr auto partition_max_rows = std::numeric_limits<uint64_t>::max();
 constexpr auto max_rows_if_set = std::numeric_limits<uint32_t>::max();
@@ -171,6 +184,12 @@ class partition_slice {
         // directly, bypassing the intermediate reconcilable_result format used
         // in pre 4.5 range scans.
         range_scan_data_variant,
+        // Set by the replica on data queries, which turn rows into a
+        // query::result holding only the selected columns. Lets sstable
+        // readers produce the cells of the other columns without their
+        // values. Never sent to other nodes, and never set on reads whose
+        // mutations may be reconciled, repaired or cached.
+        skip_unselected_values,
     };
     using option_set = enum_set<super_enum<option,
         option::send_clustering_key,
@@ -185,12 +204,16 @@ class partition_slice {
         option::with_digest,
         option::bypass_cache,
         option::always_return_static_content,
-        option::range_scan_data_variant>>;
+        option::range_scan_data_variant,
+        option::skip_unselected_values>>;
     clustering_row_ranges _row_ranges;
 public:
     column_id_vector static_columns; // TODO: consider using bitmap
     column_id_vector regular_columns;  // TODO: consider using bitmap
     option_set options;
+    // Hints about the values of regular columns rows have to match,
+    // see column_value_range. Only set for queries with filtering.
+    std::vector<column_value_range> value_ranges;
 private:
     std::unique_ptr<specific_ranges> _specific_ranges;
     cql_serialization_format _cql_format;
@@ -202,12 +225,14 @@ class partition_slice {
         std::unique_ptr<specific_ranges> specific_ranges,
         cql_serialization_format,
         uint32_t partition_row_limit_low_bits,
-        uint32_t partition_row_limit_high_bits);
+        uint32_t partition_row_limit_high_bits,
+        std::vector<column_value_range> value_ranges = {});
     partition_slice(clustering_row_ranges row_ranges, column_id_vector static_columns,
         column_id_vector regular_columns, option_set options,
         std::unique_ptr<specific_ranges> specific_ranges = nullptr,
         cql_serialization_format = cql_serialization_format::internal(),
-        uint64_t partition_row_limit = partition_max_rows);
+        uint64_t partition_row_limit = partition_max_rows,
+        std::vector<column_value_range> value_ranges = {});
     partition_slice(clustering_row_ranges ranges, const schema& schema, const column_set& mask, option_set options);
     partition_slice(const partition_slice&);
     partition_slice(partition_slice&&);
@@ -51,9 +51,16 @@ std::ostream& operator<<(std::ostream& out, const partition_slice& ps) {
     out << ", options=" << format("{:x}", ps.options.mask()); // FIXME: pretty print options
     out << ", cql_format=" << ps.cql_format();
     out << ", partition_row_limit=" << ps.partition_row_limit();
+    if (!ps.value_ranges.empty()) {
+        out << ", value_ranges=[" << join(", ", ps.value_ranges) << "]";
+    }
     return out << "}";
 }
 
+std::ostream& operator<<(std::ostream& out, const column_value_range& r) {
+    return out << "{column=" << r.column << ", range=" << r.range << "}";
+}
+
 std::ostream& operator<<(std::ostream& out, const read_command& r) {
     return out << "read_command{"
         << "cf_id=" << r.cf_id
@@ -201,11 +208,13 @@ partition_slice::partition_slice(clustering_row_ranges row_ranges,
     std::unique_ptr<specific_ranges> specific_ranges,
     cql_serialization_format cql_format,
     uint32_t partition_row_limit_low_bits,
-    uint32_t partition_row_limit_high_bits)
+    uint32_t partition_row_limit_high_bits,
+    std::vector<column_value_range> value_ranges)
     : _row_ranges(std::move(row_ranges))
     , static_columns(std::move(static_columns))
     , regular_columns(std::move(regular_columns))
     , options(options)
+    , value_ranges(std::move(value_ranges))
     , _specific_ranges(std::move(specific_ranges))
     , _cql_format(std::move(cql_format))
     , _partition_row_limit_low_bits(partition_row_limit_low_bits)
@@ -218,10 +227,11 @@ partition_slice::partition_slice(clustering_row_ranges row_ranges,
     option_set options,
     std::unique_ptr<specific_ranges> specific_ranges,
     cql_serialization_format cql_format,
-    uint64_t partition_row_limit)
+    uint64_t partition_row_limit,
+    std::vector<column_value_range> value_ranges)
     : partition_slice(std::move(row_ranges), std::move(static_columns), std::move(regular_columns), options,
             std::move(specific_ranges), std::move(cql_format), static_cast<uint32_t>(partition_row_limit),
-            static_cast<uint32_t>(partition_row_limit >> 32))
+            static_cast<uint32_t>(partition_row_limit >> 32), std::move(value_ranges))
 {}
 
 partition_slice::partition_slice(clustering_row_ranges ranges, const schema& s, const column_set& columns, option_set options)
@@ -249,6 +259,7 @@ partition_slice::partition_slice(const partition_slice& s)
     , static_columns(s.static_columns)
     , regular_columns(s.regular_columns)
     , options(s.options)
+    , value_ranges(s.value_ranges)
     , _specific_ranges(s._specific_ranges ? std::make_unique<specific_ranges>(*s._specific_ranges) : nullptr)
     , _cql_format(s._cql_format)
     , _partition_row_limit_low_bits(s._partition_row_limit_low_bits)
@@ -374,6 +374,21 @@ database::database(const db::config& cfg, database_config dbcfg, service::migrat
     setup_metrics();
 
     _row_cache_tracker.set_compaction_scheduling_group(dbcfg.memory_compaction_scheduling_group);
+    if (_cfg.cache_admission_policy() == "tinylfu") {
+        _row_cache_tracker.set_admission_policy(cache_tracker::admission_policy::tinylfu);
+    }
+    _row_cache_tracker.set_max_absent_keys_memory(size_t(_cfg.cache_absent_partition_keys_size_in_mb()) << 20);
+    _row_cache_tracker.set_max_cold_tier_memory(size_t(_cfg.cache_cold_tier_size_in_mb()) << 20);
+
+    _compaction_manager.plug_foreground_load_probe([this] {
+        auto& latency = _cf_stats.recent_read_latency;
+        auto load = compaction_controller::foreground_load{
+            .read_latency = std::chrono::microseconds(latency.quantile(0.99)),
+            .queued_reads = _read_concurrency_sem.waiters(),
+        };
+        latency.clear();
+        return load;
+    });
 
     setup_scylla_memory_diagnostics_producer();
     if (_dbcfg.sstables_format) {
@@ -448,6 +463,26 @@ void backlog_controller::update_controller(float shares) {
     _inflight_update = _scheduling_group.io.update_shares(uint32_t(shares));
 }
 
+void compaction_controller::update_controller(float shares) {
+    auto target = _latency_target ? _latency_target() : std::chrono::milliseconds(0);
+    if (controller_disabled() || !target.count() || !_foreground_load) {
+        _latency_factor = 1.0f;
+        backlog_controller::update_controller(shares);
+        return;
+    }
+
+    auto load = _foreground_load();
+    if (load.read_latency > target) {
+        _latency_factor = std::max(_latency_factor * latency_backoff, min_latency_factor);
+    } else if (load.queued_reads <= _last_queued_reads) {
+        _latency_factor = std::min(_latency_factor + latency_recovery, 1.0f);
+    }
+    _last_queued_reads = load.queued_reads;
+
+    auto max_shares = _control_points.back().output;
+    backlog_controller::update_controller(std::max(shares * _latency_factor, shares * shares / max_shares));
+}
+
 
 namespace replica {
 
@@ -1220,6 +1255,7 @@ keyspace::make_column_family_config(const schema& s, const database& db) const {
     cfg.enable_cache = _config.enable_cache;
     cfg.enable_dangerous_direct_import_of_cassandra_counters = _config.enable_dangerous_direct_import_of_cassandra_counters;
     cfg.compaction_enforce_min_threshold = _config.compaction_enforce_min_threshold;
+    cfg.sstable_token_ranges_per_shard = _config.sstable_token_ranges_per_shard;
     cfg.dirty_memory_manager = _config.dirty_memory_manager;
     cfg.streaming_read_concurrency_semaphore = _config.streaming_read_concurrency_semaphore;
     cfg.compaction_concurrency_semaphore = _config.compaction_concurrency_semaphore;
@@ -2048,6 +2084,7 @@ database::make_keyspace_config(const keyspace_metadata& ksm) {
     }
     cfg.enable_dangerous_direct_import_of_cassandra_counters = _cfg.enable_dangerous_direct_import_of_cassandra_counters();
     cfg.compaction_enforce_min_threshold = _cfg.compaction_enforce_min_threshold;
+    cfg.sstable_token_ranges_per_shard = _cfg.sstable_token_ranges_per_shard;
     cfg.dirty_memory_manager = &_dirty_memory_manager;
     cfg.streaming_read_concurrency_semaphore = &_streaming_concurrency_sem;
     cfg.compaction_concurrency_semaphore = &_compaction_concurrency_sem;
@@ -2218,6 +2255,7 @@ future<> database::stop() {
     co_await _system_dirty_memory_manager.shutdown();
     co_await _dirty_memory_manager.shutdown();
     co_await _memtable_controller.shutdown();
+    _compaction_manager.unplug_foreground_load_probe();
     co_await _user_sstables_manager->close();
     co_await _system_sstables_manager->close();
     co_await _querier_cache.stop();
@@ -308,6 +308,12 @@ struct cf_stats {
     uint64_t total_view_updates_pushed_remote = 0;
     uint64_t total_view_updates_failed_local = 0;
     uint64_t total_view_updates_failed_remote = 0;
+
+    // Latency of the reads of all tables, since the compaction controller last sampled it.
+    // Fed by table::query() (sampled) and table::mutation_query(), i.e. by the replica side
+    // of data, digest and mutation reads. Reads made by streaming, repair and view building
+    // don't go through them, so they are not accounted.
+    utils::time_estimated_histogram recent_read_latency;
 };
 
 class table;
@@ -359,6 +365,7 @@ class table : public enable_lw_shared_from_this<table> {
         bool enable_commitlog = true;
         bool enable_incremental_backups = false;
         utils::updateable_value<bool> compaction_enforce_min_threshold{false};
+        utils::updateable_value<uint32_t> sstable_token_ranges_per_shard{0};
         bool enable_dangerous_direct_import_of_cassandra_counters = false;
         replica::dirty_memory_manager* dirty_memory_manager = &default_dirty_memory_manager;
         reader_concurrency_semaphore* streaming_read_concurrency_semaphore;
@@ -601,6 +608,14 @@ class table : public enable_lw_shared_from_this<table> {
 
     snapshot_source sstables_as_snapshot_source();
     partition_presence_checker make_partition_presence_checker(lw_shared_ptr<sstables::sstable_set>);
+    // Whether reads with the slice go through the cache.
+    bool reads_from_cache(const query::partition_slice& slice) const noexcept;
+    // Element i is true iff ranges[i] is a single partition which no memtable and no
+    // sstable may contain, so that it needn't be read. Partitions which a read with the
+    // slice would find in the cache are left to it. Must not defer, so that data moving
+    // from memtables to sstables is seen in either.
+    std::vector<bool> find_absent_partitions(const schema& s, const query::partition_slice& slice,
+            const dht::partition_range_vector& ranges) const;
     std::chrono::steady_clock::time_point _sstable_writes_disabled_at;
     void do_trigger_compaction();
 
@@ -1114,6 +1129,7 @@ class keyspace {
         bool enable_cache = true;
         bool enable_incremental_backups = false;
         utils::updateable_value<bool> compaction_enforce_min_threshold{false};
+        utils::updateable_value<uint32_t> sstable_token_ranges_per_shard{0};
         bool enable_dangerous_direct_import_of_cassandra_counters = false;
         replica::dirty_memory_manager* dirty_memory_manager = &default_dirty_memory_manager;
         reader_concurrency_semaphore* streaming_read_concurrency_semaphore;
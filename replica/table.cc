@@ -20,6 +20,7 @@
 #include "replica/compaction_group.hh"
 #include "sstables/sstables.hh"
 #include "sstables/sstables_manager.hh"
+#include "sstables/zone_map.hh"
 #include "service/priority_manager.hh"
 #include "db/schema_tables.hh"
 #include "cell_locking.hh"
@@ -55,6 +56,7 @@
 #include "readers/multi_range.hh"
 #include "readers/combined.hh"
 #include "readers/compacting.hh"
+#include "mutation_writer/token_group_based_splitting_writer.hh"
 
 namespace replica {
 
@@ -199,11 +201,18 @@ table::make_reader_v2(schema_ptr s,
         }
     }
 
-    const auto bypass_cache = slice.options.contains(query::partition_slice::option::bypass_cache);
-    if (cache_enabled() && !bypass_cache && !(reversed && _config.reversed_reads_auto_bypass_cache())) {
+    if (reads_from_cache(query_slice)) {
         if (auto reader_opt = _cache.make_reader_opt(s, permit, range, slice, pc, std::move(trace_state), fwd, fwd_mr)) {
             readers.emplace_back(std::move(*reader_opt));
         }
+    } else if (readers.empty() && !slice.value_ranges.empty() && query::is_single_partition(range) && !reversed
+            && fwd == streamed_mutation::forwarding::no) {
+        // No memtable has the partition, so sstables are its only source
+        // and their zone maps can tell which rows cannot match.
+        readers.emplace_back(sstables::make_zone_map_filtering_reader(s, permit, range, slice, _sstables, pc, trace_state,
+                [this, s, permit, &range, &pc, trace_state, fwd, fwd_mr, sstables = _sstables] (const query::partition_slice& slice) {
+            return make_sstable_reader(s, permit, sstables, range, slice, pc, trace_state, fwd, fwd_mr);
+        }));
     } else {
         readers.emplace_back(make_sstable_reader(s, permit, _sstables, range, slice, pc, std::move(trace_state), fwd, fwd_mr));
     }
@@ -780,12 +789,17 @@ table::try_flush_memtable_to_sstable(compaction_group& cg, lw_shared_ptr<memtabl
         metadata.min_timestamp = old->get_min_timestamp();
         metadata.max_timestamp = old->get_max_timestamp();
         auto estimated_partitions = _compaction_strategy.adjust_partition_estimate(metadata, old->partition_count());
+        auto ranges_per_shard = _config.sstable_token_ranges_per_shard();
+        if (ranges_per_shard) {
+            // The memtable spans the whole range of the shard, so every token group gets its share.
+            estimated_partitions = std::max(uint64_t(1), estimated_partitions / ranges_per_shard);
+        }
 
         if (!_async_gate.is_closed()) {
             co_await _compaction_manager.maybe_wait_for_sstable_count_reduction(cg.as_table_state());
         }
 
-        auto consumer = _compaction_strategy.make_interposer_consumer(metadata, [this, old, permit, &newtabs, metadata, estimated_partitions, &cg] (flat_mutation_reader_v2 reader) mutable -> future<> {
+        reader_consumer_v2 writer = [this, old, permit, &newtabs, metadata, estimated_partitions, &cg] (flat_mutation_reader_v2 reader) mutable -> future<> {
           std::exception_ptr ex;
           try {
             auto&& priority = service::get_local_memtable_flush_priority();
@@ -805,7 +819,11 @@ table::try_flush_memtable_to_sstable(compaction_group& cg, lw_shared_ptr<memtabl
           }
           co_await reader.close();
           co_await coroutine::return_exception_ptr(std::move(ex));
-        });
+        };
+        if (ranges_per_shard) {
+            writer = mutation_writer::make_token_range_aligning_consumer(_schema->get_sharder(), ranges_per_shard, std::move(writer));
+        }
+        auto consumer = _compaction_strategy.make_interposer_consumer(metadata, std::move(writer));
 
         auto f = consumer(old->make_flush_reader(
             old->schema(),
@@ -880,6 +898,7 @@ void table::set_metrics() {
                 ms::make_counter("memtable_row_writes", _stats.memtable_app_stats.row_writes, ms::description("Number of row writes performed in memtables"))(cf)(ks).set_skip_when_empty(),
                 ms::make_counter("memtable_row_hits", _stats.memtable_app_stats.row_hits, ms::description("Number of rows overwritten by write operations in memtables"))(cf)(ks).set_skip_when_empty().set_skip_when_empty(),
                 ms::make_counter("memtable_rows_dropped_by_tombstones", _stats.memtable_app_stats.rows_dropped_by_tombstones, ms::description("Number of rows dropped in memtables by a tombstone write"))(cf)(ks).set_skip_when_empty(),
+                ms::make_counter("memtable_rows_appended", _stats.memtable_app_stats.rows_appended, ms::description("Number of rows written to memtables after all other rows of their partition, without a search"))(cf)(ks).set_skip_when_empty(),
                 ms::make_counter("memtable_rows_compacted_with_tombstones", _stats.memtable_app_stats.rows_compacted_with_tombstones, ms::description("Number of rows scanned during write of a tombstone for the purpose of compaction in memtables"))(cf)(ks).set_skip_when_empty(),
                 ms::make_counter("memtable_range_tombstone_reads", _stats.memtable_range_tombstone_reads, ms::description("Number of range tombstones read from memtables"))(cf)(ks).set_skip_when_empty(),
                 ms::make_counter("memtable_row_tombstone_reads", _stats.memtable_row_tombstone_reads, ms::description("Number of row tombstones read from memtables"))(cf)(ks),
@@ -890,7 +909,11 @@ void table::set_metrics() {
                 ms::make_gauge("pending_compaction", ms::description("Estimated number of compactions pending for this column family"), _stats.pending_compactions)(cf)(ks),
                 ms::make_gauge("pending_sstable_deletions",
                         ms::description("Number of tasks waiting to delete sstables from a table"),
-                        [this] { return _sstable_deletion_sem.waiters(); })(cf)(ks)
+                        [this] { return _sstable_deletion_sem.waiters(); })(cf)(ks),
+                ms::make_gauge("cache_partitions", ms::description("Number of partitions of the table in cache"),
+                        [this] { return _cache.get_table_stats().partitions; })(cf)(ks),
+                ms::make_counter("cache_quota_rejects", ms::description("Number of partitions missing in cache which reads did not insert, because the table reached its max_partitions caching quota"),
+                        [this] { return _cache.get_table_stats().quota_rejects; })(cf)(ks).set_skip_when_empty()
         });
 
         // Metrics related to row locking
@@ -1361,6 +1384,59 @@ table::make_partition_presence_checker(lw_shared_ptr<sstables::sstable_set> ssta
     };
 }
 
+bool table::reads_from_cache(const query::partition_slice& slice) const noexcept {
+    const auto bypass_cache = slice.options.contains(query::partition_slice::option::bypass_cache);
+    const auto reversed = slice.is_reversed() && _config.enable_optimized_reversed_reads();
+    return cache_enabled() && !bypass_cache && !(reversed && _config.reversed_reads_auto_bypass_cache());
+}
+
+std::vector<bool>
+table::find_absent_partitions(const schema& s, const query::partition_slice& slice, const dht::partition_range_vector& ranges) const {
+    std::vector<bool> absent(ranges.size(), false);
+    if (_virtual_reader || ranges.size() < 2) {
+        return absent;
+    }
+    // Cache hits are cheaper than the probes, so only keys the read would miss are probed.
+    const auto cached = reads_from_cache(slice);
+
+    // The keys of a batch are probed together, overlapping the filters' cache misses.
+    std::vector<dht::decorated_key> keys;
+    std::vector<size_t> key_ranges;
+    auto probe = [&] {
+        uint64_t present = 0;
+        for (auto& [sst, mask] : _sstables->filter_keys(s, keys)) {
+            present |= mask;
+        }
+        for (size_t i = 0; i < keys.size(); ++i) {
+            absent[key_ranges[i]] = !(present & (uint64_t(1) << i));
+        }
+        keys.clear();
+        key_ranges.clear();
+    };
+    for (size_t i = 0; i < ranges.size(); ++i) {
+        auto& range = ranges[i];
+        if (!query::is_single_partition(range)) {
+            continue;
+        }
+        auto& dk = range.start()->value().as_decorated_key();
+        if (cached && _cache.answers(dk)) {
+            continue;
+        }
+        if (std::ranges::any_of(*_compaction_group->memtables(), [&] (const lw_shared_ptr<memtable>& mt) { return !mt->slice(range).empty(); })) {
+            continue;
+        }
+        keys.push_back(dk);
+        key_ranges.push_back(i);
+        if (keys.size() == utils::i_filter::max_batch_size) {
+            probe();
+        }
+    }
+    if (!keys.empty()) {
+        probe();
+    }
+    return absent;
+}
+
 snapshot_source
 table::sstables_as_snapshot_source() {
     return snapshot_source([this] () {
@@ -2154,6 +2230,9 @@ table::query(schema_ptr s,
 
     auto finally = defer([&] () noexcept {
         _stats.reads.mark(lc);
+        if (lc.is_start() && _config.cf_stats) {
+            _config.cf_stats->recent_read_latency.add(lc.latency());
+        }
         _async_gate.leave();
     });
 
@@ -2169,12 +2248,24 @@ table::query(schema_ptr s,
         querier_opt = std::move(*saved_querier);
     }
 
+    // Partitions of multi-partition queries (IN) which cannot exist aren't read.
+    auto absent = find_absent_partitions(*s, cmd.slice, partition_ranges);
+
     while (!qs.done()) {
+        auto range_index = qs.current_partition_range - partition_ranges.begin();
         auto&& range = *qs.current_partition_range++;
 
+        // A saved querier is positioned within the range, so keep reading it.
+        if (!querier_opt && absent[range_index]) {
+            continue;
+        }
+
         if (!querier_opt) {
             query::querier_base::querier_config conf(_config.tombstone_warn_threshold);
-            querier_opt = query::querier(as_mutation_source(), s, permit, range, qs.cmd.slice,
+            // The rows only feed the query result, see skip_unselected_values.
+            auto slice = qs.cmd.slice;
+            slice.options.set<query::partition_slice::option::skip_unselected_values>();
+            querier_opt = query::querier(as_mutation_source(), s, permit, range, std::move(slice),
                     service::get_local_sstable_query_read_priority(), trace_state, conf);
         }
         auto& q = *querier_opt;
@@ -2199,7 +2290,7 @@ table::query(schema_ptr s,
         last_pos.emplace(*querier_opt->current_position());
     }
 
-    if (!saved_querier || (querier_opt && !querier_opt->are_limits_reached() && !qs.builder.is_short_read())) {
+    if (querier_opt && (!saved_querier || (!querier_opt->are_limits_reached() && !qs.builder.is_short_read()))) {
         co_await querier_opt->close();
         querier_opt = {};
     }
@@ -2223,6 +2314,14 @@ table::mutation_query(schema_ptr s,
         co_return reconcilable_result();
     }
 
+    utils::latency_counter lc;
+    lc.start();
+    auto record_latency = defer([&] () noexcept {
+        if (_config.cf_stats) {
+            _config.cf_stats->recent_read_latency.add(lc.stop().latency());
+        }
+    });
+
     std::optional<query::querier> querier_opt;
     if (saved_querier) {
         querier_opt = std::move(*saved_querier);
@@ -2531,6 +2630,9 @@ class compaction_group::table_state : public compaction::table_state {
     bool compaction_enforce_min_threshold() const noexcept override {
         return _t.get_config().compaction_enforce_min_threshold || _t._is_bootstrap_or_replace;
     }
+    unsigned token_ranges_per_shard() const noexcept override {
+        return _t.get_config().sstable_token_ranges_per_shard();
+    }
     const sstables::sstable_set& main_sstable_set() const override {
         return *_cg.main_sstables();
     }
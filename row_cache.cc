@@ -11,6 +11,7 @@
 #include <seastar/core/do_with.hh>
 #include <seastar/core/future-util.hh>
 #include <seastar/core/metrics.hh>
+#include <seastar/core/byteorder.hh>
 #include <seastar/util/defer.hh>
 #include "replica/memtable.hh"
 #include <chrono>
@@ -24,6 +25,8 @@
 #include "readers/nonforwardable.hh"
 #include "cache_flat_mutation_reader.hh"
 #include "clustering_key_filter.hh"
+#include "canonical_mutation.hh"
+#include <lz4.h>
 
 namespace cache {
 
@@ -114,6 +117,12 @@ cache_tracker::setup_metrics() {
         sm::make_counter("partition_evictions", sm::description("total number of evicted partitions"), _stats.partition_evictions),
         sm::make_counter("partition_removals", sm::description("total number of invalidated partitions"), _stats.partition_removals),
         sm::make_counter("mispopulations", sm::description("number of entries not inserted by reads"), _stats.mispopulations),
+        sm::make_counter("admission_rejects", sm::description("number of partitions missing in cache which reads did not insert, because of the admission policy or the priority of their table"), _stats.admission_rejects),
+        sm::make_counter("absent_partition_hits", sm::description("number of reads of partitions missing in cache which were known to be absent from sstables, and were not read from them"), _stats.absent_partition_hits),
+        sm::make_gauge("absent_keys_bytes", sm::description("memory used by the keys of partitions known to be absent from sstables"), [this] { return _absent_keys_memory; }),
+        sm::make_counter("partition_demotions", sm::description("number of cold partitions moved out of the cache LRU into the compressed cold tier"), _stats.partition_demotions),
+        sm::make_counter("partition_promotions", sm::description("number of partitions read from the compressed cold tier and put back into cache"), _stats.partition_promotions),
+        sm::make_gauge("cold_tier_bytes", sm::description("memory used by the compressed partitions of the cold tier"), [this] { return _cold_tier_memory; }),
         sm::make_gauge("partitions", sm::description("total number of cached partitions"), _stats.partitions),
         sm::make_gauge("rows", sm::description("total number of cached rows"), _stats.rows),
         sm::make_counter("reads", sm::description("number of started reads"), _stats.reads),
@@ -163,16 +172,42 @@ void cache_tracker::touch(rows_entry& e) {
     _lru.add(e);
 }
 
+cache_tracker::table_stats* cache_tracker::find_table_stats(const cache_entry& entry) noexcept {
+    auto it = _tables.find(entry.schema()->id());
+    return it != _tables.end() ? it->second.get() : nullptr;
+}
+
+lw_shared_ptr<cache_tracker::table_stats> cache_tracker::register_table(table_id id) {
+    auto& ts = _tables[id];
+    if (!ts) {
+        ts = make_lw_shared<table_stats>();
+    }
+    return ts;
+}
+
+void cache_tracker::unregister_table(table_id id) noexcept {
+    auto it = _tables.find(id);
+    if (it != _tables.end() && it->second.use_count() == 1) {
+        _tables.erase(it);
+    }
+}
+
 void cache_tracker::insert(cache_entry& entry) {
     insert(entry.partition());
     ++_stats.partition_insertions;
     ++_stats.partitions;
+    if (auto ts = find_table_stats(entry)) {
+        ++ts->partitions;
+    }
     // partition_range_cursor depends on this to detect invalidation of _end
     _region.allocator().invalidate_references();
 }
 
-void cache_tracker::on_partition_erase() noexcept {
+void cache_tracker::on_partition_erase(const cache_entry& entry) noexcept {
     --_stats.partitions;
+    if (auto ts = find_table_stats(entry)) {
+        --ts->partitions;
+    }
     ++_stats.partition_removals;
     allocator().invalidate_references();
 }
@@ -181,16 +216,86 @@ void cache_tracker::on_partition_merge() noexcept {
     ++_stats.partition_merges;
 }
 
-void cache_tracker::on_partition_hit() noexcept {
+void cache_tracker::on_partition_hit(const dht::decorated_key& dk) noexcept {
     ++_stats.partition_hits;
+    record_access(dk);
 }
 
-void cache_tracker::on_partition_miss() noexcept {
+void cache_tracker::on_partition_miss(const dht::decorated_key& dk) noexcept {
     ++_stats.partition_misses;
+    record_access(dk);
+}
+
+void cache_tracker::set_admission_policy(admission_policy policy) {
+    if (policy == admission_policy::tinylfu && !_sketch) {
+        _sketch = std::make_unique<utils::frequency_sketch>(sketch_counters);
+        _row_evictions_at_sample_start = _stats.row_evictions;
+    }
+    _admission_policy = policy;
+}
+
+void cache_tracker::record_access(const dht::decorated_key& dk) noexcept {
+    bool sample_done = _admission_policy == admission_policy::tinylfu
+            ? _sketch->record(dk.token().raw())
+            : ++_accesses_in_sample % accesses_per_sample == 0;
+    if (sample_done) {
+        _evicted_in_previous_sample = _stats.row_evictions != _row_evictions_at_sample_start;
+        _row_evictions_at_sample_start = _stats.row_evictions;
+    }
+}
+
+unsigned cache_tracker::reads_of(const dht::decorated_key& dk) const noexcept {
+    return _admission_policy == admission_policy::tinylfu ? _sketch->estimate(dk.token().raw()) : 0;
+}
+
+bool cache_tracker::evicting() const noexcept {
+    return _evicted_in_previous_sample || _stats.row_evictions != _row_evictions_at_sample_start;
+}
+
+bool cache_tracker::admit(const dht::decorated_key& dk, caching_options::priority_class priority) noexcept {
+    switch (priority) {
+    case caching_options::priority_class::high:
+        return true;
+    case caching_options::priority_class::low:
+        // Inserting evicts nothing until the cache fills up.
+        if (!evicting()) {
+            return true;
+        }
+        break;
+    case caching_options::priority_class::normal:
+        if (_admission_policy != admission_policy::tinylfu || !evicting()) {
+            return true;
+        }
+        // Admit partitions read at least once before the current miss, so that
+        // scans of partitions read once do not push the working set out.
+        if (_sketch->estimate(dk.token().raw()) >= 2) {
+            return true;
+        }
+        break;
+    }
+    ++_stats.admission_rejects;
+    return false;
+}
+
+void cache_tracker::on_absent_key_insert(absent_partition_key_link& link, size_t bytes) noexcept {
+    _absent_keys.push_back(link);
+    _absent_keys_memory += bytes;
+    while (_absent_keys_memory > _max_absent_keys_memory) {
+        auto& oldest = _absent_keys.front();
+        oldest._owner->erase(oldest);
+    }
+}
+
+void cache_tracker::on_absent_key_erase(absent_partition_key_link& link, size_t bytes) noexcept {
+    link._link.unlink();
+    _absent_keys_memory -= bytes;
 }
 
-void cache_tracker::on_partition_eviction() noexcept {
+void cache_tracker::on_partition_eviction(const cache_entry& entry) noexcept {
     --_stats.partitions;
+    if (auto ts = find_table_stats(entry)) {
+        --ts->partitions;
+    }
     ++_stats.partition_evictions;
 }
 
@@ -365,7 +470,17 @@ class single_partition_populating_reader final : public flat_mutation_reader_v2:
         _read_context->enter_partition(_read_context->range().start()->value().as_decorated_key(), src_and_phase.snapshot, phase);
         return _read_context->create_underlying().then([this, phase] {
           return _read_context->underlying().underlying()().then([this, phase] (auto&& mfopt) {
-            if (!mfopt) {
+            if (!_cache.admit(_read_context->key())) {
+                if (mfopt) {
+                    _reader = read_directly_from_underlying(*_read_context);
+                    this->push_mutation_fragment(std::move(*mfopt));
+                } else {
+                    if (phase == _cache.phase_of(_read_context->range().start()->value())) {
+                        _cache._absent_keys.insert(_read_context->key(), phase);
+                    }
+                    _end_of_stream = true;
+                }
+            } else if (!mfopt) {
                 if (phase == _cache.phase_of(_read_context->range().start()->value())) {
                     _cache._read_section(_cache._tracker.region(), [this] {
                         _cache.find_or_create_missing(_read_context->key());
@@ -438,12 +553,12 @@ void cache_tracker::clear_continuity(cache_entry& ce) noexcept {
     ce.set_continuous(false);
 }
 
-void row_cache::on_partition_hit() {
-    _tracker.on_partition_hit();
+void row_cache::on_partition_hit(const dht::decorated_key& dk) {
+    _tracker.on_partition_hit(dk);
 }
 
-void row_cache::on_partition_miss() {
-    _tracker.on_partition_miss();
+void row_cache::on_partition_miss(const dht::decorated_key& dk) {
+    _tracker.on_partition_miss(dk);
 }
 
 void row_cache::on_row_hit() {
@@ -455,6 +570,26 @@ void row_cache::on_mispopulate() {
     _tracker.on_mispopulate();
 }
 
+bool row_cache::answers(const dht::decorated_key& dk) const noexcept {
+    dht::ring_position_comparator cmp(*_schema);
+    partitions_type::bound_hint hint;
+    auto i = _partitions.lower_bound(dk, cmp, hint);
+    return hint.match || i->continuous() || _absent_keys.contains(dk, phase_of(dk)) || _cold_partitions.contains(dk);
+}
+
+bool row_cache::over_quota() const noexcept {
+    auto max_partitions = _schema->caching_options().max_partitions();
+    return max_partitions && _table_stats->partitions >= max_partitions;
+}
+
+bool row_cache::admit(const dht::decorated_key& dk) noexcept {
+    if (over_quota()) {
+        ++_table_stats->quota_rejects;
+        return false;
+    }
+    return _tracker.admit(dk, _schema->caching_options().priority());
+}
+
 void row_cache::on_row_miss() {
     _stats.misses.mark();
     _tracker.on_row_miss();
@@ -518,9 +653,16 @@ class range_populating_reader {
                         return make_ready_future<read_result>(read_result(std::nullopt, std::nullopt));
                     });
                 }
-                _cache.on_partition_miss();
                 const partition_start& ps = mfopt->as_partition_start();
                 const dht::decorated_key& key = ps.key();
+                _cache.on_partition_miss(key);
+                if (!_cache.admit(key)) {
+                    // The partition stays out of cache, so the next one
+                    // cannot be marked continuous with what precedes it.
+                    _last_key = {};
+                    return make_ready_future<read_result>(
+                            read_result(read_directly_from_underlying(_read_context), std::move(mfopt)));
+                }
                 if (_reader.creation_phase() == _cache.phase_of(key)) {
                     return _cache._read_section(_cache._tracker.region(), [&] {
                         cache_entry& e = _cache.find_or_create_incomplete(ps, _reader.creation_phase(),
@@ -571,7 +713,7 @@ class scanning_and_populating_reader final : public flat_mutation_reader_v2::imp
 private:
     flat_mutation_reader_v2 read_from_entry(cache_entry& ce) {
         _cache.upgrade_entry(ce);
-        _cache.on_partition_hit();
+        _cache.on_partition_hit(ce.key());
         return ce.read(_cache, *_read_context);
     }
 
@@ -738,6 +880,10 @@ row_cache::make_reader_opt(schema_ptr s,
     if (query::is_single_partition(range) && !fwd_mr) {
         tracing::trace(trace_state, "Querying cache for range {} and slice {}",
                 range, seastar::value_of([&slice] { return slice.get_all_ranges(); }));
+        if (!_cold_partitions.empty()) {
+            promote(range.start()->value().as_decorated_key());
+        }
+        bool missed = false;
         auto mr = _read_section(_tracker.region(), [&] () -> flat_mutation_reader_v2_opt {
             dht::ring_position_comparator cmp(*_schema);
             auto&& pos = range.start()->value();
@@ -746,17 +892,28 @@ row_cache::make_reader_opt(schema_ptr s,
             if (hint.match) {
                 cache_entry& e = *i;
                 upgrade_entry(e);
-                on_partition_hit();
+                on_partition_hit(e.key());
                 return e.read(*this, make_context());
             } else if (i->continuous()) {
                 return {};
+            } else if (_absent_keys.contains(pos.as_decorated_key(), phase_of(pos))) {
+                _tracker.on_absent_partition_hit();
+                return {};
             } else {
                 tracing::trace(trace_state, "Range {} not found in cache", range);
-                on_partition_miss();
+                on_partition_miss(pos.as_decorated_key());
+                missed = true;
                 return make_flat_mutation_reader_v2<single_partition_populating_reader>(*this, make_context());
             }
         });
 
+        // The read will populate the cache, make room for it by demoting a cold partition
+        // instead of letting eviction drop it. Eviction itself runs in reclaim context,
+        // where it can't allocate memory for the compressed partition.
+        if (missed && _tracker.max_cold_tier_memory() && _tracker.evicting()) {
+            request_demotion();
+        }
+
         if (mr && fwd == streamed_mutation::forwarding::yes) {
             return make_forwardable(std::move(*mr));
         } else {
@@ -778,21 +935,27 @@ row_cache::~row_cache() {
     with_allocator(_tracker.allocator(), [this] {
         _partitions.clear_and_dispose([this] (cache_entry* p) mutable noexcept {
             if (!p->is_dummy_entry()) {
-                _tracker.on_partition_erase();
+                _tracker.on_partition_erase(*p);
             }
             p->evict(_tracker);
         });
     });
+    if (_table_stats) {
+        _table_stats = {};
+        _tracker.unregister_table(_schema->id());
+    }
 }
 
 void row_cache::clear_now() noexcept {
     with_allocator(_tracker.allocator(), [this] {
         auto it = _partitions.erase_and_dispose(_partitions.begin(), partitions_end(), [this] (cache_entry* p) noexcept {
-            _tracker.on_partition_erase();
+            _tracker.on_partition_erase(*p);
             p->evict(_tracker);
         });
         _tracker.clear_continuity(*it);
     });
+    _absent_keys.clear();
+    _cold_partitions.clear();
 }
 
 template<typename CreateEntry, typename VisitEntry>
@@ -922,7 +1085,7 @@ void row_cache::invalidate_sync(replica::memtable& m) noexcept {
     });
 }
 
-row_cache::phase_type row_cache::phase_of(dht::ring_position_view pos) {
+row_cache::phase_type row_cache::phase_of(dht::ring_position_view pos) const {
     dht::ring_position_less_comparator less(*_schema);
     if (!_prev_snapshot_pos || less(pos, *_prev_snapshot_pos)) {
         return _underlying_phase;
@@ -963,6 +1126,13 @@ future<> row_cache::do_update(external_updater eu, replica::memtable& m, Updater
                 auto cmp = dht::ring_position_comparator(*_schema);
                 {
                     size_t partition_count = 0;
+                    // Both the memtable and cache are sorted by token, so the
+                    // lower bound of the next memtable entry is usually a few
+                    // entries after that of the current one. The cursor is where
+                    // to start looking for it. It's valid until the region is
+                    // reclaimed, or we defer.
+                    std::optional<partitions_type::iterator> cursor;
+                    uint64_t cursor_reclaim_counter = 0;
                     {
                         STAP_PROBE(scylla, row_cache_update_one_batch_start);
                         do {
@@ -970,11 +1140,37 @@ future<> row_cache::do_update(external_updater eu, replica::memtable& m, Updater
                           {
                             if (!update) {
                                 _update_section(_tracker.region(), [&] {
-                                    replica::memtable_entry& mem_e = *m.partitions.begin();
+                                    auto prev_cursor = std::exchange(cursor, std::nullopt);
+                                    auto mem_i = m.partitions.begin();
+                                    replica::memtable_entry& mem_e = *mem_i;
+                                    if (++mem_i != m.partitions.end()) {
+                                        __builtin_prefetch(&*mem_i);
+                                    }
                                     size_entry = mem_e.size_in_allocator_without_rows(_tracker.allocator());
+                                    _absent_keys.erase(mem_e.key());
+                                    _cold_partitions.erase(mem_e.key());
                                     partitions_type::bound_hint hint;
-                                    auto cache_i = _partitions.lower_bound(mem_e.key(), cmp, hint);
+                                    std::optional<partitions_type::iterator> found;
+                                    if (prev_cursor && cursor_reclaim_counter == _tracker.region().reclaim_counter()) {
+                                        found = lower_bound_from(*prev_cursor, mem_e.key(), hint);
+                                    }
+                                    auto cache_i = found ? *found : _partitions.lower_bound(mem_e.key(), cmp, hint);
+                                    // The updater may insert before cache_i, which keeps iterators valid unless
+                                    // there are entries with the same token, and may erase cache_i.
+                                    std::optional<partitions_type::iterator> next_cursor;
+                                    if (!hint.match) {
+                                        if (!hint.key_match) {
+                                            next_cursor = cache_i;
+                                        }
+                                    } else if (cache_i->is_tail()) {
+                                        next_cursor = std::next(cache_i);
+                                    }
                                     update = updater(_update_section, cache_i, mem_e, is_present, real_dirty_acc, hint);
+                                    cursor = next_cursor;
+                                    // Read after the updater, because inserting or erasing a partition
+                                    // invalidates references for other cursors. The section holds the
+                                    // reclaim lock, so nothing moved in the meantime.
+                                    cursor_reclaim_counter = _tracker.region().reclaim_counter();
                                 });
                             }
                             // We use cooperative deferring instead of futures so that
@@ -1030,6 +1226,11 @@ future<> row_cache::update(external_updater eu, replica::memtable& m) {
             mem_e.upgrade_schema(_schema, _tracker.memtable_cleaner());
             return entry.partition().apply_to_incomplete(*_schema, std::move(mem_e.partition()), _tracker.memtable_cleaner(),
                 alloc, _tracker.region(), _tracker, _underlying_phase, acc);
+        } else if (over_quota()) {
+            // The table may not have more partitions in cache, so the range
+            // which would contain this one is no longer complete.
+            _tracker.clear_continuity(*cache_i);
+            return utils::make_empty_coroutine();
         } else if (cache_i->continuous()
                    || with_allocator(standard_allocator(), [&] { return is_present(mem_e.key()); })
                       == partition_presence_checker_result::definitely_doesnt_exist) {
@@ -1067,6 +1268,378 @@ future<> row_cache::update_invalidating(external_updater eu, replica::memtable&
     });
 }
 
+future<std::vector<dht::decorated_key>> row_cache::hot_keys(size_t max_keys) {
+    return seastar::async([this, max_keys] {
+        struct hot_key {
+            dht::decorated_key key;
+            unsigned reads;
+        };
+        // Heap of the keys read most often so far, the least often read on top
+        std::vector<hot_key> hot;
+        auto more_reads = [] (const hot_key& a, const hot_key& b) { return a.reads > b.reads; };
+        // Candidates of one section. The section may be retried after
+        // reclaiming memory, so it builds them from scratch and only the
+        // caller adds them to the heap.
+        struct section_keys {
+            std::vector<hot_key> keys;
+            std::optional<dht::decorated_key> last;
+        };
+        std::optional<dht::decorated_key> last;
+        static constexpr size_t keys_per_section = 128;
+        while (true) {
+            auto section = _read_section(_tracker.region(), [&] {
+                section_keys ret;
+                auto cmp = dht::ring_position_comparator(*_schema);
+                auto it = last ? _partitions.upper_bound(*last, cmp) : _partitions.begin();
+                for (size_t n = 0; n < keys_per_section; ++n, ++it) {
+                    if (it == partitions_end()) {
+                        return ret;
+                    }
+                    auto reads = _tracker.reads_of(it->key());
+                    if (max_keys && hot.size() == max_keys && reads <= hot.front().reads) {
+                        continue;
+                    }
+                    ret.keys.push_back(hot_key{it->key(), reads});
+                }
+                ret.last = std::prev(it)->key();
+                return ret;
+            });
+            for (auto& k : section.keys) {
+                if (max_keys && hot.size() == max_keys) {
+                    if (k.reads <= hot.front().reads) {
+                        continue;
+                    }
+                    std::pop_heap(hot.begin(), hot.end(), more_reads);
+                    hot.pop_back();
+                }
+                hot.push_back(std::move(k));
+                std::push_heap(hot.begin(), hot.end(), more_reads);
+            }
+            if (!section.last) {
+                break;
+            }
+            last = std::move(section.last);
+            seastar::thread::maybe_yield();
+        }
+        std::sort_heap(hot.begin(), hot.end(), more_reads);
+        std::vector<dht::decorated_key> keys;
+        keys.reserve(hot.size());
+        for (auto& k : hot) {
+            keys.push_back(std::move(k.key));
+        }
+        return keys;
+    });
+}
+
+absent_partition_keys::absent_partition_keys(absent_partition_keys&& o) noexcept
+    : _tracker(o._tracker)
+    , _keys(std::move(o._keys))
+{
+    // The nodes, and so the keys the entries point to, move along.
+    for (auto& [key, e] : _keys) {
+        e._owner = this;
+    }
+}
+
+size_t absent_partition_keys::memory_usage(const dht::decorated_key& dk) noexcept {
+    // The map node with its links and color, and the key bytes
+    return sizeof(keys_type::value_type) + 4 * sizeof(void*) + dk.key().external_memory_usage();
+}
+
+absent_partition_keys::keys_type::iterator absent_partition_keys::erase(keys_type::iterator it) noexcept {
+    return with_allocator(standard_allocator(), [&] {
+        _tracker->on_absent_key_erase(it->second, memory_usage(it->first));
+        return _keys.erase(it);
+    });
+}
+
+void absent_partition_keys::erase(absent_partition_key_link& link) noexcept {
+    erase(_keys.find(*static_cast<entry&>(link).key));
+}
+
+void absent_partition_keys::insert(const dht::decorated_key& dk, phase_type phase) {
+    auto max_memory = _tracker->max_absent_keys_memory();
+    auto size = memory_usage(dk);
+    if (size > max_memory) {
+        return;
+    }
+    with_allocator(standard_allocator(), [&] {
+        auto [it, inserted] = _keys.try_emplace(dk, this, phase);
+        if (!inserted) {
+            it->second.phase = phase;
+            return;
+        }
+        it->second.key = &it->first;
+        _tracker->on_absent_key_insert(it->second, size);
+    });
+}
+
+bool absent_partition_keys::contains(const dht::decorated_key& dk, phase_type phase) const noexcept {
+    auto it = _keys.find(dk);
+    return it != _keys.end() && it->second.phase == phase;
+}
+
+void absent_partition_keys::erase(const dht::decorated_key& dk) noexcept {
+    auto it = _keys.find(dk);
+    if (it != _keys.end()) {
+        erase(it);
+    }
+}
+
+void absent_partition_keys::erase(const dht::partition_range& range) noexcept {
+    auto it = _keys.lower_bound(dht::ring_position_view::for_range_start(range));
+    auto end = _keys.lower_bound(dht::ring_position_view::for_range_end(range));
+    while (it != end) {
+        it = erase(it);
+    }
+}
+
+void absent_partition_keys::clear() noexcept {
+    // Erase one by one to keep the memory of the tracker in sync.
+    while (!_keys.empty()) {
+        erase(_keys.begin());
+    }
+}
+
+void absent_partition_keys::set_phase(phase_type phase) noexcept {
+    for (auto& [key, e] : _keys) {
+        e.phase = phase;
+    }
+}
+
+cold_partitions::keys_type::iterator cold_partitions::erase(keys_type::iterator it) noexcept {
+    return with_allocator(standard_allocator(), [&] {
+        _tracker->on_cold_tier_erase(it->second.blob.size());
+        _by_age.erase(it->second.seq);
+        return _partitions.erase(it);
+    });
+}
+
+bool cold_partitions::insert(const dht::decorated_key& dk, const bytes_ostream& data) {
+    auto max_memory = _tracker->max_cold_tier_memory();
+    if (data.size() > max_partition_size) {
+        return false;
+    }
+    return with_allocator(standard_allocator(), [&] {
+        // The fragments are compressed as the blocks of one LZ4 stream, so they
+        // needn't be linearized. Each block is prefixed with its compressed size.
+        size_t max_blob_size = 0;
+        for (bytes_view frag : data.fragments()) {
+            max_blob_size += sizeof(uint32_t) + LZ4_compressBound(frag.size());
+        }
+        bytes blob(bytes::initialized_later(), max_blob_size);
+        std::unique_ptr<LZ4_stream_t, decltype(&LZ4_freeStream)> stream(LZ4_createStream(), &LZ4_freeStream);
+        if (!stream) {
+            throw std::bad_alloc();
+        }
+        auto out = reinterpret_cast<char*>(blob.data());
+        for (bytes_view frag : data.fragments()) {
+            auto bound = LZ4_compressBound(frag.size());
+            auto len = LZ4_compress_fast_continue(stream.get(), reinterpret_cast<const char*>(frag.data()),
+                    out + sizeof(uint32_t), frag.size(), bound, 1);
+            if (len <= 0) {
+                throw std::runtime_error("LZ4 compression failure: LZ4_compress_fast_continue() failed");
+            }
+            write_le<uint32_t>(out, len);
+            out += sizeof(uint32_t) + len;
+        }
+        blob.resize(out - reinterpret_cast<char*>(blob.data()));
+        if (blob.size() > max_memory) {
+            return false;
+        }
+        erase(dk);
+        while (!_by_age.empty() && _tracker->cold_tier_memory() + blob.size() > max_memory) {
+            erase(_by_age.begin()->second);
+        }
+        if (_tracker->cold_tier_memory() + blob.size() > max_memory) {
+            // Taken by the partitions of other caches
+            return false;
+        }
+        auto seq = _next_seq++;
+        auto size = blob.size();
+        auto it = _partitions.emplace(dk, entry{std::move(blob), uint32_t(data.size()), seq}).first;
+        try {
+            _by_age.emplace(seq, it);
+        } catch (...) {
+            _partitions.erase(it);
+            throw;
+        }
+        _tracker->on_cold_tier_insert(size);
+        return true;
+    });
+}
+
+std::optional<mutation> cold_partitions::take(const dht::decorated_key& dk, schema_ptr s) {
+    auto it = _partitions.find(dk);
+    if (it == _partitions.end()) {
+        return std::nullopt;
+    }
+    auto& e = it->second;
+    bytes_ostream data;
+    // Decompressed blocks follow each other, so the stream finds the blocks they refer to.
+    auto out = reinterpret_cast<char*>(data.write_place_holder(e.size));
+    auto out_end = out + e.size;
+    auto in = reinterpret_cast<const char*>(e.blob.data());
+    auto in_end = in + e.blob.size();
+    LZ4_streamDecode_t stream;
+    LZ4_setStreamDecode(&stream, nullptr, 0);
+    while (in != in_end) {
+        auto len = read_le<uint32_t>(in);
+        in += sizeof(uint32_t);
+        auto n = LZ4_decompress_safe_continue(&stream, in, out, len, out_end - out);
+        if (n < 0) {
+            throw std::runtime_error("LZ4 decompression failure: LZ4_decompress_safe_continue() failed");
+        }
+        in += len;
+        out += n;
+    }
+    erase(it);
+    return canonical_mutation(std::move(data)).to_mutation(std::move(s));
+}
+
+bool cold_partitions::contains(const dht::decorated_key& dk) const noexcept {
+    return _partitions.contains(dk);
+}
+
+void cold_partitions::erase(const dht::decorated_key& dk) noexcept {
+    auto it = _partitions.find(dk);
+    if (it != _partitions.end()) {
+        erase(it);
+    }
+}
+
+void cold_partitions::erase(const dht::partition_range& range) noexcept {
+    auto it = _partitions.lower_bound(dht::ring_position_view::for_range_start(range));
+    auto end = _partitions.lower_bound(dht::ring_position_view::for_range_end(range));
+    while (it != end) {
+        it = erase(it);
+    }
+}
+
+void cold_partitions::clear() noexcept {
+    // Erase one by one to keep the memory of the tracker in sync.
+    while (!_partitions.empty()) {
+        erase(_partitions.begin());
+    }
+}
+
+void row_cache::request_demotion() noexcept {
+    static constexpr size_t max_pending_demotions = 1024;
+    _pending_demotions = std::min(_pending_demotions + 1, max_pending_demotions);
+    if (!_demotion_timer.armed()) {
+        _demotion_timer.set_callback([this] { demote_cold_partitions(); });
+        _demotion_timer.arm(timer<>::clock::now());
+    }
+}
+
+void row_cache::demote_cold_partitions() noexcept {
+    size_t demoted = 0;
+    try {
+        for (auto& dk : find_cold_entries()) {
+            if (demote(dk)) {
+                ++demoted;
+                _tracker.on_partition_demotion();
+                if (!--_pending_demotions) {
+                    return;
+                }
+            }
+            if (need_preempt()) {
+                break;
+            }
+        }
+    } catch (...) {
+        // Best effort, eviction will make room instead.
+        clogger.debug("Failed to demote a cold partition: {}", std::current_exception());
+    }
+    if (demoted) {
+        // The least recently used elements may still hold cold entries of this cache.
+        _demotion_timer.arm(timer<>::clock::now());
+    } else {
+        _pending_demotions = 0;
+    }
+}
+
+std::vector<dht::decorated_key> row_cache::find_cold_entries() {
+    static constexpr size_t max_scanned = 64;
+    return _read_section(_tracker.region(), [&] {
+        std::vector<dht::decorated_key> keys;
+        keys.reserve(std::min(_pending_demotions, max_scanned));
+        _tracker.get_lru().find_least_recently_used(max_scanned, [&] (evictable& e) {
+            // The LRU also holds index pages and the rows of other caches.
+            auto* re = dynamic_cast<rows_entry*>(&e);
+            if (!re || !re->is_last_dummy()) {
+                return false;
+            }
+            auto* rows = std::next(mutation_partition::rows_type::iterator(re)).tree_if_end();
+            auto& pv = partition_version::container_of(mutation_partition::container_of(*rows));
+            if (!pv.is_referenced_from_entry()) {
+                return false;
+            }
+            auto& ce = cache_entry::container_of(partition_entry::container_of(pv));
+            if (ce.schema()->id() != _schema->id() || !ce.is_demotable()) {
+                return false;
+            }
+            keys.push_back(ce.key());
+            return keys.size() == _pending_demotions;
+        });
+        return keys;
+    });
+}
+
+bool row_cache::demote(const dht::decorated_key& dk) {
+    return _read_section(_tracker.region(), [&] {
+        partitions_type::bound_hint hint;
+        auto i = _partitions.lower_bound(dk, dht::ring_position_comparator(*_schema), hint);
+        if (!hint.match || !i->is_demotable()) {
+            return false;
+        }
+        cache_entry& ce = *i;
+        bool inserted = with_allocator(standard_allocator(), [&] {
+            auto cm = canonical_mutation(*ce.schema(), ce.key().key(), ce.partition().version()->partition());
+            return _cold_partitions.insert(ce.key(), cm.representation());
+        });
+        if (!inserted) {
+            return false;
+        }
+        with_allocator(_tracker.allocator(), [&] {
+            auto it = partitions_type::iterator(&ce).erase_and_dispose(dht::raw_token_less_comparator{},
+                [this] (cache_entry* p) mutable noexcept {
+                    _tracker.on_partition_erase(*p);
+                    p->evict(_tracker);
+                });
+            _tracker.clear_continuity(*it);
+        });
+        return true;
+    });
+}
+
+void row_cache::promote(const dht::decorated_key& dk) {
+    if (!_cold_partitions.contains(dk) || over_quota()) {
+        return;
+    }
+    try {
+        auto m = _cold_partitions.take(dk, _schema);
+        if (!m) {
+            return;
+        }
+        _populate_section(_tracker.region(), [&] {
+            do_find_or_create_entry(dk, nullptr, [&] (auto i, const partitions_type::bound_hint& hint) {
+                partitions_type::iterator entry = _partitions.emplace_before(i, dk.token().raw(), hint,
+                        _schema, dk, m->partition());
+                _tracker.insert(*entry);
+                entry->set_continuous(i->continuous());
+                return entry;
+            }, [&] (auto i) {
+                // Populated by a scan since, from the same data.
+            });
+        });
+        _tracker.on_partition_promotion();
+    } catch (...) {
+        // The read will go to the underlying source.
+        clogger.debug("Failed to promote partition {}: {}", dk, std::current_exception());
+    }
+}
+
 void row_cache::refresh_snapshot() {
     _underlying = _snapshot_source();
 }
@@ -1100,14 +1673,42 @@ void row_cache::unlink_from_lru(const dht::decorated_key& dk) {
     });
 }
 
+std::optional<row_cache::partitions_type::iterator>
+row_cache::lower_bound_from(partitions_type::iterator it, const dht::decorated_key& key, partitions_type::bound_hint& hint) {
+    static constexpr int max_steps = 8;
+    dht::ring_position_comparator cmp(*_schema);
+    for (int steps = 0; cmp(*it, key) < 0; ++it) {
+        if (++steps > max_steps) {
+            return std::nullopt;
+        }
+    }
+    auto token = key.token().raw();
+    if (it != _partitions.begin() && std::prev(it)->position().token().raw() == token) {
+        return std::nullopt;
+    }
+    hint.key_tail = false;
+    if (it->position().token().raw() != token) {
+        hint.match = false;
+        hint.key_match = false;
+    } else if (it->key().equal(*_schema, key)) {
+        hint.match = true;
+        hint.key_match = true;
+    } else {
+        return std::nullopt;
+    }
+    return it;
+}
+
 void row_cache::invalidate_locked(const dht::decorated_key& dk) {
+    _absent_keys.erase(dk);
+    _cold_partitions.erase(dk);
     auto pos = _partitions.lower_bound(dk, dht::ring_position_comparator(*_schema));
     if (pos == partitions_end() || !pos->key().equal(*_schema, dk)) {
         _tracker.clear_continuity(*pos);
     } else {
         auto it = pos.erase_and_dispose(dht::raw_token_less_comparator{},
             [this](cache_entry* p) mutable noexcept {
-                _tracker.on_partition_erase();
+                _tracker.on_partition_erase(*p);
                 p->evict(_tracker);
             });
         _tracker.clear_continuity(*it);
@@ -1133,6 +1734,8 @@ future<> row_cache::invalidate(external_updater eu, dht::partition_range_vector&
 
             for (auto&& range : ranges) {
                 _prev_snapshot_pos = dht::ring_position_view::for_range_start(range);
+                _absent_keys.erase(range);
+                _cold_partitions.erase(range);
                 seastar::thread::maybe_yield();
 
                 while (true) {
@@ -1144,7 +1747,7 @@ future<> row_cache::invalidate(external_updater eu, dht::partition_range_vector&
                             while (it != end) {
                                 it = it.erase_and_dispose(dht::raw_token_less_comparator{},
                                     [&] (cache_entry* p) mutable noexcept {
-                                        _tracker.on_partition_erase();
+                                        _tracker.on_partition_erase(*p);
                                         p->evict(_tracker);
                                     });
                                 // it != end is necessary for correctness. We cannot set _prev_snapshot_pos to end->position()
@@ -1177,11 +1780,15 @@ future<> row_cache::invalidate(external_updater eu, dht::partition_range_vector&
 
 void row_cache::evict() {
     while (_tracker.region().evict_some() == memory::reclaiming_result::reclaimed_something) {}
+    _cold_partitions.clear();
 }
 
 row_cache::row_cache(schema_ptr s, snapshot_source src, cache_tracker& tracker, is_continuous cont)
     : _tracker(tracker)
     , _schema(std::move(s))
+    , _table_stats(_tracker.register_table(_schema->id()))
+    , _absent_keys(_schema, _tracker)
+    , _cold_partitions(_schema, _tracker)
     , _partitions(dht::raw_token_less_comparator{})
     , _underlying(src())
     , _snapshot_source(std::move(src))
@@ -1216,7 +1823,7 @@ void cache_entry::on_evicted(cache_tracker& tracker) noexcept {
     row_cache::partitions_type::iterator it(this);
     std::next(it)->set_continuous(false);
     evict(tracker);
-    tracker.on_partition_eviction();
+    tracker.on_partition_eviction(*this);
     it.erase(dht::raw_token_less_comparator{});
 }
 
@@ -1345,7 +1952,13 @@ future<> row_cache::do_update(row_cache::external_updater eu, row_cache::interna
             _prev_snapshot_pos = {};
             _prev_snapshot = {};
             if (f.failed()) {
+                _absent_keys.clear();
+                _cold_partitions.clear();
                 clogger.warn("Failure during cache update: {}", f.get_exception());
+            } else {
+                // The updater erased the keys it changed, the remaining ones
+                // are still absent in the new snapshot.
+                _absent_keys.set_phase(_underlying_phase);
             }
         });
       });
@@ -12,7 +12,10 @@
 #include <boost/intrusive/set.hpp>
 #include <boost/intrusive/parent_from_member.hpp>
 
+#include <map>
+
 #include <seastar/core/memory.hh>
+#include <seastar/core/timer.hh>
 #include <seastar/util/noncopyable_function.hh>
 
 #include "mutation_partition.hh"
@@ -32,6 +35,8 @@ namespace bi = boost::intrusive;
 class row_cache;
 class cache_tracker;
 class flat_mutation_reader_v2;
+class mutation;
+class bytes_ostream;
 
 namespace replica {
 class memtable_entry;
@@ -141,9 +146,121 @@ class cache_entry {
 
     bool is_dummy_entry() const noexcept { return _flags._dummy_entry; }
 
+    // Whether the entry holds the whole partition, which is not empty, in a
+    // single version which no reader uses.
+    bool is_demotable() const noexcept {
+        return !is_dummy_entry() && !_pe._snapshot && _pe._version->is_single()
+            && _pe._version->partition().is_fully_continuous() && !_pe._version->partition().empty();
+    }
+
     friend std::ostream& operator<<(std::ostream&, cache_entry&);
 };
 
+// Orders keys of partitions of a schema by ring position.
+struct decorated_key_less {
+    using is_transparent = void;
+    schema_ptr s;
+    bool operator()(dht::ring_position_view a, dht::ring_position_view b) const {
+        return dht::ring_position_tri_compare(*s, a, b) < 0;
+    }
+};
+
+// Keys of partitions which single-partition reads found absent in the
+// underlying mutation source of a row_cache, but did not insert into it,
+// so that reading them again does not have to go to the underlying source.
+//
+// A key is valid for the population phase in which it was found absent.
+// Synchronizers erase the keys they add to the underlying source, and then
+// move the remaining ones to the new phase.
+//
+// The keys of all caches of a tracker take at most
+// cache_tracker::max_absent_keys_memory(), the oldest key of any cache is
+// dropped first.
+class absent_partition_keys {
+public:
+    using phase_type = utils::phased_barrier::phase_type;
+private:
+    struct entry : public absent_partition_key_link {
+        phase_type phase;
+        // Of the node holding this entry, for erasing it from the tracker
+        const dht::decorated_key* key = nullptr;
+
+        entry(absent_partition_keys* owner, phase_type phase) noexcept : absent_partition_key_link(owner), phase(phase) {}
+    };
+    using keys_type = std::map<dht::decorated_key, entry, decorated_key_less>;
+    cache_tracker* _tracker;
+    keys_type _keys;
+private:
+    static size_t memory_usage(const dht::decorated_key&) noexcept;
+    keys_type::iterator erase(keys_type::iterator) noexcept;
+    // Erases the entry, on behalf of the tracker.
+    void erase(absent_partition_key_link&) noexcept;
+    friend class cache_tracker;
+public:
+    absent_partition_keys(schema_ptr s, cache_tracker& tracker) : _tracker(&tracker), _keys(decorated_key_less{std::move(s)}) {}
+    absent_partition_keys(absent_partition_keys&&) noexcept;
+    ~absent_partition_keys() { clear(); }
+    // Records that the key is absent in the snapshot of given phase,
+    // dropping the oldest keys to fit into the memory the tracker allows.
+    void insert(const dht::decorated_key&, phase_type);
+    // Tells whether the key is known to be absent in the snapshot of given phase.
+    bool contains(const dht::decorated_key&, phase_type) const noexcept;
+    void erase(const dht::decorated_key&) noexcept;
+    void erase(const dht::partition_range&) noexcept;
+    void clear() noexcept;
+    // Declares all keys absent in the snapshot of given phase.
+    void set_phase(phase_type) noexcept;
+    size_t size() const noexcept { return _keys.size(); }
+};
+
+// Partitions which a row_cache moved out of its entries because they were
+// among the least recently used ones in the LRU, kept serialized as a
+// canonical_mutation and LZ4-compressed. Single-partition reads which miss
+// in cache put them back into cache before reading, instead of going to the
+// underlying source.
+//
+// Only partitions held in full, in a single version which no reader uses,
+// are moved here, so the data of a key is the same as that of the cache
+// entry it replaces. Synchronizers erase the keys they change, as they
+// update or invalidate cache entries, so keys stay valid across phases.
+//
+// The partitions of all caches of a tracker hold at most
+// cache_tracker::max_cold_tier_memory(), the oldest one is dropped first.
+class cold_partitions {
+    struct entry {
+        bytes blob;
+        uint32_t size; // uncompressed
+        uint64_t seq;
+    };
+    using keys_type = std::map<dht::decorated_key, entry, decorated_key_less>;
+    cache_tracker* _tracker;
+    keys_type _partitions;
+    // Partitions in the order of insertion
+    std::map<uint64_t, keys_type::iterator> _by_age;
+    uint64_t _next_seq = 0;
+private:
+    keys_type::iterator erase(keys_type::iterator) noexcept;
+public:
+    // Partitions larger than this when serialized are not kept
+    static constexpr size_t max_partition_size = 128 * 1024;
+
+    cold_partitions(schema_ptr s, cache_tracker& tracker) : _tracker(&tracker), _partitions(decorated_key_less{std::move(s)}) {}
+    cold_partitions(cold_partitions&&) = default;
+    ~cold_partitions() { clear(); }
+    // Compresses and stores the partition, serialized as a canonical_mutation,
+    // dropping the oldest partitions to fit into the memory the tracker allows.
+    // Returns false if the partition doesn't fit.
+    bool insert(const dht::decorated_key&, const bytes_ostream&);
+    // Removes the partition and returns it, converted to given schema.
+    std::optional<mutation> take(const dht::decorated_key&, schema_ptr);
+    bool contains(const dht::decorated_key&) const noexcept;
+    void erase(const dht::decorated_key&) noexcept;
+    void erase(const dht::partition_range&) noexcept;
+    void clear() noexcept;
+    size_t size() const noexcept { return _partitions.size(); }
+    bool empty() const noexcept { return _partitions.empty(); }
+};
+
 //
 // A data source which wraps another data source such that data obtained from the underlying data source
 // is cached in-memory in order to serve queries faster.
@@ -214,6 +331,13 @@ class row_cache final {
     cache_tracker& _tracker;
     stats _stats{};
     schema_ptr _schema;
+    lw_shared_ptr<cache_tracker::table_stats> _table_stats;
+    absent_partition_keys _absent_keys;
+    cold_partitions _cold_partitions;
+    // Demotions requested by reads which missed while the cache was evicting,
+    // done by _demotion_timer outside of reads.
+    size_t _pending_demotions = 0;
+    seastar::timer<> _demotion_timer;
     partitions_type _partitions; // Cached partitions are complete.
 
     // The snapshots used by cache are versioned. The version number of a snapshot is
@@ -259,13 +383,31 @@ class row_cache final {
     logalloc::allocating_section _read_section;
     flat_mutation_reader_v2 create_underlying_reader(cache::read_context&, mutation_source&, const dht::partition_range&);
     flat_mutation_reader_v2 make_scanning_reader(const dht::partition_range&, std::unique_ptr<cache::read_context>);
-    void on_partition_hit();
-    void on_partition_miss();
+    void on_partition_hit(const dht::decorated_key&);
+    void on_partition_miss(const dht::decorated_key&);
     void on_row_hit();
     void on_row_miss();
     void on_static_row_insert();
     void on_mispopulate();
+    // Whether the table has as many partitions in cache as its quota allows.
+    bool over_quota() const noexcept;
+    // Tells whether a read which missed the partition should insert it,
+    // given the cache quota and priority of the table.
+    bool admit(const dht::decorated_key&) noexcept;
     void upgrade_entry(cache_entry&);
+    // Asks for a cold entry of this cache to be moved to _cold_partitions, in the background.
+    void request_demotion() noexcept;
+    // Moves pending cold entries to _cold_partitions until preempted,
+    // rearming _demotion_timer if some are left.
+    void demote_cold_partitions() noexcept;
+    // Returns the keys of the least recently used entries of this cache which
+    // can be demoted, among the least recently used elements of the LRU, at most
+    // as many as there are pending demotions.
+    std::vector<dht::decorated_key> find_cold_entries();
+    // Moves the entry of the key to _cold_partitions if it can still be demoted.
+    bool demote(const dht::decorated_key&);
+    // Puts the partition back into cache if it is in _cold_partitions.
+    void promote(const dht::decorated_key&);
     void invalidate_locked(const dht::decorated_key&);
     void clear_now() noexcept;
 
@@ -304,6 +446,12 @@ class row_cache final {
         return std::prev(_partitions.end());
     }
 
+    // Finds the lower bound of the key by walking forward from the given entry,
+    // which must not be after it, for at most a few entries.
+    // Fails if another entry has the key's token, because then the hint would
+    // have to locate the key among the entries of that token.
+    std::optional<partitions_type::iterator> lower_bound_from(partitions_type::iterator, const dht::decorated_key&, partitions_type::bound_hint&);
+
     // Only active phases are accepted.
     // Reference valid only until next deferring point.
     mutation_source& snapshot_for_phase(phase_type);
@@ -312,7 +460,7 @@ class row_cache final {
     // snapshot_for_phase() can be called to obtain mutation_source for given phase, but
     // only until the next deferring point.
     // Should be only called outside update().
-    phase_type phase_of(dht::ring_position_view);
+    phase_type phase_of(dht::ring_position_view) const;
 
     struct snapshot_and_phase {
         mutation_source& snapshot;
@@ -329,6 +477,7 @@ class row_cache final {
     // The Updater gets invoked for every entry in the memtable with a lower bound iterator
     // into _partitions (cache_i), and the memtable entry.
     // It is invoked inside allocating section and in the context of cache's allocator.
+    // It may insert entries before cache_i and erase cache_i, but no other entries.
     // All memtable entries will be removed.
     template <typename Updater>
     future<> do_update(external_updater, replica::memtable& m, Updater func);
@@ -392,6 +541,14 @@ class row_cache final {
     }
 
     const stats& stats() const { return _stats; }
+    // Occupancy of the cache by this table
+    const cache_tracker::table_stats& get_table_stats() const { return *_table_stats; }
+    const absent_partition_keys& get_absent_keys() const { return _absent_keys; }
+    const cold_partitions& get_cold_partitions() const { return _cold_partitions; }
+    // Tells whether a single-partition read of the key would be answered by
+    // the cache alone: from an entry, a continuous range, a key known to be
+    // absent or a cold partition, without reading the underlying source.
+    bool answers(const dht::decorated_key&) const noexcept;
 public:
     // Populate cache from given mutation, which must be fully continuous.
     // Intended to be used only in tests.
@@ -414,6 +571,10 @@ class row_cache final {
     // as few elements as possible.
     future<> update_invalidating(external_updater, replica::memtable&);
 
+    // Returns keys of at most max_keys (0 for no limit) cached partitions,
+    // the most often read first when the tracker counts reads.
+    future<std::vector<dht::decorated_key>> hot_keys(size_t max_keys);
+
     // Refreshes snapshot. Must only be used if logical state in the underlying data
     // source hasn't changed.
     void refresh_snapshot();
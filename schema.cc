@@ -35,6 +35,7 @@
 #include "utils/rjson.hh"
 #include "tombstone_gc_options.hh"
 #include "db/per_partition_rate_limit_extension.hh"
+#include "db/sstable_filter_extension.hh"
 
 constexpr int32_t schema::NAME_LENGTH;
 
@@ -1344,6 +1345,16 @@ const ::tombstone_gc_options& schema::tombstone_gc_options() const {
     return default_tombstone_gc_options;
 }
 
+const db::sstable_filter_options& schema::sstable_filter_options() const {
+    static const db::sstable_filter_options default_sstable_filter_options;
+    const auto& schema_extensions = _raw._extensions;
+
+    if (auto it = schema_extensions.find(db::sstable_filter_extension::NAME); it != schema_extensions.end()) {
+        return dynamic_pointer_cast<db::sstable_filter_extension>(it->second)->get_options();
+    }
+    return default_sstable_filter_options;
+}
+
 schema_builder& schema_builder::with_cdc_options(const cdc::options& opts) {
     add_extension(cdc::cdc_extension::NAME, ::make_shared<cdc::cdc_extension>(opts));
     return *this;
@@ -1359,6 +1370,11 @@ schema_builder& schema_builder::with_per_partition_rate_limit_options(const db::
     return *this;
 }
 
+schema_builder& schema_builder::with_sstable_filter_options(const db::sstable_filter_options& opts) {
+    add_extension(db::sstable_filter_extension::NAME, ::make_shared<db::sstable_filter_extension>(opts));
+    return *this;
+}
+
 schema_builder& schema_builder::set_paxos_grace_seconds(int32_t seconds) {
     add_extension(db::paxos_grace_seconds_extension::NAME, ::make_shared<db::paxos_grace_seconds_extension>(seconds));
     return *this;
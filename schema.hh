@@ -30,6 +30,7 @@
 #include "timestamp.hh"
 #include "tombstone_gc_options.hh"
 #include "db/per_partition_rate_limit_options.hh"
+#include "db/sstable_filter_options.hh"
 #include "schema_fwd.hh"
 #include "data_dictionary/keyspace_element.hh"
 
@@ -798,6 +799,8 @@ class schema final : public enable_lw_shared_from_this<schema>, public data_dict
 
     const ::tombstone_gc_options& tombstone_gc_options() const;
 
+    const db::sstable_filter_options& sstable_filter_options() const;
+
     const db::per_partition_rate_limit_options& per_partition_rate_limit_options() const {
         return _raw._per_partition_rate_limit_options;
     }
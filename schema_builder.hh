@@ -16,6 +16,7 @@
 
 namespace db {
 class per_partition_rate_limit_options;
+class sstable_filter_options;
 }
 
 struct schema_builder {
@@ -285,6 +286,7 @@ struct schema_builder {
     schema_builder& with_cdc_options(const cdc::options&);
     schema_builder& with_tombstone_gc_options(const tombstone_gc_options& opts);
     schema_builder& with_per_partition_rate_limit_options(const db::per_partition_rate_limit_options&);
+    schema_builder& with_sstable_filter_options(const db::sstable_filter_options&);
     
     default_names get_default_names() const {
         return default_names(_raw);
@@ -26,6 +26,8 @@ enum class component_type {
     TemporaryTOC,
     TemporaryStatistics,
     Scylla,
+    Partitions,
+    CompressionDictionary,
     Unknown,
 };
 
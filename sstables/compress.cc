@@ -8,12 +8,17 @@
 
 #include <stdexcept>
 #include <cstdlib>
+#include <algorithm>
+#include <unordered_map>
 
 #include <boost/range/algorithm/find_if.hpp>
 #include <seastar/core/align.hh>
 #include <seastar/core/bitops.hh>
 #include <seastar/core/byteorder.hh>
 #include <seastar/core/fstream.hh>
+#include <seastar/core/loop.hh>
+#include <seastar/core/lowres_clock.hh>
+#include <seastar/util/backtrace.hh>
 
 #include "../compress.hh"
 #include "compress.hh"
@@ -268,7 +273,11 @@ local_compression::local_compression(const compression& c)
             return std::nullopt;
         });
     }())
-{}
+{
+    if (_compressor && !c.dictionary.value.empty()) {
+        _compressor = _compressor->with_dictionary(c.dictionary.value);
+    }
+}
 
 size_t local_compression::uncompress(const char* input,
                 size_t input_len, char* output, size_t output_len) const {
@@ -468,29 +477,160 @@ enum class compressed_checksum_mode {
     checksum_all,
 };
 
+// Dictionaries trained for the sstables of each table written on this shard.
+// The next sstables of the table reuse them for a while, so that the
+// unpreemptible training runs about once per table and period, rather than
+// for every sstable.
+class trained_dictionaries {
+    struct entry {
+        size_t dictionary_size;
+        // Empty if training failed
+        bytes dictionary;
+        lowres_clock::time_point trained_at;
+    };
+    std::unordered_map<table_id, entry> _entries;
+public:
+    static constexpr auto reuse_period = std::chrono::hours(1);
+    static constexpr size_t max_entries = 256;
+
+    // The dictionary to use for a new sstable of the table, or
+    // std::nullopt if one has to be trained.
+    std::optional<bytes> get(table_id id, size_t dictionary_size) const {
+        auto it = _entries.find(id);
+        if (it == _entries.end() || it->second.dictionary_size != dictionary_size
+                || lowres_clock::now() - it->second.trained_at > reuse_period) {
+            return std::nullopt;
+        }
+        return it->second.dictionary;
+    }
+
+    void put(table_id id, size_t dictionary_size, bytes dictionary) {
+        if (_entries.size() >= max_entries && !_entries.contains(id)) {
+            _entries.erase(std::ranges::min_element(_entries, std::less<>(), [] (const auto& e) { return e.second.trained_at; }));
+        }
+        _entries.insert_or_assign(id, entry{dictionary_size, std::move(dictionary), lowres_clock::now()});
+    }
+};
+
+static thread_local trained_dictionaries dictionaries;
+
 // compressed_file_data_sink_impl works as a filter for a file output stream,
 // where the buffer flushed will be compressed and its checksum computed, then
 // the result passed to a regular output stream.
 template <typename ChecksumType, compressed_checksum_mode mode>
 requires ChecksumUtils<ChecksumType>
 class compressed_file_data_sink_impl : public data_sink_impl {
+    // Upper bound on the data held back to train a dictionary on. Training
+    // needs it in one contiguous buffer and runs without preemption, so this
+    // is kept well below what zstd would consider ideal (~100 times the size
+    // of the dictionary).
+    static constexpr size_t max_dictionary_samples_size = 256 * 1024;
+    // Samples are split into pieces of at most this size, which is what
+    // the trainer expects to see from small chunks.
+    static constexpr size_t max_dictionary_sample_size = 4 * 1024;
+
     output_stream<char> _out;
     sstables::compression* _compression_metadata;
     sstables::compression::segmented_offsets::writer _offsets;
     sstables::local_compression _compression;
     size_t _pos = 0;
     uint32_t _full_checksum;
+    // Chunks held back until the dictionary is trained, if the compressor
+    // wants one.
+    std::vector<temporary_buffer<char>> _samples;
+    size_t _samples_size = 0;
+    bool _training = false;
+    // The table the dictionary is trained for and reused by, if any.
+    std::optional<table_id> _table;
 public:
-    compressed_file_data_sink_impl(output_stream<char> out, sstables::compression* cm, sstables::local_compression lc)
+    compressed_file_data_sink_impl(output_stream<char> out, sstables::compression* cm, sstables::local_compression lc,
+            std::optional<table_id> table)
             : _out(std::move(out))
             , _compression_metadata(cm)
             , _offsets(_compression_metadata->offsets.get_writer())
             , _compression(lc)
             , _full_checksum(ChecksumType::init_checksum())
-    {}
+            , _table(table)
+    {
+        if (!_compression || !_compression.compressor()->dictionary_size()) {
+            return;
+        }
+        auto dict = _table ? dictionaries.get(*_table, _compression.compressor()->dictionary_size()) : std::nullopt;
+        if (dict) {
+            use_dictionary(std::move(*dict));
+        } else {
+            _training = true;
+        }
+    }
 
     virtual future<> put(net::packet data) override { abort(); }
     virtual future<> put(temporary_buffer<char> buf) override {
+        if (_training) {
+            _samples_size += buf.size();
+            _samples.push_back(std::move(buf));
+            if (_samples_size < samples_target()) {
+                return make_ready_future<>();
+            }
+            return train_and_flush_samples();
+        }
+        return compress_and_write(std::move(buf));
+    }
+    virtual future<> close() override {
+        auto f = _training ? train_and_flush_samples() : make_ready_future<>();
+        return f.then([this] {
+            return _out.close();
+        });
+    }
+
+    virtual size_t buffer_size() const noexcept override {
+        return _compression_metadata->uncompressed_chunk_length();
+    }
+private:
+    size_t samples_target() const {
+        return std::min(_compression.compressor()->dictionary_size() * 100, max_dictionary_samples_size);
+    }
+
+    // Trains the dictionary on the chunks held back so far, switches to
+    // compressing with it, and writes those chunks out.
+    future<> train_and_flush_samples() {
+        _training = false;
+        if (_samples.empty()) {
+            return make_ready_future<>();
+        }
+        temporary_buffer<char> samples(_samples_size);
+        std::vector<size_t> sample_sizes;
+        size_t pos = 0;
+        for (auto& b : _samples) {
+            std::copy_n(b.get(), b.size(), samples.get_write() + pos);
+            pos += b.size();
+            for (size_t i = 0; i < b.size(); i += max_dictionary_sample_size) {
+                sample_sizes.push_back(std::min(b.size() - i, max_dictionary_sample_size));
+            }
+        }
+        auto dict = _compression.compressor()->train_dictionary(samples.get(), sample_sizes);
+        if (dict.empty()) {
+            sstables::sstlog.debug("Failed to train a compression dictionary on {} bytes, compressing without one", _samples_size);
+        }
+        if (_table) {
+            dictionaries.put(*_table, _compression.compressor()->dictionary_size(), dict);
+        }
+        use_dictionary(std::move(dict));
+        return do_for_each(_samples, [this] (temporary_buffer<char>& b) {
+            return compress_and_write(std::move(b));
+        }).then([this] {
+            _samples.clear();
+            _samples_size = 0;
+        });
+    }
+
+    void use_dictionary(bytes dict) {
+        if (!dict.empty()) {
+            _compression = sstables::local_compression(_compression.compressor()->with_dictionary(dict));
+            _compression_metadata->dictionary.value = std::move(dict);
+        }
+    }
+
+    future<> compress_and_write(temporary_buffer<char> buf) {
         auto output_len = _compression.compress_max_size(buf.size());
 
         // account space for checksum that goes after compressed data.
@@ -530,29 +670,24 @@ class compressed_file_data_sink_impl : public data_sink_impl {
         auto f = _out.write(compressed.get(), compressed.size());
         return f.then([compressed = std::move(compressed)] {});
     }
-    virtual future<> close() override {
-        return _out.close();
-    }
-
-    virtual size_t buffer_size() const noexcept override {
-        return _compression_metadata->uncompressed_chunk_length();
-    }
 };
 
 template <typename ChecksumType, compressed_checksum_mode mode>
 requires ChecksumUtils<ChecksumType>
 class compressed_file_data_sink : public data_sink {
 public:
-    compressed_file_data_sink(output_stream<char> out, sstables::compression* cm, sstables::local_compression lc)
+    compressed_file_data_sink(output_stream<char> out, sstables::compression* cm, sstables::local_compression lc,
+            std::optional<table_id> table)
         : data_sink(std::make_unique<compressed_file_data_sink_impl<ChecksumType, mode>>(
-                std::move(out), cm, std::move(lc))) {}
+                std::move(out), cm, std::move(lc), table)) {}
 };
 
 template <typename ChecksumType, compressed_checksum_mode mode>
 requires ChecksumUtils<ChecksumType>
 inline output_stream<char> make_compressed_file_output_stream(output_stream<char> out,
          sstables::compression* cm,
-         const compression_parameters& cp) {
+         const compression_parameters& cp,
+         std::optional<table_id> table) {
     // buffer of output stream is set to chunk length, because flush must
     // happen every time a chunk was filled up.
 
@@ -564,7 +699,7 @@ inline output_stream<char> make_compressed_file_output_stream(output_stream<char
     // defaults to 1.0.
     cm->options.elements.push_back({"crc_check_chance", "1.0"});
 
-    return output_stream<char>(compressed_file_data_sink<ChecksumType, mode>(std::move(out), cm, p));
+    return output_stream<char>(compressed_file_data_sink<ChecksumType, mode>(std::move(out), cm, p, table));
 }
 
 input_stream<char> sstables::make_compressed_file_k_l_format_input_stream(file f,
@@ -582,8 +717,112 @@ input_stream<char> sstables::make_compressed_file_m_format_input_stream(file f,
 
 output_stream<char> sstables::make_compressed_file_m_format_output_stream(output_stream<char> out,
         sstables::compression* cm,
-        const compression_parameters& cp) {
+        const compression_parameters& cp,
+        std::optional<table_id> table) {
     return make_compressed_file_output_stream<crc32_utils, compressed_checksum_mode::checksum_all>(
-            std::move(out), cm, cp);
+            std::move(out), cm, cp, table);
+}
+
+
+// decompressed_file_impl presents the uncompressed contents of a compressed
+// file as a read-only file, so that they can be cached by cached_file.
+template <typename ChecksumType>
+requires ChecksumUtils<ChecksumType>
+class decompressed_file_impl : public file_impl {
+    file _file;
+    sstables::compression* _compression_metadata;
+    sstables::local_compression _compression;
+private:
+    [[noreturn]] void unsupported() {
+        throw_with_backtrace<std::logic_error>("unsupported operation");
+    }
+
+    // Verifies the checksum of the chunk at addr, whose compressed data
+    // starts at buf, and uncompresses it into out. Returns the length of the
+    // uncompressed chunk.
+    size_t uncompress_chunk(const sstables::compression::chunk_and_offset& addr, const char* buf, char* out, size_t out_len) {
+        auto compressed_len = addr.chunk_len - 4;
+        auto expected_checksum = read_be<uint32_t>(buf + compressed_len);
+        auto actual_checksum = ChecksumType::checksum(buf, compressed_len);
+        if (expected_checksum != actual_checksum) {
+            throw sstables::malformed_sstable_exception(format("compressed chunk of size {} at file offset {} failed checksum, expected={}, actual={}",
+                    addr.chunk_len, addr.chunk_start, expected_checksum, actual_checksum));
+        }
+        return _compression.uncompress(buf, compressed_len, out, out_len);
+    }
+public:
+    decompressed_file_impl(file f, sstables::compression* cm)
+        : file_impl(*get_file_impl(f))
+        , _file(std::move(f))
+        , _compression_metadata(cm)
+        , _compression(*cm)
+    { }
+
+    // unsupported
+    virtual future<size_t> write_dma(uint64_t pos, const void* buffer, size_t len, const io_priority_class& pc) override { unsupported(); }
+    virtual future<size_t> write_dma(uint64_t pos, std::vector<iovec> iov, const io_priority_class& pc) override { unsupported(); }
+    virtual future<> flush(void) override { unsupported(); }
+    virtual future<> truncate(uint64_t length) override { unsupported(); }
+    virtual future<> discard(uint64_t offset, uint64_t length) override { unsupported(); }
+    virtual future<> allocate(uint64_t position, uint64_t length) override { unsupported(); }
+    virtual subscription<directory_entry> list_directory(std::function<future<>(directory_entry)>) override { unsupported(); }
+    virtual std::unique_ptr<seastar::file_handle_impl> dup() override { unsupported(); }
+    virtual future<size_t> read_dma(uint64_t pos, void* buffer, size_t len, const io_priority_class& pc) override { unsupported(); }
+    virtual future<size_t> read_dma(uint64_t pos, std::vector<iovec> iov, const io_priority_class& pc) override { unsupported(); }
+
+    virtual future<struct stat> stat(void) override { return _file.stat(); }
+    virtual future<uint64_t> size(void) override {
+        return make_ready_future<uint64_t>(_compression_metadata->uncompressed_file_length());
+    }
+    // The compressed file is owned by the caller.
+    virtual future<> close() override { return make_ready_future<>(); }
+
+    virtual future<temporary_buffer<uint8_t>> dma_read_bulk(uint64_t offset, size_t size, const io_priority_class& pc) override {
+        auto end = std::min<uint64_t>(offset + size, _compression_metadata->uncompressed_file_length());
+        if (offset >= end) {
+            return make_ready_future<temporary_buffer<uint8_t>>();
+        }
+        auto accessor = _compression_metadata->offsets.get_accessor();
+        auto first = _compression_metadata->locate(offset, accessor);
+        auto last = _compression_metadata->locate(end - 1, accessor);
+        return _file.dma_read_exactly<char>(first.chunk_start, last.chunk_start + last.chunk_len - first.chunk_start, pc).then(
+                [this, offset, end, base = first.chunk_start] (temporary_buffer<char> buf) {
+            auto result = temporary_buffer<uint8_t>::aligned(_memory_dma_alignment, end - offset);
+            auto out = reinterpret_cast<char*>(result.get_write());
+            auto chunk_len = _compression_metadata->uncompressed_chunk_length();
+            auto accessor = _compression_metadata->offsets.get_accessor();
+            temporary_buffer<char> partial;
+            for (uint64_t pos = offset - offset % chunk_len; pos < end; pos += chunk_len) {
+                auto addr = _compression_metadata->locate(pos, accessor);
+                auto chunk_end = std::min<uint64_t>(pos + chunk_len, _compression_metadata->uncompressed_file_length());
+                if (pos >= offset && chunk_end <= end) {
+                    auto len = uncompress_chunk(addr, buf.get() + (addr.chunk_start - base), out + (pos - offset), chunk_end - pos);
+                    if (len != chunk_end - pos) {
+                        throw sstables::malformed_sstable_exception(format("compressed chunk at file offset {} uncompressed to {} bytes, expected {}",
+                                addr.chunk_start, len, chunk_end - pos));
+                    }
+                } else {
+                    // Only part of the chunk is wanted, at the edges of the range
+                    if (!partial) {
+                        partial = temporary_buffer<char>(chunk_len);
+                    }
+                    auto len = uncompress_chunk(addr, buf.get() + (addr.chunk_start - base), partial.get_write(), partial.size());
+                    auto from = std::max(pos, offset);
+                    auto to = std::min(pos + len, end);
+                    if (to > from) {
+                        std::copy_n(partial.get() + (from - pos), to - from, out + (from - offset));
+                    }
+                }
+            }
+            return result;
+        });
+    }
+};
+
+file sstables::make_decompressed_k_l_format_file(file f, sstables::compression* cm) {
+    return file(make_shared<decompressed_file_impl<adler32_utils>>(std::move(f), cm));
 }
 
+file sstables::make_decompressed_m_format_file(file f, sstables::compression* cm) {
+    return file(make_shared<decompressed_file_impl<crc32_utils>>(std::move(f), cm));
+}
@@ -30,12 +30,14 @@
 // of us verifying the checksum of each chunk we read.
 //
 // This implementation does not cache the compressed disk blocks (which
-// are read using O_DIRECT), nor uncompressed data. We intend to cache high-
-// level Cassandra rows, not disk blocks.
+// are read using O_DIRECT). Uncompressed data can be cached by putting a
+// cached_file over the file returned by make_decompressed_*_format_file(),
+// so that hot chunks are not uncompressed again on every read.
 
 #include <vector>
 #include <cstdint>
 #include <iterator>
+#include <optional>
 
 #include <seastar/core/file.hh>
 #include <seastar/core/seastar.hh>
@@ -43,6 +45,7 @@
 #include <seastar/core/fstream.hh>
 
 #include "types.hh"
+#include "schema_fwd.hh"
 #include "sstables/types.hh"
 #include "checksum_utils.hh"
 #include "../compress.hh"
@@ -296,6 +299,9 @@ struct compression {
     uint32_t chunk_len = 0;
     uint64_t data_len = 0;
     segmented_offsets offsets;
+    // Dictionary the chunks were compressed with, if the compressor trained
+    // one. Stored in the CompressionDictionary component, not in CompressionInfo.
+    disk_string<uint32_t> dictionary;
 
 private:
     // Variables *not* found in the "Compression Info" file (added by update()):
@@ -377,9 +383,21 @@ input_stream<char> make_compressed_file_m_format_input_stream(file f,
                 sstables::compression* cm, uint64_t offset, size_t len,
                 class file_input_stream_options options);
 
+// If the compressor trains a dictionary and table is given, the dictionary is
+// reused by the next sstables of the table written on this shard for a while.
 output_stream<char> make_compressed_file_m_format_output_stream(output_stream<char> out,
                 sstables::compression* cm,
-                const compression_parameters& cp);
+                const compression_parameters& cp,
+                std::optional<table_id> table = std::nullopt);
+
+// Returns a read-only file which reflects the uncompressed contents of the
+// compressed file f. A read uncompresses the chunks it overlaps, each chunk
+// which is wanted whole straight into the returned buffer.
+// The same lifetime rules as for the streams above apply to cm. Closing the
+// returned file does not close f.
+file make_decompressed_k_l_format_file(file f, sstables::compression* cm);
+
+file make_decompressed_m_format_file(file f, sstables::compression* cm);
 
 }
 
@@ -25,7 +25,6 @@
 
 namespace sstables {
 
-using use_caching = bool_class<struct use_caching_tag>;
 using promoted_index_block_position_view = std::variant<composite_view, position_in_partition_view>;
 using promoted_index_block_position = std::variant<composite, position_in_partition>;
 
@@ -200,6 +199,13 @@ class clustered_index_cursor {
 };
 
 // Allocated inside LSA.
+// Where the promoted index of a partition is in the index file.
+struct promoted_index_location {
+    uint64_t start; // of the first block
+    uint32_t size;  // from the first block on
+    uint32_t num_blocks;
+};
+
 class promoted_index {
     deletion_time _del_time;
     uint64_t _promoted_index_start;
@@ -218,7 +224,9 @@ class promoted_index {
     { }
 
     [[nodiscard]] deletion_time get_deletion_time() const { return _del_time; }
+    [[nodiscard]] uint64_t get_promoted_index_start() const { return _promoted_index_start; }
     [[nodiscard]] uint32_t get_promoted_index_size() const { return _promoted_index_size; }
+    [[nodiscard]] uint32_t get_num_blocks() const { return _num_blocks; }
 
     // Call under allocating_section.
     // For sstable versions >= mc the returned cursor will be of type `bsearch_clustered_cursor`.
@@ -12,12 +12,15 @@
 #include "downsampling.hh"
 #include "sstables/partition_index_cache.hh"
 #include <seastar/util/bool_class.hh>
+#include <seastar/core/coroutine.hh>
 #include "utils/buffer_input_stream.hh"
 #include "sstables/prepended_input_stream.hh"
 #include "tracing/traced_file.hh"
 #include "sstables/scanning_clustered_index_cursor.hh"
 #include "sstables/mx/bsearch_clustered_cursor.hh"
+#include "sstables/mx/trie_clustered_cursor.hh"
 #include "sstables/sstables_manager.hh"
+#include "sstables/partition_trie.hh"
 
 namespace sstables {
 
@@ -332,6 +335,12 @@ std::unique_ptr<clustered_index_cursor> promoted_index::make_cursor(shared_sstab
                                                     sst->manager().get_cache_tracker().get_lru(),
                                                     sst->manager().get_cache_tracker().region(),
                                                     sst->_index_file_size);
+        if (sst->has_row_trie_index()) {
+            return std::make_unique<mc::trie_clustered_cursor>(*sst->get_schema(),
+                _promoted_index_start, _promoted_index_size,
+                promoted_index_cache_metrics, permit,
+                *ck_values_fixed_lengths, cached_file_ptr, options.io_priority_class, _num_blocks, trace_state);
+        }
         return std::make_unique<mc::bsearch_clustered_cursor>(*sst->get_schema(),
             _promoted_index_start, _promoted_index_size,
             promoted_index_cache_metrics, permit,
@@ -393,6 +402,11 @@ struct index_bound {
     uint64_t data_file_position = 0;
     indexable_element element = indexable_element::partition;
     std::optional<open_rt_marker> end_open_marker;
+    // Set when current_list was looked up in the partition trie rather than
+    // the summary. It then holds the entries of one or two partitions, the
+    // last of which ends at trie_page_end in the index file.
+    bool trie_page = false;
+    uint64_t trie_page_end = 0;
 
     // Holds the cursor for the current partition. Lazily initialized.
     std::unique_ptr<clustered_index_cursor> clustered_cursor;
@@ -409,6 +423,8 @@ struct index_bound {
             , data_file_position(other.data_file_position)
             , element(other.element)
             , end_open_marker(other.end_open_marker)
+            , trie_page(other.trie_page)
+            , trie_page_end(other.trie_page_end)
     { }
 
     index_bound(index_bound&&) noexcept = default;
@@ -436,9 +452,12 @@ class index_reader {
     use_caching _use_caching;
     bool _single_page_read;
 
-    std::unique_ptr<index_consume_entry_context<index_consumer>> make_context(uint64_t begin, uint64_t end, index_consumer& consumer) {
+    // If single_page is false, the input stream extends to the end of the
+    // index file, so that the context can be fast forwarded past end later.
+    std::unique_ptr<index_consume_entry_context<index_consumer>> make_context(uint64_t begin, uint64_t end, index_consumer& consumer,
+            bool single_page) {
         auto index_file = make_tracked_index_file(*_sstable, _permit, _trace_state, _use_caching);
-        auto input = make_file_input_stream(index_file, begin, (_single_page_read ? end : _sstable->index_size()) - begin,
+        auto input = make_file_input_stream(index_file, begin, (single_page ? end : _sstable->index_size()) - begin,
                         get_file_input_stream_options(_pc));
         auto trust_pi = trust_promoted_index(_sstable->has_correct_promoted_index_entries());
         auto ck_values_fixed_lengths = _sstable->get_version() >= sstable_version_types::mc
@@ -451,7 +470,7 @@ class index_reader {
     future<> advance_context(index_bound& bound, uint64_t begin, uint64_t end, int quantity) {
         if (!bound.context) {
             bound.consumer = std::make_unique<index_consumer>(_region, _sstable->get_schema());
-            bound.context = make_context(begin, end, *bound.consumer);
+            bound.context = make_context(begin, end, *bound.consumer, _single_page_read);
             bound.consumer->prepare(quantity);
             return make_ready_future<>();
         }
@@ -484,6 +503,25 @@ class index_reader {
         bound.element = indexable_element::partition;
         bound.current_list = {};
         bound.end_open_marker.reset();
+        bound.trie_page = false;
+        return reset_clustered_cursor(bound);
+    }
+
+    // Drops a page looked up in the partition trie and rewinds the bound to
+    // the first partition, from where it can be advanced through the summary
+    // again. The bound must then be advanced to a position which is not before
+    // the dropped page.
+    future<> leave_trie_page(index_bound& bound) {
+        sstlog.trace("index {}: leave_trie_page() bound {}", fmt::ptr(this), fmt::ptr(&bound));
+        bound.trie_page = false;
+        bound.current_list = {};
+        bound.previous_summary_idx = 0;
+        bound.current_summary_idx = 0;
+        bound.current_index_idx = 0;
+        bound.current_pi_idx = 0;
+        bound.data_file_position = 0;
+        bound.element = indexable_element::partition;
+        bound.end_open_marker.reset();
         return reset_clustered_cursor(bound);
     }
 
@@ -615,6 +653,9 @@ class index_reader {
             bound.end_open_marker.reset();
             return reset_clustered_cursor(bound);
         }
+        if (bound.trie_page) {
+            return advance_past_trie_page(bound);
+        }
         auto& summary = _sstable->get_summary();
         if (bound.current_summary_idx + 1 < summary.header.size) {
             return advance_to_page(bound, bound.current_summary_idx + 1);
@@ -622,6 +663,19 @@ class index_reader {
         return advance_to_end(bound);
     }
 
+    // Positions the bound on the partition which follows the last one of its trie page.
+    future<> advance_past_trie_page(index_bound& bound) {
+        if (bound.trie_page_end == _sstable->index_size()) {
+            co_return co_await advance_to_end(bound);
+        }
+        auto& s = *_sstable->_schema;
+        auto dk = _alloc_section(_region, [&] {
+            return dht::decorate_key(s, bound.current_list->_entries.back()->get_key().to_partition_key(s));
+        });
+        co_await leave_trie_page(bound);
+        co_await advance_to(bound, dht::ring_position_view(dk, dht::ring_position_view::after_key::yes));
+    }
+
     future<> advance_to(index_bound& bound, dht::ring_position_view pos) {
         sstlog.trace("index {} bound {}: advance_to({}), _previous_summary_idx={}, _current_summary_idx={}",
             fmt::ptr(this), fmt::ptr(&bound), pos, bound.previous_summary_idx, bound.current_summary_idx);
@@ -636,6 +690,11 @@ class index_reader {
             sstlog.trace("index {}: eof", fmt::ptr(this));
             return make_ready_future<>();
         }
+        if (bound.trie_page) {
+            return leave_trie_page(bound).then([this, &bound, pos] {
+                return advance_to(bound, pos);
+            });
+        }
 
         auto& summary = _sstable->get_summary();
         bound.previous_summary_idx = std::distance(std::begin(summary.entries),
@@ -738,6 +797,90 @@ class index_reader {
         });
     }
 
+    // Whether the lower bound can be advanced to pos with advance_lower_with_trie().
+    // The trie only tells apart the partitions around pos if pos is a partition key,
+    // and does not know the summary page the lower bound is in.
+    bool use_partition_trie(dht::ring_position_view pos) const {
+        return _sstable->_cached_partitions_file && pos.key() && !pos.is_after_key()
+            && !partition_data_ready(_lower_bound) && !eof();
+    }
+
+    future<index_list> load_trie_page(uint64_t begin, uint64_t end) {
+        index_consumer consumer(_region, _sstable->get_schema());
+        auto context = make_context(begin, end, consumer, true);
+        consumer.prepare(2);
+        std::exception_ptr ex;
+        try {
+            co_await context->consume_input();
+        } catch (...) {
+            ex = std::current_exception();
+        }
+        co_await context->close();
+        if (ex) {
+            sstlog.error("failed reading index for {}: {}", _sstable->get_filename(), ex);
+            std::rethrow_exception(std::move(ex));
+        }
+        co_return std::move(consumer.indexes);
+    }
+
+    // Like advance_to(_lower_bound, pos), but finds the partition in the
+    // partition trie and reads only its index entry and the next one, instead
+    // of a whole summary page.
+    //
+    // Precondition: use_partition_trie(pos).
+    future<> advance_lower_with_trie(dht::ring_position_view pos) {
+        auto& s = *_sstable->_schema;
+        auto trie_key = partition_trie_key(pos.token(), bytes_view(key::from_partition_key(s, *pos.key())));
+        auto trie_file = _use_caching
+                ? _sstable->_cached_partitions_file
+                : seastar::make_shared<cached_file>(make_tracked_file(_sstable->_cached_partitions_file->get_file(), _permit),
+                                                    index_page_cache_metrics,
+                                                    _sstable->manager().get_cache_tracker().get_lru(),
+                                                    _sstable->manager().get_cache_tracker().region(),
+                                                    _sstable->_cached_partitions_file->size());
+        trie_reader trie(*trie_file, _sstable->_partition_trie_root, _pc, _permit, _trace_state);
+        auto entry = co_await trie.floor(trie_key);
+        if (!entry) {
+            sstlog.trace("index {}: before the first partition in the trie", fmt::ptr(this));
+            co_return;
+        }
+        auto begin = entry->value;
+        auto end = entry->value + entry->length;
+        if (end > _sstable->index_size()) {
+            throw malformed_sstable_exception(format("partition trie entry [{}, {}) past the end of the index", begin, end),
+                    _sstable->filename(component_type::Partitions));
+        }
+        // Summary indexes never have the most significant bit set
+        auto page_key = (uint64_t(1) << 63) | begin;
+        auto ref = co_await _index_cache.get_or_load(page_key, [this, begin, end] (uint64_t) {
+            return load_trie_page(begin, end);
+        });
+        if (ref->empty()) {
+            throw malformed_sstable_exception(format("missing index entry for partition trie entry at {}", begin),
+                    _sstable->filename(component_type::Index));
+        }
+        co_await reset_clustered_cursor(_lower_bound);
+        _lower_bound.current_list = std::move(ref);
+        _lower_bound.trie_page = true;
+        _lower_bound.trie_page_end = end;
+        _lower_bound.current_index_idx = 0;
+        _lower_bound.current_pi_idx = 0;
+        _lower_bound.data_file_position = _lower_bound.current_list->_entries[0]->position();
+        _lower_bound.element = indexable_element::partition;
+        _lower_bound.end_open_marker.reset();
+
+        // All partitions before the first one of the page are smaller than
+        // pos, and all partitions after the page are greater.
+        bool before = _alloc_section(_region, [&] {
+            return index_comparator(s)(_lower_bound.current_list->_entries[0], pos);
+        });
+        sstlog.trace("index {}: trie page at {} with {} entries, first {} pos", fmt::ptr(this), begin,
+                _lower_bound.current_list->size(), before ? "before" : "not before");
+        if (before) {
+            co_await advance_to_next_partition(_lower_bound);
+        }
+    }
+
     // Returns position right after all partitions in the sstable
     uint64_t data_file_end() const {
         return _sstable->data_size();
@@ -810,7 +953,8 @@ class index_reader {
     //
     // Precondition: partition_data_ready(bound).
     //
-    // For sstable versions >= mc the returned cursor (if not nullptr) will be of type `bsearch_clustered_cursor`.
+    // For sstable versions >= mc the returned cursor (if not nullptr) will be of type `bsearch_clustered_cursor`
+    // or of a type derived from it.
     clustered_index_cursor* current_clustered_cursor(index_bound& bound) {
         if (!bound.clustered_cursor) {
             _alloc_section(_region, [&] {
@@ -862,6 +1006,19 @@ class index_reader {
         return e.get_promoted_index_size();
     }
 
+    // Returns the location of the promoted index of the current partition,
+    // or std::nullopt if it has none.
+    // Can be called only when partition_data_ready().
+    std::optional<promoted_index_location> get_promoted_index_location() {
+        return _alloc_section(_region, [this] () -> std::optional<promoted_index_location> {
+            promoted_index* pi = current_partition_entry(_lower_bound).get_promoted_index().get();
+            if (!pi) {
+                return std::nullopt;
+            }
+            return promoted_index_location{pi->get_promoted_index_start(), pi->get_promoted_index_size(), pi->get_num_blocks()};
+        });
+    }
+
     bool partition_data_ready() const {
         return partition_data_ready(_lower_bound);
     }
@@ -921,7 +1078,8 @@ class index_reader {
     // If upper_bound is provided, the upper bound within position is looked up
     future<bool> advance_lower_and_check_if_present(
             dht::ring_position_view key, std::optional<position_in_partition_view> pos = {}) {
-        return advance_to(_lower_bound, key).then([this, key, pos] {
+        auto advanced = use_partition_trie(key) ? advance_lower_with_trie(key) : advance_to(_lower_bound, key);
+        return advanced.then([this, key, pos] {
             if (eof()) {
                 return make_ready_future<bool>(false);
             }
@@ -1340,7 +1340,8 @@ class sstable_mutation_reader : public mp_row_consumer_reader_k_l {
 
         if (_single_partition_read) {
             _read_enabled = (begin != *end);
-            _context = data_consume_single_partition<DataConsumeRowsContext>(*_schema, _sst, _consumer, { begin, *end });
+            _context = data_consume_single_partition<DataConsumeRowsContext>(*_schema, _sst, _consumer, { begin, *end },
+                    use_caching(!_slice.options.contains(query::partition_slice::option::bypass_cache)));
         } else {
             sstable::disk_read_range drr{begin, *end};
             auto last_end = _fwd_mr ? _sst->data_size() : drr.end;
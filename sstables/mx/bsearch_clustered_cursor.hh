@@ -360,6 +360,7 @@ class cached_promoted_index {
 /// N = number of index entries
 ///
 class bsearch_clustered_cursor : public clustered_index_cursor {
+protected:
     using pi_offset_type = cached_promoted_index::pi_offset_type;
     using pi_index_type = cached_promoted_index::pi_index_type;
     using promoted_index_block = cached_promoted_index::promoted_index_block;
@@ -379,14 +380,14 @@ class bsearch_clustered_cursor : public clustered_index_cursor {
     std::optional<position_in_partition> _current_pos;
 
     tracing::trace_state_ptr _trace_state;
-private:
+protected:
     // Advances the cursor to the nearest block whose start position is > pos.
     //
     // upper_idx should be the index of the block which is known to have start position > pos.
     // upper_idx can be set to _blocks_count if no such entry is known.
     //
     // Async calls must be serialized.
-    future<> advance_to_upper_bound(position_in_partition_view pos) {
+    virtual future<> advance_to_upper_bound(position_in_partition_view pos) {
         // Binary search over blocks.
         //
         // Post conditions:
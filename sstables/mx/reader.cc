@@ -57,6 +57,17 @@ class mp_row_consumer_m {
     // For static-compact tables C* stores the only row in the static row but in our representation they're regular rows.
     const bool _treat_static_row_as_regular;
 
+    // Data queries which bypass the cache hand their rows only to the query
+    // result, which looks at nothing but the columns selected by the slice.
+    // Such reads skip over the values of the other columns instead of copying
+    // them, and produce their cells with empty values, which keeps the liveness
+    // of rows intact. The cells can't be dropped entirely, since then rows with
+    // only unselected cells would disappear from the result. Column ids of the
+    // selected columns, by kind.
+    bool _project_columns = false;
+    boost::dynamic_bitset<uint64_t> _projected_static_columns;
+    boost::dynamic_bitset<uint64_t> _projected_regular_columns;
+
     std::optional<clustering_row> _in_progress_row;
     std::optional<range_tombstone_change> _stored_tombstone;
     static_row _in_progress_static_row;
@@ -127,6 +138,15 @@ class mp_row_consumer_m {
         return on_range_tombstone_change(std::move(pos), right);
     }
 
+    // Whether the value of the column has to be read, see _project_columns.
+    bool needs_column_value(const column_translation::column_info& column_info) const {
+        if (!_project_columns || !column_info.id || column_info.is_counter) {
+            return true;
+        }
+        auto& projected = _inside_static_row ? _projected_static_columns : _projected_regular_columns;
+        return *column_info.id >= projected.size() || projected.test(*column_info.id);
+    }
+
     const column_definition& get_column_definition(std::optional<column_id> column_id) const {
         auto column_type = _inside_static_row ? column_kind::static_column : column_kind::regular_column;
         return _schema->column_at(column_type, *column_id);
@@ -216,6 +236,20 @@ class mp_row_consumer_m {
             && (!sst->has_scylla_component() || sst->features().is_enabled(sstable_feature::CorrectStaticCompact))) // See #4139
     {
         _cells.reserve(std::max(_schema->static_columns_count(), _schema->regular_columns_count()));
+        // Reversed reads cannot skip within a row, see partition_reversing_data_source.
+        if (_slice.options.contains(query::partition_slice::option::skip_unselected_values)
+                && _slice.options.contains(query::partition_slice::option::bypass_cache)
+                && !_slice.is_reversed() && !_treat_static_row_as_regular) {
+            _project_columns = true;
+            _projected_static_columns.resize(_schema->static_columns_count());
+            for (auto id : _slice.static_columns) {
+                _projected_static_columns.set(id);
+            }
+            _projected_regular_columns.resize(_schema->regular_columns_count());
+            for (auto id : _slice.regular_columns) {
+                _projected_regular_columns.set(id);
+            }
+        }
     }
 
     mp_row_consumer_m(mp_row_consumer_reader_mx* reader,
@@ -1079,6 +1113,18 @@ class data_consume_rows_context_m : public data_consumer::continuous_data_consum
             }
             if (!_column_flags.has_value()) {
                 _column_value = fragmented_temporary_buffer();
+            } else if (!_consumer.needs_column_value(get_column_info())) {
+                _sst->get_stats().on_unselected_value_skip();
+                _column_value = fragmented_temporary_buffer();
+                if (auto len = get_column_value_length()) {
+                    _u64 = *len;
+                } else {
+                    co_yield read_unsigned_vint(*_processing_data);
+                }
+                auto maybe_skip_bytes = skip(*_processing_data, _u64);
+                if (std::holds_alternative<skip_bytes>(maybe_skip_bytes)) {
+                    co_yield maybe_skip_bytes;
+                }
             } else {
                 read_status status = read_status::waiting;
                 if (auto len = get_column_value_length()) {
@@ -1516,7 +1562,8 @@ class mx_sstable_mutation_reader : public mp_row_consumer_reader_mx {
                 _context = std::move(reversed_context.the_context);
                 _reversed_read_sstable_position = &reversed_context.current_position_in_sstable;
             } else {
-                _context = data_consume_single_partition<DataConsumeRowsContext>(*_schema, _sst, _consumer, { begin, *end });
+                _context = data_consume_single_partition<DataConsumeRowsContext>(*_schema, _sst, _consumer, { begin, *end },
+                    use_caching(!_slice.options.contains(query::partition_slice::option::bypass_cache)));
             }
         } else {
             sstable::disk_read_range drr{begin, *end};
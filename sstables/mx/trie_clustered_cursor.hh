@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2022-present ScyllaDB
+ */
+
+/*
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include "sstables/mx/bsearch_clustered_cursor.hh"
+#include "sstables/exceptions.hh"
+#include "sstables/row_trie.hh"
+#include "sstables/trie.hh"
+
+#include <seastar/core/coroutine.hh>
+
+namespace sstables::mc {
+
+/// Cursor implementation which looks up blocks in the row trie embedded
+/// in the promoted index (see row_trie.hh).
+///
+/// The trie narrows the search down to two blocks, whose start positions
+/// decide between them. Everything else is inherited from bsearch_clustered_cursor,
+/// including the parsing and caching of the blocks.
+///
+/// Worst-case lookup cost:
+///
+///    comparisons: O(1)
+///    I/O:         O(K)
+///
+/// K = length of the encoded clustering key
+///
+class trie_clustered_cursor : public bsearch_clustered_cursor {
+    // Position of the trie root in the index file, read on first use.
+    std::optional<uint64_t> _trie_root;
+private:
+    future<uint64_t> get_trie_root() {
+        if (_trie_root) {
+            co_return *_trie_root;
+        }
+        auto& pi = _promoted_index;
+        auto footer_size = _blocks_count * sizeof(pi_offset_type) + sizeof(pi_offset_type);
+        if (pi._promoted_index_size < footer_size) {
+            throw malformed_sstable_exception(format("Promoted index of {} bytes too small for {} blocks and a row trie",
+                    pi._promoted_index_size, _blocks_count));
+        }
+        auto root_pos = pi._promoted_index_size - footer_size;
+        auto buf = co_await read_cached_bytes(pi.file(), pi._promoted_index_start + root_pos, sizeof(pi_offset_type),
+                pi._pc, pi._permit, _trace_state);
+        if (buf.size() < sizeof(pi_offset_type)) {
+            throw malformed_sstable_exception("Truncated row trie root offset");
+        }
+        auto root = read_be<pi_offset_type>(buf.get());
+        if (root >= root_pos) {
+            throw malformed_sstable_exception(format("Invalid row trie root offset {}, the trie ends at {}", root, root_pos));
+        }
+        _trie_root = pi._promoted_index_start + root;
+        co_return *_trie_root;
+    }
+protected:
+    future<> advance_to_upper_bound(position_in_partition_view pos) override {
+        auto& pi = _promoted_index;
+        trie_reader trie(pi.file(), co_await get_trie_root(), pi._pc, pi._permit, _trace_state);
+        auto entry = co_await trie.floor(row_trie_key(_s, pos));
+        if (entry) {
+            if (entry->value >= _blocks_count) {
+                throw malformed_sstable_exception(format("Row trie entry {} past the last of {} blocks", entry->value, _blocks_count));
+            }
+            // Blocks before the floor start before pos, and the block after
+            // the floor's successor in the trie starts after pos.
+            _current_idx = std::max<pi_index_type>(_current_idx, entry->value);
+        }
+        sstlog.trace("mc_trie_clustered_cursor {}: floor of {} is [{}]", fmt::ptr(this), pos, _current_idx);
+        position_in_partition::less_compare less(_s);
+        while (_current_idx < _blocks_count) {
+            auto block = co_await pi.get_block_with_start(_current_idx, _trace_state);
+            if (less(pos, *block->start)) {
+                _current_pos = *block->start;
+                co_return;
+            }
+            ++_current_idx;
+        }
+        _current_pos = position_in_partition::after_all_clustered_rows();
+    }
+public:
+    using bsearch_clustered_cursor::bsearch_clustered_cursor;
+};
+
+}
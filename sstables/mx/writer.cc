@@ -14,6 +14,9 @@
 #include "vint-serialization.hh"
 #include "sstables/types.hh"
 #include "sstables/mx/types.hh"
+#include "sstables/partition_trie.hh"
+#include "sstables/row_trie.hh"
+#include "sstables/zone_map.hh"
 #include "db/config.hh"
 #include "atomic_cell.hh"
 #include "utils/exceptions.hh"
@@ -532,6 +535,12 @@ class writer : public sstable_writer::writer_impl {
     bool _compression_enabled = false;
     std::unique_ptr<file_writer> _data_writer;
     std::unique_ptr<file_writer> _index_writer;
+    std::unique_ptr<file_writer> _partitions_writer;
+    std::optional<partition_trie_writer> _partition_trie;
+    // Whether promoted indexes embed a row trie
+    bool _row_trie_index;
+    // Builds the zone maps of promoted index blocks, if enabled
+    std::optional<zone_map_writer> _zone_map;
     bool _tombstone_written = false;
     bool _static_row_written = false;
     // The length of partition header (partition key, partition deletion and static row, if present)
@@ -566,6 +575,7 @@ class writer : public sstable_writer::writer_impl {
         uint64_t offset;
         uint64_t width;
         std::optional<tombstone> open_marker;
+        bytes zone_map;
     };
     // _pi_write_m is used temporarily for building the promoted
     // index (column sample) of one partition when writing a new sstable.
@@ -576,6 +586,8 @@ class writer : public sstable_writer::writer_impl {
         std::optional<pi_block> first_entry;
         bytes_ostream blocks; // Serialized pi_blocks.
         bytes_ostream offsets; // Serialized block offsets (uint32_t) relative to the start of "blocks".
+        std::vector<bytes> row_trie_keys; // row_trie_key() of the start of each block in blocks, if _row_trie_index.
+        bytes_ostream zone_maps; // Zone map of each block in blocks, if _zone_map.
         uint64_t promoted_index_size = 0; // Number of pi_blocks inside blocks and first_entry;
         tombstone tomb;
         uint64_t block_start_offset;
@@ -756,6 +768,7 @@ class writer : public sstable_writer::writer_impl {
         , _sst_schema(make_sstable_schema(s, _enc_stats, _cfg))
         , _run_identifier(cfg.run_identifier)
         , _write_regular_as_static(s.is_static_compact_table())
+        , _row_trie_index(cfg.row_trie_index && row_trie_supported(s))
         , _partition_size_entry(
                     large_data_stats_entry{
                         .threshold = _sst.get_large_data_handler().get_partition_threshold_bytes(),
@@ -787,7 +800,7 @@ class writer : public sstable_writer::writer_impl {
         // exactly what callers used to do anyway.
         estimated_partitions = std::max(uint64_t(1), estimated_partitions);
 
-        _sst.generate_toc(_schema.get_compressor_params().get_compressor(), _schema.bloom_filter_fp_chance());
+        _sst.generate_toc(_schema.get_compressor_params().get_compressor(), _schema.bloom_filter_fp_chance(), _cfg.partition_trie_index);
         _sst.write_toc(_pc);
         _sst.create_data().get();
         _compression_enabled = !_sst.has_component(component_type::CRC);
@@ -795,9 +808,26 @@ class writer : public sstable_writer::writer_impl {
         _sst._shards = { shard };
 
         _cfg.monitor->on_write_started(_data_writer->offset_tracker());
-        _sst._components->filter = utils::i_filter::get_filter(estimated_partitions, _schema.bloom_filter_fp_chance(), utils::filter_format::m_format);
+        auto filter_format = utils::filter_format::m_format;
+        switch (_schema.sstable_filter_options().type()) {
+        case db::sstable_filter_type::bloom:
+            break;
+        case db::sstable_filter_type::split_block_bloom:
+            filter_format = utils::filter_format::split_block_format;
+            break;
+        case db::sstable_filter_type::xor_filter:
+            filter_format = utils::filter_format::xor_format;
+            break;
+        }
+        _sst._components->filter = utils::i_filter::get_filter(estimated_partitions, _schema.bloom_filter_fp_chance(), filter_format);
         _pi_write_m.promoted_index_block_size = cfg.promoted_index_block_size;
         _pi_write_m.promoted_index_auto_scale_threshold = cfg.promoted_index_auto_scale_threshold;
+        if (cfg.zone_maps) {
+            zone_map_writer zone_map(s);
+            if (!zone_map.empty()) {
+                _zone_map.emplace(std::move(zone_map));
+            }
+        }
         _index_sampling_state.summary_byte_cost = _cfg.summary_byte_cost;
         prepare_summary(_sst._components->summary, estimated_partitions, _schema.min_index_interval());
     }
@@ -824,6 +854,7 @@ writer::~writer() {
         }
     };
     close_writer(_index_writer);
+    close_writer(_partitions_writer);
     close_writer(_data_writer);
 }
 
@@ -842,7 +873,8 @@ void writer::add_pi_block() {
         *_pi_write_m.last_clustering,
         _pi_write_m.block_start_offset - _c_stats.start_offset,
         _data_writer->offset() - _pi_write_m.block_start_offset,
-        (_current_tombstone ? std::make_optional(_current_tombstone) : std::optional<tombstone>{})};
+        (_current_tombstone ? std::make_optional(_current_tombstone) : std::optional<tombstone>{}),
+        (_zone_map ? _zone_map->finish_block() : bytes())};
 
     if (_pi_write_m.blocks.empty()) {
         if (!_pi_write_m.first_entry) {
@@ -878,7 +910,7 @@ void writer::init_file_writers() {
     file_output_stream_options options;
     options.io_priority_class = _pc;
     options.buffer_size = _sst.sstable_buffer_size;
-    options.write_behind = 10;
+    options.write_behind = _cfg.data_write_behind;
 
     if (!_compression_enabled) {
         auto out = make_file_data_sink(std::move(_sst._data_file), options).get0();
@@ -889,7 +921,15 @@ void writer::init_file_writers() {
             make_compressed_file_m_format_output_stream(
                 std::move(out),
                 &_sst._components->compression,
-                _schema.get_compressor_params()), _sst.filename(component_type::Data));
+                _schema.get_compressor_params(),
+                _schema.id()), _sst.filename(component_type::Data));
+    }
+    options.write_behind = _cfg.index_write_behind;
+    if (_sst.has_component(component_type::Partitions)) {
+        auto f = _sst.open_file(component_type::Partitions, open_flags::wo | open_flags::create | open_flags::exclusive).get0();
+        auto w = file_writer::make(std::move(f), options, _sst.filename(component_type::Partitions));
+        _partitions_writer = std::make_unique<file_writer>(w.get0());
+        _partition_trie.emplace(*_partitions_writer);
     }
     auto w = file_writer::make(std::move(_sst._index_file), std::move(options), _sst.filename(component_type::Index));
     _index_writer = std::make_unique<file_writer>(w.get0());
@@ -922,6 +962,10 @@ void writer::consume_new_partition(const dht::decorated_key& dk) {
     _sst._components->filter->add(bytes_view(*_partition_key));
     _collector.add_key(bytes_view(*_partition_key));
 
+    if (_partition_trie) {
+        _partition_trie->add(partition_trie_key(dk.token(), bytes_view(*_partition_key)), _index_writer->offset());
+    }
+
     auto p_key = disk_string_view<uint16_t>();
     p_key.value = bytes_view(*_partition_key);
 
@@ -935,6 +979,12 @@ void writer::consume_new_partition(const dht::decorated_key& dk) {
     _pi_write_m.first_entry.reset();
     _pi_write_m.blocks.clear();
     _pi_write_m.offsets.clear();
+    _pi_write_m.row_trie_keys.clear();
+    _pi_write_m.zone_maps.clear();
+    if (_zone_map) {
+        // Drop what the last block of the previous partition, which had no promoted index, left.
+        _zone_map->finish_block();
+    }
     _pi_write_m.promoted_index_size = 0;
     _pi_write_m.tomb = {};
     _pi_write_m.first_clustering.reset();
@@ -1162,6 +1212,9 @@ void writer::write_cells(bytes_ostream& writer, const clustering_key_prefix* clu
         ++_c_stats.cells_count;
         ++_c_stats.column_count;
         write_cell(writer, clustering_key, cell, column_definition, properties);
+        if (_zone_map && kind == column_kind::regular_column) {
+            _zone_map->add(column_definition, cell);
+        }
     });
 
     for (const auto& col: _collections) {
@@ -1346,10 +1399,41 @@ void writer::write_promoted_index() {
     write_vint(_tmp_bufs, _partition_header_length);
     write(_sst.get_version(), _tmp_bufs, to_deletion_time(_pi_write_m.tomb));
     write_vint(_tmp_bufs, _pi_write_m.promoted_index_size);
-    uint64_t pi_size = _tmp_bufs.size() + _pi_write_m.blocks.size() + _pi_write_m.offsets.size();
+    // The row trie and the zone maps go between the blocks and the offsets,
+    // so that readers which locate the offsets from the end skip them.
+    bytes_ostream row_trie;
+    std::optional<uint32_t> row_trie_root;
+    if (_row_trie_index) {
+        trie_writer<bytes_ostream> trie(row_trie, _pi_write_m.blocks.size());
+        const bytes* prev = nullptr;
+        for (uint32_t i = 0; i < _pi_write_m.row_trie_keys.size(); ++i) {
+            auto& key = _pi_write_m.row_trie_keys[i];
+            // Blocks may start at the same position; readers step
+            // over the following ones when they compare block starts.
+            if (!prev || *prev != key) {
+                trie.add(key, i);
+            }
+            prev = &key;
+        }
+        row_trie_root = trie.finish(_pi_write_m.promoted_index_size);
+    }
+    // The trie root stays right before the offsets, so the offset of the zone maps goes before it.
+    bytes_ostream footer;
+    if (_zone_map) {
+        uint32_t zone_map_offset = _pi_write_m.blocks.size() + row_trie.size();
+        write(_sst.get_version(), footer, zone_map_offset);
+    }
+    if (row_trie_root) {
+        write(_sst.get_version(), footer, *row_trie_root);
+    }
+    uint64_t pi_size = _tmp_bufs.size() + _pi_write_m.blocks.size() + row_trie.size() + _pi_write_m.zone_maps.size()
+            + footer.size() + _pi_write_m.offsets.size();
     write_vint(*_index_writer, pi_size);
     flush_tmp_bufs(*_index_writer);
     write(_sst.get_version(), *_index_writer, _pi_write_m.blocks);
+    write(_sst.get_version(), *_index_writer, row_trie);
+    write(_sst.get_version(), *_index_writer, _pi_write_m.zone_maps);
+    write(_sst.get_version(), *_index_writer, footer);
     write(_sst.get_version(), *_index_writer, _pi_write_m.offsets);
 }
 
@@ -1358,6 +1442,18 @@ void writer::write_pi_block(const pi_block& block) {
     bytes_ostream& blocks = _pi_write_m.blocks;
     uint32_t offset = blocks.size();
     write(_sst.get_version(), _pi_write_m.offsets, offset);
+    if (_row_trie_index) {
+        // Same as the start position readers parse from the block
+        auto kind = block.first.kind;
+        auto weight = kind == bound_kind_m::clustering
+                ? bound_weight::equal
+                : position_weight(is_bound_kind(kind) ? to_bound_kind(kind) : boundary_to_start_bound(kind));
+        auto start = position_in_partition_view(block.first.clustering, weight);
+        _pi_write_m.row_trie_keys.push_back(row_trie_key(_schema, start));
+    }
+    if (_zone_map) {
+        _pi_write_m.zone_maps.write(bytes_view(block.zone_map));
+    }
     write_clustering_prefix(_sst.get_version(), blocks, block.first.kind, _schema, block.first.clustering);
     write_clustering_prefix(_sst.get_version(), blocks, block.last.kind, _schema, block.last.clustering);
     write_vint(blocks, block.offset);
@@ -1453,6 +1549,11 @@ void writer::consume_end_of_stream() {
         _collector.add_compression_ratio(_sst._components->compression.compressed_file_length(), _sst._components->compression.uncompressed_file_length());
     }
 
+    if (_partition_trie) {
+        _partition_trie->finish(_index_writer->offset());
+        _partition_trie.reset();
+        close_writer(_partitions_writer);
+    }
     close_writer(_index_writer);
     _sst.set_first_and_last_keys();
 
@@ -1466,6 +1567,12 @@ void writer::consume_end_of_stream() {
     _sst.write_statistics(_pc);
     _sst.write_compression(_pc);
     auto features = sstable_enabled_features::all();
+    if (!_row_trie_index) {
+        features.disable(sstable_feature::RowTrieIndex);
+    }
+    if (!_zone_map) {
+        features.disable(sstable_feature::ZoneMaps);
+    }
     run_identifier identifier{_run_identifier};
     std::optional<scylla_metadata::large_data_stats> ld_stats(scylla_metadata::large_data_stats{
         .map = {
@@ -1476,7 +1583,8 @@ void writer::consume_end_of_stream() {
             { large_data_type::elements_in_collection, std::move(_elements_in_collection_entry) },
         }
     });
-    _sst.write_scylla_metadata(_pc, _shard, std::move(features), std::move(identifier), std::move(ld_stats), _cfg.origin);
+    _sst.write_scylla_metadata(_pc, _shard, std::move(features), std::move(identifier), std::move(ld_stats), _cfg.origin,
+            _zone_map ? std::make_optional(_zone_map->columns()) : std::nullopt);
     if (!_cfg.leave_unsealed) {
         _sst.seal_sstable(_cfg.backup).get();
     }
@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2022-present ScyllaDB
+ */
+
+/*
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include <algorithm>
+
+#include <seastar/core/byteorder.hh>
+#include <seastar/core/coroutine.hh>
+
+#include "partition_trie.hh"
+#include "exceptions.hh"
+#include "writer.hh"
+
+namespace sstables {
+
+bytes partition_trie_key(dht::token token, bytes_view key) {
+    bytes k(bytes::initialized_later(), sizeof(uint64_t) + key.size());
+    write_be<uint64_t>(reinterpret_cast<char*>(k.begin()), uint64_t(token.raw()) ^ (uint64_t(1) << 63));
+    std::copy(key.begin(), key.end(), k.begin() + sizeof(uint64_t));
+    return k;
+}
+
+partition_trie_writer::partition_trie_writer(file_writer& out)
+    : _out(out)
+    , _trie(out, out.offset())
+{ }
+
+void partition_trie_writer::add(bytes_view key, uint64_t index_offset) {
+    _trie.add(key, index_offset);
+}
+
+void partition_trie_writer::finish(uint64_t index_size) {
+    auto root = _trie.finish(index_size);
+    std::array<char, sizeof(uint64_t)> footer;
+    write_be<uint64_t>(footer.data(), root);
+    _out.write(footer.data(), footer.size());
+}
+
+future<uint64_t> read_partition_trie_root(file f, uint64_t size, const io_priority_class& pc) {
+    if (size < sizeof(uint64_t)) {
+        throw malformed_sstable_exception(format("Partition trie too small: {} bytes", size));
+    }
+    auto buf = co_await f.dma_read_exactly<char>(size - sizeof(uint64_t), sizeof(uint64_t), pc);
+    auto root = read_be<uint64_t>(buf.get());
+    if (root >= size - sizeof(uint64_t)) {
+        throw malformed_sstable_exception(format("Invalid partition trie root offset {} for size {}", root, size));
+    }
+    co_return root;
+}
+
+}
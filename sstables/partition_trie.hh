@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2022-present ScyllaDB
+ */
+
+/*
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <seastar/core/future.hh>
+
+#include "bytes.hh"
+#include "dht/token.hh"
+#include "sstables/trie.hh"
+
+namespace sstables {
+
+class file_writer;
+
+// Trie-based partition index, stored in the Partitions component.
+//
+// Partitions are keyed by a byte-comparable encoding of their decorated key
+// (see partition_trie_key()), so that the order of the byte strings is the
+// order of the partitions in the sstable. Each key maps to the position of
+// the partition's entry in the Index component, and the entry length spans
+// the entry of the next partition too (see trie.hh), so a lookup reads
+// the candidate entries with a single Index read and needs no in-memory
+// summary.
+//
+// On-disk format:
+//
+//   partitions = node* root_offset
+//   root_offset = be64
+//
+// where node is a trie node as described in trie.hh, whose value is
+// the position of the partition's entry in Index.
+
+// Byte-comparable encoding of a decorated key: the token, as big-endian with
+// the sign bit flipped, followed by the key in its sstable form.
+bytes partition_trie_key(dht::token token, bytes_view key);
+
+// Writes a partition trie. Keys must be added in increasing order.
+// Must be used in a seastar thread.
+class partition_trie_writer {
+    file_writer& _out;
+    trie_writer<file_writer> _trie;
+public:
+    explicit partition_trie_writer(file_writer& out);
+
+    // index_offset is the position of the partition's entry in the Index component.
+    void add(bytes_view key, uint64_t index_offset);
+
+    // Writes the rest of the trie. index_size is the final size of the Index component.
+    void finish(uint64_t index_size);
+};
+
+// Reads the root offset from the end of a Partitions component of the given size.
+future<uint64_t> read_partition_trie_root(file f, uint64_t size, const io_priority_class& pc);
+
+}
@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2022-present ScyllaDB
+ */
+
+/*
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <seastar/core/byteorder.hh>
+
+#include "row_trie.hh"
+#include "schema.hh"
+#include "types.hh"
+
+namespace sstables {
+
+// Component headers. The empty value sorts first, unless the type is reversed.
+static constexpr uint8_t empty_header = 0x3f;
+static constexpr uint8_t value_header = 0x40;
+static constexpr uint8_t reversed_empty_header = 0x41;
+
+// Prefix terminators, by bound weight
+static constexpr uint8_t before_all_prefixed_terminator = 0x20;
+static constexpr uint8_t equal_terminator = 0x38;
+static constexpr uint8_t after_all_prefixed_terminator = 0x60;
+
+// Positions outside of the clustered region sort before and after all of it.
+static constexpr uint8_t partition_end_key = 0xff;
+
+enum class component_encoding {
+    signed_fixed,  // big-endian two's complement
+    unsigned_fixed,
+    boolean,
+    floating,
+    byte_comparable,
+    unsupported,
+};
+
+static component_encoding encoding_of(const abstract_type& t) {
+    switch (t.without_reversed().get_kind()) {
+    case abstract_type::kind::byte:
+    case abstract_type::kind::short_kind:
+    case abstract_type::kind::int32:
+    case abstract_type::kind::long_kind:
+    case abstract_type::kind::timestamp:
+    case abstract_type::kind::time:
+        return component_encoding::signed_fixed;
+    case abstract_type::kind::simple_date:
+        return component_encoding::unsigned_fixed;
+    case abstract_type::kind::boolean:
+        return component_encoding::boolean;
+    case abstract_type::kind::float_kind:
+    case abstract_type::kind::double_kind:
+        return component_encoding::floating;
+    case abstract_type::kind::ascii:
+    case abstract_type::kind::utf8:
+    case abstract_type::kind::bytes:
+    case abstract_type::kind::date:
+    case abstract_type::kind::inet:
+        return component_encoding::byte_comparable;
+    default:
+        return component_encoding::unsupported;
+    }
+}
+
+bool row_trie_supported(const schema& s) {
+    auto& types = s.clustering_key_type()->types();
+    return std::none_of(types.begin(), types.end(), [] (const data_type& t) {
+        return encoding_of(*t) == component_encoding::unsupported;
+    });
+}
+
+// Floating point values compare like their bits once negative values have
+// all their bits flipped and positive ones only the sign bit. NaNs are equal
+// to each other and greater than everything else, so they are all mapped to
+// the same positive NaN first.
+template <typename Float, typename Bits>
+static void encode_floating(bytes_view v, std::vector<int8_t>& out) {
+    static_assert(sizeof(Float) == sizeof(Bits));
+    if (v.size() != sizeof(Bits)) {
+        out.insert(out.end(), v.begin(), v.end());
+        return;
+    }
+    auto bits = read_be<Bits>(reinterpret_cast<const char*>(v.data()));
+    Float f;
+    std::memcpy(&f, &bits, sizeof(f));
+    if (std::isnan(f)) {
+        f = std::numeric_limits<Float>::quiet_NaN();
+        std::memcpy(&bits, &f, sizeof(f));
+    }
+    constexpr Bits sign = Bits(1) << (sizeof(Bits) * 8 - 1);
+    bits = (bits & sign) ? ~bits : (bits | sign);
+    char buf[sizeof(Bits)];
+    write_be<Bits>(buf, bits);
+    out.insert(out.end(), buf, buf + sizeof(buf));
+}
+
+static void encode_component(const abstract_type& t, bytes_view v, std::vector<int8_t>& out) {
+    if (v.empty()) {
+        out.push_back(t.is_reversed() ? reversed_empty_header : empty_header);
+        return;
+    }
+    out.push_back(value_header);
+    auto start = out.size();
+    switch (encoding_of(t)) {
+    case component_encoding::signed_fixed:
+        out.insert(out.end(), v.begin(), v.end());
+        out[start] ^= int8_t(0x80);
+        break;
+    case component_encoding::unsigned_fixed:
+        out.insert(out.end(), v.begin(), v.end());
+        break;
+    case component_encoding::boolean:
+        // Any non-zero byte is true
+        out.push_back(std::any_of(v.begin(), v.end(), [] (int8_t b) { return b != 0; }));
+        break;
+    case component_encoding::floating:
+        if (t.without_reversed().get_kind() == abstract_type::kind::float_kind) {
+            encode_floating<float, uint32_t>(v, out);
+        } else {
+            encode_floating<double, uint64_t>(v, out);
+        }
+        break;
+    case component_encoding::byte_comparable:
+        // Zero bytes are escaped, so that the 0x00 0x00 terminator sorts
+        // before any continuation of the value.
+        for (auto b : v) {
+            out.push_back(b);
+            if (b == 0) {
+                out.push_back(int8_t(0xff));
+            }
+        }
+        out.push_back(0);
+        out.push_back(0);
+        break;
+    case component_encoding::unsupported:
+        throw std::logic_error(format("Type {} is not supported by the row trie index", t.name()));
+    }
+    if (t.is_reversed()) {
+        for (auto i = start; i < out.size(); ++i) {
+            out[i] = ~out[i];
+        }
+    }
+}
+
+bytes row_trie_key(const schema& s, position_in_partition_view pos) {
+    switch (pos.region()) {
+    case partition_region::partition_start:
+    case partition_region::static_row:
+        return bytes();
+    case partition_region::partition_end:
+        return bytes(1, int8_t(partition_end_key));
+    case partition_region::clustered:
+        break;
+    }
+
+    std::vector<int8_t> out;
+    if (pos.has_key()) {
+        auto& types = s.clustering_key_type()->types();
+        auto type = types.begin();
+        for (auto&& component : pos.key().components(s)) {
+            encode_component(**type++, to_bytes(component), out);
+        }
+    }
+    switch (pos.get_bound_weight()) {
+    case bound_weight::before_all_prefixed:
+        out.push_back(before_all_prefixed_terminator);
+        break;
+    case bound_weight::equal:
+        out.push_back(equal_terminator);
+        break;
+    case bound_weight::after_all_prefixed:
+        out.push_back(after_all_prefixed_terminator);
+        break;
+    }
+    return bytes(out.data(), out.size());
+}
+
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2022-present ScyllaDB
+ */
+
+/*
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include "bytes.hh"
+#include "position_in_partition.hh"
+#include "schema_fwd.hh"
+
+namespace sstables {
+
+// Trie-based row index, embedded in the promoted index of a partition.
+//
+// The trie maps the byte-comparable encoding of the start position of each
+// promoted index block (see row_trie_key()) to the block's index, so that
+// finding the block which contains a position visits a handful of trie
+// nodes and at most two block starts, instead of the O(log(N)) block starts
+// of a binary search over the offsets map.
+//
+// The trie is stored between the blocks and the offsets map, followed by the
+// position of its root:
+//
+//   promoted_index = header block* row_trie root_offset offset*
+//   row_trie = node*              // see trie.hh
+//   root_offset = be32            // relative to the start of the first block
+//
+// Readers which do not know about the trie locate the offsets map from the
+// end of the promoted index and never look at it. Sstables which carry it
+// have sstable_feature::RowTrieIndex enabled.
+
+// Whether row_trie_key() can encode the clustering keys of the schema,
+// that is whether all of its clustering column types are byte-comparable.
+bool row_trie_supported(const schema& s);
+
+// Byte-comparable encoding of a position in a partition: the byte strings
+// of two positions compare like the positions.
+//
+// Each clustering key component is encoded as a header byte, which
+// tells empty values apart, followed by an order-preserving encoding of
+// the value. The prefix is terminated by a byte which depends on the
+// position's bound weight, and which sorts before (for weights up to
+// equal) or after (for after_all_prefixed) the header of any further
+// component.
+//
+// Precondition: row_trie_supported(s).
+bytes row_trie_key(const schema& s, position_in_partition_view pos);
+
+}
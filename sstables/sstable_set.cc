@@ -6,6 +6,9 @@
  * SPDX-License-Identifier: AGPL-3.0-or-later
  */
 
+#include <bit>
+#include <numeric>
+
 #include <seastar/util/defer.hh>
 
 #include <boost/icl/interval_map.hpp>
@@ -19,6 +22,7 @@
 #include "compaction/compaction_strategy_impl.hh"
 #include "compaction/leveled_compaction_strategy.hh"
 #include "compaction/time_window_compaction_strategy.hh"
+#include "compaction/incremental_compaction_strategy.hh"
 
 #include "sstable_set_impl.hh"
 
@@ -165,6 +169,62 @@ void sstable_set::for_each_sstable(std::function<void(const shared_sstable&)> fu
     return _impl->for_each_sstable(std::move(func));
 }
 
+std::vector<std::pair<shared_sstable, uint64_t>>
+sstable_set::filter_keys(const schema& s, std::span<const dht::decorated_key> keys) const {
+    assert(keys.size() <= utils::i_filter::max_batch_size);
+    // The selector wants increasing positions.
+    std::vector<unsigned> order(keys.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&] (unsigned a, unsigned b) {
+        return keys[a].less_compare(s, keys[b]);
+    });
+
+    // Keys of the batch within the key range of each sstable
+    std::vector<std::pair<shared_sstable, uint64_t>> candidates;
+    std::unordered_map<shared_sstable, size_t> candidate_index;
+    auto cmp = dht::ring_position_comparator(s);
+    auto sel = make_incremental_selector();
+    for (auto i : order) {
+        for (auto& sst : sel.select(keys[i]).sstables) {
+            if (cmp(keys[i], sst->get_first_decorated_key()) < 0 || cmp(keys[i], sst->get_last_decorated_key()) > 0) {
+                continue;
+            }
+            auto [it, inserted] = candidate_index.emplace(sst, candidates.size());
+            if (inserted) {
+                candidates.emplace_back(sst, 0);
+            }
+            candidates[it->second].second |= uint64_t(1) << i;
+        }
+    }
+
+    std::vector<utils::hashed_key> hashed;
+    hashed.reserve(keys.size());
+    for (auto& dk : keys) {
+        hashed.push_back(sstable::make_hashed_key(s, dk.key()));
+    }
+
+    std::vector<std::pair<shared_sstable, uint64_t>> ret;
+    std::vector<utils::hashed_key> batch;
+    std::vector<unsigned> batch_index;
+    for (auto& [sst, mask] : candidates) {
+        batch.clear();
+        batch_index.clear();
+        for (auto m = mask; m; m &= m - 1) {
+            auto i = std::countr_zero(m);
+            batch.push_back(hashed[i]);
+            batch_index.push_back(i);
+        }
+        uint64_t present = 0;
+        for (auto m = sst->filter_has_keys(batch); m; m &= m - 1) {
+            present |= uint64_t(1) << batch_index[std::countr_zero(m)];
+        }
+        if (present) {
+            ret.emplace_back(sst, present);
+        }
+    }
+    return ret;
+}
+
 void
 sstable_set::insert(shared_sstable sst) {
     _impl->insert(sst);
@@ -655,6 +715,11 @@ std::unique_ptr<sstable_set_impl> leveled_compaction_strategy::make_sstable_set(
     return std::make_unique<partitioned_sstable_set>(std::move(schema));
 }
 
+std::unique_ptr<sstable_set_impl> incremental_compaction_strategy::make_sstable_set(schema_ptr schema) const {
+    // Fragments are disjoint within their run, so all of them go to the interval map.
+    return std::make_unique<partitioned_sstable_set>(std::move(schema), false);
+}
+
 std::unique_ptr<sstable_set_impl> time_window_compaction_strategy::make_sstable_set(schema_ptr schema) const {
     return std::make_unique<time_series_sstable_set>(std::move(schema));
 }
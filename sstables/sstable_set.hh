@@ -16,6 +16,8 @@
 #include <seastar/core/shared_ptr.hh>
 #include <seastar/core/io_priority_class.hh>
 #include <vector>
+#include <span>
+#include "utils/i_filter.hh"
 
 namespace utils {
 class estimated_histogram;
@@ -69,6 +71,13 @@ class sstable_set : public enable_lw_shared_from_this<sstable_set> {
     void insert(shared_sstable sst);
     void erase(shared_sstable sst);
 
+    // Checks a batch of keys against the filters of the sstables whose key range
+    // contains them, overlapping the filters' memory accesses across the keys.
+    // Returns the sstables that may contain at least one of the keys, along
+    // with a mask in which bit i is set iff keys[i] may be present in that sstable.
+    // keys.size() must not exceed utils::i_filter::max_batch_size.
+    std::vector<std::pair<shared_sstable, uint64_t>> filter_keys(const schema& s, std::span<const dht::decorated_key> keys) const;
+
     // Used to incrementally select sstables from sstable set using ring-position.
     // sstable set must be alive during the lifetime of the selector.
     class incremental_selector {
@@ -44,6 +44,7 @@
 #include "compress.hh"
 #include "unimplemented.hh"
 #include "index_reader.hh"
+#include "partition_trie.hh"
 #include "replica/memtable.hh"
 #include "downsampling.hh"
 #include <boost/algorithm/string.hpp>
@@ -57,6 +58,7 @@
 #include "counters.hh"
 #include "binary_search.hh"
 #include "utils/bloom_filter.hh"
+#include "utils/xor_filter.hh"
 #include "utils/memory_data_sink.hh"
 #include "utils/cached_file.hh"
 #include "checked-file-impl.hh"
@@ -104,6 +106,8 @@ thread_local utils::updateable_value<bool> global_cache_index_pages(false);
 
 logging::logger sstlog("sstable");
 
+thread_local cached_file::metrics decompressed_page_cache_metrics;
+
 // Because this is a noop and won't hold any state, it is better to use a global than a
 // thread_local. It will be faster, specially on non-x86.
 struct noop_write_monitor final : public write_monitor {
@@ -867,7 +871,7 @@ future<> sstable::read_toc() noexcept {
 
 }
 
-void sstable::generate_toc(compressor_ptr c, double filter_fp_chance) {
+void sstable::generate_toc(compressor_ptr c, double filter_fp_chance, bool partition_trie) {
     // Creating table of components.
     _recognized_components.insert(component_type::TOC);
     _recognized_components.insert(component_type::Statistics);
@@ -882,6 +886,12 @@ void sstable::generate_toc(compressor_ptr c, double filter_fp_chance) {
         _recognized_components.insert(component_type::CRC);
     } else {
         _recognized_components.insert(component_type::CompressionInfo);
+        if (c->dictionary_size()) {
+            _recognized_components.insert(component_type::CompressionDictionary);
+        }
+    }
+    if (partition_trie) {
+        _recognized_components.insert(component_type::Partitions);
     }
     _recognized_components.insert(component_type::Scylla);
 }
@@ -1093,7 +1103,13 @@ future<> sstable::read_compression(const io_priority_class& pc) {
         return make_ready_future<>();
     }
 
-    return read_simple<component_type::CompressionInfo>(_components->compression, pc);
+    auto f = read_simple<component_type::CompressionInfo>(_components->compression, pc);
+    if (!has_component(component_type::CompressionDictionary)) {
+        return f;
+    }
+    return f.then([this, &pc] {
+        return read_simple<component_type::CompressionDictionary>(_components->compression.dictionary, pc);
+    });
 }
 
 void sstable::write_compression(const io_priority_class& pc) {
@@ -1102,6 +1118,9 @@ void sstable::write_compression(const io_priority_class& pc) {
     }
 
     write_simple<component_type::CompressionInfo>(_components->compression, pc);
+    if (has_component(component_type::CompressionDictionary)) {
+        write_simple<component_type::CompressionDictionary>(_components->compression.dictionary, pc);
+    }
 }
 
 void sstable::validate_partitioner() {
@@ -1417,6 +1436,38 @@ future<> sstable::update_info_for_opened_data() {
                                                             _index_file_size);
     _index_file = make_cached_seastar_file(*_cached_index_file);
 
+    if (this->has_component(component_type::Partitions)) {
+        auto f = co_await open_file(component_type::Partitions, open_flags::ro);
+        std::exception_ptr ex;
+        try {
+            auto size = co_await f.size();
+            _partition_trie_root = co_await read_partition_trie_root(f, size, default_priority_class());
+            _cached_partitions_file = seastar::make_shared<cached_file>(f,
+                                                                        index_page_cache_metrics,
+                                                                        _manager.get_cache_tracker().get_lru(),
+                                                                        _manager.get_cache_tracker().region(),
+                                                                        size);
+        } catch (...) {
+            ex = std::current_exception();
+        }
+        if (ex) {
+            co_await f.close();
+            std::rethrow_exception(ex);
+        }
+    }
+
+    if (_components->compression && _manager.config().sstable_decompressed_chunk_cache()) {
+        auto f = _version >= sstable_version_types::mc
+                ? make_decompressed_m_format_file(_data_file, &_components->compression)
+                : make_decompressed_k_l_format_file(_data_file, &_components->compression);
+        _cached_decompressed_data_file = seastar::make_shared<cached_file>(std::move(f),
+                                                                           decompressed_page_cache_metrics,
+                                                                           _manager.get_cache_tracker().get_lru(),
+                                                                           _manager.get_cache_tracker().region(),
+                                                                           _components->compression.uncompressed_file_length(),
+                                                                           get_filename());
+    }
+
     if (this->has_component(component_type::Filter)) {
         auto size = co_await io_check([&] {
             return file_size(this->filename(component_type::Filter));
@@ -1463,6 +1514,10 @@ future<> sstable::create_data() noexcept {
 
 future<> sstable::drop_caches() {
     return _cached_index_file->evict_gently().then([this] {
+        return _cached_partitions_file ? _cached_partitions_file->evict_gently() : make_ready_future<>();
+    }).then([this] {
+        return _cached_decompressed_data_file ? _cached_decompressed_data_file->evict_gently() : make_ready_future<>();
+    }).then([this] {
         return _index_cache->evict_gently();
     });
 }
@@ -1476,12 +1531,35 @@ future<> sstable::read_filter(const io_priority_class& pc) {
     return seastar::async([this, &pc] () mutable {
         sstables::filter filter;
         read_simple<component_type::Filter>(filter, pc).get();
+        auto layout = _components->scylla_metadata ? _components->scylla_metadata->get_filter_layout() : filter_layout::bloom;
+        if (layout == filter_layout::xor_filter) {
+            try {
+                _components->filter = utils::filter::create_xor_filter(std::move(filter.buckets.elements));
+            } catch (std::invalid_argument& e) {
+                throw malformed_sstable_exception(e.what(), filename(component_type::Filter));
+            }
+            return;
+        }
         auto nr_bits = filter.buckets.elements.size() * std::numeric_limits<typename decltype(filter.buckets.elements)::value_type>::digits;
         large_bitset bs(nr_bits, std::move(filter.buckets.elements));
-        utils::filter_format format = (_version >= sstable_version_types::mc)
-                                      ? utils::filter_format::m_format
-                                      : utils::filter_format::k_l_format;
-        _components->filter = utils::filter::create_filter(filter.hashes, std::move(bs), format);
+        switch (layout) {
+        case filter_layout::bloom: {
+            utils::filter_format format = (_version >= sstable_version_types::mc)
+                                          ? utils::filter_format::m_format
+                                          : utils::filter_format::k_l_format;
+            _components->filter = utils::filter::create_filter(filter.hashes, std::move(bs), format);
+            break;
+        }
+        case filter_layout::split_block_bloom:
+            if (nr_bits == 0 || nr_bits % utils::filter::split_block_bloom_filter::bits_per_block) {
+                throw malformed_sstable_exception(format("Split-block bloom filter has {} bits, not a positive multiple of {}",
+                        nr_bits, utils::filter::split_block_bloom_filter::bits_per_block), filename(component_type::Filter));
+            }
+            _components->filter = utils::filter::create_split_block_filter(std::move(bs));
+            break;
+        default:
+            throw malformed_sstable_exception(format("Unknown filter layout {}", static_cast<uint32_t>(layout)), filename(component_type::Filter));
+        }
     });
 }
 
@@ -1490,10 +1568,29 @@ void sstable::write_filter(const io_priority_class& pc) {
         return;
     }
 
-    auto f = static_cast<utils::filter::murmur3_bloom_filter *>(_components->filter.get());
+    // Versions which don't know about the FilterLayout entry read the bits of any layout as a
+    // classic bloom filter. A hash count of 0 makes them consider every key present, rather than
+    // miss data. The other layouts don't need the field.
+    if (auto* xf = dynamic_cast<utils::filter::xor_filter*>(_components->filter.get())) {
+        if (!xf->saturated()) {
+            xf->build();
+            auto filter_ref = sstables::filter_ref(0, xf->words());
+            write_simple<component_type::Filter>(filter_ref, pc);
+            return;
+        }
+        // The partition count was underestimated, past what an xor filter can be built for.
+        // Write a classic bloom filter without hash functions, which lets every key through,
+        // like a bloom filter sized after the estimate would have, once overfilled.
+        sstlog.info("{}: too many partitions for an xor filter, writing a filter which lets every key through",
+                get_filename());
+        _components->filter = utils::filter::create_filter(0, large_bitset(64), utils::filter_format::m_format);
+    }
+
+    auto f = static_cast<utils::filter::bloom_filter *>(_components->filter.get());
 
     auto&& bs = f->bits();
-    auto filter_ref = sstables::filter_ref(f->num_hashes(), bs.get_storage());
+    auto hashes = f->format() == utils::filter_format::split_block_format ? 0 : f->num_hashes();
+    auto filter_ref = sstables::filter_ref(hashes, bs.get_storage());
     write_simple<component_type::Filter>(filter_ref, pc);
 }
 
@@ -1693,7 +1790,8 @@ sstable::read_scylla_metadata(const io_priority_class& pc) noexcept {
 
 void
 sstable::write_scylla_metadata(const io_priority_class& pc, shard_id shard, sstable_enabled_features features, struct run_identifier identifier,
-        std::optional<scylla_metadata::large_data_stats> ld_stats, sstring origin) {
+        std::optional<scylla_metadata::large_data_stats> ld_stats, sstring origin,
+        std::optional<scylla_metadata::zone_map_columns> zone_map_columns) {
     auto&& first_key = get_first_decorated_key();
     auto&& last_key = get_last_decorated_key();
     auto sm = create_sharding_metadata(_schema, first_key, last_key, shard);
@@ -1711,6 +1809,13 @@ sstable::write_scylla_metadata(const io_priority_class& pc, shard_id shard, ssta
     _components->scylla_metadata->data.set<scylla_metadata_type::Sharding>(std::move(sm));
     _components->scylla_metadata->data.set<scylla_metadata_type::Features>(std::move(features));
     _components->scylla_metadata->data.set<scylla_metadata_type::RunIdentifier>(std::move(identifier));
+    // Leave the entry out for classic bloom filters, so that such sstables remain readable by older versions.
+    if (auto* f = dynamic_cast<utils::filter::bloom_filter*>(_components->filter.get());
+            f && f->format() == utils::filter_format::split_block_format) {
+        _components->scylla_metadata->data.set<scylla_metadata_type::FilterLayout>(filter_layout::split_block_bloom);
+    } else if (dynamic_cast<utils::filter::xor_filter*>(_components->filter.get())) {
+        _components->scylla_metadata->data.set<scylla_metadata_type::FilterLayout>(filter_layout::xor_filter);
+    }
     if (ld_stats) {
         _components->scylla_metadata->data.set<scylla_metadata_type::LargeDataStats>(std::move(*ld_stats));
     }
@@ -1719,6 +1824,9 @@ sstable::write_scylla_metadata(const io_priority_class& pc, shard_id shard, ssta
         o.value = bytes(to_bytes_view(sstring_view(origin)));
         _components->scylla_metadata->data.set<scylla_metadata_type::SSTableOrigin>(std::move(o));
     }
+    if (zone_map_columns) {
+        _components->scylla_metadata->data.set<scylla_metadata_type::ZoneMapColumns>(std::move(*zone_map_columns));
+    }
 
     scylla_metadata::scylla_version version;
     version.value = bytes(to_bytes_view(sstring_view(scylla_version())));
@@ -2401,8 +2509,58 @@ component_type sstable::component_from_sstring(version_types v, sstring &s) {
     }
 }
 
+// Reads the uncompressed contents of a compressed data file through their
+// cached_file. Cached pages are handed out as they are, without copying.
+class cached_decompressed_data_source_impl : public data_source_impl {
+    cached_file& _cf;
+    io_priority_class _pc;
+    reader_permit _permit;
+    tracing::trace_state_ptr _trace_state;
+    uint64_t _pos;
+    uint64_t _end;
+    uint64_t _chunk_len;
+    cached_file::stream _stream;
+public:
+    cached_decompressed_data_source_impl(cached_file& cf, const io_priority_class& pc, reader_permit permit,
+            tracing::trace_state_ptr trace_state, uint64_t pos, uint64_t len, uint64_t chunk_len)
+        : _cf(cf)
+        , _pc(pc)
+        , _permit(std::move(permit))
+        , _trace_state(std::move(trace_state))
+        , _pos(pos)
+        , _end(std::min(pos + len, cf.size()))
+        , _chunk_len(chunk_len)
+    { }
+
+    virtual future<temporary_buffer<char>> get() override {
+        if (_pos >= _end) {
+            return make_ready_future<temporary_buffer<char>>();
+        }
+        // A miss uncompresses the whole chunk, so populate the rest of it
+        // along with the page we want.
+        auto size_hint = _chunk_len - _pos % _chunk_len;
+        _stream = _cf.read(_pos, _pc, _permit, _trace_state, size_hint);
+        return _stream.next().then([this] (temporary_buffer<char> buf) {
+            buf.trim(std::min<uint64_t>(buf.size(), _end - _pos));
+            _pos += buf.size();
+            return buf;
+        });
+    }
+
+    virtual future<temporary_buffer<char>> skip(uint64_t n) override {
+        _pos = std::min(_pos + n, _end);
+        return make_ready_future<temporary_buffer<char>>();
+    }
+};
+
 input_stream<char> sstable::data_stream(uint64_t pos, size_t len, const io_priority_class& pc,
-        reader_permit permit, tracing::trace_state_ptr trace_state, lw_shared_ptr<file_input_stream_history> history, raw_stream raw) {
+        reader_permit permit, tracing::trace_state_ptr trace_state, lw_shared_ptr<file_input_stream_history> history, raw_stream raw,
+        use_caching caching) {
+    if (_cached_decompressed_data_file && raw == raw_stream::no && caching) {
+        return input_stream<char>(data_source(std::make_unique<cached_decompressed_data_source_impl>(*_cached_decompressed_data_file,
+                pc, std::move(permit), std::move(trace_state), pos, len, _components->compression.uncompressed_chunk_length())));
+    }
+
     file_input_stream_options options;
     options.buffer_size = sstable_buffer_size;
     options.io_priority_class = pc;
@@ -2726,6 +2884,13 @@ future<> sstable::close_files() {
             general_disk_error();
         });
     }
+    auto partitions_closed = make_ready_future<>();
+    if (_cached_partitions_file) {
+        partitions_closed = _cached_partitions_file->get_file().close().handle_exception([me = shared_from_this()] (auto ep) {
+            sstlog.warn("sstable close partitions_file failed: {}", ep);
+            general_disk_error();
+        });
+    }
     auto data_closed = make_ready_future<>();
     if (_data_file) {
         data_closed = _data_file.close().handle_exception([me = shared_from_this()] (auto ep) {
@@ -2772,7 +2937,7 @@ future<> sstable::close_files() {
 
     _on_closed(*this);
 
-    return when_all_succeed(std::move(index_closed), std::move(data_closed), std::move(unlinked), std::move(unlinked_temp_dir)).discard_result().then([this, me = shared_from_this()] {
+    return when_all_succeed(std::move(index_closed), std::move(partitions_closed), std::move(data_closed), std::move(unlinked), std::move(unlinked_temp_dir)).discard_result().then([this, me = shared_from_this()] {
         if (_open_mode) {
             if (_open_mode.value() == open_flags::ro) {
                 _stats.on_close_for_reading();
@@ -3079,6 +3244,17 @@ future<> init_metrics() {
         sm::make_gauge("index_page_cache_bytes_in_std", [] { return index_page_cache_metrics.bytes_in_std; },
             sm::description("Total number of bytes in temporary buffers which live in the std allocator")),
 
+        sm::make_counter("decompressed_page_cache_hits", [] { return decompressed_page_cache_metrics.page_hits; },
+            sm::description("Reads of compressed data which were served from the cache of uncompressed pages")),
+        sm::make_counter("decompressed_page_cache_misses", [] { return decompressed_page_cache_metrics.page_misses; },
+            sm::description("Reads of compressed data which had to read and uncompress chunks")),
+        sm::make_counter("decompressed_page_cache_evictions", [] { return decompressed_page_cache_metrics.page_evictions; },
+            sm::description("Total number of uncompressed pages which have been evicted")),
+        sm::make_counter("decompressed_page_cache_populations", [] { return decompressed_page_cache_metrics.page_populations; },
+            sm::description("Total number of uncompressed pages which were inserted into the cache")),
+        sm::make_gauge("decompressed_page_cache_bytes", [] { return decompressed_page_cache_metrics.cached_bytes; },
+            sm::description("Total number of bytes cached in the uncompressed page cache")),
+
         sm::make_counter("pi_cache_hits_l0", [] { return promoted_index_cache_metrics.hits_l0; },
             sm::description("Number of requests for promoted index block in state l0 which didn't have to go to the page cache")),
         sm::make_counter("pi_cache_hits_l1", [] { return promoted_index_cache_metrics.hits_l1; },
@@ -3131,6 +3307,8 @@ future<> init_metrics() {
             sm::description("Number of partitions seeked")),
         sm::make_counter("row_reads", [] { return sstables_stats::get_shard_stats().row_reads; },
             sm::description("Number of rows read")),
+        sm::make_counter("skipped_unselected_values", [] { return sstables_stats::get_shard_stats().skipped_unselected_values; },
+            sm::description("Number of cell values of columns a data query doesn't select, which were skipped instead of read")),
 
         sm::make_counter("capped_local_deletion_time", [] { return sstables_stats::get_shard_stats().capped_local_deletion_time; },
             sm::description("Was local deletion time capped at maximum allowed value in Statistics")),
@@ -3156,6 +3334,9 @@ future<> init_metrics() {
 
         sm::make_gauge("bloom_filter_memory_size", [] { return utils::filter::bloom_filter::get_shard_stats().memory_size; },
             sm::description("Bloom filter memory usage in bytes.")),
+
+        sm::make_gauge("xor_filter_memory_size", [] { return utils::filter::xor_filter::get_shard_stats().memory_size; },
+            sm::description("Xor filter memory usage in bytes.")),
     });
   });
 }
@@ -3221,6 +3402,18 @@ future<> sstable::destroy() {
             } else {
                 return make_ready_future<>();
             }
+        }).then([this] {
+            if (_cached_partitions_file) {
+                return _cached_partitions_file->evict_gently();
+            } else {
+                return make_ready_future<>();
+            }
+        }).then([this] {
+            if (_cached_decompressed_data_file) {
+                return _cached_decompressed_data_file->evict_gently();
+            } else {
+                return make_ready_future<>();
+            }
         });
     });
 }
@@ -3252,6 +3445,8 @@ std::ostream& operator<<(std::ostream& out, const sstables::component_type& comp
     case ct::TemporaryTOC: out << "TemporaryTOC"; break;
     case ct::TemporaryStatistics: out << "TemporaryStatistics"; break;
     case ct::Scylla: out << "Scylla"; break;
+    case ct::Partitions: out << "Partitions"; break;
+    case ct::CompressionDictionary: out << "CompressionDictionary"; break;
     case ct::Unknown: out << "Unknown"; break;
     }
     return out;
@@ -107,6 +107,16 @@ struct sstable_writer_config {
     write_monitor* monitor = &default_write_monitor();
     run_id run_identifier = run_id::create_random_id();
     size_t summary_byte_cost;
+    // Write the Partitions component (see partition_trie.hh)
+    bool partition_trie_index = false;
+    // Embed a row trie in promoted indexes (see row_trie.hh)
+    bool row_trie_index = false;
+    // Record zone maps in promoted indexes (see zone_map.hh)
+    bool zone_maps = false;
+    // Number of buffers of the Data and of the Index (and Partitions)
+    // components which may be written to disk concurrently
+    unsigned data_write_behind = 10;
+    unsigned index_write_behind = 10;
     sstring origin;
 
 private:
@@ -503,6 +513,11 @@ class sstable : public enable_lw_shared_from_this<sstable> {
     std::set<generation_type> _compaction_ancestors;
     file _index_file;
     seastar::shared_ptr<cached_file> _cached_index_file;
+    // The Partitions component, if present
+    seastar::shared_ptr<cached_file> _cached_partitions_file;
+    // Uncompressed contents of a compressed data file, when they are cached
+    seastar::shared_ptr<cached_file> _cached_decompressed_data_file;
+    uint64_t _partition_trie_root = 0;
     file _data_file;
     uint64_t _data_file_size;
     uint64_t _index_file_size;
@@ -586,7 +601,7 @@ class sstable : public enable_lw_shared_from_this<sstable> {
     future<> touch_temp_dir();
     future<> remove_temp_dir();
 
-    void generate_toc(compressor_ptr c, double filter_fp_chance);
+    void generate_toc(compressor_ptr c, double filter_fp_chance, bool partition_trie = false);
     void write_toc(const io_priority_class& pc);
     future<> seal_sstable();
 
@@ -595,7 +610,8 @@ class sstable : public enable_lw_shared_from_this<sstable> {
 
     future<> read_scylla_metadata(const io_priority_class& pc) noexcept;
     void write_scylla_metadata(const io_priority_class& pc, shard_id shard, sstable_enabled_features features, run_identifier identifier,
-            std::optional<scylla_metadata::large_data_stats> ld_stats, sstring origin);
+            std::optional<scylla_metadata::large_data_stats> ld_stats, sstring origin,
+            std::optional<scylla_metadata::zone_map_columns> zone_map_columns = {});
 
     future<> read_filter(const io_priority_class& pc);
 
@@ -659,9 +675,16 @@ class sstable : public enable_lw_shared_from_this<sstable> {
     //
     // When created with `raw_stream::yes`, the sstable data file will be
     // streamed as-is, without decompressing (if compressed).
+    //
+    // When created with `use_caching::yes`, a compressed data file is read
+    // through the cache of its uncompressed pages, if that is enabled. Only
+    // reads whose pages are likely to be read again should ask for it, like
+    // single-partition user reads; scans would evict hotter pages and row
+    // cache entries with pages they read once.
     using raw_stream = bool_class<class raw_stream_tag>;
     input_stream<char> data_stream(uint64_t pos, size_t len, const io_priority_class& pc,
-            reader_permit permit, tracing::trace_state_ptr trace_state, lw_shared_ptr<file_input_stream_history> history, raw_stream raw = raw_stream::no);
+            reader_permit permit, tracing::trace_state_ptr trace_state, lw_shared_ptr<file_input_stream_history> history, raw_stream raw = raw_stream::no,
+            use_caching caching = use_caching::no);
 
     // Read exactly the specific byte range from the data file (after
     // uncompression, if the file is compressed). This can be used to read
@@ -725,6 +748,14 @@ class sstable : public enable_lw_shared_from_this<sstable> {
         return has_scylla_component() && _components->scylla_metadata->has_feature(sstable_feature::ShadowableTombstones);
     }
 
+    bool has_row_trie_index() const {
+        return has_scylla_component() && _components->scylla_metadata->has_feature(sstable_feature::RowTrieIndex);
+    }
+
+    bool has_zone_maps() const {
+        return has_scylla_component() && _components->scylla_metadata->has_feature(sstable_feature::ZoneMaps);
+    }
+
     sstable_enabled_features features() const {
         if (!has_scylla_component()) {
             return {};
@@ -764,6 +795,12 @@ class sstable : public enable_lw_shared_from_this<sstable> {
         return filter_has_key(key::from_partition_key(s, key));
     }
 
+    // Checks up to utils::i_filter::max_batch_size keys against the filter.
+    // Bit i of the result is set iff keys[i] may be present in the sstable.
+    uint64_t filter_has_keys(std::span<const utils::hashed_key> keys) const {
+        return _components->filter->is_present_batch(keys);
+    }
+
     static utils::hashed_key make_hashed_key(const schema& s, const partition_key& key);
 
     filter_tracker& get_filter_tracker() { return _filter_tracker; }
@@ -869,6 +906,15 @@ class sstable : public enable_lw_shared_from_this<sstable> {
     // Return true if this sstable possibly stores clustering row(s) specified by ranges.
     bool may_contain_rows(const query::clustering_row_ranges& ranges) const;
 
+    // Returns the clustering ranges of the partition whose rows may match
+    // all value ranges, according to the zone maps of its promoted index
+    // blocks (see zone_map.hh). The ranges are empty if the sstable does not
+    // have the partition, and std::nullopt if the zone maps cannot tell.
+    // Index pages are read through the index page cache only with `use_caching::yes`.
+    future<std::optional<query::clustering_row_ranges>> zone_map_ranges(const schema& s, reader_permit permit,
+            const dht::decorated_key& key, const std::vector<query::column_value_range>& ranges,
+            const io_priority_class& pc, tracing::trace_state_ptr trace_state, use_caching caching);
+
     // false => there are no partition tombstones, true => we don't know
     bool may_have_partition_tombstones() const {
         return !has_correct_min_max_column_names()
@@ -63,6 +63,11 @@ sstable_writer_config sstables_manager::configure_writer(sstring origin) const {
             ? mutation_fragment_stream_validation_level::clustering_key
             : mutation_fragment_stream_validation_level::token;
     cfg.summary_byte_cost = summary_byte_cost(_db_config.sstable_summary_ratio());
+    cfg.partition_trie_index = _db_config.sstable_partition_trie_index();
+    cfg.row_trie_index = _db_config.sstable_row_trie_index();
+    cfg.zone_maps = _db_config.sstable_zone_maps();
+    cfg.data_write_behind = std::max(_db_config.sstable_data_write_behind(), 1u);
+    cfg.index_write_behind = std::max(_db_config.sstable_index_write_behind(), 1u);
 
     cfg.origin = std::move(origin);
 
@@ -0,0 +1,298 @@
+/*
+ * Copyright (C) 2022-present ScyllaDB
+ */
+
+/*
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include <algorithm>
+
+#include <seastar/core/coroutine.hh>
+
+#include "trie.hh"
+#include "exceptions.hh"
+#include "writer.hh"
+#include "bytes_ostream.hh"
+#include "vint-serialization.hh"
+
+namespace sstables {
+
+static constexpr uint8_t has_payload_flag = 0x01;
+static constexpr uint8_t has_children_flag = 0x02;
+static constexpr unsigned distance_width_shift = 2;
+// Flags, both payload vints and the child count.
+static constexpr size_t max_header_size = 1 + 2 * max_vint_length + 1;
+
+static size_t common_prefix_length(bytes_view a, bytes_view b) {
+    return std::mismatch(a.begin(), a.end(), b.begin(), b.end()).first - a.begin();
+}
+
+template <typename Output>
+trie_writer<Output>::trie_writer(Output& out, uint64_t base)
+    : _out(out)
+    , _pos(base)
+{
+    _path.emplace_back();
+}
+
+template <typename Output>
+uint64_t trie_writer<Output>::write_node(const node& n) {
+    auto pos = _pos;
+    uint8_t flags = 0;
+    size_t size = 1;
+    unsigned width_log2 = 0;
+    if (n.payload) {
+        flags |= has_payload_flag;
+        size += unsigned_vint::serialized_size(n.payload->value) + unsigned_vint::serialized_size(n.payload->length);
+    }
+    if (!n.children.empty()) {
+        flags |= has_children_flag;
+        // Children are written in order, so the first one is the furthest
+        auto max_distance = pos - n.children.front().second;
+        while (width_log2 < 3 && max_distance >= (uint64_t(1) << (8 << width_log2))) {
+            ++width_log2;
+        }
+        flags |= width_log2 << distance_width_shift;
+        size += 1 + n.children.size() * (1 + (1 << width_log2));
+    }
+
+    bytes buf(bytes::initialized_later(), size);
+    auto out = buf.begin();
+    *out++ = flags;
+    if (n.payload) {
+        out += unsigned_vint::serialize(n.payload->value, out);
+        out += unsigned_vint::serialize(n.payload->length, out);
+    }
+    if (!n.children.empty()) {
+        *out++ = n.children.size() - 1;
+        for (auto& [transition, child_pos] : n.children) {
+            *out++ = transition;
+        }
+        for (auto& [transition, child_pos] : n.children) {
+            auto distance = pos - child_pos;
+            for (int i = (1 << width_log2) - 1; i >= 0; --i) {
+                *out++ = distance >> (8 * i);
+            }
+        }
+    }
+    _out.write(reinterpret_cast<const char*>(buf.data()), buf.size());
+    _pos += size;
+    return pos;
+}
+
+template <typename Output>
+void trie_writer<Output>::pop_node() {
+    auto n = std::move(_path.back());
+    _path.pop_back();
+    auto pos = write_node(n);
+    _path.back().children.emplace_back(n.transition, pos);
+}
+
+// Prefixes are inserted in increasing order, so nodes which are not on the
+// path to the new prefix are complete and can be written out.
+template <typename Output>
+void trie_writer<Output>::insert(bytes_view prefix, trie_entry entry) {
+    auto common = common_prefix_length(_last_prefix, prefix);
+    while (_path.size() > common + 1) {
+        pop_node();
+    }
+    for (auto i = common; i < prefix.size(); ++i) {
+        _path.push_back(node{.transition = uint8_t(prefix[i])});
+    }
+    _path.back().payload = entry;
+    _last_prefix = bytes(prefix.data(), prefix.size());
+}
+
+template <typename Output>
+void trie_writer<Output>::flush_pending(uint64_t end) {
+    auto& p = _pending.front();
+    insert(bytes_view(p.key).substr(0, p.prefix_length), trie_entry{p.value, end - p.value});
+    _pending.pop_front();
+}
+
+template <typename Output>
+void trie_writer<Output>::add(bytes_view key, uint64_t value) {
+    // The prefix of a key must extend past the bytes it shares with
+    // either neighbour, so it is known only once the next key is.
+    size_t prefix_length = 1;
+    if (!_pending.empty()) {
+        auto& prev = _pending.back();
+        auto common = common_prefix_length(prev.key, key);
+        prev.prefix_length = std::min(prev.key.size(), std::max(prev.prefix_length, common + 1));
+        prefix_length = common + 1;
+    }
+    _pending.push_back(pending_key{bytes(key.data(), key.size()), value, prefix_length});
+    // An entry covers its key and the next one, so it ends where the value
+    // of the key after the next one starts.
+    if (_pending.size() == 3) {
+        flush_pending(value);
+    }
+}
+
+template <typename Output>
+uint64_t trie_writer<Output>::finish(uint64_t end_value) {
+    while (!_pending.empty()) {
+        flush_pending(end_value);
+    }
+    while (_path.size() > 1) {
+        pop_node();
+    }
+    return write_node(_path.back());
+}
+
+template class trie_writer<file_writer>;
+template class trie_writer<bytes_ostream>;
+
+struct trie_reader::node {
+    temporary_buffer<char> buf;
+    uint64_t pos;
+    std::optional<trie_entry> payload;
+    size_t children = 0;
+    const uint8_t* transitions = nullptr;
+    const uint8_t* distances = nullptr;
+    unsigned distance_width = 0;
+
+    uint64_t child(size_t i) const {
+        uint64_t distance = 0;
+        for (unsigned j = 0; j < distance_width; ++j) {
+            distance = (distance << 8) | distances[i * distance_width + j];
+        }
+        if (distance == 0 || distance > pos) {
+            throw malformed_sstable_exception(format("Invalid trie child distance {} at {}", distance, pos));
+        }
+        return pos - distance;
+    }
+};
+
+trie_reader::trie_reader(cached_file& file, uint64_t root, const io_priority_class& pc,
+        reader_permit permit, tracing::trace_state_ptr trace_state)
+    : _file(file)
+    , _root(root)
+    , _pc(pc)
+    , _permit(std::move(permit))
+    , _trace_state(std::move(trace_state))
+{ }
+
+future<temporary_buffer<char>> read_cached_bytes(cached_file& f, uint64_t pos, size_t len, const io_priority_class& pc,
+        reader_permit permit, tracing::trace_state_ptr trace_state) {
+    len = std::min<uint64_t>(len, f.size() - pos);
+    auto stream = f.read(pos, pc, std::move(permit), std::move(trace_state), len);
+    auto buf = co_await stream.next();
+    if (buf.size() >= len) {
+        buf.trim(len);
+        co_return buf;
+    }
+    // The range spans pages
+    temporary_buffer<char> result(len);
+    size_t filled = 0;
+    while (filled < len) {
+        if (buf.empty()) {
+            throw malformed_sstable_exception(format("Unexpected end of file reading {} bytes at {}", len, pos));
+        }
+        auto n = std::min(len - filled, buf.size());
+        std::copy_n(buf.get(), n, result.get_write() + filled);
+        filled += n;
+        if (filled < len) {
+            buf = co_await stream.next();
+        }
+    }
+    co_return result;
+}
+
+future<trie_reader::node> trie_reader::read_node(uint64_t pos) {
+    auto header = co_await read_cached_bytes(_file, pos, max_header_size, _pc, _permit, _trace_state);
+    auto malformed = [pos] {
+        return malformed_sstable_exception(format("Truncated trie node at {}", pos));
+    };
+    auto v = bytes_view(reinterpret_cast<const int8_t*>(header.get()), header.size());
+    if (v.empty()) {
+        throw malformed();
+    }
+    uint8_t flags = v[0];
+    size_t off = 1;
+    auto read_vint = [&] {
+        if (off >= v.size() || off + unsigned_vint::serialized_size_from_first_byte(v[off]) > v.size()) {
+            throw malformed();
+        }
+        auto value = unsigned_vint::deserialize(v.substr(off));
+        off += unsigned_vint::serialized_size(value);
+        return value;
+    };
+
+    node n;
+    n.pos = pos;
+    if (flags & has_payload_flag) {
+        auto value = read_vint();
+        auto length = read_vint();
+        n.payload = trie_entry{value, length};
+    }
+    auto size = off;
+    if (flags & has_children_flag) {
+        if (off >= v.size()) {
+            throw malformed();
+        }
+        n.children = uint8_t(v[off++]) + 1;
+        n.distance_width = 1 << ((flags >> distance_width_shift) & 3);
+        size = off + n.children * (1 + n.distance_width);
+    }
+
+    if (size <= header.size()) {
+        header.trim(size);
+        n.buf = std::move(header);
+    } else {
+        n.buf = co_await read_cached_bytes(_file, pos, size, _pc, _permit, _trace_state);
+        if (n.buf.size() < size) {
+            throw malformed();
+        }
+    }
+    n.transitions = reinterpret_cast<const uint8_t*>(n.buf.get()) + off;
+    n.distances = n.transitions + n.children;
+    co_return n;
+}
+
+future<trie_entry> trie_reader::last_entry(uint64_t pos) {
+    auto n = co_await read_node(pos);
+    while (n.children) {
+        n = co_await read_node(n.child(n.children - 1));
+    }
+    if (!n.payload) {
+        throw malformed_sstable_exception(format("Trie leaf without payload at {}", n.pos));
+    }
+    co_return *n.payload;
+}
+
+future<std::optional<trie_entry>> trie_reader::floor(bytes_view key) {
+    // A node's payload is smaller than its children, and the children are
+    // ordered by transition, so each candidate found on the way down is
+    // greater than the previous one.
+    std::optional<trie_entry> best;
+    // The greatest subtree entirely smaller than key, when it is the best candidate
+    std::optional<uint64_t> best_subtree;
+    auto n = co_await read_node(_root);
+    for (size_t depth = 0; ; ++depth) {
+        if (n.payload) {
+            best = n.payload;
+            best_subtree.reset();
+        }
+        if (depth == key.size()) {
+            break;
+        }
+        auto b = uint8_t(key[depth]);
+        auto i = std::lower_bound(n.transitions, n.transitions + n.children, b) - n.transitions;
+        if (i > 0) {
+            best_subtree = n.child(i - 1);
+            best.reset();
+        }
+        if (size_t(i) == n.children || n.transitions[i] != b) {
+            break;
+        }
+        n = co_await read_node(n.child(i));
+    }
+    if (best_subtree) {
+        co_return co_await last_entry(*best_subtree);
+    }
+    co_return best;
+}
+
+}
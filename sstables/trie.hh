@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2022-present ScyllaDB
+ */
+
+/*
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <deque>
+#include <optional>
+#include <vector>
+
+#include <seastar/core/future.hh>
+
+#include "bytes.hh"
+#include "reader_permit.hh"
+#include "tracing/trace_state.hh"
+#include "utils/cached_file.hh"
+
+namespace sstables {
+
+// On-disk trie over byte-comparable keys, used by the partition index
+// (see partition_trie.hh) and by the row index (see row_trie.hh).
+//
+// Keys are added in increasing order, each with a value. The trie only
+// stores, for each key, the shortest prefix which tells it apart from its
+// neighbours, and maps it to the key's value.
+//
+// A lookup walks the trie from the root and finds the greatest stored prefix
+// which is not greater than the searched key. Call it the prefix of key i.
+// Then all keys before i are smaller than the searched key, and all keys
+// after i + 1 are greater, so comparing key i with the searched key decides
+// between the two. The number of nodes visited is bounded by the length of
+// the prefix.
+//
+// Format:
+//
+//   node = flags [payload] [child_count transition* child_distance*]
+//   flags = byte
+//           // bit 0: the node has a payload
+//           // bit 1: the node has children
+//           // bits 2-3: log2 of the width of a child_distance (1 to 8 bytes)
+//   payload = value length
+//   value = unsigned_vint
+//   length = unsigned_vint        // value of the key after the next one, if any, minus value
+//   child_count = byte            // number of children minus one
+//   transition = byte             // in increasing order
+//   child_distance = be8 | be16 | be32 | be64 // node offset minus child offset
+//
+// Nodes are written in post-order, so that children always precede their
+// parent and the root is the last node. Since nodes only refer to their
+// children by distance, a trie can be embedded anywhere in a file.
+
+struct trie_entry {
+    uint64_t value;
+    uint64_t length;
+};
+
+// Writes a trie to Output, which is file_writer or bytes_ostream.
+// Keys must be added in increasing order.
+template <typename Output>
+class trie_writer {
+    struct node {
+        uint8_t transition;
+        std::optional<trie_entry> payload;
+        std::vector<std::pair<uint8_t, uint64_t>> children; // (transition, offset)
+    };
+    struct pending_key {
+        bytes key;
+        uint64_t value;
+        size_t prefix_length;
+    };
+
+    Output& _out;
+    // Position of the next node to be written.
+    uint64_t _pos;
+    // The path to the most recently inserted prefix; _path[0] is the root.
+    std::vector<node> _path;
+    bytes _last_prefix;
+    // Keys whose prefix length or entry length is not known yet.
+    std::deque<pending_key> _pending;
+private:
+    uint64_t write_node(const node& n);
+    void pop_node();
+    void insert(bytes_view prefix, trie_entry entry);
+    void flush_pending(uint64_t end);
+public:
+    // base is the position in the file at which the trie starts.
+    trie_writer(Output& out, uint64_t base);
+
+    void add(bytes_view key, uint64_t value);
+
+    // Writes the rest of the trie and returns the position of its root.
+    // end_value is the value past the last key, used for entry lengths.
+    uint64_t finish(uint64_t end_value);
+};
+
+// Looks up keys in a trie.
+class trie_reader {
+    struct node;
+
+    cached_file& _file;
+    uint64_t _root;
+    const io_priority_class& _pc;
+    reader_permit _permit;
+    tracing::trace_state_ptr _trace_state;
+private:
+    future<node> read_node(uint64_t pos);
+    future<trie_entry> last_entry(uint64_t pos);
+public:
+    trie_reader(cached_file& file, uint64_t root, const io_priority_class& pc,
+            reader_permit permit, tracing::trace_state_ptr trace_state);
+
+    // Returns the entry of the greatest stored prefix which is not greater than key,
+    // or std::nullopt if key is smaller than all of them.
+    future<std::optional<trie_entry>> floor(bytes_view key);
+};
+
+// Returns len bytes of f starting at pos, or less at the end of the file.
+future<temporary_buffer<char>> read_cached_bytes(cached_file& f, uint64_t pos, size_t len, const io_priority_class& pc,
+        reader_permit permit, tracing::trace_state_ptr trace_state);
+
+}
@@ -486,7 +486,9 @@ enum sstable_feature : uint8_t {
     CorrectStaticCompact = 3, // See #4139
     CorrectEmptyCounters = 4, // See #4363
     CorrectUDTsInCollections = 5, // See #6130
-    End = 6,
+    RowTrieIndex = 6, // Promoted indexes embed a row trie, see row_trie.hh
+    ZoneMaps = 7, // Promoted indexes embed zone maps, see zone_map.hh
+    End = 8,
 };
 
 // Scylla-specific features enabled for a particular sstable.
@@ -529,6 +531,8 @@ enum class scylla_metadata_type : uint32_t {
     SSTableOrigin = 6,
     ScyllaBuildId = 7,
     ScyllaVersion = 8,
+    FilterLayout = 9,
+    ZoneMapColumns = 10,
 };
 
 // UUID is used for uniqueness across nodes, such that an imported sstable
@@ -554,6 +558,27 @@ enum class large_data_type : uint32_t {
     elements_in_collection = 5,// number of elements in a collection
 };
 
+// Layout of the bits in the Filter component.
+// Absence of the FilterLayout entry in the Scylla component means bloom.
+//
+// Note: For extensibility, never reuse an identifier,
+// only add new ones, since these are stored on stable storage.
+enum class filter_layout : uint32_t {
+    bloom = 1,              // classic bloom filter, compatible with Cassandra
+    split_block_bloom = 2,  // utils::filter::split_block_bloom_filter
+    xor_filter = 3,         // utils::filter::xor_filter
+};
+
+// A column with zone maps, see zone_map.hh
+struct zone_map_column {
+    disk_string<uint32_t> name;
+    disk_string<uint32_t> type; // abstract_type::name()
+    uint32_t length;            // of the column's values
+
+    template <typename Describer>
+    auto describe_type(sstable_version_types v, Describer f) { return f(name, type, length); }
+};
+
 struct large_data_stats_entry {
     uint64_t max_value;
     uint64_t threshold;
@@ -569,6 +594,7 @@ struct scylla_metadata {
     using sstable_origin = disk_string<uint32_t>;
     using scylla_build_id = disk_string<uint32_t>;
     using scylla_version = disk_string<uint32_t>;
+    using zone_map_columns = disk_array<uint32_t, zone_map_column>;
 
     disk_set_of_tagged_union<scylla_metadata_type,
             disk_tagged_union_member<scylla_metadata_type, scylla_metadata_type::Sharding, sharding_metadata>,
@@ -578,7 +604,9 @@ struct scylla_metadata {
             disk_tagged_union_member<scylla_metadata_type, scylla_metadata_type::LargeDataStats, large_data_stats>,
             disk_tagged_union_member<scylla_metadata_type, scylla_metadata_type::SSTableOrigin, sstable_origin>,
             disk_tagged_union_member<scylla_metadata_type, scylla_metadata_type::ScyllaBuildId, scylla_build_id>,
-            disk_tagged_union_member<scylla_metadata_type, scylla_metadata_type::ScyllaVersion, scylla_version>
+            disk_tagged_union_member<scylla_metadata_type, scylla_metadata_type::ScyllaVersion, scylla_version>,
+            disk_tagged_union_member<scylla_metadata_type, scylla_metadata_type::FilterLayout, filter_layout>,
+            disk_tagged_union_member<scylla_metadata_type, scylla_metadata_type::ZoneMapColumns, zone_map_columns>
             > data;
 
     sstable_enabled_features get_features() const {
@@ -602,6 +630,13 @@ struct scylla_metadata {
         }
         return *ext;
     }
+    const zone_map_columns* get_zone_map_columns() const {
+        return data.get<scylla_metadata_type::ZoneMapColumns, zone_map_columns>();
+    }
+    filter_layout get_filter_layout() const {
+        auto* layout = data.get<scylla_metadata_type::FilterLayout, filter_layout>();
+        return layout ? *layout : filter_layout::bloom;
+    }
     std::optional<run_id> get_optional_run_identifier() const {
         auto* m = data.get<scylla_metadata_type::RunIdentifier, run_identifier>();
         return m ? std::make_optional(m->id) : std::nullopt;
@@ -8,11 +8,14 @@
 
 #pragma once
 
+#include <seastar/util/bool_class.hh>
+
 #include "shared_sstable.hh"
 #include "utils/UUID.hh"
 
 namespace sstables {
 
 using run_id = utils::tagged_uuid<struct run_id_tag>;
+using use_caching = seastar::bool_class<struct use_caching_tag>;
 
 } // namespace sstables
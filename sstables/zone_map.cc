@@ -0,0 +1,375 @@
+/*
+ * Copyright (C) 2022-present ScyllaDB
+ */
+
+/*
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include <seastar/core/byteorder.hh>
+#include <seastar/core/coroutine.hh>
+
+#include "zone_map.hh"
+#include "atomic_cell.hh"
+#include "clustering_interval_set.hh"
+#include "exceptions.hh"
+#include "index_reader.hh"
+#include "schema.hh"
+#include "sstable_set.hh"
+#include "sstables.hh"
+#include "trie.hh"
+#include "types.hh"
+
+namespace sstables {
+
+// Flags of a column_range
+static constexpr uint8_t has_values_flag = 0x01;  // min and max are valid
+static constexpr uint8_t has_empty_flag = 0x02;   // some cell has an empty value
+static constexpr uint8_t unknown_flag = 0x04;     // some cell has a value of unexpected length
+
+bool zone_map_supported(const column_definition& cdef) {
+    return cdef.is_regular() && cdef.is_atomic() && !cdef.is_counter() && cdef.type->value_length_if_fixed();
+}
+
+zone_map_writer::zone_map_writer(const schema& s)
+    : _column_index(s.regular_columns_count(), -1)
+{
+    for (auto& cdef : s.regular_columns()) {
+        if (zone_map_supported(cdef)) {
+            _column_index[cdef.id] = _columns.size();
+            _columns.push_back(column_range{&cdef, *cdef.type->value_length_if_fixed()});
+        }
+    }
+}
+
+scylla_metadata::zone_map_columns zone_map_writer::columns() const {
+    scylla_metadata::zone_map_columns columns;
+    for (auto& c : _columns) {
+        columns.elements.push_back(zone_map_column{
+            .name = {bytes(c.cdef->name())},
+            .type = {bytes(to_bytes_view(sstring_view(c.cdef->type->name())))},
+            .length = c.length,
+        });
+    }
+    return columns;
+}
+
+void zone_map_writer::add(const column_definition& cdef, atomic_cell_view cell) {
+    auto idx = _column_index[cdef.id];
+    if (idx < 0 || !cell.is_live()) {
+        return;
+    }
+    auto& c = _columns[idx];
+    auto value = cell.value();
+    if (value.empty()) {
+        c.flags |= has_empty_flag;
+        return;
+    }
+    if (value.size() != c.length) {
+        c.flags |= unknown_flag;
+        return;
+    }
+    if (!(c.flags & has_values_flag)) {
+        c.min = c.max = to_bytes(value);
+        c.flags |= has_values_flag;
+        return;
+    }
+    if (c.cdef->type->compare(value, managed_bytes_view(bytes_view(c.min))) < 0) {
+        c.min = to_bytes(value);
+    } else if (c.cdef->type->compare(value, managed_bytes_view(bytes_view(c.max))) > 0) {
+        c.max = to_bytes(value);
+    }
+}
+
+bytes zone_map_writer::finish_block() {
+    size_t size = 0;
+    for (auto& c : _columns) {
+        size += 1 + 2 * c.length;
+    }
+    bytes record(size, 0);
+    auto out = record.begin();
+    for (auto& c : _columns) {
+        *out++ = c.flags;
+        if (c.flags & has_values_flag) {
+            out = std::copy(c.min.begin(), c.min.end(), out);
+            out = std::copy(c.max.begin(), c.max.end(), out);
+        } else {
+            out += 2 * c.length;
+        }
+        c.flags = 0;
+    }
+    return record;
+}
+
+zone_map_filter::zone_map_filter(const schema& s, const scylla_metadata::zone_map_columns& columns,
+        const std::vector<query::column_value_range>& ranges) {
+    // Records also have room for columns which were dropped since.
+    std::vector<size_t> offsets;
+    for (auto& c : columns.elements) {
+        offsets.push_back(_record_size);
+        _record_size += 1 + 2 * c.length;
+    }
+    for (auto& r : ranges) {
+        if (r.column >= s.regular_columns_count()) {
+            continue;
+        }
+        auto& cdef = s.regular_column_at(r.column);
+        auto type_name = to_bytes_view(sstring_view(cdef.type->name()));
+        for (size_t i = 0; i < columns.elements.size(); ++i) {
+            auto& c = columns.elements[i];
+            if (c.name.value == cdef.name() && c.type.value == type_name) {
+                _filters.push_back(column_filter{offsets[i], c.length, cdef.type, r.range});
+                break;
+            }
+        }
+    }
+}
+
+bool zone_map_filter::may_match(bytes_view record) const {
+    for (auto& f : _filters) {
+        auto flags = uint8_t(record[f.offset]);
+        if (flags & unknown_flag) {
+            continue;
+        }
+        auto cmp = [&] (bytes_view a, bytes_view b) { return f.type->compare(a, b); };
+        if ((flags & has_empty_flag) && f.range.contains(bytes(), cmp)) {
+            continue;
+        }
+        if (!(flags & has_values_flag)) {
+            return false;
+        }
+        auto min = record.substr(f.offset + 1, f.length);
+        auto max = record.substr(f.offset + 1 + f.length, f.length);
+        if (auto& start = f.range.start()) {
+            auto c = cmp(max, start->value());
+            if (c < 0 || (c == 0 && !start->is_inclusive())) {
+                return false;
+            }
+        }
+        if (auto& end = f.range.end()) {
+            auto c = cmp(min, end->value());
+            if (c > 0 || (c == 0 && !end->is_inclusive())) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+future<std::optional<query::clustering_row_ranges>>
+sstable::zone_map_ranges(const schema& s, reader_permit permit, const dht::decorated_key& key,
+        const std::vector<query::column_value_range>& ranges, const io_priority_class& pc, tracing::trace_state_ptr trace_state,
+        use_caching caching) {
+    if (!has_zone_maps()) {
+        co_return std::nullopt;
+    }
+    zone_map_filter filter(s, *_components->scylla_metadata->get_zone_map_columns(), ranges);
+    if (filter.empty()) {
+        co_return std::nullopt;
+    }
+
+    index_reader ir(shared_from_this(), permit, pc, trace_state, caching, true);
+    std::optional<promoted_index_location> pi_location;
+    bool present = false;
+    std::exception_ptr ex;
+    try {
+        present = co_await ir.advance_lower_and_check_if_present(key);
+        if (present) {
+            pi_location = ir.get_promoted_index_location();
+        }
+    } catch (...) {
+        ex = std::current_exception();
+    }
+    co_await ir.close();
+    if (ex) {
+        std::rethrow_exception(std::move(ex));
+    }
+    if (!present) {
+        co_return query::clustering_row_ranges();
+    }
+    if (!pi_location) {
+        co_return std::nullopt;
+    }
+
+    auto blocks = pi_location->num_blocks;
+    auto record_size = filter.record_size();
+    auto footer_size = (blocks + 1 + has_row_trie_index()) * sizeof(uint32_t);
+    if (pi_location->size < footer_size) {
+        throw malformed_sstable_exception(format("Promoted index of {} bytes too small for {} blocks and zone maps",
+                pi_location->size, blocks));
+    }
+    auto index_file = caching
+            ? _cached_index_file
+            : seastar::make_shared<cached_file>(make_tracked_index_file(*this, permit, trace_state, caching),
+                                                index_page_cache_metrics,
+                                                manager().get_cache_tracker().get_lru(),
+                                                manager().get_cache_tracker().region(),
+                                                _index_file_size);
+    auto offset_pos = pi_location->start + pi_location->size - footer_size;
+    auto buf = co_await read_cached_bytes(*index_file, offset_pos, sizeof(uint32_t), pc, permit, trace_state);
+    if (buf.size() < sizeof(uint32_t)) {
+        throw malformed_sstable_exception("Truncated zone map offset");
+    }
+    auto records_pos = pi_location->start + read_be<uint32_t>(buf.get());
+    if (records_pos + uint64_t(blocks) * record_size > offset_pos) {
+        throw malformed_sstable_exception(format("Zone maps of {} blocks at {} overlap their offset at {}",
+                blocks, records_pos, offset_pos));
+    }
+
+    mc::cached_promoted_index pi(*_schema, pi_location->start, pi_location->size, promoted_index_cache_metrics, permit,
+            get_clustering_values_fixed_lengths(get_serialization_header()), *index_file, pc, blocks);
+    position_in_partition::less_compare less(*_schema);
+    query::clustering_row_ranges result;
+    // Start of the current run of blocks which may match
+    std::optional<position_in_partition> run_start;
+    auto end_run = [&] (position_in_partition_view last) {
+        auto end = position_in_partition::after_key(*_schema, last);
+        if (less(*run_start, end)) {
+            if (auto r = position_range_to_clustering_range(position_range(std::move(*run_start), std::move(end)), *_schema)) {
+                result.push_back(std::move(*r));
+            }
+        }
+        run_start.reset();
+    };
+    for (uint32_t idx = 0; idx < blocks; ++idx) {
+        auto record = co_await read_cached_bytes(*index_file, records_pos + uint64_t(idx) * record_size, record_size,
+                pc, permit, trace_state);
+        if (record.size() < record_size) {
+            throw malformed_sstable_exception("Truncated zone map");
+        }
+        bool match = filter.may_match(bytes_view(reinterpret_cast<const int8_t*>(record.get()), record.size()));
+        if (match && !run_start) {
+            run_start = *(co_await pi.get_block_with_start(idx, trace_state))->start;
+        } else if (!match && run_start) {
+            end_run(*(co_await pi.get_block(idx - 1, trace_state))->end);
+        }
+    }
+    if (run_start) {
+        end_run(*(co_await pi.get_block(blocks - 1, trace_state))->end);
+    }
+    sstlog.trace("{}: zone maps of {} match {}", get_filename(), key, result);
+    co_return result;
+}
+
+namespace {
+
+class zone_map_filtering_reader : public flat_mutation_reader_v2::impl {
+    const dht::partition_range& _pr;
+    const query::partition_slice& _slice;
+    lw_shared_ptr<sstable_set> _sstables;
+    const io_priority_class& _pc;
+    tracing::trace_state_ptr _trace_state;
+    noncopyable_function<flat_mutation_reader_v2(const query::partition_slice&)> _make_reader;
+    std::unique_ptr<query::partition_slice> _narrowed_slice;
+    flat_mutation_reader_v2_opt _reader;
+private:
+    // Returns the union of the ranges of all sstables, or std::nullopt if any of them cannot tell.
+    future<std::optional<clustering_interval_set>> matching_ranges(const dht::decorated_key& key) {
+        std::vector<shared_sstable> sstables;
+        for (auto& sst : _sstables->select(_pr)) {
+            if (sst->filter_has_key(*_schema, key.key())) {
+                sstables.push_back(sst);
+            }
+        }
+        // Cells of a row matching several value ranges may come from
+        // different sstables, none of which has a block matching them all.
+        if (sstables.size() > 1 && _slice.value_ranges.size() > 1) {
+            co_return std::nullopt;
+        }
+        clustering_interval_set matching;
+        for (auto& sst : sstables) {
+            auto ranges = co_await sst->zone_map_ranges(*_schema, _permit, key, _slice.value_ranges, _pc, _trace_state,
+                    use_caching(global_cache_index_pages && !_slice.options.contains(query::partition_slice::option::bypass_cache)));
+            if (!ranges) {
+                co_return std::nullopt;
+            }
+            for (auto& r : *ranges) {
+                matching.add(*_schema, position_range::from_range(r));
+            }
+        }
+        co_return matching;
+    }
+
+    future<> create_reader() {
+        auto key = _pr.start()->value().as_decorated_key();
+        auto matching = co_await matching_ranges(key);
+        if (!matching) {
+            _reader = _make_reader(_slice);
+            co_return;
+        }
+        // Intersect with the ranges of the slice. Both are sorted and
+        // disjoint, and so is the result.
+        position_in_partition::less_compare less(*_schema);
+        query::clustering_row_ranges narrowed;
+        for (auto& r : _slice.row_ranges(*_schema, key.key())) {
+            auto range = position_range::from_range(r);
+            for (auto&& m : *matching) {
+                auto& start = less(range.start(), m.start()) ? m.start() : range.start();
+                auto& end = less(m.end(), range.end()) ? m.end() : range.end();
+                if (!less(start, end)) {
+                    continue;
+                }
+                if (auto cr = position_range_to_clustering_range(position_range(start, end), *_schema)) {
+                    narrowed.push_back(std::move(*cr));
+                }
+            }
+        }
+        tracing::trace(_trace_state, "Zone maps narrowed the read of {} down to {} clustering ranges", key, narrowed.size());
+        _narrowed_slice = std::make_unique<query::partition_slice>(_slice);
+        _narrowed_slice->clear_ranges();
+        _narrowed_slice->set_range(*_schema, key.key(), std::move(narrowed));
+        _reader = _make_reader(*_narrowed_slice);
+    }
+public:
+    zone_map_filtering_reader(schema_ptr s, reader_permit permit, const dht::partition_range& pr,
+            const query::partition_slice& slice, lw_shared_ptr<sstable_set> sstables, const io_priority_class& pc,
+            tracing::trace_state_ptr trace_state, noncopyable_function<flat_mutation_reader_v2(const query::partition_slice&)> make_reader)
+        : impl(std::move(s), std::move(permit))
+        , _pr(pr)
+        , _slice(slice)
+        , _sstables(std::move(sstables))
+        , _pc(pc)
+        , _trace_state(std::move(trace_state))
+        , _make_reader(std::move(make_reader))
+    { }
+
+    virtual future<> fill_buffer() override {
+        if (!_reader) {
+            co_await create_reader();
+        }
+        if (is_buffer_full()) {
+            co_return;
+        }
+        co_await _reader->fill_buffer();
+        _end_of_stream = _reader->is_end_of_stream();
+        _reader->move_buffer_content_to(*this);
+    }
+    virtual future<> next_partition() override {
+        clear_buffer_to_next_partition();
+        if (is_buffer_empty() && _reader) {
+            co_await _reader->next_partition();
+            _end_of_stream = _reader->is_end_of_stream() && _reader->is_buffer_empty();
+        }
+    }
+    virtual future<> fast_forward_to(const dht::partition_range&) override {
+        return make_exception_future<>(make_backtraced_exception_ptr<std::bad_function_call>());
+    }
+    virtual future<> fast_forward_to(position_range) override {
+        return make_exception_future<>(make_backtraced_exception_ptr<std::bad_function_call>());
+    }
+    virtual future<> close() noexcept override {
+        return _reader ? _reader->close() : make_ready_future<>();
+    }
+};
+
+}
+
+flat_mutation_reader_v2 make_zone_map_filtering_reader(schema_ptr s, reader_permit permit,
+        const dht::partition_range& pr, const query::partition_slice& slice, lw_shared_ptr<sstable_set> sstables,
+        const io_priority_class& pc, tracing::trace_state_ptr trace_state,
+        noncopyable_function<flat_mutation_reader_v2(const query::partition_slice&)> make_reader) {
+    return make_flat_mutation_reader_v2<zone_map_filtering_reader>(std::move(s), std::move(permit), pr, slice,
+            std::move(sstables), pc, std::move(trace_state), std::move(make_reader));
+}
+
+}
@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2022-present ScyllaDB
+ */
+
+/*
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <vector>
+
+#include <seastar/util/noncopyable_function.hh>
+
+#include "bytes.hh"
+#include "query-request.hh"
+#include "readers/flat_mutation_reader_v2.hh"
+#include "schema_fwd.hh"
+#include "sstables/shared_sstable.hh"
+#include "sstables/types.hh"
+
+class atomic_cell_view;
+
+namespace sstables {
+
+class sstable_set;
+
+// Zone maps: the range of values of regular columns in each promoted index block.
+//
+// Every promoted index block gets a record with the smallest and greatest
+// value of each zone-mapped column among the cells of its rows, so that
+// queries with filtering, which know which values rows have to match (see
+// query::column_value_range), can leave out the blocks none of whose rows
+// can match, and whole partitions if none of their blocks can.
+//
+// Only atomic regular columns of fixed-size types are zone-mapped, so that
+// all records are equally long. They are listed, in record order, in the
+// ZoneMapColumns entry of the Scylla component. Records are stored after
+// the blocks and the row trie, followed by their position:
+//
+//   promoted_index = header block* row_trie? zone_map* zone_map_offset root_offset? offset*
+//   zone_map = column_range*      // one per zone-mapped column
+//   column_range = flags:byte min max
+//   zone_map_offset = be32        // relative to the start of the first block
+//
+// min and max are as long as the values of the column, and only valid if
+// the flags say the block has values. Readers which do not know about zone
+// maps locate the offsets and the row trie from the end of the promoted
+// index and never look at them. Sstables which carry them have
+// sstable_feature::ZoneMaps enabled.
+//
+// Partitions which fit in a single block have no promoted index, hence no
+// zone maps either.
+
+// Whether values of the column are recorded in zone maps.
+bool zone_map_supported(const column_definition& cdef);
+
+// Builds the records of the promoted index blocks of partitions.
+class zone_map_writer {
+    struct column_range {
+        const column_definition* cdef;
+        uint32_t length;
+        uint8_t flags = 0;
+        bytes min;
+        bytes max;
+    };
+    std::vector<column_range> _columns;
+    // Index into _columns of each regular column, or -1 if not zone-mapped
+    std::vector<int> _column_index;
+public:
+    explicit zone_map_writer(const schema& s);
+
+    // Whether the schema has no zone-mapped columns.
+    bool empty() const {
+        return _columns.empty();
+    }
+
+    // The zone-mapped columns, in record order.
+    scylla_metadata::zone_map_columns columns() const;
+
+    // Accounts for a cell of a row of the current block.
+    void add(const column_definition& cdef, atomic_cell_view cell);
+
+    // Returns the record of the current block and starts the next one.
+    bytes finish_block();
+};
+
+// Tells from the records of an sstable whether blocks may have rows
+// matching the value ranges of a query.
+class zone_map_filter {
+    struct column_filter {
+        size_t offset;
+        uint32_t length;
+        data_type type;
+        nonwrapping_range<bytes> range;
+    };
+    std::vector<column_filter> _filters;
+    size_t _record_size = 0;
+public:
+    // Value ranges on columns which are not zone-mapped by the sstable,
+    // or whose type changed since, are ignored.
+    zone_map_filter(const schema& s, const scylla_metadata::zone_map_columns& columns,
+            const std::vector<query::column_value_range>& ranges);
+
+    // Whether none of the value ranges applies to the records.
+    bool empty() const {
+        return _filters.empty();
+    }
+
+    size_t record_size() const {
+        return _record_size;
+    }
+
+    // Whether rows of the block with the given record may match all value ranges.
+    bool may_match(bytes_view record) const;
+};
+
+// Reads a single partition from sstables, which have to be its only source,
+// leaving out the rows which zone maps tell cannot match the value ranges
+// of the slice.
+//
+// The clustering ranges of the slice are narrowed down to the union of the
+// blocks of all sstables which may have matching rows, and make_reader is
+// called with the narrowed slice. Rows outside of it have no matching value
+// in any sstable, so they cannot match after being merged either. If any
+// sstable cannot tell, make_reader is called with the slice as is.
+//
+// Only for forward reads, without forwarding.
+flat_mutation_reader_v2 make_zone_map_filtering_reader(schema_ptr s, reader_permit permit,
+        const dht::partition_range& pr, const query::partition_slice& slice, lw_shared_ptr<sstable_set> sstables,
+        const io_priority_class& pc, tracing::trace_state_ptr trace_state,
+        noncopyable_function<flat_mutation_reader_v2(const query::partition_slice&)> make_reader);
+
+}
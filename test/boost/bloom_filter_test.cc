@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2022-present ScyllaDB
+ */
+
+/*
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include <seastar/testing/test_case.hh>
+#include <seastar/testing/thread_test_case.hh>
+
+#include "utils/bloom_filter.hh"
+#include "utils/xor_filter.hh"
+#include "test/lib/random_utils.hh"
+#include "test/lib/log.hh"
+
+static std::vector<bytes> make_keys(size_t n) {
+    std::vector<bytes> keys;
+    keys.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        keys.push_back(tests::random::get_bytes(16));
+    }
+    return keys;
+}
+
+static double false_positive_rate(utils::i_filter& f, size_t probes) {
+    size_t false_positives = 0;
+    for (size_t i = 0; i < probes; i++) {
+        // Longer than the inserted keys, so never present
+        if (f.is_present(tests::random::get_bytes(17))) {
+            false_positives++;
+        }
+    }
+    return double(false_positives) / probes;
+}
+
+SEASTAR_THREAD_TEST_CASE(test_split_block_filter_has_no_false_negatives) {
+    for (auto n : {1, 7, 1000, 50000}) {
+        auto keys = make_keys(n);
+        auto f = utils::i_filter::get_filter(n, 0.01, utils::filter_format::split_block_format);
+        for (auto& k : keys) {
+            f->add(k);
+        }
+        for (auto& k : keys) {
+            BOOST_REQUIRE(f->is_present(k));
+            BOOST_REQUIRE(f->is_present(utils::make_hashed_key(k)));
+        }
+    }
+}
+
+SEASTAR_THREAD_TEST_CASE(test_split_block_filter_false_positive_rate) {
+    const size_t n = 100000;
+    auto keys = make_keys(n);
+    for (auto fp_chance : {0.1, 0.01, 0.001}) {
+        auto classic = utils::i_filter::get_filter(n, fp_chance, utils::filter_format::m_format);
+        auto blocked = utils::i_filter::get_filter(n, fp_chance, utils::filter_format::split_block_format);
+        for (auto& k : keys) {
+            classic->add(k);
+            blocked->add(k);
+        }
+        auto classic_fpr = false_positive_rate(*classic, n);
+        auto blocked_fpr = false_positive_rate(*blocked, n);
+        testlog.info("fp_chance={} classic: fpr={} size={}, split-block: fpr={} size={}", fp_chance,
+                classic_fpr, classic->memory_size(), blocked_fpr, blocked->memory_size());
+        // Blocking costs some accuracy for a given size, but must stay in the same ballpark.
+        BOOST_REQUIRE_LE(blocked_fpr, fp_chance * 2);
+    }
+}
+
+SEASTAR_THREAD_TEST_CASE(test_split_block_filter_survives_serialization) {
+    const size_t n = 1000;
+    auto keys = make_keys(n);
+    auto f = utils::i_filter::get_filter(n, 0.01, utils::filter_format::split_block_format);
+    for (auto& k : keys) {
+        f->add(k);
+    }
+
+    auto& bf = static_cast<utils::filter::bloom_filter&>(*f);
+    BOOST_REQUIRE(bf.format() == utils::filter_format::split_block_format);
+    BOOST_REQUIRE_EQUAL(bf.num_hashes(), utils::filter::split_block_bloom_filter::words_per_block);
+    auto storage = bf.bits().get_storage();
+    large_bitset bs(bf.bits().size(), std::move(storage));
+    auto copy = utils::filter::create_split_block_filter(std::move(bs));
+    for (auto& k : keys) {
+        BOOST_REQUIRE(copy->is_present(k));
+    }
+
+    BOOST_REQUIRE_THROW(utils::filter::create_split_block_filter(large_bitset(64)), std::invalid_argument);
+}
+
+SEASTAR_THREAD_TEST_CASE(test_batched_probes_match_single_probes) {
+    const size_t n = 1000;
+    auto keys = make_keys(n);
+    for (auto format : {utils::filter_format::k_l_format, utils::filter_format::m_format, utils::filter_format::split_block_format,
+            utils::filter_format::xor_format}) {
+        // A high false positive chance, so that batches see a mix of hits and misses
+        auto f = utils::i_filter::get_filter(n, 0.3, format);
+        for (auto& k : keys) {
+            f->add(k);
+        }
+        if (auto* xf = dynamic_cast<utils::filter::xor_filter*>(f.get())) {
+            xf->build();
+        }
+        std::vector<utils::hashed_key> probes;
+        for (size_t i = 0; i < n; i++) {
+            probes.push_back(utils::make_hashed_key(i % 2 ? keys[i] : tests::random::get_bytes(17)));
+        }
+        for (size_t batch : {size_t(1), size_t(5), utils::i_filter::max_batch_size}) {
+            for (size_t pos = 0; pos + batch <= probes.size(); pos += batch) {
+                auto keys_in_batch = std::span<const utils::hashed_key>(probes).subspan(pos, batch);
+                auto mask = f->is_present_batch(keys_in_batch);
+                for (size_t i = 0; i < batch; i++) {
+                    BOOST_REQUIRE_EQUAL(bool(mask & (uint64_t(1) << i)), f->is_present(keys_in_batch[i]));
+                }
+            }
+        }
+    }
+
+    utils::filter::always_present_filter always;
+    std::vector<utils::hashed_key> probes(utils::i_filter::max_batch_size, utils::make_hashed_key(keys[0]));
+    BOOST_REQUIRE_EQUAL(always.is_present_batch(std::span(probes).first(3)), 0b111);
+    BOOST_REQUIRE_EQUAL(always.is_present_batch(probes), ~uint64_t(0));
+}
+
+SEASTAR_THREAD_TEST_CASE(test_xor_filter_has_no_false_negatives) {
+    for (auto n : {0, 1, 7, 1000, 50000}) {
+        auto keys = make_keys(n);
+        auto f = utils::i_filter::get_filter(n, 0.01, utils::filter_format::xor_format);
+        for (auto& k : keys) {
+            f->add(k);
+        }
+        // Duplicates must not prevent the construction from succeeding
+        if (n) {
+            f->add(keys[0]);
+        }
+        static_cast<utils::filter::xor_filter&>(*f).build();
+        for (auto& k : keys) {
+            BOOST_REQUIRE(f->is_present(k));
+            BOOST_REQUIRE(f->is_present(utils::make_hashed_key(k)));
+        }
+    }
+}
+
+SEASTAR_THREAD_TEST_CASE(test_xor_filter_false_positive_rate) {
+    const size_t n = 100000;
+    auto keys = make_keys(n);
+    for (auto fp_chance : {0.1, 0.01, 0.001}) {
+        auto classic = utils::i_filter::get_filter(n, fp_chance, utils::filter_format::m_format);
+        auto xf = utils::i_filter::get_filter(n, fp_chance, utils::filter_format::xor_format);
+        for (auto& k : keys) {
+            classic->add(k);
+            xf->add(k);
+        }
+        static_cast<utils::filter::xor_filter&>(*xf).build();
+        auto classic_fpr = false_positive_rate(*classic, n);
+        auto xor_fpr = false_positive_rate(*xf, n);
+        testlog.info("fp_chance={} classic: fpr={} size={}, xor: fpr={} size={}", fp_chance,
+                classic_fpr, classic->memory_size(), xor_fpr, xf->memory_size());
+        BOOST_REQUIRE_LE(xor_fpr, fp_chance * 1.2);
+    }
+}
+
+SEASTAR_THREAD_TEST_CASE(test_xor_filter_survives_serialization) {
+    const size_t n = 1000;
+    auto keys = make_keys(n);
+    auto f = utils::i_filter::get_filter(n, 0.01, utils::filter_format::xor_format);
+    for (auto& k : keys) {
+        f->add(k);
+    }
+
+    auto& xf = static_cast<utils::filter::xor_filter&>(*f);
+    xf.build();
+    auto words = xf.words();
+    auto copy = utils::filter::create_xor_filter(words);
+    for (auto& k : keys) {
+        BOOST_REQUIRE(copy->is_present(k));
+    }
+
+    auto bad_width = words;
+    bad_width[2] = 33;
+    BOOST_REQUIRE_THROW(utils::filter::create_xor_filter(std::move(bad_width)), std::invalid_argument);
+    words.pop_back();
+    BOOST_REQUIRE_THROW(utils::filter::create_xor_filter(std::move(words)), std::invalid_argument);
+    BOOST_REQUIRE_THROW(utils::filter::create_xor_filter(utils::filter::xor_filter::storage()), std::invalid_argument);
+}
+
+SEASTAR_THREAD_TEST_CASE(test_xor_filter_falls_back_above_max_elements) {
+    using utils::filter::xor_filter;
+
+    // An estimate above the limit gets a classic bloom filter right away
+    auto f = utils::i_filter::get_filter(xor_filter::max_elements + 1, 0.01, utils::filter_format::xor_format);
+    auto* bf = dynamic_cast<utils::filter::bloom_filter*>(f.get());
+    BOOST_REQUIRE(bf);
+    BOOST_REQUIRE(bf->format() == utils::filter_format::m_format);
+
+    // An underestimate saturates the xor filter, which gives up its key hashes
+    auto keys = make_keys(1000);
+    f = utils::i_filter::get_filter(keys.size(), 0.01, utils::filter_format::xor_format);
+    auto& xf = static_cast<xor_filter&>(*f);
+    for (uint64_t i = 0; i < xor_filter::max_elements; i++) {
+        xf.add(keys[i % keys.size()]);
+    }
+    BOOST_REQUIRE(!xf.saturated());
+    xf.add(keys[0]);
+    BOOST_REQUIRE(xf.saturated());
+    BOOST_REQUIRE_EQUAL(xf.memory_size(), 0);
+}
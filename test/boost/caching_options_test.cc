@@ -34,4 +34,20 @@ BOOST_AUTO_TEST_CASE(test_caching_options) {
         sstring in_str = "{\"keys\": \"NONE, }";
         BOOST_REQUIRE_THROW(caching_options::from_sstring(in_str), std::exception);
     }
+    {
+        string_map in_map = { {"keys", "ALL"}, {"rows_per_partition", "ALL"}, {"max_partitions", "1000"}, {"priority", "high"}};
+        caching_options co = caching_options::from_map(in_map);
+        BOOST_REQUIRE_EQUAL(co.max_partitions(), 1000);
+        BOOST_REQUIRE(co.priority() == caching_options::priority_class::high);
+        BOOST_REQUIRE(in_map == co.to_map());
+        BOOST_REQUIRE(co != caching_options::from_map({ {"keys", "ALL"}, {"rows_per_partition", "ALL"}}));
+    }
+    {
+        // Defaults are not serialized
+        string_map in_map = { {"keys", "ALL"}, {"rows_per_partition", "ALL"}, {"max_partitions", "0"}, {"priority", "normal"}};
+        auto out_map = caching_options::from_map(in_map).to_map();
+        BOOST_REQUIRE(out_map == string_map({ {"keys", "ALL"}, {"rows_per_partition", "ALL"}}));
+    }
+    BOOST_REQUIRE_THROW(caching_options::from_map({ {"priority", "urgent"}}), std::exception);
+    BOOST_REQUIRE_THROW(caching_options::from_map({ {"max_partitions", "many"}}), std::exception);
 }
@@ -34,6 +34,7 @@
 #include "db/config.hh"
 #include "cql3/cql_config.hh"
 #include "compaction/compaction_manager.hh"
+#include "sstables/stats.hh"
 #include "test/lib/exception_utils.hh"
 #include "utils/rjson.hh"
 #include "utils/fmt-compat.hh"
@@ -3711,6 +3712,38 @@ SEASTAR_TEST_CASE(test_cache_bypass) {
     });
 }
 
+SEASTAR_TEST_CASE(test_range_scan_skips_unselected_values) {
+    return do_with_cql_env_thread([] (cql_test_env& e) {
+        e.execute_cql("CREATE TABLE t (pk int, ck int, v1 text, v2 text, PRIMARY KEY (pk, ck))").get();
+        std::vector<std::vector<bytes_opt>> expected;
+        for (int pk = 0; pk < 10; ++pk) {
+            e.execute_cql(format("INSERT INTO t (pk, ck, v1, v2) VALUES ({}, 0, 'selected', 'unselected')", pk)).get();
+            // A row with only unselected cells, and no row marker, is still returned
+            e.execute_cql(format("UPDATE t SET v2 = 'unselected' WHERE pk = {} AND ck = 1", pk)).get();
+            expected.push_back({int32_type->decompose(pk), int32_type->decompose(0), utf8_type->decompose("selected")});
+            expected.push_back({int32_type->decompose(pk), int32_type->decompose(1), std::nullopt});
+        }
+        e.db().invoke_on_all([] (replica::database& db) { return db.flush_all_memtables(); }).get();
+
+        auto skipped_values = [&] {
+            return e.db().map_reduce0([] (const replica::database&) {
+                return sstables::sstables_stats::get_shard_stats().skipped_unselected_values;
+            }, uint64_t(0), std::plus<uint64_t>()).get0();
+        };
+
+        auto before = skipped_values();
+        assert_that(e.execute_cql("SELECT pk, ck, v1 FROM t BYPASS CACHE").get0())
+            .is_rows().with_rows_ignore_order(expected);
+        BOOST_REQUIRE_GE(skipped_values() - before, expected.size());
+
+        // Reads through the cache get all values
+        before = skipped_values();
+        assert_that(e.execute_cql("SELECT pk, ck, v1 FROM t").get0())
+            .is_rows().with_rows_ignore_order(expected);
+        BOOST_REQUIRE_EQUAL(skipped_values(), before);
+    });
+}
+
 SEASTAR_TEST_CASE(test_describe_varchar) {
    // Test that, like cassandra, a varchar column is represented as a text column.
    return do_with_cql_env_thread([] (cql_test_env& e) {
@@ -10,6 +10,7 @@
 #include <seastar/core/seastar.hh>
 #include <seastar/core/thread.hh>
 #include <seastar/core/coroutine.hh>
+#include <seastar/util/defer.hh>
 
 #include <seastar/testing/test_case.hh>
 #include <seastar/testing/thread_test_case.hh>
@@ -36,6 +37,7 @@
 #include "multishard_mutation_query.hh"
 #include "transport/messages/result_message.hh"
 #include "db/snapshot-ctl.hh"
+#include "db/cache_warmer.hh"
 
 using namespace std::chrono_literals;
 using namespace sstables;
@@ -1293,3 +1295,59 @@ SEASTAR_TEST_CASE(drop_table_with_explicit_snapshot) {
         co_return;
     });
 }
+
+SEASTAR_TEST_CASE(test_cache_warmer) {
+    return do_with_cql_env_thread([] (cql_test_env& e) {
+        e.execute_cql("create table ks.cf (pk int, ck int, v int, primary key (pk, ck));").get();
+        static constexpr size_t nr_partitions = 10;
+        for (size_t i = 0; i < nr_partitions; ++i) {
+            e.execute_cql(format("insert into ks.cf (pk, ck, v) values ({}, 0, 0);", i)).get();
+        }
+        e.db().invoke_on_all([] (replica::database& db) {
+            return db.flush_all_memtables();
+        }).get();
+        e.execute_cql("select * from ks.cf;").get();
+
+        auto cached_partitions = [&] {
+            return e.db().map_reduce0([] (replica::database& db) {
+                return db.find_column_family("ks", "cf").get_row_cache().get_table_stats().partitions;
+            }, uint64_t(0), std::plus<uint64_t>()).get0();
+        };
+        BOOST_REQUIRE_EQUAL(cached_partitions(), nr_partitions);
+
+        tmpdir dir;
+        sharded<db::cache_warmer> warmer;
+        warmer.start(std::ref(e.db()), db::cache_warmer::config{
+            .directory = dir.path().string(),
+            .save_period = std::chrono::hours(1),
+        }).get();
+        auto stop_warmer = defer([&warmer] { warmer.stop().get(); });
+        warmer.invoke_on_all(&db::cache_warmer::save).get();
+
+        e.db().invoke_on_all([] (replica::database& db) {
+            return db.find_column_family("ks", "cf").get_row_cache().invalidate(row_cache::external_updater([] {}));
+        }).get();
+        BOOST_REQUIRE_EQUAL(cached_partitions(), 0);
+
+        auto loaded = warmer.map_reduce0([] (db::cache_warmer& w) {
+            return w.load();
+        }, size_t(0), std::plus<size_t>()).get0();
+        BOOST_REQUIRE_EQUAL(loaded, nr_partitions);
+        BOOST_REQUIRE_EQUAL(cached_partitions(), nr_partitions);
+
+        // The keys saved by a shard which no longer exists are read by some
+        // other shard, routed to their owners, and the file is removed.
+        auto saved = dir.path() / "row_cache_keys-0.txt";
+        auto stale = dir.path() / format("row_cache_keys-{}.txt", smp::count + 1);
+        rename_file(saved.native(), stale.native()).get();
+        e.db().invoke_on_all([] (replica::database& db) {
+            return db.find_column_family("ks", "cf").get_row_cache().invalidate(row_cache::external_updater([] {}));
+        }).get();
+        loaded = warmer.map_reduce0([] (db::cache_warmer& w) {
+            return w.load();
+        }, size_t(0), std::plus<size_t>()).get0();
+        BOOST_REQUIRE_EQUAL(loaded, nr_partitions);
+        BOOST_REQUIRE_EQUAL(cached_partitions(), nr_partitions);
+        BOOST_REQUIRE(!file_exists(stale.native()).get0());
+    });
+}
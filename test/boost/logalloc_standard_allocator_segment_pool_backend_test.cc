@@ -5,8 +5,10 @@
 
 using namespace logalloc;
 
+// Maps the segment area from reserved huge pages when there are enough of them,
+// and falls back to transparent huge pages otherwise.
 SEASTAR_TEST_CASE(test_preinit) {
-    return use_standard_allocator_segment_pool_backend(1 << 30);
+    return use_standard_allocator_segment_pool_backend(1 << 30, true);
 }
 
 #include "./logalloc_test.cc"
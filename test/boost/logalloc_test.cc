@@ -130,6 +130,48 @@ SEASTAR_TEST_CASE(test_occupancy) {
 }
 
 
+SEASTAR_THREAD_TEST_CASE(test_huge_page_usage) {
+    constexpr size_t segments_per_huge_page = (2 << 20) / segment_size;
+    auto owned_segments = [] {
+        return shard_tracker().occupancy().total_space() / segment_size;
+    };
+    auto check = [&] (const tracker::huge_page_usage& usage) {
+        BOOST_REQUIRE_LE(usage.shared_pages, usage.pages);
+        BOOST_REQUIRE_LE(usage.pages, owned_segments());
+        BOOST_REQUIRE_GE(usage.pages * segments_per_huge_page, owned_segments());
+    };
+
+    region reg;
+    std::vector<managed_bytes> allocs;
+    auto clean_up = defer([&] () noexcept {
+        with_allocator(reg.allocator(), [&] {
+            allocs.clear();
+        });
+    });
+    with_allocator(reg.allocator(), [&] {
+        for (size_t i = 0; i < 8 * segments_per_huge_page * segment_size / 1024; ++i) {
+            allocs.emplace_back(managed_bytes::initialized_later(), 1000);
+        }
+    });
+    auto usage = shard_tracker().huge_pages_in_use();
+#ifdef SEASTAR_DEFAULT_ALLOCATOR
+    if (!usage.pages) {
+        testlog.info("Segments are allocated one by one, huge pages are not tracked");
+        return;
+    }
+#endif
+    BOOST_REQUIRE_GE(usage.pages, 7);
+    check(usage);
+
+    with_allocator(reg.allocator(), [&] {
+        allocs.clear();
+    });
+    shard_tracker().reclaim_all_free_segments();
+    auto freed = shard_tracker().huge_pages_in_use();
+    BOOST_REQUIRE_LT(freed.pages, usage.pages);
+    check(freed);
+}
+
 SEASTAR_TEST_CASE(test_compaction_with_multiple_regions) {
     return seastar::async([] {
         region reg1;
@@ -768,6 +810,49 @@ SEASTAR_THREAD_TEST_CASE(background_reclaim) {
     }
 }
 
+SEASTAR_THREAD_TEST_CASE(test_reclaim_step_ends_at_deadline) {
+    region evictable;
+    std::vector<managed_bytes> allocs;
+    auto clean_up = defer([&] () noexcept {
+        with_allocator(evictable.allocator(), [&] {
+            allocs.clear();
+        });
+    });
+    with_allocator(evictable.allocator(), [&] {
+        for (int i = 0; i < 64 * 128; ++i) {
+            allocs.emplace_back(managed_bytes::initialized_later(), 1000);
+        }
+    });
+    size_t evictions = 0;
+    evictable.make_evictable([&] () -> memory::reclaiming_result {
+        if (allocs.empty()) {
+            return memory::reclaiming_result::reclaimed_nothing;
+        }
+        with_allocator(evictable.allocator(), [&] {
+            allocs.pop_back();
+        });
+        ++evictions;
+        return memory::reclaiming_result::reclaimed_something;
+    });
+    shard_tracker().reclaim_all_free_segments();
+
+    auto step = [&] (std::chrono::steady_clock::duration budget) {
+        thread::yield(); // Start with a fresh task quota
+        evictions = 0;
+        auto released = shard_tracker().reclaim_step(64 << 20, std::chrono::steady_clock::now() + budget);
+        return std::make_pair(released, evictions);
+    };
+
+    // Past its deadline, a step releases at most one free segment and evicts nothing
+    auto [released, evicted] = step(0s);
+    BOOST_REQUIRE_LE(released, segment_size);
+    BOOST_REQUIRE_EQUAL(evicted, 0);
+
+    // Otherwise it runs until the task quota ends
+    std::tie(released, evicted) = step(1h);
+    BOOST_REQUIRE_GT(evicted, 0);
+}
+
 inline
 bool is_aligned(void* ptr, size_t alignment) {
     return uintptr_t(ptr) % alignment == 0;
@@ -2980,3 +2980,34 @@ SEASTAR_THREAD_TEST_CASE(test_compactor_range_tombstone_spanning_many_pages) {
         BOOST_REQUIRE_EQUAL(res_mut, ref_mut);
     }
 }
+
+SEASTAR_THREAD_TEST_CASE(test_apply_appends_rows_after_last_row) {
+    simple_schema s;
+    auto pk = s.make_pkey();
+    mutation_application_stats app_stats;
+
+    mutation m(s.schema(), pk);
+    mutation expected(s.schema(), pk);
+    auto apply = [&] (std::initializer_list<uint32_t> cks) {
+        mutation m2(s.schema(), pk);
+        for (auto ck : cks) {
+            s.add_row(m2, s.make_ckey(ck), "v");
+        }
+        expected.apply(m2);
+        m.partition().apply(*s.schema(), m2.partition(), *s.schema(), app_stats);
+    };
+
+    apply({1});
+    BOOST_REQUIRE_EQUAL(app_stats.rows_appended, 0);
+    apply({2, 3});
+    BOOST_REQUIRE_EQUAL(app_stats.rows_appended, 2);
+    apply({3, 4});
+    BOOST_REQUIRE_EQUAL(app_stats.rows_appended, 2);
+    apply({0, 5});
+    BOOST_REQUIRE_EQUAL(app_stats.rows_appended, 2);
+    apply({6});
+    BOOST_REQUIRE_EQUAL(app_stats.rows_appended, 3);
+
+    BOOST_REQUIRE_EQUAL(app_stats.row_writes, 8);
+    assert_that(m).is_equal_to(expected);
+}
@@ -21,11 +21,13 @@
 #include "mutation_writer/multishard_writer.hh"
 #include "mutation_writer/timestamp_based_splitting_writer.hh"
 #include "mutation_writer/partition_based_splitting_writer.hh"
+#include "mutation_writer/token_group_based_splitting_writer.hh"
 #include "test/lib/cql_test_env.hh"
 #include "test/lib/flat_mutation_reader_assertions.hh"
 #include "test/lib/mutation_assertions.hh"
 #include "test/lib/random_utils.hh"
 #include "test/lib/random_schema.hh"
+#include "test/lib/simple_schema.hh"
 #include "test/lib/log.hh"
 
 #include <boost/range/adaptor/map.hpp>
@@ -523,3 +525,134 @@ SEASTAR_THREAD_TEST_CASE(test_partition_based_splitting_mutation_writer) {
     }
 
 }
+
+SEASTAR_THREAD_TEST_CASE(test_token_group_based_splitting_mutation_writer) {
+    tests::reader_concurrency_semaphore_wrapper semaphore;
+    auto random_spec = tests::make_random_schema_specification(
+            get_name(),
+            std::uniform_int_distribution<size_t>(1, 2),
+            std::uniform_int_distribution<size_t>(0, 2),
+            std::uniform_int_distribution<size_t>(1, 2),
+            std::uniform_int_distribution<size_t>(0, 1));
+
+    auto random_schema = tests::random_schema{tests::random::get_int<uint32_t>(), *random_spec};
+
+    const auto input_mutations = tests::generate_random_mutations(
+            random_schema,
+            tests::default_timestamp_generator(),
+            tests::no_expiry_expiry_generator(),
+            std::uniform_int_distribution<size_t>(100, 1000), // partitions
+            std::uniform_int_distribution<size_t>(1, 4), // rows
+            std::uniform_int_distribution<size_t>(0, 1)).get(); // range tombstones
+
+    testlog.info("input_mutations.size()={}", input_mutations.size());
+
+    // The number of groups of a shard doesn't depend on the ignored msb bits, whether
+    // there are more groups than round trips around the shards or not.
+    for (auto ignore_msb : {2U, 12U}) {
+        const auto sharder = dht::sharder(3, ignore_msb);
+        const unsigned ranges_per_shard = 16;
+        testlog.info("ignore_msb={}", ignore_msb);
+        auto group_of = [&] (const mutation& m) {
+            return dht::token_group_of(sharder.shard_count(), sharder.sharding_ignore_msb(), ranges_per_shard, m.token());
+        };
+
+        for (unsigned shard = 0; shard < sharder.shard_count(); ++shard) {
+            std::vector<mutation> shard_mutations;
+            for (const auto& mut : input_mutations) {
+                if (sharder.shard_of(mut.token()) == shard) {
+                    shard_mutations.push_back(mut);
+                }
+            }
+
+            std::vector<std::vector<mutation>> output_mutations;
+            auto consumer = [&] (flat_mutation_reader_v2 rd) {
+                output_mutations.emplace_back();
+                return async([&, index = output_mutations.size() - 1, rd = std::move(rd)] () mutable {
+                    auto close_rd = deferred_close(rd);
+                    while (auto mut_opt = read_mutation_from_flat_mutation_reader(rd).get0()) {
+                        output_mutations[index].emplace_back(std::move(*mut_opt));
+                    }
+                });
+            };
+
+            mutation_writer::make_token_range_aligning_consumer(sharder, ranges_per_shard, std::move(consumer))(
+                    make_flat_mutation_reader_from_mutations_v2(random_schema.schema(), semaphore.make_permit(), shard_mutations)).get();
+
+            std::map<uint64_t, std::vector<mutation>> groups;
+            for (const auto& mut : shard_mutations) {
+                groups[group_of(mut)].push_back(mut);
+            }
+            BOOST_REQUIRE_EQUAL(output_mutations.size(), groups.size());
+            BOOST_REQUIRE_LE(output_mutations.size(), ranges_per_shard);
+
+            // Every output holds the partitions of one group, in the order of the input.
+            for (const auto& muts : output_mutations) {
+                BOOST_REQUIRE(!muts.empty());
+                const auto group = group_of(muts.front());
+                BOOST_REQUIRE_EQUAL(group / ranges_per_shard, shard);
+                auto& expected = groups.at(group);
+                BOOST_REQUIRE_EQUAL(muts.size(), expected.size());
+                for (size_t i = 0; i < muts.size(); ++i) {
+                    assert_that(muts[i]).is_equal_to(expected[i]);
+                }
+            }
+        }
+    }
+}
+
+SEASTAR_THREAD_TEST_CASE(test_token_groups_survive_shard_count_change) {
+    tests::reader_concurrency_semaphore_wrapper semaphore;
+    simple_schema ss;
+    auto s = ss.schema();
+
+    const unsigned ranges_per_shard = 8;
+    for (auto ignore_msb : {0U, 12U}) {
+        for (auto [old_shards, new_shards] : {std::pair(3U, 4U), std::pair(4U, 3U), std::pair(6U, 13U)}) {
+            const auto old_sharder = dht::sharder(old_shards, ignore_msb);
+            const auto new_sharder = dht::sharder(new_shards, ignore_msb);
+            testlog.info("ignore_msb={} shards: {} -> {}", ignore_msb, old_shards, new_shards);
+
+            std::vector<dht::decorated_key> keys;
+            for (uint32_t i = 0; i < 2000; ++i) {
+                keys.push_back(ss.make_pkey(i));
+            }
+            std::ranges::sort(keys, dht::decorated_key::less_comparator(s));
+            std::vector<std::vector<mutation>> per_shard(old_shards);
+            for (auto& dk : keys) {
+                auto m = mutation(s, dk);
+                ss.add_row(m, ss.make_ckey(0), "v");
+                per_shard[old_sharder.shard_of(dk.token())].push_back(std::move(m));
+            }
+
+            // The sstables each shard writes before the shard count changes.
+            std::vector<std::vector<mutation>> sstables;
+            auto consumer = [&] (flat_mutation_reader_v2 rd) {
+                sstables.emplace_back();
+                return async([&, index = sstables.size() - 1, rd = std::move(rd)] () mutable {
+                    auto close_rd = deferred_close(rd);
+                    while (auto mut_opt = read_mutation_from_flat_mutation_reader(rd).get0()) {
+                        sstables[index].emplace_back(std::move(*mut_opt));
+                    }
+                });
+            };
+            for (auto& muts : per_shard) {
+                mutation_writer::make_token_range_aligning_consumer(old_sharder, ranges_per_shard, consumer)(
+                        make_flat_mutation_reader_from_mutations_v2(s, semaphore.make_permit(), muts)).get();
+            }
+
+            size_t split = 0;
+            for (const auto& muts : sstables) {
+                std::set<unsigned> owners;
+                for (const auto& m : muts) {
+                    owners.insert(new_sharder.shard_of(m.token()));
+                }
+                split += owners.size() > 1;
+            }
+            testlog.info("{} of {} sstables span more than one shard", split, sstables.size());
+            // Every boundary between the new shards splits at most one group, in all round trips.
+            BOOST_REQUIRE_LE(split, new_shards - 1);
+            BOOST_REQUIRE_LT(split * 2, sstables.size());
+        }
+    }
+}
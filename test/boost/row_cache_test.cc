@@ -32,6 +32,7 @@
 #include "test/lib/log.hh"
 #include "test/lib/reader_concurrency_semaphore.hh"
 #include "test/lib/random_utils.hh"
+#include "test/lib/eventually.hh"
 
 #include <boost/range/algorithm/min_element.hpp>
 #include "readers/from_mutations_v2.hh"
@@ -158,6 +159,340 @@ SEASTAR_TEST_CASE(test_cache_works_after_clearing) {
     });
 }
 
+SEASTAR_TEST_CASE(test_cache_tinylfu_admission) {
+    return seastar::async([] {
+        auto s = make_schema();
+        tests::reader_concurrency_semaphore_wrapper semaphore;
+        auto m1 = make_new_mutation(s);
+        auto m2 = make_new_mutation(s);
+        auto m3 = make_new_mutation(s);
+        auto mt = make_lw_shared<replica::memtable>(s);
+        mt->apply(m1);
+        mt->apply(m2);
+        mt->apply(m3);
+
+        cache_tracker tracker;
+        tracker.set_admission_policy(cache_tracker::admission_policy::tinylfu);
+        row_cache cache(s, snapshot_source_from_snapshot(mt->as_data_source()), tracker);
+
+        auto read = [&] (const mutation& m) {
+            assert_that(cache.make_reader(s, semaphore.make_permit(), dht::partition_range::make_singular(m.decorated_key())))
+                .produces(m)
+                .produces_end_of_stream();
+        };
+
+        // Until the cache evicts, every partition read is inserted
+        read(m1);
+        BOOST_REQUIRE_EQUAL(tracker.get_stats().partitions, 1);
+        while (tracker.region().evict_some() == memory::reclaiming_result::reclaimed_something) ;
+        BOOST_REQUIRE_EQUAL(tracker.get_stats().partitions, 0);
+
+        // Then, partitions read once are not...
+        read(m2);
+        BOOST_REQUIRE_EQUAL(tracker.get_stats().partitions, 0);
+        BOOST_REQUIRE_EQUAL(tracker.get_stats().admission_rejects, 1);
+
+        // ...but partitions read before are.
+        read(m2);
+        BOOST_REQUIRE_EQUAL(tracker.get_stats().partitions, 1);
+        read(m1);
+        BOOST_REQUIRE_EQUAL(tracker.get_stats().partitions, 2);
+
+        // Scans leave out partitions read once, and still produce them.
+        std::vector<mutation> all{m1, m2, m3};
+        std::sort(all.begin(), all.end(), mutation_decorated_key_less_comparator());
+        assert_that(cache.make_reader(s, semaphore.make_permit(), query::full_partition_range))
+            .produces(all)
+            .produces_end_of_stream();
+        BOOST_REQUIRE_EQUAL(tracker.get_stats().partitions, 2);
+        BOOST_REQUIRE_EQUAL(tracker.get_stats().admission_rejects, 2);
+    });
+}
+
+SEASTAR_TEST_CASE(test_cache_table_quota_and_priority) {
+    return seastar::async([] {
+        auto make_table_schema = [] (sstring name, std::map<sstring, sstring> caching) {
+            return schema_builder("ks", name)
+                .with_column("pk", bytes_type, column_kind::partition_key)
+                .with_column("v", bytes_type, column_kind::regular_column)
+                .set_caching_options(caching_options::from_map(caching))
+                .build();
+        };
+        auto limited = make_table_schema("limited", {{"max_partitions", "2"}});
+        auto low = make_table_schema("low", {{"priority", "low"}});
+        auto high = make_table_schema("high", {{"priority", "high"}});
+        tests::reader_concurrency_semaphore_wrapper semaphore;
+
+        cache_tracker tracker;
+        tracker.set_admission_policy(cache_tracker::admission_policy::tinylfu);
+
+        struct test_table {
+            schema_ptr s;
+            std::vector<mutation> mutations;
+            lw_shared_ptr<replica::memtable> mt;
+            row_cache cache;
+
+            test_table(schema_ptr s, cache_tracker& tracker)
+                : s(s)
+                , mutations{make_new_mutation(s), make_new_mutation(s), make_new_mutation(s)}
+                , mt(make_lw_shared<replica::memtable>(s))
+                , cache(s, snapshot_source_from_snapshot(mt->as_data_source()), tracker)
+            {
+                for (auto& m : mutations) {
+                    mt->apply(m);
+                }
+            }
+        };
+        test_table t_limited(limited, tracker);
+        test_table t_low(low, tracker);
+        test_table t_high(high, tracker);
+
+        auto read = [&] (test_table& t, const mutation& m) {
+            assert_that(t.cache.make_reader(t.s, semaphore.make_permit(), dht::partition_range::make_singular(m.decorated_key())))
+                .produces(m)
+                .produces_end_of_stream();
+        };
+
+        // The quota applies regardless of eviction
+        for (auto& m : t_limited.mutations) {
+            read(t_limited, m);
+        }
+        BOOST_REQUIRE_EQUAL(t_limited.cache.get_table_stats().partitions, 2);
+        BOOST_REQUIRE_EQUAL(t_limited.cache.get_table_stats().quota_rejects, 1);
+
+        read(t_low, t_low.mutations[0]);
+        BOOST_REQUIRE_EQUAL(t_low.cache.get_table_stats().partitions, 1);
+        BOOST_REQUIRE_EQUAL(tracker.get_stats().partitions, 3);
+
+        while (tracker.region().evict_some() == memory::reclaiming_result::reclaimed_something) ;
+        BOOST_REQUIRE_EQUAL(t_limited.cache.get_table_stats().partitions, 0);
+        BOOST_REQUIRE_EQUAL(t_low.cache.get_table_stats().partitions, 0);
+
+        // While the cache evicts, low priority tables get nothing inserted,
+        // not even partitions read before, and high priority ones everything.
+        read(t_low, t_low.mutations[0]);
+        read(t_low, t_low.mutations[1]);
+        BOOST_REQUIRE_EQUAL(t_low.cache.get_table_stats().partitions, 0);
+        read(t_high, t_high.mutations[0]);
+        BOOST_REQUIRE_EQUAL(t_high.cache.get_table_stats().partitions, 1);
+        BOOST_REQUIRE_EQUAL(tracker.get_stats().admission_rejects, 2);
+
+        // Lowering the quota stops insertions by memtable flushes too
+        for (auto& m : t_limited.mutations) {
+            read(t_limited, m);
+            read(t_limited, m);
+        }
+        BOOST_REQUIRE_EQUAL(t_limited.cache.get_table_stats().partitions, 2);
+        t_limited.cache.set_schema(schema_builder(limited)
+                .set_caching_options(caching_options::from_map({{"max_partitions", "1"}}))
+                .build());
+        auto mt = make_lw_shared<replica::memtable>(limited);
+        auto fresh = make_new_mutation(limited);
+        mt->apply(fresh);
+        t_limited.cache.update(row_cache::external_updater([&] { t_limited.mt->apply(fresh); }), *mt).get();
+        BOOST_REQUIRE_EQUAL(t_limited.cache.get_table_stats().partitions, 2);
+
+        BOOST_REQUIRE_EQUAL(tracker.get_stats().partitions, 3);
+    });
+}
+
+SEASTAR_TEST_CASE(test_cache_remembers_absent_partitions) {
+    return seastar::async([] {
+        auto s = make_schema();
+        tests::reader_concurrency_semaphore_wrapper semaphore;
+        auto present = make_new_mutation(s);
+        auto absent1 = make_new_mutation(s);
+        auto absent2 = make_new_mutation(s);
+        auto mt = make_lw_shared<replica::memtable>(s);
+        mt->apply(present);
+
+        int underlying_reads = 0;
+        cache_tracker tracker;
+        tracker.set_admission_policy(cache_tracker::admission_policy::tinylfu);
+        tracker.set_max_absent_keys_memory(1 << 20);
+        row_cache cache(s, snapshot_source_from_snapshot(mutation_source([&] (
+                schema_ptr s,
+                reader_permit permit,
+                const dht::partition_range& range,
+                const query::partition_slice& slice,
+                const io_priority_class& pc,
+                tracing::trace_state_ptr trace,
+                streamed_mutation::forwarding fwd) {
+            return make_counting_reader(mt->as_data_source().make_reader_v2(s, std::move(permit), range, slice, pc, trace, fwd), underlying_reads);
+        })), tracker);
+
+        auto read_absent = [&] (const mutation& m) {
+            assert_that(cache.make_reader(s, semaphore.make_permit(), dht::partition_range::make_singular(m.decorated_key())))
+                .produces_end_of_stream();
+        };
+
+        // Make the admission policy reject partitions read once
+        verify_has(cache, present);
+        while (tracker.region().evict_some() == memory::reclaiming_result::reclaimed_something) ;
+
+        read_absent(absent1);
+        read_absent(absent2);
+        BOOST_REQUIRE_EQUAL(tracker.get_stats().partitions, 0);
+        BOOST_REQUIRE_EQUAL(cache.get_absent_keys().size(), 2);
+        auto reads = underlying_reads;
+
+        read_absent(absent1);
+        read_absent(absent2);
+        BOOST_REQUIRE_EQUAL(underlying_reads, reads);
+        BOOST_REQUIRE_EQUAL(tracker.get_stats().absent_partition_hits, 2);
+        BOOST_REQUIRE(cache.answers(absent2.decorated_key()));
+
+        // A write makes its key present, other keys stay absent
+        auto mt2 = make_lw_shared<replica::memtable>(s);
+        mt2->apply(absent1);
+        cache.update(row_cache::external_updater([&] { mt->apply(absent1); }), *mt2).get();
+        BOOST_REQUIRE_EQUAL(cache.get_absent_keys().size(), 1);
+        verify_has(cache, absent1);
+        reads = underlying_reads;
+        read_absent(absent2);
+        BOOST_REQUIRE_EQUAL(underlying_reads, reads);
+
+        // Invalidation forgets absent keys
+        cache.invalidate(row_cache::external_updater([] {}), query::full_partition_range).get();
+        BOOST_REQUIRE_EQUAL(cache.get_absent_keys().size(), 0);
+        BOOST_REQUIRE_EQUAL(tracker.absent_keys_memory(), 0);
+        BOOST_REQUIRE(!cache.answers(absent2.decorated_key()));
+        read_absent(absent2);
+        BOOST_REQUIRE_GT(underlying_reads, reads);
+        cache.invalidate(row_cache::external_updater([] {}), query::full_partition_range).get();
+
+        // The memory of the keys remembered by all caches of the tracker is
+        // bounded, the oldest key of any cache goes first
+        row_cache cache2(s, snapshot_source_from_snapshot(mt->as_data_source()), tracker);
+        auto other = make_new_mutation(s);
+        assert_that(cache2.make_reader(s, semaphore.make_permit(), dht::partition_range::make_singular(other.decorated_key())))
+            .produces_end_of_stream();
+        BOOST_REQUIRE_EQUAL(cache2.get_absent_keys().size(), 1);
+        auto key_memory = tracker.absent_keys_memory();
+        BOOST_REQUIRE_GT(key_memory, 0);
+
+        // Room for one key
+        auto max_memory = key_memory + key_memory / 2;
+        tracker.set_max_absent_keys_memory(max_memory);
+        read_absent(make_new_mutation(s));
+        BOOST_REQUIRE_EQUAL(cache.get_absent_keys().size(), 1);
+        BOOST_REQUIRE_EQUAL(cache2.get_absent_keys().size(), 0);
+        BOOST_REQUIRE_LE(tracker.absent_keys_memory(), max_memory);
+        read_absent(make_new_mutation(s));
+        BOOST_REQUIRE_EQUAL(cache.get_absent_keys().size(), 1);
+        BOOST_REQUIRE_LE(tracker.absent_keys_memory(), max_memory);
+    });
+}
+
+SEASTAR_TEST_CASE(test_cache_keeps_cold_partitions_compressed) {
+    return seastar::async([] {
+        auto s = make_schema();
+        tests::reader_concurrency_semaphore_wrapper semaphore;
+        auto filler = make_new_mutation(s);
+        auto p1 = make_new_mutation(s);
+        auto p2 = make_new_mutation(s);
+        auto mt = make_lw_shared<replica::memtable>(s);
+        mt->apply(filler);
+        mt->apply(p1);
+        mt->apply(p2);
+
+        int underlying_reads = 0;
+        cache_tracker tracker;
+        row_cache cache(s, snapshot_source_from_snapshot(mutation_source([&] (
+                schema_ptr s,
+                reader_permit permit,
+                const dht::partition_range& range,
+                const query::partition_slice& slice,
+                const io_priority_class& pc,
+                tracing::trace_state_ptr trace,
+                streamed_mutation::forwarding fwd) {
+            return make_counting_reader(mt->as_data_source().make_reader_v2(s, std::move(permit), range, slice, pc, trace, fwd), underlying_reads);
+        })), tracker);
+
+        auto read = [&] (const mutation& m) {
+            assert_that(cache.make_reader(s, semaphore.make_permit(), dht::partition_range::make_singular(m.decorated_key())))
+                .produces(m)
+                .produces_end_of_stream();
+        };
+
+        // Partitions are demoted only while the cache evicts
+        read(filler);
+        while (tracker.region().evict_some() == memory::reclaiming_result::reclaimed_something) ;
+        read(p1);
+        tracker.set_max_cold_tier_memory(1 << 20);
+
+        // The read only asks for a demotion, which is done in the background
+        auto rd = cache.make_reader(s, semaphore.make_permit(), dht::partition_range::make_singular(p2.decorated_key()));
+        BOOST_REQUIRE_EQUAL(tracker.get_stats().partition_demotions, 0);
+        assert_that(std::move(rd))
+            .produces(p2)
+            .produces_end_of_stream();
+        REQUIRE_EVENTUALLY_EQUAL(tracker.get_stats().partition_demotions, 1);
+        BOOST_REQUIRE(cache.get_cold_partitions().contains(p1.decorated_key()));
+        BOOST_REQUIRE_EQUAL(tracker.get_stats().partitions, 1);
+        BOOST_REQUIRE_GT(tracker.cold_tier_memory(), 0);
+
+        // Reading it again puts it back into cache without going to the source
+        auto reads = underlying_reads;
+        read(p1);
+        BOOST_REQUIRE_EQUAL(underlying_reads, reads);
+        BOOST_REQUIRE_EQUAL(tracker.get_stats().partition_promotions, 1);
+        BOOST_REQUIRE(!cache.get_cold_partitions().contains(p1.decorated_key()));
+        BOOST_REQUIRE_EQUAL(tracker.cold_tier_memory(), 0);
+        BOOST_REQUIRE_EQUAL(tracker.get_stats().partitions, 2);
+
+        // Updates erase the partitions they change
+        read(filler);
+        REQUIRE_EVENTUALLY_EQUAL(tracker.get_stats().partition_demotions, 2);
+        BOOST_REQUIRE(cache.get_cold_partitions().contains(p2.decorated_key()));
+        auto p2_update = make_new_mutation(s, p2.key());
+        auto mt2 = make_lw_shared<replica::memtable>(s);
+        mt2->apply(p2_update);
+        cache.update(row_cache::external_updater([&] { mt->apply(p2_update); }), *mt2).get();
+        BOOST_REQUIRE(!cache.get_cold_partitions().contains(p2.decorated_key()));
+        BOOST_REQUIRE_EQUAL(tracker.cold_tier_memory(), 0);
+        read(p2 + p2_update);
+    });
+}
+
+SEASTAR_TEST_CASE(test_cache_hot_keys) {
+    return seastar::async([] {
+        auto s = make_schema();
+        tests::reader_concurrency_semaphore_wrapper semaphore;
+        auto mt = make_lw_shared<replica::memtable>(s);
+        std::vector<mutation> mutations;
+        for (int i = 0; i < 300; ++i) {
+            mutations.push_back(make_new_mutation(s));
+            mt->apply(mutations.back());
+        }
+
+        cache_tracker tracker;
+        tracker.set_admission_policy(cache_tracker::admission_policy::tinylfu);
+        row_cache cache(s, snapshot_source_from_snapshot(mt->as_data_source()), tracker);
+
+        auto read = [&] (const mutation& m) {
+            assert_that(cache.make_reader(s, semaphore.make_permit(), dht::partition_range::make_singular(m.decorated_key())))
+                .produces(m)
+                .produces_end_of_stream();
+        };
+        for (auto& m : mutations) {
+            read(m);
+        }
+        for (int i = 0; i < 3; ++i) {
+            read(mutations[7]);
+        }
+        read(mutations[200]);
+
+        auto all = cache.hot_keys(0).get0();
+        BOOST_REQUIRE_EQUAL(all.size(), mutations.size());
+
+        auto hot = cache.hot_keys(2).get0();
+        BOOST_REQUIRE_EQUAL(hot.size(), 2);
+        BOOST_REQUIRE(hot[0].equal(*s, mutations[7].decorated_key()));
+        BOOST_REQUIRE(hot[1].equal(*s, mutations[200].decorated_key()));
+    });
+}
+
 class partition_counting_reader final : public delegating_reader_v2 {
     int& _counter;
     bool _count_fill_buffer = true;
@@ -1118,6 +1453,53 @@ SEASTAR_TEST_CASE(test_update) {
     });
 }
 
+// Cache update walks cache and memtable in lock-step, make sure it finds
+// the right entries when they interleave.
+SEASTAR_TEST_CASE(test_update_interleaved_with_cache) {
+    return seastar::async([] {
+        auto s = make_schema();
+        tests::reader_concurrency_semaphore_wrapper semaphore;
+        auto cache_mt = make_lw_shared<replica::memtable>(s);
+
+        cache_tracker tracker;
+        row_cache cache(s, snapshot_source_from_snapshot(cache_mt->as_data_source()), tracker, is_continuous::yes);
+
+        std::vector<mutation> mutations;
+        for (int i = 0; i < 1000; i++) {
+            mutations.push_back(make_new_mutation(s));
+        }
+        std::sort(mutations.begin(), mutations.end(), mutation_decorated_key_less_comparator());
+
+        // Runs of various lengths alternate between cache and memtable,
+        // and some partitions are in both.
+        auto mt = make_lw_shared<replica::memtable>(s);
+        std::vector<mutation> expected;
+        for (size_t i = 0; i < mutations.size(); i++) {
+            auto& m = mutations[i];
+            auto run = i % 23;
+            if (run < 7) {
+                cache.populate(m);
+                expected.push_back(m);
+            } else if (run < 19) {
+                mt->apply(m);
+                expected.push_back(m);
+            } else {
+                cache.populate(m);
+                auto m2 = make_new_mutation(s, m.key());
+                mt->apply(m2);
+                expected.push_back(m + m2);
+            }
+        }
+
+        cache.update(row_cache::external_updater([] {}), *mt).get();
+
+        assert_that(cache.make_reader(s, semaphore.make_permit(), query::full_partition_range))
+            .produces(expected)
+            .produces_end_of_stream();
+        BOOST_REQUIRE_EQUAL(tracker.get_stats().partitions, mutations.size());
+    });
+}
+
 #ifndef SEASTAR_DEFAULT_ALLOCATOR
 
 static inline
@@ -1818,6 +1818,196 @@ SEASTAR_TEST_CASE(test_zstd_compression) {
   });
 }
 
+SEASTAR_TEST_CASE(test_zstd_compression_with_dictionary) {
+  return test_env::do_with_async([] (test_env& env) {
+    auto s = schema_builder("test_ks", "test_table")
+        .with_column("pk", int32_type, column_kind::partition_key)
+        .with_column("ck", int32_type, column_kind::clustering_key)
+        .with_column("v", utf8_type)
+        .set_compressor_params(compression_parameters{std::map<sstring, sstring>{
+            {"sstable_compression", "org.apache.cassandra.io.compress.ZstdCompressor"},
+            {"chunk_length_in_kb", "4"},
+            {"dictionary_size_in_kb", "2"}}})
+        .build();
+
+    // Enough data for the dictionary to be trained on the first chunks
+    // and used for the remaining ones.
+    mutation m(s, partition_key::from_single_value(*s, int32_type->decompose(0)));
+    for (int i = 0; i < 8000; ++i) {
+        auto ck = clustering_key::from_single_value(*s, int32_type->decompose(i));
+        auto v = format("row {} of user {} in region {}, status {}", i, i % 97, i % 13 ? "eu-west" : "us-east", i % 3 ? "active" : "idle");
+        m.set_clustered_cell(ck, "v", data_value(v), 1);
+    }
+
+    tmpdir dir;
+    auto version = sstables::get_highest_sstable_version();
+    auto sst = make_sstable(env, s, dir.path().string(), {m}, env.manager().configure_writer(), version);
+    BOOST_REQUIRE(sst->has_component(component_type::CompressionDictionary));
+
+    auto reopened = env.reusable_sst(s, dir.path().string(), 1, version).get0();
+    BOOST_REQUIRE(!reopened->get_compression().dictionary.value.empty());
+    BOOST_REQUIRE_GT(reopened->get_compression().offsets.size(), 1);
+    assert_that(reopened->as_mutation_source().make_reader_v2(s, env.make_reader_permit()))
+        .produces(m)
+        .produces_end_of_stream();
+
+    // The next sstable of the table reuses the dictionary instead of training
+    // one on its own data.
+    mutation m2(s, partition_key::from_single_value(*s, int32_type->decompose(1)));
+    for (int i = 0; i < 8000; ++i) {
+        auto ck = clustering_key::from_single_value(*s, int32_type->decompose(i));
+        m2.set_clustered_cell(ck, "v", data_value(format("entry {} of shelf {}, {} items", i, i % 31, i % 7)), 1);
+    }
+    tmpdir dir2;
+    auto sst2 = make_sstable(env, s, dir2.path().string(), {m2}, env.manager().configure_writer(), version);
+    BOOST_REQUIRE(sst2->get_compression().dictionary.value == reopened->get_compression().dictionary.value);
+    auto reopened2 = env.reusable_sst(s, dir2.path().string(), 1, version).get0();
+    assert_that(reopened2->as_mutation_source().make_reader_v2(s, env.make_reader_permit()))
+        .produces(m2)
+        .produces_end_of_stream();
+  });
+}
+
+SEASTAR_TEST_CASE(test_decompressed_chunk_cache) {
+  return test_env::do_with_async([] (test_env& env) {
+    env.db_config().sstable_decompressed_chunk_cache.set(true);
+    simple_schema ss;
+    auto s = schema_builder(ss.schema())
+        .set_compressor_params(compression_parameters{std::map<sstring, sstring>{
+            {"sstable_compression", "org.apache.cassandra.io.compress.LZ4Compressor"},
+            {"chunk_length_in_kb", "16"}}})
+        .build();
+
+    std::vector<mutation> muts;
+    auto pkeys = ss.make_pkeys(4);
+    for (size_t p = 0; p < pkeys.size(); ++p) {
+        mutation m(s, pkeys[p]);
+        for (uint32_t i = 0; i < 500; ++i) {
+            m.set_clustered_cell(ss.make_ckey(i), "v", data_value(format("value {} of partition {}", i, p)), 1);
+        }
+        muts.push_back(std::move(m));
+    }
+
+    tmpdir dir;
+    auto version = sstables::get_highest_sstable_version();
+    auto cfg = env.manager().configure_writer();
+    cfg.promoted_index_block_size = 1024;
+    make_sstable(env, s, dir.path().string(), muts, cfg, version);
+    auto sst = env.reusable_sst(s, dir.path().string(), 1, version).get0();
+    BOOST_REQUIRE_GT(sst->get_compression().offsets.size(), 1);
+
+    // Scans don't go through the cache, so that they don't evict hotter pages.
+    auto rd = assert_that(sst->as_mutation_source().make_reader_v2(s, env.make_reader_permit()));
+    for (auto& m : muts) {
+        rd.produces(m);
+    }
+    rd.produces_end_of_stream();
+    BOOST_REQUIRE_EQUAL(sstables::test(sst).decompressed_cached_bytes(), 0);
+
+    // Neither do single-partition reads bypassing the cache.
+    {
+        auto pr = dht::partition_range::make_singular(muts.front().decorated_key());
+        auto slice = partition_slice_builder(*s).with_option<query::partition_slice::option::bypass_cache>().build();
+        assert_that(sst->as_mutation_source().make_reader_v2(s, env.make_reader_permit(), pr, slice))
+            .produces(muts.front())
+            .produces_end_of_stream();
+        BOOST_REQUIRE_EQUAL(sstables::test(sst).decompressed_cached_bytes(), 0);
+    }
+
+    // Read each partition twice, the second time from the cache, and slices
+    // starting in the middle of chunks.
+    for (int pass = 0; pass < 2; ++pass) {
+        for (auto& m : muts) {
+            auto pr = dht::partition_range::make_singular(m.decorated_key());
+            assert_that(sst->as_mutation_source().make_reader_v2(s, env.make_reader_permit(), pr, s->full_slice()))
+                .produces(m)
+                .produces_end_of_stream();
+        }
+    }
+    BOOST_REQUIRE_GT(sstables::test(sst).decompressed_cached_bytes(), 0);
+    for (auto& m : muts) {
+        auto pr = dht::partition_range::make_singular(m.decorated_key());
+        for (uint32_t start : {0, 77, 250, 499}) {
+            auto range = query::clustering_range::make_starting_with({ss.make_ckey(start)});
+            auto slice = partition_slice_builder(*s).with_range(range).build();
+            assert_that(sst->as_mutation_source().make_reader_v2(s, env.make_reader_permit(), pr, slice))
+                .produces(m.sliced({range}))
+                .produces_end_of_stream();
+        }
+    }
+  });
+}
+
+SEASTAR_TEST_CASE(test_read_bypassing_cache_skips_unselected_values) {
+  return test_env::do_with_async([] (test_env& env) {
+    auto s = schema_builder("test_ks", "test_table")
+        .with_column("pk", int32_type, column_kind::partition_key)
+        .with_column("ck", int32_type, column_kind::clustering_key)
+        .with_column("s1", utf8_type, column_kind::static_column)
+        .with_column("v1", utf8_type)
+        .with_column("v2", utf8_type)
+        .build();
+    auto& s1 = *s->get_column_definition("s1");
+    auto& v1 = *s->get_column_definition("v1");
+    auto& v2 = *s->get_column_definition("v2");
+    auto ck = [&] (int i) { return clustering_key::from_single_value(*s, int32_type->decompose(i)); };
+    auto live = [] (const column_definition& def, sstring v) {
+        return atomic_cell::make_live(*def.type, 1, def.type->decompose(data_value(v)));
+    };
+    auto dead = atomic_cell::make_dead(1, gc_clock::now());
+
+    auto pk = partition_key::from_single_value(*s, int32_type->decompose(0));
+    mutation m(s, pk);
+    m.set_static_cell(s1, live(s1, "static"));
+    m.set_clustered_cell(ck(1), v1, live(v1, "selected"));
+    m.set_clustered_cell(ck(1), v2, live(v2, "unselected"));
+    // Rows with only unselected cells have to stay alive, or dead
+    m.set_clustered_cell(ck(2), v2, live(v2, "unselected"));
+    m.set_clustered_cell(ck(3), v2, atomic_cell(*v2.type, dead));
+
+    mutation expected(s, pk);
+    expected.set_static_cell(s1, live(s1, ""));
+    expected.set_clustered_cell(ck(1), v1, live(v1, "selected"));
+    expected.set_clustered_cell(ck(1), v2, live(v2, ""));
+    expected.set_clustered_cell(ck(2), v2, live(v2, ""));
+    expected.set_clustered_cell(ck(3), v2, atomic_cell(*v2.type, dead));
+
+    tmpdir dir;
+    auto sst = make_sstable(env, s, dir.path().string(), {m}, env.manager().configure_writer(), sstables::get_highest_sstable_version());
+    auto pr = dht::partition_range::make_singular(m.decorated_key());
+
+    auto slice = partition_slice_builder(*s)
+        .with_no_static_columns()
+        .with_regular_column(to_bytes("v1"))
+        .with_option<query::partition_slice::option::bypass_cache>()
+        .with_option<query::partition_slice::option::skip_unselected_values>()
+        .build();
+    assert_that(sst->as_mutation_source().make_reader_v2(s, env.make_reader_permit(), pr, slice))
+        .produces(expected)
+        .produces_end_of_stream();
+
+    // Mutation queries, whose results may be reconciled and repaired, get all values
+    auto mutation_slice = partition_slice_builder(*s)
+        .with_no_static_columns()
+        .with_regular_column(to_bytes("v1"))
+        .with_option<query::partition_slice::option::bypass_cache>()
+        .build();
+    assert_that(sst->as_mutation_source().make_reader_v2(s, env.make_reader_permit(), pr, mutation_slice))
+        .produces(m)
+        .produces_end_of_stream();
+
+    // Reads which may populate the cache get all values
+    auto cached_slice = partition_slice_builder(*s)
+        .with_no_static_columns()
+        .with_regular_column(to_bytes("v1"))
+        .with_option<query::partition_slice::option::skip_unselected_values>()
+        .build();
+    assert_that(sst->as_mutation_source().make_reader_v2(s, env.make_reader_permit(), pr, cached_slice))
+        .produces(m)
+        .produces_end_of_stream();
+  });
+}
+
 // Following tests run on files in test/resource/sstables/3.x/uncompressed/subset_of_columns
 // They were created using following CQL statements:
 //
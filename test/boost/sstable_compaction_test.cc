@@ -1804,6 +1804,257 @@ SEASTAR_TEST_CASE(size_tiered_beyond_max_threshold_test) {
   });
 }
 
+SEASTAR_TEST_CASE(incremental_compaction_strategy_compacts_runs_test) {
+  return test_env::do_with_async([] (test_env& env) {
+    table_for_tests cf(env.manager());
+    auto cs = sstables::make_compaction_strategy(sstables::compaction_strategy_type::incremental, {{"sstable_size_in_mb", "10"}});
+    auto keys = token_generation_for_current_shard(6);
+    int max_threshold = cf->schema()->max_compaction_threshold();
+
+    int64_t gen = 1;
+    std::vector<sstables::shared_sstable> candidates;
+    // (max_threshold+1) runs of similar size, with three disjoint fragments each
+    for (auto i = 0; i < max_threshold + 1; i++) {
+        auto id = sstables::run_id::create_random_id();
+        for (auto f = 0; f < 3; f++) {
+            auto sst = env.make_sstable(cf.schema(), "", gen++, la, big);
+            sstables::test(sst).set_values(keys[2 * f].first, keys[2 * f + 1].first, {});
+            sstables::test(sst).set_run_identifier(id);
+            candidates.push_back(std::move(sst));
+        }
+    }
+
+    auto check_whole_runs = [] (const std::vector<sstables::shared_sstable>& sstables) {
+        std::unordered_map<sstables::run_id, unsigned> fragments;
+        for (auto& sst : sstables) {
+            ++fragments[sst->run_identifier()];
+        }
+        for (auto& [id, n] : fragments) {
+            BOOST_REQUIRE_EQUAL(n, 3);
+        }
+        return fragments.size();
+    };
+
+    auto strategy_c = make_strategy_control_for_test(false);
+    auto desc = cs.get_sstables_for_compaction(cf.as_table_state(), *strategy_c, candidates);
+    BOOST_REQUIRE_EQUAL(check_whole_runs(desc.sstables), size_t(max_threshold));
+    BOOST_REQUIRE_EQUAL(desc.max_sstable_bytes, 10 * 1024 * 1024);
+
+    auto jobs = cs.get_cleanup_compaction_jobs(cf.as_table_state(), candidates);
+    BOOST_REQUIRE_EQUAL(jobs.size(), size_t(max_threshold + 1));
+    for (auto& job : jobs) {
+        BOOST_REQUIRE_EQUAL(check_whole_runs(job.sstables), 1);
+    }
+
+    cf.stop_and_keep_alive().get();
+  });
+}
+
+SEASTAR_TEST_CASE(compaction_of_parallel_sub_ranges_test) {
+    return test_env::do_with_async([] (test_env& env) {
+        auto s = schema_builder(some_keyspace, "parallel_sub_ranges_test")
+                .with_column("id", utf8_type, column_kind::partition_key)
+                .with_column("value", int32_type).build();
+
+        auto tmp = tmpdir();
+        auto sst_gen = [&env, s, &tmp, gen = make_lw_shared<unsigned>(1)] () mutable {
+            return env.make_sstable(s, tmp.path().string(), (*gen)++, sstables::get_highest_sstable_version(), big);
+        };
+
+        auto make_insert = [&] (const sstring& key, int32_t value, api::timestamp_type ts) {
+            mutation m(s, partition_key::from_deeply_exploded(*s, { key }));
+            m.set_clustered_cell(clustering_key::make_empty(), bytes("value"), data_value(value), ts);
+            return m;
+        };
+
+        // Two overlapping sstables, the second overwriting every other partition of the first.
+        auto total_partitions = 1000U;
+        auto local_keys = make_local_keys(total_partitions, s);
+        std::vector<mutation> old_mutations;
+        std::vector<mutation> new_mutations;
+        std::vector<mutation> expected;
+        for (auto i = 0U; i < total_partitions; i++) {
+            old_mutations.push_back(make_insert(local_keys[i], 1, 0));
+            if (i % 2) {
+                new_mutations.push_back(make_insert(local_keys[i], 2, 1));
+            }
+            expected.push_back(i % 2 ? new_mutations.back() : old_mutations.back());
+        }
+        std::sort(expected.begin(), expected.end(), [&] (const mutation& a, const mutation& b) {
+            return a.decorated_key().less_compare(*s, b.decorated_key());
+        });
+        std::vector<shared_sstable> ssts = {
+            make_sstable_containing(sst_gen, std::move(old_mutations)),
+            make_sstable_containing(sst_gen, std::move(new_mutations)),
+        };
+
+        table_for_tests cf(env.manager(), s, tmp.path().string());
+        auto close_cf = deferred_stop(cf);
+
+        auto desc = sstables::compaction_descriptor(ssts, default_priority_class());
+        desc.sub_ranges = 4;
+        auto ret = compact_sstables(std::move(desc), cf, sst_gen).get0();
+
+        // Every sub-range is written to its own output, and the outputs form a single run.
+        BOOST_REQUIRE_EQUAL(ret.new_sstables.size(), 4);
+        auto run_identifier = ret.new_sstables.front()->run_identifier();
+        std::vector<flat_mutation_reader_v2> readers;
+        for (auto& sst : ret.new_sstables) {
+            BOOST_REQUIRE(sst->run_identifier() == run_identifier);
+            readers.push_back(sstable_reader(sst, s, env.make_reader_permit()));
+        }
+        auto rd = assert_that(make_combined_reader(s, env.make_reader_permit(), std::move(readers)));
+        for (auto& m : expected) {
+            rd.produces(m);
+        }
+        rd.produces_end_of_stream();
+
+        // A job of a run-based strategy releases exhausted fragments of its input
+        // runs early, which requires writing in token order, so it isn't split.
+        std::vector<mutation> first_half(expected.begin(), expected.begin() + total_partitions / 2);
+        std::vector<mutation> second_half(expected.begin() + total_partitions / 2, expected.end());
+        auto input_run_identifier = sstables::run_id::create_random_id();
+        std::vector<shared_sstable> run = {
+            make_sstable_containing(sst_gen, std::move(first_half)),
+            make_sstable_containing(sst_gen, std::move(second_half)),
+        };
+        for (auto& sst : run) {
+            sstables::test(sst).set_run_identifier(input_run_identifier);
+        }
+        auto run_desc = sstables::compaction_descriptor(run, default_priority_class(), 0, 1024*1024*1024);
+        run_desc.sub_ranges = 4;
+        auto run_ret = compact_sstables(std::move(run_desc), cf, sst_gen).get0();
+        BOOST_REQUIRE_EQUAL(run_ret.new_sstables.size(), 1);
+    });
+}
+
+SEASTAR_TEST_CASE(tombstone_gc_compaction_jobs_test) {
+    return test_env::do_with_async([] (test_env& env) {
+        auto builder = schema_builder(some_keyspace, "tombstone_gc_compaction_jobs_test")
+                .with_column("id", utf8_type, column_kind::partition_key)
+                .with_column("value", int32_type);
+        builder.set_gc_grace_seconds(0);
+        auto s = builder.build();
+
+        auto tmp = tmpdir();
+        auto sst_gen = [&env, s, &tmp, gen = make_lw_shared<unsigned>(1)] () mutable {
+            return env.make_sstable(s, tmp.path().string(), (*gen)++, sstables::get_highest_sstable_version(), big);
+        };
+
+        auto make_insert = [&] (const sstring& key, api::timestamp_type ts) {
+            mutation m(s, partition_key::from_exploded(*s, {to_bytes(key)}));
+            m.set_clustered_cell(clustering_key::make_empty(), bytes("value"), data_value(int32_t(1)), ts);
+            return m;
+        };
+        auto make_delete = [&] (const sstring& key, api::timestamp_type ts) {
+            mutation m(s, partition_key::from_exploded(*s, {to_bytes(key)}));
+            m.partition().apply(tombstone(ts, gc_clock::now() - std::chrono::seconds(3600)));
+            return m;
+        };
+
+        auto keys = make_local_keys(4, s);
+        std::vector<mutation> old_data, deletions, new_data;
+        for (auto i = 0; i < 3; i++) {
+            old_data.push_back(make_insert(keys[i], 1));
+            deletions.push_back(make_delete(keys[i], 2));
+        }
+        new_data.push_back(make_insert(keys[3], 10));
+        auto old_sst = make_sstable_containing(sst_gen, std::move(old_data));
+        auto tombstone_sst = make_sstable_containing(sst_gen, std::move(deletions));
+        // Newer than every tombstone, so it doesn't hold data they shadow.
+        auto new_sst = make_sstable_containing(sst_gen, std::move(new_data));
+
+        table_for_tests cf(env.manager(), s, tmp.path().string());
+        auto close_cf = deferred_stop(cf);
+        for (auto& sst : {old_sst, tombstone_sst, new_sst}) {
+            column_family_test(cf).add_sstable(sst).get();
+        }
+
+        auto jobs = cf.as_table_state().get_compaction_strategy().get_tombstone_gc_compaction_jobs(cf.as_table_state(), {old_sst, tombstone_sst, new_sst});
+        BOOST_REQUIRE_EQUAL(jobs.size(), 1);
+        auto& job = jobs.front();
+        BOOST_REQUIRE_EQUAL(job.sstables.size(), 2);
+        BOOST_REQUIRE(job.sstables[0] == tombstone_sst);
+        BOOST_REQUIRE(job.sstables[1] == old_sst);
+
+        // Both the tombstones and the data they shadow are purged.
+        auto ret = compact_sstables(std::move(job), cf, sst_gen).get0();
+        BOOST_REQUIRE(ret.new_sstables.empty());
+    });
+}
+
+SEASTAR_TEST_CASE(leveled_tombstone_gc_compaction_jobs_test) {
+    return test_env::do_with_async([] (test_env& env) {
+        auto builder = schema_builder(some_keyspace, "leveled_tombstone_gc_compaction_jobs_test")
+                .with_column("id", utf8_type, column_kind::partition_key)
+                .with_column("value", int32_type);
+        builder.set_gc_grace_seconds(0);
+        builder.set_compaction_strategy(sstables::compaction_strategy_type::leveled);
+        auto s = builder.build();
+
+        auto tmp = tmpdir();
+        auto sst_gen = [&env, s, &tmp, gen = make_lw_shared<unsigned>(1)] () mutable {
+            return env.make_sstable(s, tmp.path().string(), (*gen)++, sstables::get_highest_sstable_version(), big);
+        };
+
+        auto make_insert = [&] (const sstring& key, api::timestamp_type ts) {
+            mutation m(s, partition_key::from_exploded(*s, {to_bytes(key)}));
+            m.set_clustered_cell(clustering_key::make_empty(), bytes("value"), data_value(int32_t(1)), ts);
+            return m;
+        };
+        auto make_delete = [&] (const sstring& key, api::timestamp_type ts) {
+            mutation m(s, partition_key::from_exploded(*s, {to_bytes(key)}));
+            m.partition().apply(tombstone(ts, gc_clock::now() - std::chrono::seconds(3600)));
+            return m;
+        };
+
+        // Level 2 holds old data of all keys. Level 1 holds the deletions of the
+        // first half of the keys, and new data of the second half.
+        auto keys = make_local_keys(4, s);
+        std::vector<mutation> old_data, deletions, new_data;
+        for (auto i = 0; i < 4; i++) {
+            old_data.push_back(make_insert(keys[i], 1));
+        }
+        deletions.push_back(make_delete(keys[0], 2));
+        deletions.push_back(make_delete(keys[1], 2));
+        new_data.push_back(make_insert(keys[2], 10));
+        new_data.push_back(make_insert(keys[3], 10));
+        auto old_sst = make_sstable_containing(sst_gen, std::move(old_data));
+        auto tombstone_sst = make_sstable_containing(sst_gen, std::move(deletions));
+        auto new_sst = make_sstable_containing(sst_gen, std::move(new_data));
+        old_sst->set_sstable_level(2);
+        tombstone_sst->set_sstable_level(1);
+        new_sst->set_sstable_level(1);
+
+        table_for_tests cf(env.manager(), s, tmp.path().string());
+        auto close_cf = deferred_stop(cf);
+        std::vector<shared_sstable> all = {old_sst, tombstone_sst, new_sst};
+        for (auto& sst : all) {
+            column_family_test(cf).add_sstable(sst).get();
+        }
+
+        auto overlaps = [&s] (const shared_sstable& a, const shared_sstable& b) {
+            return a->get_first_decorated_key().tri_compare(*s, b->get_last_decorated_key()) <= 0
+                && b->get_first_decorated_key().tri_compare(*s, a->get_last_decorated_key()) <= 0;
+        };
+
+        auto jobs = cf.as_table_state().get_compaction_strategy().get_tombstone_gc_compaction_jobs(cf.as_table_state(), all);
+        BOOST_REQUIRE_EQUAL(jobs.size(), 1);
+        auto& job = jobs.front();
+        // Rewriting the overlapping sstable of level 2 along with it would produce
+        // output overlapping the rest of the level it goes to.
+        BOOST_REQUIRE_EQUAL(job.sstables.size(), 1);
+        BOOST_REQUIRE(job.sstables[0] == tombstone_sst);
+        BOOST_REQUIRE_EQUAL(job.level, 1);
+
+        auto ret = compact_sstables(std::move(job), cf, sst_gen).get0();
+        for (auto& sst : ret.new_sstables) {
+            BOOST_REQUIRE_EQUAL(sst->get_sstable_level(), 1);
+            BOOST_REQUIRE(!overlaps(sst, new_sst));
+        }
+    });
+}
+
 SEASTAR_TEST_CASE(sstable_expired_data_ratio) {
     return test_env::do_with_async([] (test_env& env) {
         auto tmp = tmpdir();
@@ -4746,6 +4997,47 @@ SEASTAR_TEST_CASE(simple_backlog_controller_test) {
     });
 }
 
+SEASTAR_THREAD_TEST_CASE(compaction_controller_read_latency_target_test) {
+    auto target = std::chrono::milliseconds(10);
+    auto load = compaction_controller::foreground_load{ .read_latency = std::chrono::milliseconds(100) };
+    // The timer never fires during the test, adjustments are made by hand.
+    compaction_controller controller({}, 0, std::chrono::hours(1), [] { return 1.5f; }, [&target] { return target; });
+    controller.set_foreground_load_probe([&load] { return load; });
+    auto adjust = [&controller] (unsigned times) {
+        for (unsigned i = 0; i < times; ++i) {
+            controller.adjust_now();
+        }
+    };
+
+    // Missing the target backs off, down to the minimum factor.
+    adjust(1);
+    BOOST_REQUIRE_CLOSE(controller.latency_factor(), 0.7f, 0.01);
+    adjust(20);
+    BOOST_REQUIRE_CLOSE(controller.latency_factor(), 0.05f, 0.01);
+
+    // Meeting the target doesn't recover the factor while reads queue up.
+    load.read_latency = std::chrono::milliseconds(1);
+    load.queued_reads = 1;
+    adjust(1);
+    BOOST_REQUIRE_CLOSE(controller.latency_factor(), 0.05f, 0.01);
+
+    // Otherwise it recovers it additively.
+    adjust(1);
+    BOOST_REQUIRE_CLOSE(controller.latency_factor(), 0.1f, 0.01);
+    adjust(20);
+    BOOST_REQUIRE_EQUAL(controller.latency_factor(), 1.0f);
+
+    // Without a target, the shares follow the backlog alone.
+    load.read_latency = std::chrono::milliseconds(100);
+    adjust(1);
+    BOOST_REQUIRE_LT(controller.latency_factor(), 1.0f);
+    target = std::chrono::milliseconds(0);
+    adjust(1);
+    BOOST_REQUIRE_EQUAL(controller.latency_factor(), 1.0f);
+
+    controller.shutdown().get();
+}
+
 SEASTAR_TEST_CASE(test_compaction_strategy_cleanup_method) {
     return test_env::do_with_async([] (test_env& env) {
         constexpr size_t all_files = 64;
@@ -84,10 +84,13 @@ void test_cache_population_with_range_tombstone_adjacent_to_population_range(pop
             .produces_end_of_stream();
 }
 
-static future<> test_sstable_conforms_to_mutation_source(sstable_version_types version, int index_block_size) {
-    return sstables::test_env::do_with_async([version, index_block_size] (sstables::test_env& env) {
+static future<> test_sstable_conforms_to_mutation_source(sstable_version_types version, int index_block_size, bool partition_trie = false,
+        bool row_trie = false) {
+    return sstables::test_env::do_with_async([version, index_block_size, partition_trie, row_trie] (sstables::test_env& env) {
         sstable_writer_config cfg = env.manager().configure_writer();
         cfg.promoted_index_block_size = index_block_size;
+        cfg.partition_trie_index = partition_trie;
+        cfg.row_trie_index = row_trie;
 
         std::vector<tmpdir> dirs;
         auto populate = [&env, &dirs, &cfg, version] (schema_ptr s, const std::vector<mutation>& partitions,
@@ -133,6 +136,14 @@ SEASTAR_TEST_CASE(test_sstable_conforms_to_mutation_source_md_large) {
     return test_sstable_conforms_to_mutation_source(writable_sstable_versions[1], block_sizes[2]);
 }
 
+SEASTAR_TEST_CASE(test_sstable_conforms_to_mutation_source_with_partition_trie) {
+    return test_sstable_conforms_to_mutation_source(writable_sstable_versions.back(), block_sizes[1], true);
+}
+
+SEASTAR_TEST_CASE(test_sstable_conforms_to_mutation_source_with_row_trie) {
+    return test_sstable_conforms_to_mutation_source(writable_sstable_versions.back(), block_sizes[0], false, true);
+}
+
 // This assert makes sure we don't miss writable vertions
 static_assert(writable_sstable_versions.size() == 3);
 
@@ -11,6 +11,8 @@
 #include <seastar/core/align.hh>
 #include <seastar/core/aligned_buffer.hh>
 #include <seastar/util/closeable.hh>
+#include <seastar/util/file.hh>
+#include <seastar/core/byteorder.hh>
 
 #include "sstables/sstables.hh"
 #include "sstables/key.hh"
@@ -2399,6 +2401,55 @@ SEASTAR_TEST_CASE(test_summary_entry_spanning_more_keys_than_min_interval) {
     });
 }
 
+static future<> test_sstable_filter_type(db::sstable_filter_type type, filter_layout layout) {
+    return test_env::do_with_async([type, layout] (test_env& env) {
+        db::sstable_filter_options filter_opts;
+        filter_opts.set_type(type);
+        auto s = schema_builder(some_keyspace, some_column_family)
+                .with_column("p1", int32_type, column_kind::partition_key)
+                .with_column("r1", int32_type)
+                .with_sstable_filter_options(filter_opts)
+                .build();
+
+        const column_definition& r1_col = *s->get_column_definition("r1");
+        std::vector<mutation> mutations;
+        for (auto i = 0; i < 1000; i++) {
+            auto key = partition_key::from_exploded(*s, {int32_type->decompose(i)});
+            mutation m(s, key);
+            m.set_clustered_cell(clustering_key::make_empty(), r1_col, make_atomic_cell(int32_type, int32_type->decompose(1)));
+            mutations.push_back(std::move(m));
+        }
+        boost::sort(mutations, mutation_decorated_key_less_comparator());
+
+        auto tmp = tmpdir();
+        auto sst_gen = [&env, s, &tmp, gen = make_lw_shared<unsigned>(1)] () mutable {
+            return env.make_sstable(s, tmp.path().string(), (*gen)++, sstables::get_highest_sstable_version(), big);
+        };
+        auto sst = make_sstable_containing(sst_gen, mutations);
+        sst = env.reusable_sst(s, tmp.path().string(), generation_value(sst->generation())).get0();
+
+        BOOST_REQUIRE(sst->get_scylla_metadata()->get_filter_layout() == layout);
+        // Readers ignoring the layout must see a bloom filter with no hashes, which never misses a key.
+        auto filter_file = seastar::util::read_entire_file_contiguous(fs::path(sst->filename(component_type::Filter))).get0();
+        BOOST_REQUIRE_GE(filter_file.size(), sizeof(uint32_t));
+        BOOST_REQUIRE_EQUAL(read_be<uint32_t>(filter_file.data()), 0);
+        for (auto& m : mutations) {
+            BOOST_REQUIRE(sst->filter_has_key(*s, m.key()));
+        }
+        assert_that(sst->as_mutation_source().make_reader_v2(s, env.make_reader_permit(), query::full_partition_range))
+            .produces(mutations)
+            .produces_end_of_stream();
+    });
+}
+
+SEASTAR_TEST_CASE(test_split_block_bloom_filter) {
+    return test_sstable_filter_type(db::sstable_filter_type::split_block_bloom, filter_layout::split_block_bloom);
+}
+
+SEASTAR_TEST_CASE(test_xor_filter) {
+    return test_sstable_filter_type(db::sstable_filter_type::xor_filter, filter_layout::xor_filter);
+}
+
 SEASTAR_TEST_CASE(test_wrong_counter_shard_order) {
         // CREATE TABLE IF NOT EXISTS scylla_bench.test_counters (
         //     pk bigint,
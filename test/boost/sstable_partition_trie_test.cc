@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2022-present ScyllaDB
+ */
+
+/*
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <seastar/testing/test_case.hh>
+#include <seastar/testing/thread_test_case.hh>
+#include <seastar/util/closeable.hh>
+
+#include "sstables/partition_trie.hh"
+#include "sstables/index_reader.hh"
+#include "sstables/writer.hh"
+#include "test/boost/sstable_test.hh"
+#include "test/lib/flat_mutation_reader_assertions.hh"
+#include "test/lib/reader_concurrency_semaphore.hh"
+#include "test/lib/simple_schema.hh"
+#include "test/lib/sstable_utils.hh"
+#include "test/lib/random_utils.hh"
+#include "test/lib/tmpdir.hh"
+#include "test/lib/log.hh"
+#include "types.hh"
+
+using namespace sstables;
+
+static lru trie_lru;
+
+static bool unsigned_less(const bytes& a, const bytes& b) {
+    return compare_unsigned(a, b) < 0;
+}
+
+// Writes keys to a partition trie, with key i at index offset i * entry_size,
+// and checks that lookups of random keys find their lower bound.
+static void test_partition_trie_with(std::vector<bytes> keys, const std::vector<bytes>& queries) {
+    static constexpr uint64_t entry_size = 10;
+    std::sort(keys.begin(), keys.end(), unsigned_less);
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    testlog.debug("{} keys, {} queries", keys.size(), queries.size());
+
+    tmpdir dir;
+    auto path = (dir.path() / "Partitions.db").native();
+    {
+        auto f = open_file_dma(path, open_flags::create | open_flags::wo).get0();
+        auto out = file_writer::make(std::move(f), file_output_stream_options(), path).get0();
+        partition_trie_writer trie(out);
+        for (size_t i = 0; i < keys.size(); ++i) {
+            trie.add(keys[i], i * entry_size);
+        }
+        trie.finish(keys.size() * entry_size);
+        out.close();
+    }
+
+    auto f = open_file_dma(path, open_flags::ro).get0();
+    auto close_f = deferred_close(f);
+    auto size = f.size().get0();
+    auto root = read_partition_trie_root(f, size, default_priority_class()).get0();
+    tests::reader_concurrency_semaphore_wrapper semaphore;
+    cached_file::metrics metrics;
+    logalloc::region region;
+    cached_file cf(f, metrics, trie_lru, region, size);
+    trie_reader trie(cf, root, default_priority_class(), semaphore.make_permit(), {});
+
+    for (auto& q : queries) {
+        auto expected = std::lower_bound(keys.begin(), keys.end(), q, unsigned_less) - keys.begin();
+        auto entry = trie.floor(q).get0();
+        size_t found = 0;
+        if (entry) {
+            auto i = entry->value / entry_size;
+            BOOST_REQUIRE_EQUAL(entry->value, i * entry_size);
+            BOOST_REQUIRE_LT(i, keys.size());
+            BOOST_REQUIRE_EQUAL(entry->length, (std::min(i + 2, keys.size()) - i) * entry_size);
+            found = compare_unsigned(q, keys[i]) <= 0 ? i : i + 1;
+        }
+        BOOST_REQUIRE_EQUAL(found, expected);
+    }
+}
+
+static bytes random_key(size_t max_length, const std::vector<int8_t>& alphabet) {
+    auto len = tests::random::get_int<size_t>(0, max_length);
+    bytes b(bytes::initialized_later(), len);
+    for (auto& c : b) {
+        c = alphabet[tests::random::get_int<size_t>(0, alphabet.size() - 1)];
+    }
+    return b;
+}
+
+SEASTAR_THREAD_TEST_CASE(test_partition_trie_lookups) {
+    // A small alphabet gives keys which are prefixes of each other
+    std::vector<int8_t> small_alphabet = { 0, 1, 0x7f, int8_t(0x80), int8_t(0xff) };
+    std::vector<int8_t> full_alphabet;
+    for (int c = -128; c < 128; ++c) {
+        full_alphabet.push_back(c);
+    }
+
+    test_partition_trie_with({to_bytes("a")}, {to_bytes(""), to_bytes("a"), to_bytes("aa"), to_bytes("b")});
+
+    for (auto [nr_keys, max_length, alphabet] : {
+            std::tuple(10, 3, &small_alphabet),
+            std::tuple(1000, 8, &small_alphabet),
+            std::tuple(50000, 12, &full_alphabet)}) {
+        std::vector<bytes> keys;
+        std::vector<bytes> queries;
+        for (int i = 0; i < nr_keys; ++i) {
+            keys.push_back(random_key(max_length, *alphabet));
+            queries.push_back(random_key(max_length, *alphabet));
+        }
+        // Also look up the keys themselves and their neighbours
+        for (int i = 0; i < 1000 && i < nr_keys; ++i) {
+            auto& k = keys[tests::random::get_int<size_t>(0, keys.size() - 1)];
+            queries.push_back(k);
+            queries.push_back(k + bytes(1, int8_t(0)));
+            if (!k.empty()) {
+                queries.push_back(to_bytes(bytes_view(k).substr(0, k.size() - 1)));
+            }
+        }
+        test_partition_trie_with(std::move(keys), queries);
+    }
+}
+
+SEASTAR_TEST_CASE(test_sstable_partition_trie_lookups) {
+    return test_env::do_with_async([] (test_env& env) {
+        simple_schema ss;
+        auto s = ss.schema();
+
+        // Odd keys are written, even keys are absent
+        auto pks = ss.make_pkeys(4000);
+        std::vector<mutation> muts;
+        for (size_t i = 1; i < pks.size(); i += 2) {
+            mutation m(s, pks[i]);
+            ss.add_row(m, ss.make_ckey(1), "v");
+            muts.push_back(std::move(m));
+        }
+
+        tmpdir dir;
+        auto cfg = env.manager().configure_writer();
+        cfg.partition_trie_index = true;
+        auto sst = make_sstable(env, s, dir.path().string(), muts, cfg, sstables::get_highest_sstable_version());
+        BOOST_REQUIRE(sst->has_component(component_type::Partitions));
+
+        for (size_t i = 0; i < pks.size(); ++i) {
+            auto& dk = pks[i];
+            auto hk = sstables::sstable::make_hashed_key(*s, dk.key());
+            // The filter may not tell absent keys apart, the index must
+            BOOST_REQUIRE_EQUAL(sst->has_partition_key(hk, dk).get0(), i % 2 == 1);
+
+            auto pr = dht::partition_range::make_singular(dk);
+            auto rd = assert_that(sst->as_mutation_source().make_reader_v2(s, env.make_reader_permit(), pr));
+            if (i % 2) {
+                rd.produces(muts[i / 2]);
+            }
+            rd.produces_end_of_stream();
+        }
+
+        // Walks past the partitions found through the trie
+        for (size_t i = 0; i < pks.size(); i += 97) {
+            auto ir = std::make_unique<index_reader>(sst, env.make_reader_permit(), default_priority_class(),
+                                                     tracing::trace_state_ptr(), use_caching::yes);
+            auto close_ir = deferred_close(*ir);
+            BOOST_REQUIRE_EQUAL(ir->advance_lower_and_check_if_present(pks[i]).get0(), i % 2 == 1);
+            for (auto j = i / 2; j < muts.size() && j < i / 2 + 4; ++j) {
+                BOOST_REQUIRE(!ir->eof());
+                ir->read_partition_data().get();
+                BOOST_REQUIRE(ir->get_partition_key().equal(*s, muts[j].key()));
+                ir->advance_to_next_partition().get();
+            }
+        }
+
+        assert_that(sst->as_mutation_source().make_reader_v2(s, env.make_reader_permit(), query::full_partition_range))
+            .produces(muts)
+            .produces_end_of_stream();
+    });
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2022-present ScyllaDB
+ */
+
+/*
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <seastar/testing/test_case.hh>
+#include <seastar/testing/thread_test_case.hh>
+
+#include "sstables/row_trie.hh"
+#include "partition_slice_builder.hh"
+#include "schema_builder.hh"
+#include "test/boost/sstable_test.hh"
+#include "test/lib/flat_mutation_reader_assertions.hh"
+#include "test/lib/simple_schema.hh"
+#include "test/lib/sstable_utils.hh"
+#include "test/lib/random_utils.hh"
+#include "test/lib/tmpdir.hh"
+#include "test/lib/log.hh"
+#include "types.hh"
+
+using namespace sstables;
+
+SEASTAR_THREAD_TEST_CASE(test_row_trie_key_order) {
+    auto s = schema_builder("ks", "cf")
+            .with_column("pk", int32_type, column_kind::partition_key)
+            .with_column("ck1", int32_type, column_kind::clustering_key)
+            .with_column("ck2", reversed_type_impl::get_instance(utf8_type), column_kind::clustering_key)
+            .with_column("ck3", double_type, column_kind::clustering_key)
+            .with_column("ck4", boolean_type, column_kind::clustering_key)
+            .with_column("v", int32_type)
+            .build();
+    BOOST_REQUIRE(row_trie_supported(*s));
+    BOOST_REQUIRE(!row_trie_supported(*schema_builder("ks", "cf2")
+            .with_column("pk", int32_type, column_kind::partition_key)
+            .with_column("ck", uuid_type, column_kind::clustering_key)
+            .build()));
+
+    // Values of each clustering column, including empty ones and, for
+    // text, values with embedded zeros and values which prefix others.
+    auto nan = std::numeric_limits<double>::quiet_NaN();
+    auto inf = std::numeric_limits<double>::infinity();
+    std::vector<std::vector<bytes>> values = {
+        { bytes(), int32_type->decompose(std::numeric_limits<int32_t>::min()), int32_type->decompose(-1),
+          int32_type->decompose(0), int32_type->decompose(1), int32_type->decompose(std::numeric_limits<int32_t>::max()) },
+        { bytes(), utf8_type->decompose(sstring("a")), utf8_type->decompose(sstring("a\0", 2)),
+          utf8_type->decompose(sstring("a\0b", 3)), utf8_type->decompose(sstring("ab")), utf8_type->decompose(sstring("b")) },
+        { bytes(), double_type->decompose(-inf), double_type->decompose(-1.5), double_type->decompose(-0.0),
+          double_type->decompose(0.0), double_type->decompose(1.0), double_type->decompose(inf),
+          double_type->decompose(nan), double_type->decompose(-nan) },
+        { bytes(), boolean_type->decompose(false), boolean_type->decompose(true) },
+    };
+
+    std::vector<clustering_key_prefix> prefixes;
+    for (int i = 0; i < 300; ++i) {
+        std::vector<bytes> components;
+        auto size = tests::random::get_int<size_t>(0, values.size());
+        for (size_t j = 0; j < size; ++j) {
+            components.push_back(values[j][tests::random::get_int<size_t>(0, values[j].size() - 1)]);
+        }
+        prefixes.push_back(clustering_key_prefix::from_exploded(*s, components));
+    }
+    std::vector<position_in_partition_view> positions = {
+        position_in_partition_view::for_static_row(),
+        position_in_partition_view::for_partition_end(),
+        position_in_partition_view::before_all_clustered_rows(),
+        position_in_partition_view::after_all_clustered_rows(),
+    };
+    for (auto& p : prefixes) {
+        for (auto w : {bound_weight::before_all_prefixed, bound_weight::equal, bound_weight::after_all_prefixed}) {
+            positions.emplace_back(p, w);
+        }
+    }
+
+    position_in_partition::tri_compare cmp(*s);
+    std::vector<bytes> keys;
+    for (auto& pos : positions) {
+        keys.push_back(row_trie_key(*s, pos));
+    }
+    for (size_t i = 0; i < positions.size(); ++i) {
+        for (size_t j = 0; j < positions.size(); ++j) {
+            auto c = cmp(positions[i], positions[j]);
+            auto expected = c < 0 ? -1 : c > 0 ? 1 : 0;
+            auto k = compare_unsigned(keys[i], keys[j]);
+            auto actual = k < 0 ? -1 : k > 0 ? 1 : 0;
+            if (expected != actual) {
+                BOOST_FAIL(format("Order of {} and {} is {} but their keys {} and {} compare as {}",
+                        positions[i], positions[j], expected, keys[i], keys[j], actual));
+            }
+        }
+    }
+}
+
+SEASTAR_TEST_CASE(test_sstable_row_trie_lookups) {
+    return test_env::do_with_async([] (test_env& env) {
+        simple_schema ss;
+        auto s = ss.schema();
+
+        // Odd rows are written, even rows are absent
+        static constexpr uint32_t nr_rows = 2000;
+        mutation m(s, ss.make_pkey());
+        for (uint32_t i = 1; i < nr_rows; i += 2) {
+            ss.add_row(m, ss.make_ckey(i), "v");
+        }
+
+        tmpdir dir;
+        auto cfg = env.manager().configure_writer();
+        cfg.promoted_index_block_size = 1;
+        cfg.row_trie_index = true;
+        auto sst = make_sstable(env, s, dir.path().string(), {m}, cfg, sstables::get_highest_sstable_version());
+        BOOST_REQUIRE(sst->has_row_trie_index());
+
+        auto pr = dht::partition_range::make_singular(m.decorated_key());
+        auto read_range = [&] (query::clustering_range range) {
+            testlog.trace("reading {}", range);
+            auto slice = partition_slice_builder(*s).with_range(range).build();
+            assert_that(sst->as_mutation_source().make_reader_v2(s, env.make_reader_permit(), pr, slice))
+                .produces(m.sliced({range}))
+                .produces_end_of_stream();
+        };
+
+        for (int i = 0; i < 200; ++i) {
+            auto a = tests::random::get_int<uint32_t>(0, nr_rows);
+            auto b = tests::random::get_int<uint32_t>(a, nr_rows);
+            read_range(ss.make_ckey_range(a, b));
+            read_range(query::clustering_range::make_singular(ss.make_ckey(a)));
+        }
+        read_range(query::clustering_range::make_starting_with({ss.make_ckey(nr_rows - 1)}));
+        read_range(query::clustering_range::make_ending_with({ss.make_ckey(0)}));
+
+        // Without the option, promoted indexes are written as before
+        cfg.row_trie_index = false;
+        tmpdir dir2;
+        auto plain = make_sstable(env, s, dir2.path().string(), {m}, cfg, sstables::get_highest_sstable_version());
+        BOOST_REQUIRE(!plain->has_row_trie_index());
+    });
+}
@@ -89,3 +89,37 @@ SEASTAR_TEST_CASE(test_time_series_sstable_set_read_modify_write) {
         return make_ready_future<>();
     });
 }
+
+SEASTAR_TEST_CASE(test_sstable_set_filter_keys) {
+    return test_setup::do_with_tmp_directory([] (test_env& env, sstring tmpdir_path) {
+        simple_schema ss;
+        auto s = ss.schema();
+        fs::path tmp(tmpdir_path);
+        int gen = 1;
+        sstable_writer_config cfg = env.manager().configure_writer("");
+
+        auto pkeys = ss.make_pkeys(5);
+        auto make_sst = [&] (std::vector<dht::decorated_key> keys) {
+            std::vector<mutation> muts;
+            for (auto& pk : keys) {
+                muts.emplace_back(s, pk);
+                ss.add_row(muts.back(), ss.make_ckey(0), "val");
+            }
+            auto mr = make_flat_mutation_reader_from_mutations_v2(s, env.make_reader_permit(), std::move(muts));
+            return make_sstable_easy(env, tmp, std::move(mr), cfg, gen++);
+        };
+        auto sst1 = make_sst({pkeys[0], pkeys[1]});
+        auto sst2 = make_sst({pkeys[3], pkeys[4]});
+        auto set = make_sstable_set(s, make_lw_shared<sstable_list>({sst1, sst2}));
+
+        // pkeys[2] falls between the sstables, so neither may contain it.
+        std::vector<dht::decorated_key> keys = {pkeys[4], pkeys[0], pkeys[2]};
+        auto result = set.filter_keys(*s, keys);
+        BOOST_REQUIRE_EQUAL(result.size(), 2u);
+        for (auto& [sst, mask] : result) {
+            BOOST_REQUIRE_EQUAL(mask, uint64_t(sst == sst1 ? 0b010 : 0b001));
+        }
+
+        return make_ready_future<>();
+    });
+}
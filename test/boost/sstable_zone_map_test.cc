@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) 2022-present ScyllaDB
+ */
+
+/*
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <seastar/testing/test_case.hh>
+#include <seastar/testing/thread_test_case.hh>
+
+#include "sstables/zone_map.hh"
+#include "sstables/sstable_set.hh"
+#include "partition_slice_builder.hh"
+#include "schema_builder.hh"
+#include "service/priority_manager.hh"
+#include "test/boost/sstable_test.hh"
+#include "test/lib/flat_mutation_reader_assertions.hh"
+#include "test/lib/sstable_utils.hh"
+#include "test/lib/tmpdir.hh"
+#include "test/lib/log.hh"
+#include "types.hh"
+
+using namespace sstables;
+
+static schema_ptr make_zone_map_schema() {
+    return schema_builder("ks", "cf")
+            .with_column("pk", int32_type, column_kind::partition_key)
+            .with_column("ck", int32_type, column_kind::clustering_key)
+            .with_column("v", int32_type)
+            .with_column("t", utf8_type)
+            .build();
+}
+
+SEASTAR_THREAD_TEST_CASE(test_zone_map_filter) {
+    auto s = make_zone_map_schema();
+    auto& v = *s->get_column_definition("v");
+    auto& t = *s->get_column_definition("t");
+    BOOST_REQUIRE(zone_map_supported(v));
+    BOOST_REQUIRE(!zone_map_supported(t));
+
+    zone_map_writer writer(*s);
+    auto columns = writer.columns();
+    BOOST_REQUIRE_EQUAL(columns.elements.size(), 1);
+
+    auto add = [&] (int32_t value) {
+        auto cell = atomic_cell::make_live(*v.type, 1, int32_type->decompose(value));
+        writer.add(v, cell);
+    };
+    add(10);
+    add(-5);
+    add(3);
+    auto block = writer.finish_block();
+    auto no_values = writer.finish_block();
+
+    auto filter = [&] (nonwrapping_range<int32_t> r) {
+        auto range = r.transform([] (int32_t x) { return int32_type->decompose(x); });
+        return zone_map_filter(*s, columns, {query::column_value_range{v.id, std::move(range)}});
+    };
+    BOOST_REQUIRE(filter(nonwrapping_range<int32_t>::make_singular(3)).may_match(block));
+    BOOST_REQUIRE(filter(nonwrapping_range<int32_t>::make_singular(-5)).may_match(block));
+    BOOST_REQUIRE(filter(nonwrapping_range<int32_t>::make_singular(10)).may_match(block));
+    BOOST_REQUIRE(!filter(nonwrapping_range<int32_t>::make_singular(11)).may_match(block));
+    BOOST_REQUIRE(!filter(nonwrapping_range<int32_t>::make_ending_with({-5, false})).may_match(block));
+    BOOST_REQUIRE(filter(nonwrapping_range<int32_t>::make_ending_with({-5, true})).may_match(block));
+    BOOST_REQUIRE(!filter(nonwrapping_range<int32_t>::make_starting_with({10, false})).may_match(block));
+    BOOST_REQUIRE(!filter(nonwrapping_range<int32_t>::make_singular(3)).may_match(no_values));
+
+    // Ranges of columns which are not zone-mapped are ignored
+    BOOST_REQUIRE(zone_map_filter(*s, columns, {query::column_value_range{t.id,
+            nonwrapping_range<bytes>::make_singular(utf8_type->decompose(sstring("a")))}}).empty());
+}
+
+SEASTAR_TEST_CASE(test_sstable_zone_map_reads) {
+    return test_env::do_with_async([] (test_env& env) {
+        auto s = make_zone_map_schema();
+        auto& v = *s->get_column_definition("v");
+
+        // v grows with ck, so matching rows are contiguous
+        static constexpr int32_t nr_rows = 1000;
+        mutation m(s, partition_key::from_single_value(*s, int32_type->decompose(0)));
+        for (int32_t i = 0; i < nr_rows; ++i) {
+            auto ck = clustering_key::from_single_value(*s, int32_type->decompose(i));
+            m.set_clustered_cell(ck, v, atomic_cell::make_live(*v.type, 1, int32_type->decompose(i * 2)));
+        }
+
+        tmpdir dir;
+        auto cfg = env.manager().configure_writer();
+        cfg.promoted_index_block_size = 1;
+        cfg.zone_maps = true;
+        auto sst = make_sstable(env, s, dir.path().string(), {m}, cfg, sstables::get_highest_sstable_version());
+        BOOST_REQUIRE(sst->has_zone_maps());
+
+        auto& pc = service::get_local_sstable_query_read_priority();
+        auto value_range = [&] (int32_t a, int32_t b) {
+            return query::column_value_range{v.id, nonwrapping_range<bytes>({int32_type->decompose(a)}, {int32_type->decompose(b)})};
+        };
+        auto ck_range = [&] (int32_t a, int32_t b) {
+            return query::clustering_range({clustering_key::from_single_value(*s, int32_type->decompose(a))},
+                    {clustering_key::from_single_value(*s, int32_type->decompose(b))});
+        };
+
+        // Reads which bypass the cache leave the index page cache alone
+        auto cached_bytes = sstables::test(sst).index_cached_bytes();
+        auto uncached_ranges = sst->zone_map_ranges(*s, env.make_reader_permit(), m.decorated_key(), {value_range(200, 400)}, pc, {}, use_caching::no).get0();
+        BOOST_REQUIRE_EQUAL(sstables::test(sst).index_cached_bytes(), cached_bytes);
+
+        auto ranges = sst->zone_map_ranges(*s, env.make_reader_permit(), m.decorated_key(), {value_range(200, 400)}, pc, {}, use_caching::yes).get0();
+        BOOST_REQUIRE(ranges);
+        BOOST_REQUIRE(uncached_ranges && uncached_ranges->size() == ranges->size());
+        BOOST_REQUIRE(uncached_ranges->front().equal(ranges->front(), clustering_key::prefix_equal_tri_compare(*s)));
+        BOOST_REQUIRE_GT(sstables::test(sst).index_cached_bytes(), cached_bytes);
+        BOOST_REQUIRE_EQUAL(ranges->size(), 1);
+        BOOST_REQUIRE(ranges->front().contains(ck_range(100, 200), clustering_key::prefix_equal_tri_compare(*s)));
+        BOOST_REQUIRE(!ranges->front().contains(clustering_key::from_single_value(*s, int32_type->decompose(99)),
+                clustering_key::prefix_equal_tri_compare(*s)));
+        BOOST_REQUIRE(!ranges->front().contains(clustering_key::from_single_value(*s, int32_type->decompose(201)),
+                clustering_key::prefix_equal_tri_compare(*s)));
+
+        auto other_key = dht::decorate_key(*s, partition_key::from_single_value(*s, int32_type->decompose(1)));
+        auto absent = sst->zone_map_ranges(*s, env.make_reader_permit(), other_key, {value_range(200, 400)}, pc, {}, use_caching::yes).get0();
+        BOOST_REQUIRE(absent && absent->empty());
+
+        auto sstables = make_lw_shared<sstable_set>(sstables::make_partitioned_sstable_set(s, false));
+        sstables->insert(sst);
+        auto pr = dht::partition_range::make_singular(m.decorated_key());
+        auto read = [&] (query::column_value_range r, query::clustering_range expected) {
+            testlog.trace("reading {}", r);
+            auto slice = partition_slice_builder(*s).with_value_range(std::move(r)).build();
+            auto permit = env.make_reader_permit();
+            assert_that(make_zone_map_filtering_reader(s, permit, pr, slice, sstables, pc, {},
+                    [&] (const query::partition_slice& slice) {
+                return sst->as_mutation_source().make_reader_v2(s, permit, pr, slice);
+            }))
+                .produces(m.sliced({expected}))
+                .produces_end_of_stream();
+        };
+        read(value_range(200, 400), ck_range(100, 200));
+        read(value_range(201, 399), ck_range(101, 199));
+        read(value_range(0, 0), ck_range(0, 0));
+        read(value_range(2 * nr_rows - 2, 2 * nr_rows), ck_range(nr_rows - 1, nr_rows - 1));
+
+        // Without the option, zone maps are not written
+        cfg.zone_maps = false;
+        tmpdir dir2;
+        auto plain = make_sstable(env, s, dir2.path().string(), {m}, cfg, sstables::get_highest_sstable_version());
+        BOOST_REQUIRE(!plain->has_zone_maps());
+        BOOST_REQUIRE(!plain->zone_map_ranges(*s, env.make_reader_permit(), m.decorated_key(), {value_range(200, 400)}, pc, {}, use_caching::yes).get0());
+    });
+}
+
+// The row trie and the zone maps both go between the blocks and the offsets
+// of promoted indexes. Check that each is found when both are written, and
+// that readers which don't know about either skip them.
+SEASTAR_TEST_CASE(test_sstable_zone_maps_with_row_trie) {
+    return test_env::do_with_async([] (test_env& env) {
+        auto s = make_zone_map_schema();
+        auto& v = *s->get_column_definition("v");
+
+        static constexpr int32_t nr_rows = 1000;
+        mutation m(s, partition_key::from_single_value(*s, int32_type->decompose(0)));
+        for (int32_t i = 0; i < nr_rows; ++i) {
+            auto ck = clustering_key::from_single_value(*s, int32_type->decompose(i));
+            m.set_clustered_cell(ck, v, atomic_cell::make_live(*v.type, 1, int32_type->decompose(i * 2)));
+        }
+
+        tmpdir dir;
+        auto cfg = env.manager().configure_writer();
+        cfg.promoted_index_block_size = 1;
+        cfg.row_trie_index = true;
+        cfg.zone_maps = true;
+        auto sst = make_sstable(env, s, dir.path().string(), {m}, cfg, sstables::get_highest_sstable_version());
+        BOOST_REQUIRE(sst->has_row_trie_index());
+        BOOST_REQUIRE(sst->has_zone_maps());
+
+        auto& pc = service::get_local_sstable_query_read_priority();
+        auto ck_range = [&] (int32_t a, int32_t b) {
+            return query::clustering_range({clustering_key::from_single_value(*s, int32_type->decompose(a))},
+                    {clustering_key::from_single_value(*s, int32_type->decompose(b))});
+        };
+        auto value_range = query::column_value_range{v.id, nonwrapping_range<bytes>({int32_type->decompose(200)}, {int32_type->decompose(400)})};
+        auto ranges = sst->zone_map_ranges(*s, env.make_reader_permit(), m.decorated_key(), {value_range}, pc, {}, use_caching::yes).get0();
+        BOOST_REQUIRE(ranges);
+        BOOST_REQUIRE_EQUAL(ranges->size(), 1);
+        BOOST_REQUIRE(ranges->front().contains(ck_range(100, 200), clustering_key::prefix_equal_tri_compare(*s)));
+
+        auto pr = dht::partition_range::make_singular(m.decorated_key());
+        auto check_reads = [&] {
+            for (int32_t a = 0; a < nr_rows; a += 97) {
+                for (auto range : {ck_range(a, a + 50), query::clustering_range::make_singular(clustering_key::from_single_value(*s, int32_type->decompose(a)))}) {
+                    auto slice = partition_slice_builder(*s).with_range(range).build();
+                    assert_that(sst->as_mutation_source().make_reader_v2(s, env.make_reader_permit(), pr, slice))
+                        .produces(m.sliced({range}))
+                        .produces_end_of_stream();
+                }
+            }
+        };
+        check_reads();
+
+        // Readers which know about the row trie but not about zone maps
+        sstables::test(sst).disable_feature(sstable_feature::ZoneMaps);
+        BOOST_REQUIRE(!sst->zone_map_ranges(*s, env.make_reader_permit(), m.decorated_key(), {value_range}, pc, {}, use_caching::yes).get0());
+        check_reads();
+
+        // Readers which know about neither
+        sstables::test(sst).disable_feature(sstable_feature::RowTrieIndex);
+        check_reads();
+    });
+}
@@ -104,6 +104,7 @@ cql_test_config::cql_test_config(shared_ptr<db::config> cfg)
 
     db_config->add_cdc_extension();
     db_config->add_per_partition_rate_limit_extension();
+    db_config->add_sstable_filter_extension();
 
     db_config->flush_schema_tables_after_modification.set(false);
 }
@@ -684,6 +685,8 @@ class single_node_cql_env : public cql_test_env {
                     .available_memory = dbcfg.available_memory,
                     .static_shares = cfg->compaction_static_shares,
                     .throughput_mb_per_sec = cfg->compaction_throughput_mb_per_sec,
+                    .parallel_sub_ranges = cfg->compaction_parallel_sub_ranges,
+                    .read_latency_target_ms = cfg->compaction_read_latency_target_in_ms,
                 };
             });
             cm.start(std::move(get_cm_cfg), std::ref(abort_sources)).get();
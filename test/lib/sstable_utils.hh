@@ -55,6 +55,21 @@ class test {
         return _sst->_components->summary;
     }
 
+    size_t index_cached_bytes() const {
+        return _sst->_cached_index_file->cached_bytes();
+    }
+
+    size_t decompressed_cached_bytes() const {
+        return _sst->_cached_decompressed_data_file ? _sst->_cached_decompressed_data_file->cached_bytes() : 0;
+    }
+
+    // Makes the sstable look like readers which don't know about the feature see it.
+    void disable_feature(sstable_feature f) {
+        auto features = _sst->_components->scylla_metadata->get_features();
+        features.disable(f);
+        _sst->_components->scylla_metadata->data.set<scylla_metadata_type::Features>(std::move(features));
+    }
+
     future<temporary_buffer<char>> data_read(reader_permit permit, uint64_t pos, size_t len) {
         return _sst->data_read(pos, len, default_priority_class(), std::move(permit));
     }
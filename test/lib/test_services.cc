@@ -75,6 +75,9 @@ class table_for_tests::table_state : public compaction::table_state {
     bool compaction_enforce_min_threshold() const noexcept override {
         return true;
     }
+    unsigned token_ranges_per_shard() const noexcept override {
+        return table().get_config().sstable_token_ranges_per_shard();
+    }
     const sstables::sstable_set& main_sstable_set() const override {
         return table().as_table_state().main_sstable_set();
     }
@@ -156,6 +156,28 @@ void test_small_partitions() {
     });
 }
 
+// Every update merges into partitions which are already in cache
+void test_small_partitions_with_overwrites() {
+    auto s = schema_builder("ks", "cf")
+        .with_column("pk", uuid_type, column_kind::partition_key)
+        .with_column("v1", bytes_type, column_kind::regular_column)
+        .build();
+
+    std::vector<dht::decorated_key> keys;
+    for (int i = 0; i < 100000; ++i) {
+        keys.push_back(dht::decorate_key(*s, partition_key::from_single_value(*s,
+            serialized(utils::UUID_gen::get_time_UUID()))));
+    }
+    size_t key_idx = 0;
+
+    run_test("Small partitions, overwrites", s, [&] {
+        mutation m(s, keys[key_idx++ % keys.size()]);
+        auto val = data_value(bytes(bytes::initialized_later(), cell_size));
+        m.set_clustered_cell(clustering_key::make_empty(), "v1", val, api::new_timestamp());
+        return m;
+    });
+}
+
 void test_partition_with_lots_of_small_rows() {
     auto s = schema_builder("ks", "cf")
         .with_column("pk", uuid_type, column_kind::partition_key)
@@ -274,6 +296,7 @@ int main(int argc, char** argv) {
             });
             logalloc::prime_segment_pool(memory::stats().total_memory(), memory::min_free_memory()).get();
             test_small_partitions();
+            test_small_partitions_with_overwrites();
             test_partition_with_few_small_rows();
             test_partition_with_lots_of_small_rows();
             test_partition_with_lots_of_range_tombstones();
@@ -1353,6 +1353,8 @@ const char* to_string(sstables::scylla_metadata_type t) {
         case sstables::scylla_metadata_type::SSTableOrigin: return "sstable_origin";
         case sstables::scylla_metadata_type::ScyllaVersion: return "scylla_version";
         case sstables::scylla_metadata_type::ScyllaBuildId: return "scylla_build_id";
+        case sstables::scylla_metadata_type::FilterLayout: return "filter_layout";
+        case sstables::scylla_metadata_type::ZoneMapColumns: return "zone_map_columns";
     }
     std::abort();
 }
@@ -1368,6 +1370,15 @@ const char* to_string(sstables::large_data_type t) {
     std::abort();
 }
 
+const char* to_string(sstables::filter_layout l) {
+    switch (l) {
+        case sstables::filter_layout::bloom: return "bloom";
+        case sstables::filter_layout::split_block_bloom: return "split_block_bloom";
+        case sstables::filter_layout::xor_filter: return "xor";
+    }
+    return "unknown";
+}
+
 class scylla_metadata_visitor : public boost::static_visitor<> {
     json_writer& _writer;
 
@@ -1407,6 +1418,8 @@ class scylla_metadata_visitor : public boost::static_visitor<> {
                 {sstables::sstable_feature::CorrectStaticCompact, "CorrectStaticCompact"},
                 {sstables::sstable_feature::CorrectEmptyCounters, "CorrectEmptyCounters"},
                 {sstables::sstable_feature::CorrectUDTsInCollections, "CorrectUDTsInCollections"},
+                {sstables::sstable_feature::RowTrieIndex, "RowTrieIndex"},
+                {sstables::sstable_feature::ZoneMaps, "ZoneMaps"},
         };
         _writer.StartObject();
         _writer.Key("mask");
@@ -1447,6 +1460,21 @@ class scylla_metadata_visitor : public boost::static_visitor<> {
         }
         _writer.EndObject();
     }
+    void operator()(const sstables::filter_layout& val) const {
+        _writer.String(to_string(val));
+    }
+    void operator()(const sstables::scylla_metadata::zone_map_columns& val) const {
+        _writer.StartArray();
+        for (const auto& c : val.elements) {
+            _writer.StartObject();
+            _writer.Key("name");
+            _writer.String(disk_string_to_string(c.name));
+            _writer.Key("type");
+            _writer.String(disk_string_to_string(c.type));
+            _writer.EndObject();
+        }
+        _writer.EndArray();
+    }
     template <typename Size>
     void operator()(const sstables::disk_string<Size>& val) const {
         _writer.String(disk_string_to_string(val));
@@ -10,6 +10,7 @@
 
 #pragma once
 
+#include <cmath>
 #include <seastar/core/print.hh>
 #include "exceptions/exceptions.hh"
 
@@ -124,6 +125,38 @@ namespace bloom_calculations {
         return std::min(probs.size() - 1, size_t(v));
     }
 
+    /**
+     * False positive rate of a split-block bloom filter (256-bit blocks of
+     * eight 32-bit words, one bit set per word) with the given number of bits
+     * per element. The number of elements hashed to a block is Poisson
+     * distributed with mean 256/c, and a block holding k elements answers a
+     * foreign probe positively with probability (1 - (31/32)^k)^8.
+     */
+    inline double split_block_false_positive_rate(double bits_per_element) {
+        double lambda = 256 / bits_per_element;
+        double p_k = std::exp(-lambda);
+        double fpr = 0;
+        for (int k = 0; k < int(lambda * 4) + 100; k++) {
+            fpr += p_k * std::pow(1 - std::pow(31.0 / 32, k), 8);
+            p_k *= lambda / (k + 1);
+        }
+        return fpr;
+    }
+
+    /**
+     * Bits per element needed by a split-block bloom filter to meet the given
+     * false positive rate. Starts from the estimate of a classic filter with
+     * k = 8, c = -8 / ln(1 - p^(1/8)), which is optimistic since blocks are
+     * unevenly loaded, and grows it until the blocked rate is satisfied.
+     */
+    inline double split_block_bits_per_element(double max_false_pos_prob) {
+        double c = -8.0 / std::log(1.0 - std::pow(max_false_pos_prob, 1.0 / 8));
+        while (split_block_false_positive_rate(c) > max_false_pos_prob) {
+            c *= 1.02;
+        }
+        return c;
+    }
+
     /**
      * Retrieves the minimum supported bloom_filter_fp_chance value
      * if compute_bloom_spec() above is attempted with bloom_filter_fp_chance
@@ -18,8 +18,16 @@
 #include "utils/large_bitset.hh"
 #include <array>
 #include <cstdlib>
+#include <cmath>
 #include "bloom_filter.hh"
 
+#ifdef __x86_64__
+#include <x86intrin.h>
+#define arch_target(name) [[gnu::target(name)]]
+#else
+#define arch_target(name)
+#endif
+
 namespace utils {
 namespace filter {
 
@@ -62,6 +70,25 @@ bool bloom_filter::is_present(hashed_key key) {
     return result;
 }
 
+uint64_t bloom_filter::is_present_batch(std::span<const hashed_key> keys) {
+    assert(keys.size() <= max_batch_size);
+    // Issue all the loads first, so that their cache misses overlap instead
+    // of being paid one key at a time.
+    for (auto& key : keys) {
+        for_each_index(key, _hash_count, _bitset.size(), _format, [this] (auto i) {
+            _bitset.prefetch(i);
+            return stop_iteration::no;
+        });
+    }
+    uint64_t mask = 0;
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (bloom_filter::is_present(keys[i])) {
+            mask |= uint64_t(1) << i;
+        }
+    }
+    return mask;
+}
+
 void bloom_filter::add(const bytes_view& key) {
     for_each_index(make_hashed_key(key), _hash_count, _bitset.size(), _format, [this] (auto i) {
         _bitset.set(i);
@@ -73,6 +100,105 @@ bool bloom_filter::is_present(const bytes_view& key) {
     return is_present(make_hashed_key(key));
 }
 
+// Odd constants used to derive the eight per-word bit positions from a
+// single 32-bit key, as in the Parquet/Impala split-block bloom filter.
+static constexpr uint32_t split_block_salt[split_block_bloom_filter::words_per_block] = {
+    0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+    0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U,
+};
+
+// The block is stored as four 64-bit words; 32-bit word i is the low
+// (even i) or high (odd i) half of 64-bit word i / 2. This matches what a
+// little-endian vector load of the block sees.
+static inline uint64_t split_block_mask(uint32_t key, int word64) {
+    auto bit = [key] (int i) {
+        return uint64_t(1) << ((key * split_block_salt[i]) >> 27);
+    };
+    return bit(2 * word64) | (bit(2 * word64 + 1) << 32);
+}
+
+arch_target("default") bool split_block_contains(const uint64_t* block, uint32_t key) {
+    for (int i = 0; i < split_block_bloom_filter::words_per_block / 2; i++) {
+        auto mask = split_block_mask(key, i);
+        if ((block[i] & mask) != mask) {
+            return false;
+        }
+    }
+    return true;
+}
+
+arch_target("default") void split_block_insert(uint64_t* block, uint32_t key) {
+    for (int i = 0; i < split_block_bloom_filter::words_per_block / 2; i++) {
+        block[i] |= split_block_mask(key, i);
+    }
+}
+
+#ifdef __x86_64__
+
+[[gnu::target("avx2")]]
+static inline __m256i split_block_mask_avx2(uint32_t key) {
+    const auto salt = _mm256_setr_epi32(
+            split_block_salt[0], split_block_salt[1], split_block_salt[2], split_block_salt[3],
+            split_block_salt[4], split_block_salt[5], split_block_salt[6], split_block_salt[7]);
+    // 1. Multiply the key by each salt, 8 lanes in one go
+    auto h = _mm256_mullo_epi32(_mm256_set1_epi32(key), salt);
+    // 2. The top 5 bits of each product select the bit within its word
+    h = _mm256_srli_epi32(h, 27);
+    return _mm256_sllv_epi32(_mm256_set1_epi32(1), h);
+}
+
+arch_target("avx2") bool split_block_contains(const uint64_t* block, uint32_t key) {
+    auto b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+    // Carry flag is set iff every mask bit is also set in the block
+    return _mm256_testc_si256(b, split_block_mask_avx2(key));
+}
+
+arch_target("avx2") void split_block_insert(uint64_t* block, uint32_t key) {
+    auto b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+    b = _mm256_or_si256(b, split_block_mask_avx2(key));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(block), b);
+}
+
+#endif
+
+split_block_bloom_filter::split_block_bloom_filter(bitmap&& bs) noexcept
+    : bloom_filter(words_per_block, std::move(bs), filter_format::split_block_format)
+    , _nr_blocks(bits().size() / bits_per_block)
+{
+}
+
+uint64_t* split_block_bloom_filter::block_for(hashed_key key) {
+    auto h = key.hash();
+    // Map the first half of the hash onto [0, _nr_blocks) without a division
+    auto block = uint64_t((static_cast<unsigned __int128>(h[0]) * _nr_blocks) >> 64);
+    return bits().word_ptr(block * (bits_per_block / 64));
+}
+
+bool split_block_bloom_filter::is_present(hashed_key key) {
+    return split_block_contains(block_for(key), uint32_t(key.hash()[1]));
+}
+
+uint64_t split_block_bloom_filter::is_present_batch(std::span<const hashed_key> keys) {
+    assert(keys.size() <= max_batch_size);
+    std::array<uint64_t*, max_batch_size> blocks;
+    for (size_t i = 0; i < keys.size(); i++) {
+        blocks[i] = block_for(keys[i]);
+        __builtin_prefetch(blocks[i]);
+    }
+    uint64_t mask = 0;
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (split_block_contains(blocks[i], uint32_t(keys[i].hash()[1]))) {
+            mask |= uint64_t(1) << i;
+        }
+    }
+    return mask;
+}
+
+void split_block_bloom_filter::add(const bytes_view& key) {
+    auto hk = make_hashed_key(key);
+    split_block_insert(block_for(hk), uint32_t(hk.hash()[1]));
+}
+
 filter_ptr create_filter(int hash, large_bitset&& bitset, filter_format format) {
     return std::make_unique<murmur3_bloom_filter>(hash, std::move(bitset), format);
 }
@@ -83,5 +209,21 @@ filter_ptr create_filter(int hash, int64_t num_elements, int buckets_per, filter
     large_bitset bitset(num_bits);
     return std::make_unique<murmur3_bloom_filter>(hash, std::move(bitset), format);
 }
+
+filter_ptr create_split_block_filter(large_bitset&& bitset) {
+    if (bitset.size() == 0 || bitset.size() % split_block_bloom_filter::bits_per_block) {
+        throw std::invalid_argument(format("Invalid split-block bloom filter size {}: must be a positive multiple of {} bits",
+                bitset.size(), split_block_bloom_filter::bits_per_block));
+    }
+    return std::make_unique<split_block_bloom_filter>(std::move(bitset));
+}
+
+filter_ptr create_split_block_filter(int64_t num_elements, double max_false_pos_prob) {
+    num_elements = std::max(int64_t(1), num_elements);
+    auto num_bits = int64_t(std::ceil(num_elements * bloom_calculations::split_block_bits_per_element(max_false_pos_prob)));
+    num_bits = align_up<int64_t>(num_bits, split_block_bloom_filter::bits_per_block);
+    large_bitset bitset(num_bits);
+    return std::make_unique<split_block_bloom_filter>(std::move(bitset));
+}
 }
 }
@@ -37,6 +37,7 @@ class bloom_filter: public i_filter {
 public:
     int num_hashes() { return _hash_count; }
     bitmap& bits() { return _bitset; }
+    filter_format format() const { return _format; }
 
     bloom_filter(int hashes, bitmap&& bs, filter_format format) noexcept;
     ~bloom_filter() noexcept;
@@ -47,6 +48,8 @@ class bloom_filter: public i_filter {
 
     virtual bool is_present(hashed_key key) override;
 
+    virtual uint64_t is_present_batch(std::span<const hashed_key> keys) override;
+
     virtual void clear() override {
         _bitset.clear();
     }
@@ -69,6 +72,33 @@ struct murmur3_bloom_filter: public bloom_filter {
     {}
 };
 
+// Split-block bloom filter (Putze, Sanders, Singler: "Cache-, Hash- and
+// Space-Efficient Bloom Filters").
+//
+// The bitmap is divided into 256-bit blocks of eight 32-bit words. A key
+// selects one block and sets exactly one bit in each of the block's words,
+// so a probe touches a single cache line instead of _hash_count scattered
+// ones, and the eight word tests are done with a single SIMD comparison
+// where the CPU supports it.
+class split_block_bloom_filter: public bloom_filter {
+public:
+    static constexpr int words_per_block = 8;
+    static constexpr size_t bits_per_block = words_per_block * 32;
+private:
+    uint64_t _nr_blocks;
+
+    uint64_t* block_for(hashed_key key);
+public:
+    explicit split_block_bloom_filter(bitmap&& bs) noexcept;
+
+    virtual void add(const bytes_view& key) override;
+
+    using bloom_filter::is_present;
+    virtual bool is_present(hashed_key key) override;
+
+    virtual uint64_t is_present_batch(std::span<const hashed_key> keys) override;
+};
+
 struct always_present_filter: public i_filter {
 
     virtual bool is_present(const bytes_view& key) override {
@@ -79,6 +109,10 @@ struct always_present_filter: public i_filter {
         return true;
     }
 
+    virtual uint64_t is_present_batch(std::span<const hashed_key> keys) override {
+        return keys.size() == max_batch_size ? ~uint64_t(0) : (uint64_t(1) << keys.size()) - 1;
+    }
+
     virtual void add(const bytes_view& key) override { }
 
     virtual void clear() override { }
@@ -92,5 +126,7 @@ struct always_present_filter: public i_filter {
 
 filter_ptr create_filter(int hash, large_bitset&& bitset, filter_format format);
 filter_ptr create_filter(int hash, int64_t num_elements, int buckets_per, filter_format format);
+filter_ptr create_split_block_filter(large_bitset&& bitset);
+filter_ptr create_split_block_filter(int64_t num_elements, double max_false_pos_prob);
 }
 }
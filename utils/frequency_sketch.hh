@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2022-present ScyllaDB
+ */
+
+/*
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include <seastar/core/bitops.hh>
+
+namespace utils {
+
+// Approximate access counts of keys, for deciding which keys are worth
+// keeping in a cache (the TinyLFU count-min sketch).
+//
+// Every key maps to one 4-bit counter in each of four rows, and its count
+// is estimated as the smallest of them. Once as many accesses as ten times
+// the number of counters per row were recorded, all counters are halved,
+// so that counts follow changes of the access pattern.
+class frequency_sketch {
+    static constexpr unsigned depth = 4;
+    static constexpr uint64_t max_count = 15;
+    static constexpr uint64_t counters_per_word = 16;
+    // A row of counters, 16 per word
+    std::vector<uint64_t> _rows[depth];
+    uint64_t _counter_mask;
+    uint64_t _additions = 0;
+    uint64_t _sample_size;
+private:
+    static uint64_t index_of(uint64_t hash, unsigned row) noexcept {
+        static constexpr uint64_t seeds[depth] = {
+            0xc3a5c85c97cb3127ull, 0xb492b66fbe98f273ull, 0x9ae16a3b2f90404full, 0xcbf29ce484222325ull,
+        };
+        auto h = (hash + seeds[row]) * seeds[row];
+        return h ^ (h >> 32);
+    }
+    uint64_t get(unsigned row, uint64_t idx) const noexcept {
+        auto word = _rows[row][idx / counters_per_word];
+        return (word >> ((idx % counters_per_word) * 4)) & max_count;
+    }
+    // Returns true if the counter was incremented, false if saturated.
+    bool increment(unsigned row, uint64_t idx) noexcept {
+        auto& word = _rows[row][idx / counters_per_word];
+        auto shift = (idx % counters_per_word) * 4;
+        if (((word >> shift) & max_count) == max_count) {
+            return false;
+        }
+        word += uint64_t(1) << shift;
+        return true;
+    }
+    void age() noexcept {
+        // Halve every counter, dropping the bit shifted in from its neighbour.
+        static constexpr uint64_t mask = 0x7777777777777777ull;
+        for (auto& row : _rows) {
+            for (auto& word : row) {
+                word = (word >> 1) & mask;
+            }
+        }
+        _additions /= 2;
+    }
+public:
+    // The sketch has room for about as many keys as counters per row.
+    explicit frequency_sketch(size_t counters)
+        : _counter_mask((uint64_t(1) << log2ceil(std::max<size_t>(counters, counters_per_word))) - 1)
+        , _sample_size(10 * (_counter_mask + 1))
+    {
+        for (auto& row : _rows) {
+            row.resize((_counter_mask + 1) / counters_per_word);
+        }
+    }
+
+    // Records an access to the key with the given hash.
+    // Returns true if it caused the counters to be halved.
+    bool record(uint64_t hash) noexcept {
+        bool added = false;
+        for (unsigned row = 0; row < depth; ++row) {
+            added |= increment(row, index_of(hash, row) & _counter_mask);
+        }
+        if (added && ++_additions >= _sample_size) {
+            age();
+            return true;
+        }
+        return false;
+    }
+
+    // Returns the estimated number of recent accesses to the key with the given hash.
+    unsigned estimate(uint64_t hash) const noexcept {
+        uint64_t count = max_count;
+        for (unsigned row = 0; row < depth; ++row) {
+            count = std::min(count, get(row, index_of(hash, row) & _counter_mask));
+        }
+        return count;
+    }
+};
+
+}
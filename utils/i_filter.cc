@@ -9,6 +9,7 @@
 
 #include "log.hh"
 #include "bloom_filter.hh"
+#include "xor_filter.hh"
 #include "bloom_calculations.hh"
 #include <seastar/core/thread.hh>
 
@@ -26,11 +27,34 @@ filter_ptr i_filter::get_filter(int64_t num_elements, double max_false_pos_proba
         return std::make_unique<filter::always_present_filter>();
     }
 
+    if (fformat == filter_format::split_block_format) {
+        return filter::create_split_block_filter(num_elements, max_false_pos_probability);
+    }
+
+    if (fformat == filter_format::xor_format) {
+        if (num_elements <= int64_t(filter::xor_filter::max_elements)) {
+            return filter::create_xor_filter(num_elements, max_false_pos_probability);
+        }
+        // Too many keys to build an xor filter for
+        fformat = filter_format::m_format;
+    }
+
     int buckets_per_element = bloom_calculations::max_buckets_per_element(num_elements);
     auto spec = bloom_calculations::compute_bloom_spec(buckets_per_element, max_false_pos_probability);
     return filter::create_filter(spec.K, num_elements, spec.buckets_per_element, fformat);
 }
 
+uint64_t i_filter::is_present_batch(std::span<const hashed_key> keys) {
+    assert(keys.size() <= max_batch_size);
+    uint64_t mask = 0;
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (is_present(keys[i])) {
+            mask |= uint64_t(1) << i;
+        }
+    }
+    return mask;
+}
+
 hashed_key make_hashed_key(bytes_view b) {
     std::array<uint64_t, 2> h;
     utils::murmur_hash::hash3_x64_128(b, 0, h);
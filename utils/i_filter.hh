@@ -9,6 +9,8 @@
  */
 #pragma once
 
+#include <span>
+
 #include "bytes.hh"
 #include "bloom_calculations.hh"
 
@@ -20,6 +22,12 @@ using filter_ptr = std::unique_ptr<i_filter>;
 enum class filter_format {
     k_l_format,
     m_format,
+    // Split-block bloom filter: all probes of a key land in a single
+    // 256-bit block, so a lookup touches one cache line.
+    split_block_format,
+    // Xor filter: smaller than a bloom filter for the same false positive
+    // rate, but built only once all keys were added.
+    xor_format,
 };
 
 class hashed_key {
@@ -35,11 +43,18 @@ hashed_key make_hashed_key(bytes_view key);
 // FIXME: serialize() and serialized_size() not implemented. We should only be serializing to
 // disk, not in the wire.
 struct i_filter {
+    // Largest number of keys is_present_batch() accepts at once.
+    static constexpr size_t max_batch_size = 64;
+
     virtual ~i_filter() {}
 
     virtual void add(const bytes_view& key) = 0;
     virtual bool is_present(const bytes_view& key) = 0;
     virtual bool is_present(hashed_key) = 0;
+    // Tests up to max_batch_size keys at once. Bit i of the result is set iff
+    // keys[i] may be present. Implementations are expected to issue the memory
+    // accesses of all keys before testing any of them, to overlap cache misses.
+    virtual uint64_t is_present_batch(std::span<const hashed_key> keys);
     virtual void clear() = 0;
     virtual void close() = 0;
 
@@ -811,6 +811,14 @@ class tree {
             revalidate();
         }
 
+        /*
+         * Returns pointer on the owning tree if this is the end()
+         * iterator, e.g. one advanced past the last element.
+         */
+        tree_ptr tree_if_end() const noexcept {
+            return is_end() ? _tree : nullptr;
+        }
+
         /*
          * Returns pointer on the owning tree if the element is the
          * last one left in it.
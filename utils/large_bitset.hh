@@ -50,6 +50,9 @@ class large_bitset {
         auto idx2 = idx;
         _storage[idx1] |= int_type(1) << idx2;
     }
+    void prefetch(size_t idx) const {
+        __builtin_prefetch(&_storage[idx / bits_per_int()]);
+    }
     void clear(size_t idx) {
         auto idx1 = idx / bits_per_int();
         idx %= bits_per_int();
@@ -61,4 +64,14 @@ class large_bitset {
     const utils::chunked_vector<int_type>& get_storage() const {
         return _storage;
     }
+
+    // Returns a pointer to the word at word_idx. Words never straddle a
+    // storage chunk and chunks hold a power-of-two number of words, so any
+    // naturally aligned group of up to 8 words is contiguous in memory.
+    int_type* word_ptr(size_t word_idx) {
+        return &_storage[word_idx];
+    }
+    const int_type* word_ptr(size_t word_idx) const {
+        return &_storage[word_idx];
+    }
 };
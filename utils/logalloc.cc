@@ -37,6 +37,7 @@
 
 #include <random>
 #include <chrono>
+#include <sys/mman.h>
 
 using namespace std::chrono_literals;
 
@@ -363,18 +364,27 @@ static thread_local tracker& tracker_instance = get_tracker_instance();
 using clock = std::chrono::steady_clock;
 
 class background_reclaimer {
+public:
+    struct config {
+        // Reclaims until there is this much free memory
+        size_t free_memory_threshold = 60'000'000;
+        // Time a reclaim step may take before yielding, 0 for the task quota
+        std::chrono::microseconds step_budget{0};
+    };
+private:
     scheduling_group _sg;
-    noncopyable_function<void (size_t target)> _reclaim;
+    noncopyable_function<void (size_t target, std::optional<clock::time_point> deadline)> _reclaim;
     timer<lowres_clock> _adjust_shares_timer;
+    const size_t _free_memory_threshold;
+    const std::chrono::microseconds _step_budget;
     // If engaged, main loop is not running, set_value() to wake it.
     promise<>* _main_loop_wait = nullptr;
     future<> _done;
     bool _stopping = false;
-    static constexpr size_t free_memory_threshold = 60'000'000;
 private:
     bool have_work() const {
 #ifndef SEASTAR_DEFAULT_ALLOCATOR
-        return memory::free_memory() < free_memory_threshold;
+        return memory::free_memory() < _free_memory_threshold;
 #else
         return false;
 #endif
@@ -400,14 +410,20 @@ class background_reclaimer {
             if (_stopping) {
                 break;
             }
-            _reclaim(free_memory_threshold - memory::free_memory());
-            co_await coroutine::maybe_yield();
+            if (_step_budget.count()) {
+                _reclaim(_free_memory_threshold - memory::free_memory(), clock::now() + _step_budget);
+                // The step may have ended before the task quota did.
+                co_await yield();
+            } else {
+                _reclaim(_free_memory_threshold - memory::free_memory(), std::nullopt);
+                co_await coroutine::maybe_yield();
+            }
         }
         llogger.debug("background_reclaimer::main_loop: exit");
     }
     void adjust_shares() {
         if (have_work()) {
-            auto shares = 1 + (1000 * (free_memory_threshold - memory::free_memory())) / free_memory_threshold;
+            auto shares = 1 + (1000 * (_free_memory_threshold - memory::free_memory())) / _free_memory_threshold;
             _sg.set_shares(shares);
             llogger.trace("background_reclaimer::adjust_shares: {}", shares);
             if (_main_loop_wait) {
@@ -416,10 +432,12 @@ class background_reclaimer {
         }
     }
 public:
-    explicit background_reclaimer(scheduling_group sg, noncopyable_function<void (size_t target)> reclaim)
+    background_reclaimer(scheduling_group sg, config cfg, noncopyable_function<void (size_t target, std::optional<clock::time_point> deadline)> reclaim)
             : _sg(sg)
             , _reclaim(std::move(reclaim))
             , _adjust_shares_timer(default_scheduling_group(), [this] { adjust_shares(); })
+            , _free_memory_threshold(cfg.free_memory_threshold)
+            , _step_budget(cfg.step_budget)
             , _done(with_scheduling_group(_sg, [this] { return main_loop(); })) {
         if (sg != default_scheduling_group()) {
             _adjust_shares_timer.arm_periodic(50ms);
@@ -445,6 +463,8 @@ class tracker::impl {
     bool _abort_on_bad_alloc = false;
     bool _sanitizer_report_backtrace = false;
     reclaim_timer* _active_timer = nullptr;
+    // Ends the current background reclaim step
+    std::optional<clock::time_point> _reclaim_deadline;
 private:
     // Prevents tracker's reclaimer from running while live. Reclaimer may be
     // invoked synchronously with allocator. This guard ensures that this
@@ -503,12 +523,24 @@ class tracker::impl {
     // Abort on allocation failure from LSA
     void enable_abort_on_bad_alloc() noexcept { _abort_on_bad_alloc = true; }
     bool should_abort_on_bad_alloc() const noexcept { return _abort_on_bad_alloc; }
-    void setup_background_reclaim(scheduling_group sg) {
+    void setup_background_reclaim(scheduling_group sg, background_reclaimer::config cfg) {
         assert(!_background_reclaimer);
-        _background_reclaimer.emplace(sg, [this] (size_t target) {
-            reclaim(target, is_preemptible::yes);
+        _background_reclaimer.emplace(sg, cfg, [this] (size_t target, std::optional<clock::time_point> deadline) {
+            reclaim_step(target, deadline);
         });
     }
+    // Reclaims preemptibly, until the deadline if given.
+    size_t reclaim_step(size_t target, std::optional<clock::time_point> deadline) {
+        _reclaim_deadline = deadline;
+        auto released = reclaim(target, is_preemptible::yes);
+        _reclaim_deadline = std::nullopt;
+        return released;
+    }
+    // Whether preemptible reclaim should stop, because of the task quota
+    // or the time budget of the background reclaim step.
+    bool should_preempt(is_preemptible preempt) const noexcept {
+        return preempt && (need_preempt() || (_reclaim_deadline && clock::now() >= *_reclaim_deadline));
+    }
     // const bool&, so interested parties can save a reference and see updates.
     const bool& sanitizer_report_backtrace() const { return _sanitizer_report_backtrace; }
     void set_sanitizer_report_backtrace(bool rb) { _sanitizer_report_backtrace = rb; }
@@ -615,6 +647,7 @@ static constexpr size_t max_managed_object_size = segment_size * 0.1;
 static constexpr auto max_used_space_ratio_for_compaction = 0.85;
 static constexpr size_t max_used_space_for_compaction = segment_size * max_used_space_ratio_for_compaction;
 static constexpr size_t min_free_space_for_compaction = segment_size - max_used_space_for_compaction;
+static constexpr size_t huge_page_size = 2 << 20;
 
 struct [[gnu::packed]] non_lsa_object_cookie {
     uint64_t value = 0xbadcaffe;
@@ -712,6 +745,14 @@ class segment_store_backend {
     virtual void* alloc_segment_memory() noexcept = 0;
     virtual void free_segment_memory(void* seg) noexcept = 0;
     virtual size_t free_memory() const noexcept = 0;
+    // Asks the kernel to back the memory area with transparent huge pages.
+    void advise_huge_pages() const noexcept {
+        auto start = align_up(_layout.start, static_cast<uintptr_t>(huge_page_size));
+        auto end = align_down(_layout.end, static_cast<uintptr_t>(huge_page_size));
+        if (start < end && madvise(reinterpret_cast<void*>(start), end - start, MADV_HUGEPAGE)) {
+            llogger.info("Failed to advise huge pages for the segment area: {}", strerror(errno));
+        }
+    }
     bool can_allocate_more_segments(size_t non_lsa_reserve) const noexcept {
         if (_freed_segment_increases_general_memory_availability) {
             return free_memory() >= non_lsa_reserve + segment::size;
@@ -754,22 +795,38 @@ class standard_memory_segment_store_backend : public segment_store_backend {
     size_t _available_segments; // for fast free_memory()
 
 private:
-    static memory::memory_layout allocate_memory(size_t segments) {
-        const auto size = segments * segment_size;
-        auto p = mmap(nullptr, size,
-                PROT_READ | PROT_WRITE,
-                MAP_PRIVATE | MAP_ANONYMOUS,
-                -1, 0);
+    static memory::memory_layout allocate_memory(size_t segments, bool huge_pages) {
+        auto size = segments * segment_size;
+        void* p = MAP_FAILED;
+        if (huge_pages) {
+            // Reserved up front, mmap() fails when there are not enough free huge pages.
+            auto huge_size = align_up(size, huge_page_size);
+            p = mmap(nullptr, huge_size,
+                    PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (21 << MAP_HUGE_SHIFT),
+                    -1, 0);
+            if (p == MAP_FAILED) {
+                llogger.info("Failed to map {} bytes of reserved huge pages for the segment pool, using transparent huge pages: {}", huge_size, strerror(errno));
+            } else {
+                size = huge_size;
+            }
+        }
         if (p == MAP_FAILED) {
-            std::abort();
+            p = mmap(nullptr, size,
+                    PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS,
+                    -1, 0);
+            if (p == MAP_FAILED) {
+                std::abort();
+            }
+            madvise(p, size, MADV_HUGEPAGE);
         }
-        madvise(p, size, MADV_HUGEPAGE);
         auto start = reinterpret_cast<uintptr_t>(p);
         return {start, start + size};
     }
 public:
-    standard_memory_segment_store_backend(size_t segments)
-        : segment_store_backend(allocate_memory(segments), false)
+    standard_memory_segment_store_backend(size_t segments, bool huge_pages)
+        : segment_store_backend(allocate_memory(segments, huge_pages), false)
         , _available_segments((_layout.end - _segments_base) / segment_size)
     { }
     ~standard_memory_segment_store_backend() {
@@ -812,13 +869,19 @@ class contiguous_memory_segment_store {
         : _backend(std::make_unique<seastar_memory_segment_store_backend>())
     { }
     struct with_standard_memory_backend {};
-    contiguous_memory_segment_store(with_standard_memory_backend, size_t available_memory) {
-        use_standard_allocator_segment_pool_backend(available_memory);
+    contiguous_memory_segment_store(with_standard_memory_backend, size_t available_memory, bool huge_pages) {
+        use_standard_allocator_segment_pool_backend(available_memory, huge_pages);
     }
-    void use_standard_allocator_segment_pool_backend(size_t available_memory) {
-        _backend = std::make_unique<standard_memory_segment_store_backend>(available_memory / segment::size);
+    void use_standard_allocator_segment_pool_backend(size_t available_memory, bool huge_pages) {
+        _backend = std::make_unique<standard_memory_segment_store_backend>(available_memory / segment::size, huge_pages);
         llogger.debug("using the standard allocator segment pool backend with {} available memory", available_memory);
     }
+    void advise_huge_pages() const noexcept {
+        _backend->advise_huge_pages();
+    }
+    memory::memory_layout memory_layout() const noexcept {
+        return _backend->memory_layout();
+    }
     const segment* segment_from_idx(size_t idx) const noexcept {
         return reinterpret_cast<segment*>(_backend->segments_base()) + idx;
     }
@@ -880,8 +943,8 @@ class segment_store {
     segment_store() : _segments(max_segments()) {
         _segment_indexes.reserve(max_segments());
     }
-    void use_standard_allocator_segment_pool_backend(size_t available_memory) {
-        _delegate_store = std::make_unique<contiguous_memory_segment_store>(contiguous_memory_segment_store::with_standard_memory_backend{}, available_memory);
+    void use_standard_allocator_segment_pool_backend(size_t available_memory, bool huge_pages) {
+        _delegate_store = std::make_unique<contiguous_memory_segment_store>(contiguous_memory_segment_store::with_standard_memory_backend{}, available_memory, huge_pages);
         free_segments();
         _segment_indexes = {};
         llogger.debug("using the standard allocator segment pool backend with {} available memory", available_memory);
@@ -953,6 +1016,15 @@ class segment_store {
         auto i = find_empty();
         return i != _segments.end();
     }
+    void advise_huge_pages() const noexcept {
+        if (_delegate_store) {
+            _delegate_store->advise_huge_pages();
+        }
+    }
+    // Segments allocated one by one have no common memory area.
+    memory::memory_layout memory_layout() const noexcept {
+        return _delegate_store ? _delegate_store->memory_layout() : memory::memory_layout{0, 0};
+    }
 };
 #endif
 
@@ -974,6 +1046,12 @@ class segment_pool {
     size_t _emergency_reserve_max = 30;
     bool _allocation_failure_flag = false;
     bool _allocation_enabled = true;
+    uint64_t _synchronous_reclaims = 0;
+    // Number of segments owned by LSA in each 2MB page of the segment memory area,
+    // starting with the page of index _first_huge_page.
+    std::vector<uint8_t> _owned_segments_per_huge_page;
+    uintptr_t _first_huge_page = 0;
+    tracker::huge_page_usage _huge_page_usage{};
 
     struct allocation_lock {
         segment_pool& _pool;
@@ -1004,6 +1082,9 @@ class segment_pool {
 private:
     segment* allocate_segment(size_t reserve);
     void deallocate_segment(segment* seg) noexcept;
+    void reset_huge_page_usage();
+    // Accounts for the segment of given index becoming owned by LSA, or not.
+    void update_huge_page_usage(size_t idx, bool owned) noexcept;
     friend void* segment::operator new(size_t);
     friend void segment::operator delete(void*);
 
@@ -1028,7 +1109,9 @@ class segment_pool {
     explicit segment_pool(logalloc::tracker::impl& tracker);
     logalloc::tracker::impl& tracker() { return _tracker; }
     void prime(size_t available_memory, size_t min_free_memory);
-    void use_standard_allocator_segment_pool_backend(size_t available_memory);
+    void use_standard_allocator_segment_pool_backend(size_t available_memory, bool huge_pages);
+    void advise_huge_pages() const noexcept { _store.advise_huge_pages(); }
+    const tracker::huge_page_usage& huge_pages_in_use() const noexcept { return _huge_page_usage; }
     segment* new_segment(region::impl* r);
     const segment_descriptor& descriptor(const segment* seg) const noexcept {
         uintptr_t index = idx_from_segment(seg);
@@ -1061,6 +1144,10 @@ class segment_pool {
     size_t non_lsa_memory_in_use() const noexcept {
         return _non_lsa_memory_in_use;
     }
+    // Number of times segment allocation had to compact or evict
+    uint64_t synchronous_reclaims() const noexcept {
+        return _synchronous_reclaims;
+    }
     size_t total_memory_in_use() const noexcept {
         return _non_lsa_memory_in_use + _segments_in_use * segment::size;
     }
@@ -1194,6 +1281,18 @@ tracker::stats tracker::statistics() const {
     return _impl->segment_pool().statistics();
 }
 
+uint64_t tracker::synchronous_reclaims() const noexcept {
+    return _impl->segment_pool().synchronous_reclaims();
+}
+
+size_t tracker::reclaim_step(size_t bytes, std::chrono::steady_clock::time_point deadline) {
+    return _impl->reclaim_step(bytes, deadline);
+}
+
+tracker::huge_page_usage tracker::huge_pages_in_use() const noexcept {
+    return _impl->segment_pool().huge_pages_in_use();
+}
+
 size_t segment_pool::reclaim_segments(size_t target, is_preemptible preempt) {
     // Reclaimer tries to release segments occupying lower parts of the address
     // space.
@@ -1235,10 +1334,11 @@ size_t segment_pool::reclaim_segments(size_t target, is_preemptible preempt) {
         }
         _lsa_free_segments_bitmap.clear(src_idx);
         _lsa_owned_segments_bitmap.clear(src_idx);
+        update_huge_page_usage(src_idx, false);
         _store.free_segment(src);
         ++reclaimed_segments;
         --_free_segments;
-        if (preempt && need_preempt()) {
+        if (_tracker.should_preempt(preempt)) {
             break;
         }
     }
@@ -1263,6 +1363,7 @@ segment* segment_pool::allocate_segment(size_t reserve)
     // 3. Finally, the algorithm ties to compact and evict data stored in LSA
     //    memory in order to reclaim enough segments.
     //
+    bool reclaimed = false;
     do {
         tracker_reclaimer_lock rl(_tracker);
         if (_free_segments > reserve) {
@@ -1279,8 +1380,13 @@ segment* segment_pool::allocate_segment(size_t reserve)
                 continue;
             }
             _lsa_owned_segments_bitmap.set(idx);
+            update_huge_page_usage(idx, true);
             return seg;
         }
+        // Counted once per allocation, however many rounds it takes
+        if (!std::exchange(reclaimed, true)) {
+            ++_synchronous_reclaims;
+        }
     } while (_tracker.compact_and_evict(reserve, _tracker.reclamation_step() * segment::size, is_preemptible::no));
     return nullptr;
 }
@@ -1365,6 +1471,7 @@ segment_pool::segment_pool(tracker::impl& tracker)
     , _lsa_owned_segments_bitmap(max_segments())
     , _lsa_free_segments_bitmap(max_segments())
 {
+    reset_huge_page_usage();
 }
 
 void segment_pool::prime(size_t available_memory, size_t min_free_memory) {
@@ -1387,14 +1494,40 @@ void segment_pool::prime(size_t available_memory, size_t min_free_memory) {
     reclaim_segments(_store.non_lsa_reserve / segment::size, is_preemptible::no);
 }
 
-void segment_pool::use_standard_allocator_segment_pool_backend(size_t available_memory) {
+void segment_pool::use_standard_allocator_segment_pool_backend(size_t available_memory, bool huge_pages) {
     if (_segments_in_use) {
         throw std::runtime_error("cannot change segment store backend after segments are in use");
     }
-    _store.use_standard_allocator_segment_pool_backend(available_memory);
+    _store.use_standard_allocator_segment_pool_backend(available_memory, huge_pages);
     _segments = std::vector<segment_descriptor>(max_segments());
     _lsa_owned_segments_bitmap = utils::dynamic_bitset(max_segments());
     _lsa_free_segments_bitmap = utils::dynamic_bitset(max_segments());
+    reset_huge_page_usage();
+}
+
+void segment_pool::reset_huge_page_usage() {
+    auto layout = _store.memory_layout();
+    _first_huge_page = layout.start / huge_page_size;
+    auto end_page = align_up(layout.end, static_cast<uintptr_t>(huge_page_size)) / huge_page_size;
+    _owned_segments_per_huge_page = std::vector<uint8_t>(end_page - _first_huge_page);
+    _huge_page_usage = {};
+}
+
+void segment_pool::update_huge_page_usage(size_t idx, bool owned) noexcept {
+    static constexpr size_t segments_per_huge_page = huge_page_size / segment::size;
+    auto page = reinterpret_cast<uintptr_t>(segment_from_idx(idx)) / huge_page_size - _first_huge_page;
+    if (page >= _owned_segments_per_huge_page.size()) {
+        return;
+    }
+    auto& segments = _owned_segments_per_huge_page[page];
+    auto shared = [&] { return segments && segments < segments_per_huge_page; };
+    _huge_page_usage.shared_pages -= shared();
+    if (owned) {
+        _huge_page_usage.pages += !segments++;
+    } else {
+        _huge_page_usage.pages -= !--segments;
+    }
+    _huge_page_usage.shared_pages += shared();
 }
 
 inline void segment_pool::on_segment_compaction(size_t used_size) noexcept {
@@ -2314,8 +2447,14 @@ void tracker::configure(const config& cfg) {
     if (cfg.abort_on_lsa_bad_alloc) {
         _impl->enable_abort_on_bad_alloc();
     }
-    _impl->setup_background_reclaim(cfg.background_reclaim_sched_group);
+    _impl->setup_background_reclaim(cfg.background_reclaim_sched_group, background_reclaimer::config{
+        .free_memory_threshold = cfg.background_reclaim_free_memory,
+        .step_budget = cfg.background_reclaim_step_budget,
+    });
     _impl->set_sanitizer_report_backtrace(cfg.sanitizer_report_backtrace);
+    if (cfg.huge_pages) {
+        _impl->segment_pool().advise_huge_pages();
+    }
 }
 
 memory::reclaiming_result tracker::reclaim(seastar::memory::reclaimer::request r) {
@@ -2515,7 +2654,7 @@ static void reclaim_from_evictable(region::impl& r, size_t target_mem_in_use, is
                 llogger.debug("Target met after evicting {} bytes", used - r.occupancy().used_space());
                 return;
             }
-            if (preempt && need_preempt()) {
+            if (r.segment_pool().tracker().should_preempt(preempt)) {
                 llogger.debug("reclaim_from_evictable preempted");
                 return;
             }
@@ -2529,7 +2668,7 @@ static void reclaim_from_evictable(region::impl& r, size_t target_mem_in_use, is
         // If the system is overwhelmed, and reclaim_from_evictable keeps getting
         // preempted without doing any useful work, then eventually memory will be
         // exhausted and reclaim will be called synchronously, without preemption.
-        if (preempt && need_preempt()) {
+        if (r.segment_pool().tracker().should_preempt(preempt)) {
             llogger.debug("reclaim_from_evictable preempted");
             return;
         }
@@ -2594,7 +2733,7 @@ size_t tracker::impl::reclaim_locked(size_t memory_to_release, is_preemptible pr
         llogger.debug("reclaim_locked() = {}", memory_to_release);
         return memory_to_release;
     }
-    if (preempt && need_preempt()) {
+    if (should_preempt(preempt)) {
         llogger.debug("reclaim_locked() = {}", mem_released);
         return mem_released;
     }
@@ -2701,7 +2840,7 @@ size_t tracker::impl::compact_and_evict_locked(size_t reserve_segments, size_t m
 
             boost::range::push_heap(_regions, cmp);
 
-            if (preempt && need_preempt()) {
+            if (should_preempt(preempt)) {
                 break;
             }
         }
@@ -2717,7 +2856,7 @@ size_t tracker::impl::compact_and_evict_locked(size_t reserve_segments, size_t m
         llogger.debug("Considering evictable regions.");
         // FIXME: Fair eviction
         for (region::impl* r : _regions) {
-            if (preempt && need_preempt()) {
+            if (should_preempt(preempt)) {
                 break;
             }
             ++regions;
@@ -2804,6 +2943,15 @@ tracker::impl::impl() : _segment_pool(std::make_unique<logalloc::segment_pool>(*
 
         sm::make_counter("memory_freed", [this] { return _segment_pool->statistics().memory_freed; },
                         sm::description("Counts number of bytes which were requested to be freed in LSA.")),
+
+        sm::make_counter("synchronous_reclaims", [this] { return _segment_pool->synchronous_reclaims(); },
+                        sm::description("Counts segment allocations which had to compact or evict memory, because background reclaim did not keep up.")),
+
+        sm::make_gauge("huge_pages", [this] { return _segment_pool->huge_pages_in_use().pages; },
+                       sm::description("Holds a current number of 2MB pages holding LSA segments. Each takes a TLB entry when backed by a huge page, so the lower the fewer TLB misses.")),
+
+        sm::make_gauge("shared_huge_pages", [this] { return _segment_pool->huge_pages_in_use().shared_pages; },
+                       sm::description("Holds a current number of 2MB pages holding both LSA segments and memory not owned by LSA.")),
     });
 }
 
@@ -2921,9 +3069,9 @@ future<> prime_segment_pool(size_t available_memory, size_t min_free_memory) {
     });
 }
 
-future<> use_standard_allocator_segment_pool_backend(size_t available_memory) {
+future<> use_standard_allocator_segment_pool_backend(size_t available_memory, bool huge_pages) {
     return smp::invoke_on_all([=] {
-        shard_tracker().get_impl().segment_pool().use_standard_allocator_segment_pool_backend(available_memory);
+        shard_tracker().get_impl().segment_pool().use_standard_allocator_segment_pool_backend(available_memory, huge_pages);
     });
 }
 
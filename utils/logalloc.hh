@@ -61,8 +61,14 @@ class tracker {
         bool defragment_on_idle;
         bool abort_on_lsa_bad_alloc;
         bool sanitizer_report_backtrace = false; // Better reports but slower
+        bool huge_pages = false; // Advise transparent huge pages for the segment memory
         size_t lsa_reclamation_step;
         scheduling_group background_reclaim_sched_group;
+        // Background reclaim keeps this much memory free, so that allocations
+        // rarely have to reclaim synchronously.
+        size_t background_reclaim_free_memory = 60'000'000;
+        // Time a background reclaim step may take before yielding, 0 for the task quota
+        std::chrono::microseconds background_reclaim_step_budget{0};
     };
 
     struct stats {
@@ -129,6 +135,14 @@ class tracker {
     //
     size_t reclaim(size_t bytes);
 
+    // Reclaims like a step of the background reclaimer with a time budget,
+    // which ends at the deadline or when the task quota does.
+    // Returns the number of bytes actually reclaimed.
+    size_t reclaim_step(size_t bytes, std::chrono::steady_clock::time_point deadline);
+
+    // Returns the number of segment allocations which had to compact or evict memory.
+    uint64_t synchronous_reclaims() const noexcept;
+
     // Compacts as much as possible. Very expensive, mainly for testing.
     // Guarantees that every live object from reclaimable regions will be moved.
     // Invalidates references to objects in all compactible and evictable regions.
@@ -147,6 +161,16 @@ class tracker {
     // Returns amount of allocated memory not managed by LSA
     size_t non_lsa_used_space() const noexcept;
 
+    struct huge_page_usage {
+        // 2MB pages holding segments owned by LSA
+        size_t pages;
+        // Pages which also hold memory not owned by LSA
+        size_t shared_pages;
+    };
+    // Returns the 2MB pages of the segment memory area which hold segments owned by LSA.
+    // Not tracked when segments are allocated one by one from the standard allocator.
+    huge_page_usage huge_pages_in_use() const noexcept;
+
     impl& get_impl() noexcept { return *_impl; }
 
     // Returns the minimum number of segments reclaimed during single reclamation cycle.
@@ -529,6 +553,8 @@ future<> prime_segment_pool(size_t available_memory, size_t min_free_memory);
 //
 // In debug mode, this will use the release standard allocator store.
 // Call once, when initializing the application, before any LSA allocation takes place.
-future<> use_standard_allocator_segment_pool_backend(size_t available_memory);
+// With huge_pages, the segments are backed by reserved 2MB huge pages if there
+// are enough of them, and by transparent huge pages otherwise.
+future<> use_standard_allocator_segment_pool_backend(size_t available_memory, bool huge_pages = false);
 
 }
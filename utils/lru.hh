@@ -76,6 +76,21 @@ class lru {
         add(e);
     }
 
+    // Returns the least recently used element satisfying pred, out of the
+    // max least recently used ones, or nullptr.
+    template <typename Pred>
+    evictable* find_least_recently_used(size_t max, Pred&& pred) {
+        for (auto& e : _list) {
+            if (!max--) {
+                break;
+            }
+            if (pred(e)) {
+                return &e;
+            }
+        }
+        return nullptr;
+    }
+
     // Evicts a single element from the LRU
     reclaiming_result evict() noexcept {
         if (_list.empty()) {
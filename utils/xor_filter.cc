@@ -0,0 +1,301 @@
+/*
+ * Copyright (C) 2022-present ScyllaDB
+ */
+
+/*
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <seastar/core/thread.hh>
+
+#include "xor_filter.hh"
+#include "log.hh"
+
+namespace utils {
+namespace filter {
+
+static logging::logger xflog("xor_filter");
+
+thread_local xor_filter::stats xor_filter::_shard_stats;
+
+// The fingerprint array is 1.23 times the key count, plus some slack which
+// keeps the construction likely to succeed for small key counts.
+static constexpr double size_factor = 1.23;
+static constexpr uint64_t size_slack = 32;
+
+// Attempts after which duplicate key hashes are suspected (they make the
+// construction fail no matter the seed) and removed.
+static constexpr int attempts_before_dedup = 4;
+static constexpr int max_attempts = 100;
+
+static uint64_t fmix64(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+static uint64_t splitmix64(uint64_t& state) {
+    uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// Maps x uniformly onto [0, n) without a division
+static uint64_t reduce(uint32_t x, uint64_t n) {
+    return (uint64_t(x) * n) >> 32;
+}
+
+template <typename T>
+static void fill_zeros(utils::chunked_vector<T>& v, size_t n) {
+    v.clear();
+    auto remaining = n;
+    while (remaining) {
+        remaining = v.reserve_partial(remaining);
+        seastar::thread::maybe_yield();
+    }
+    for (size_t i = 0; i < n; i++) {
+        v.push_back(T(0));
+        seastar::thread::maybe_yield();
+    }
+}
+
+static size_t words_for(uint64_t nr_fingerprints, unsigned fingerprint_bits) {
+    return xor_filter::header_words + (nr_fingerprints * fingerprint_bits + 63) / 64;
+}
+
+xor_filter::xor_filter(unsigned fingerprint_bits, uint64_t expected_elements)
+    : _fingerprint_bits(fingerprint_bits)
+{
+    while (expected_elements) {
+        expected_elements = _hashes.reserve_partial(expected_elements);
+        seastar::thread::maybe_yield();
+    }
+}
+
+xor_filter::xor_filter(storage words)
+    : _fingerprint_bits(words[2])
+    , _seed(words[0])
+    , _block_length(words[1] / 3)
+    , _words(std::move(words))
+{
+    _stats.memory_size += _words.memory_size();
+}
+
+xor_filter::~xor_filter() {
+    _stats.memory_size -= _words.memory_size();
+}
+
+xor_filter::slots xor_filter::get_slots(uint64_t hash) const {
+    return slots{
+        .hash = hash,
+        .pos = {
+            reduce(uint32_t(hash), _block_length),
+            reduce(uint32_t(std::rotl(hash, 21)), _block_length) + _block_length,
+            reduce(uint32_t(std::rotl(hash, 42)), _block_length) + 2 * _block_length,
+        },
+    };
+}
+
+uint64_t xor_filter::fingerprint(uint64_t hash) const {
+    return (hash ^ (hash >> 32)) & ((uint64_t(1) << _fingerprint_bits) - 1);
+}
+
+// A fingerprint may straddle two words, in which case its low bits are the
+// high bits of the first word.
+uint64_t xor_filter::get_fingerprint(uint64_t idx) const {
+    auto bit = idx * _fingerprint_bits;
+    auto word = header_words + bit / 64;
+    auto shift = bit % 64;
+    auto fp = _words[word] >> shift;
+    if (shift + _fingerprint_bits > 64) {
+        fp |= _words[word + 1] << (64 - shift);
+    }
+    return fp & ((uint64_t(1) << _fingerprint_bits) - 1);
+}
+
+void xor_filter::set_fingerprint(uint64_t idx, uint64_t fp) {
+    auto mask = (uint64_t(1) << _fingerprint_bits) - 1;
+    auto bit = idx * _fingerprint_bits;
+    auto word = header_words + bit / 64;
+    auto shift = bit % 64;
+    _words[word] = (_words[word] & ~(mask << shift)) | (fp << shift);
+    if (shift + _fingerprint_bits > 64) {
+        _words[word + 1] = (_words[word + 1] & ~(mask >> (64 - shift))) | (fp >> (64 - shift));
+    }
+}
+
+void xor_filter::add(const bytes_view& key) {
+    assert(!built());
+    if (_saturated) {
+        return;
+    }
+    if (_hashes.size() == max_elements) {
+        xflog.debug("more than {} keys added, giving up on the xor filter", max_elements);
+        _hashes = utils::chunked_vector<uint64_t>();
+        _saturated = true;
+        return;
+    }
+    _hashes.push_back(make_hashed_key(key).hash()[0]);
+}
+
+bool xor_filter::is_present(const bytes_view& key) {
+    return is_present(make_hashed_key(key));
+}
+
+bool xor_filter::is_present(hashed_key key) {
+    auto s = get_slots(fmix64(key.hash()[0] + _seed));
+    return fingerprint(s.hash) == (get_fingerprint(s.pos[0]) ^ get_fingerprint(s.pos[1]) ^ get_fingerprint(s.pos[2]));
+}
+
+uint64_t xor_filter::is_present_batch(std::span<const hashed_key> keys) {
+    assert(keys.size() <= max_batch_size);
+    std::array<slots, max_batch_size> batch;
+    for (size_t i = 0; i < keys.size(); i++) {
+        batch[i] = get_slots(fmix64(keys[i].hash()[0] + _seed));
+        for (auto pos : batch[i].pos) {
+            __builtin_prefetch(&_words[header_words + pos * _fingerprint_bits / 64]);
+        }
+    }
+    uint64_t mask = 0;
+    for (size_t i = 0; i < keys.size(); i++) {
+        auto& s = batch[i];
+        if (fingerprint(s.hash) == (get_fingerprint(s.pos[0]) ^ get_fingerprint(s.pos[1]) ^ get_fingerprint(s.pos[2]))) {
+            mask |= uint64_t(1) << i;
+        }
+    }
+    return mask;
+}
+
+void xor_filter::clear() {
+    _stats.memory_size -= _words.memory_size();
+    _words.clear();
+    _hashes.clear();
+    _saturated = false;
+}
+
+// Peels the 3-hypergraph formed by the keys' slots: a slot used by a single
+// key can be assigned last, so that it fixes that key's xor. Removing the key
+// may in turn leave other slots with a single key, and so on. Succeeds iff
+// every key is peeled, then assigns fingerprints in reverse peeling order.
+bool xor_filter::try_build(uint64_t seed) {
+    auto capacity = 3 * _block_length;
+    _seed = seed;
+
+    utils::chunked_vector<uint64_t> xor_mask;
+    utils::chunked_vector<uint32_t> count;
+    fill_zeros(xor_mask, capacity);
+    fill_zeros(count, capacity);
+    for (auto key_hash : _hashes) {
+        auto s = get_slots(fmix64(key_hash + _seed));
+        for (auto pos : s.pos) {
+            xor_mask[pos] ^= s.hash;
+            count[pos]++;
+        }
+        seastar::thread::maybe_yield();
+    }
+
+    utils::chunked_vector<uint64_t> queue;
+    for (uint64_t i = 0; i < capacity; i++) {
+        if (count[i] == 1) {
+            queue.push_back(i);
+        }
+        seastar::thread::maybe_yield();
+    }
+
+    // Peeled (slot, hash) pairs
+    utils::chunked_vector<std::pair<uint64_t, uint64_t>> stack;
+    while (!queue.empty()) {
+        auto idx = queue.back();
+        queue.pop_back();
+        if (count[idx] != 1) {
+            continue;
+        }
+        auto s = get_slots(xor_mask[idx]);
+        stack.emplace_back(idx, s.hash);
+        for (auto pos : s.pos) {
+            xor_mask[pos] ^= s.hash;
+            if (--count[pos] == 1) {
+                queue.push_back(pos);
+            }
+        }
+        seastar::thread::maybe_yield();
+    }
+    if (stack.size() != _hashes.size()) {
+        return false;
+    }
+
+    fill_zeros(_words, words_for(capacity, _fingerprint_bits));
+    _words[0] = _seed;
+    _words[1] = capacity;
+    _words[2] = _fingerprint_bits;
+    for (auto it = stack.rbegin(); it != stack.rend(); ++it) {
+        auto [idx, hash] = *it;
+        auto s = get_slots(hash);
+        // The slot being assigned is still zero, so this is the xor of the other two
+        set_fingerprint(idx, fingerprint(hash) ^ get_fingerprint(s.pos[0]) ^ get_fingerprint(s.pos[1]) ^ get_fingerprint(s.pos[2]));
+        seastar::thread::maybe_yield();
+    }
+    return true;
+}
+
+void xor_filter::build() {
+    assert(seastar::thread::running_in_thread());
+    assert(!built());
+    assert(!_saturated);
+
+    auto capacity = size_slack + uint64_t(std::ceil(size_factor * _hashes.size()));
+    _block_length = capacity / 3;
+
+    uint64_t seed_state = 0;
+    for (int attempt = 0; attempt < max_attempts; attempt++) {
+        if (attempt == attempts_before_dedup) {
+            auto size = _hashes.size();
+            std::sort(_hashes.begin(), _hashes.end());
+            auto unique_size = std::distance(_hashes.begin(), std::unique(_hashes.begin(), _hashes.end()));
+            while (_hashes.size() > size_t(unique_size)) {
+                _hashes.pop_back();
+            }
+            xflog.debug("removed {} duplicate key hashes after {} failed attempts", size - _hashes.size(), attempt);
+        }
+        if (try_build(splitmix64(seed_state))) {
+            _hashes.clear();
+            _stats.memory_size += _words.memory_size();
+            return;
+        }
+    }
+    throw std::runtime_error(format("Failed to build xor filter for {} keys", _hashes.size()));
+}
+
+unsigned xor_filter_fingerprint_bits(double max_false_pos_prob) {
+    auto bits = std::ceil(-std::log2(max_false_pos_prob));
+    return std::clamp(unsigned(bits), xor_filter::min_fingerprint_bits, xor_filter::max_fingerprint_bits);
+}
+
+filter_ptr create_xor_filter(int64_t num_elements, double max_false_pos_prob) {
+    return std::make_unique<xor_filter>(xor_filter_fingerprint_bits(max_false_pos_prob),
+            std::clamp(num_elements, int64_t(0), int64_t(xor_filter::max_elements)));
+}
+
+filter_ptr create_xor_filter(xor_filter::storage words) {
+    if (words.size() < xor_filter::header_words) {
+        throw std::invalid_argument(format("Invalid xor filter size {} words", words.size()));
+    }
+    auto fingerprint_bits = words[2];
+    if (fingerprint_bits < xor_filter::min_fingerprint_bits || fingerprint_bits > xor_filter::max_fingerprint_bits) {
+        throw std::invalid_argument(format("Invalid xor filter fingerprint size {}", fingerprint_bits));
+    }
+    if (words[1] % 3 || words.size() != words_for(words[1], fingerprint_bits)) {
+        throw std::invalid_argument(format("Invalid xor filter size {} words", words.size()));
+    }
+    return std::make_unique<xor_filter>(std::move(words));
+}
+
+}
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2022-present ScyllaDB
+ */
+
+/*
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include "i_filter.hh"
+#include "utils/chunked_vector.hh"
+
+namespace utils {
+namespace filter {
+
+// Xor filter (Graf, Lemire: "Xor Filters: Faster and Smaller Than Bloom and
+// Cuckoo Filters").
+//
+// A static filter: every key maps to three slots, one in each third of a
+// fingerprint array, and the array is solved so that the xor of the three
+// slots equals the key's fingerprint. It needs about 1.23 * fingerprint_bits
+// bits per key for a false positive rate of 2^-fingerprint_bits, against
+// 1.44 * fingerprint_bits for a bloom filter with the same rate.
+//
+// Since the array can only be solved once all keys are known, the filter
+// has two phases: add() accumulates key hashes, and build() computes the
+// fingerprints and drops the hashes. Queries are only valid after build().
+// Sstables are immutable, so the filter is built once, when the sstable is
+// sealed, and loaded in its built form afterwards.
+//
+// Building takes about 50 bytes per key, so filters are limited to
+// max_elements keys. Past that, add() drops the hashes collected so far and
+// the filter becomes saturated: it can no longer be built, and the caller
+// has to fall back to a filter which lets every key through.
+class xor_filter : public i_filter {
+public:
+    // Serialized form: a header of header_words words (the seed, the
+    // fingerprint array length and the fingerprint width) followed by the
+    // fingerprints, packed back to back from the lowest bit of the first
+    // word on.
+    using storage = utils::chunked_vector<uint64_t>;
+    static constexpr size_t header_words = 3;
+    static constexpr unsigned min_fingerprint_bits = 1;
+    static constexpr unsigned max_fingerprint_bits = 32;
+    static constexpr uint64_t max_elements = 1 << 20;
+private:
+    unsigned _fingerprint_bits;
+    uint64_t _seed = 0;
+    uint64_t _block_length = 0;
+    storage _words;
+    // Hashes of the keys added so far; only used before build().
+    utils::chunked_vector<uint64_t> _hashes;
+    bool _saturated = false;
+
+    static thread_local struct stats {
+        uint64_t memory_size = 0;
+    } _shard_stats;
+    stats& _stats = _shard_stats;
+
+    struct slots {
+        uint64_t hash;
+        uint64_t pos[3];
+    };
+    slots get_slots(uint64_t key_hash) const;
+    uint64_t fingerprint(uint64_t hash) const;
+    uint64_t get_fingerprint(uint64_t idx) const;
+    void set_fingerprint(uint64_t idx, uint64_t fp);
+    bool try_build(uint64_t seed);
+public:
+    // An empty filter, ready to accept keys. expected_elements is a hint.
+    xor_filter(unsigned fingerprint_bits, uint64_t expected_elements);
+    explicit xor_filter(storage words);
+    ~xor_filter();
+
+    virtual void add(const bytes_view& key) override;
+
+    virtual bool is_present(const bytes_view& key) override;
+
+    virtual bool is_present(hashed_key key) override;
+
+    virtual uint64_t is_present_batch(std::span<const hashed_key> keys) override;
+
+    virtual void clear() override;
+
+    virtual void close() override { }
+
+    virtual size_t memory_size() override {
+        return _words.memory_size() + _hashes.memory_size();
+    }
+
+    // Solves the fingerprint array for the keys added so far.
+    // Must be called from a seastar thread, exactly once, and only
+    // if the filter is not saturated.
+    void build();
+
+    // More than max_elements keys were added.
+    bool saturated() const {
+        return _saturated;
+    }
+
+    bool built() const {
+        return !_words.empty();
+    }
+
+    unsigned fingerprint_bits() const {
+        return _fingerprint_bits;
+    }
+
+    // The serialized form, valid after build().
+    const storage& words() const {
+        return _words;
+    }
+
+    static const stats& get_shard_stats() noexcept {
+        return _shard_stats;
+    }
+};
+
+// Smallest fingerprint width meeting the given false positive rate.
+unsigned xor_filter_fingerprint_bits(double max_false_pos_prob);
+
+filter_ptr create_xor_filter(int64_t num_elements, double max_false_pos_prob);
+// Throws std::invalid_argument if words is not a valid serialized filter.
+filter_ptr create_xor_filter(xor_filter::storage words);
+
+}
+}
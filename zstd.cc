@@ -7,32 +7,145 @@
  */
 
 #include <seastar/core/aligned_buffer.hh>
+#include <seastar/core/shared_ptr.hh>
+
+#include <unordered_map>
 
 // We need to use experimental features of the zstd library (to allocate compression/decompression context),
 // which are available only when the library is linked statically.
 #define ZSTD_STATIC_LINKING_ONLY
 #include "zstd.h"
+#include "zdict.h"
 
 #include "compress.hh"
 #include "utils/class_registrator.hh"
 
 static const sstring COMPRESSION_LEVEL = "compression_level";
+static const sstring DICTIONARY_SIZE_KB = "dictionary_size_in_kb";
 static const sstring COMPRESSOR_NAME = compressor::namespace_prefix + "ZstdCompressor";
 
+static constexpr size_t max_dictionary_size_kb = 64;
+
+struct zstd_cdict_deleter {
+    void operator()(ZSTD_CDict* d) const noexcept { ZSTD_freeCDict(d); }
+};
+struct zstd_ddict_deleter {
+    void operator()(ZSTD_DDict* d) const noexcept { ZSTD_freeDDict(d); }
+};
+struct zstd_cctx_deleter {
+    void operator()(ZSTD_CCtx* c) const noexcept { ZSTD_freeCCtx(c); }
+};
+struct zstd_dctx_deleter {
+    void operator()(ZSTD_DCtx* c) const noexcept { ZSTD_freeDCtx(c); }
+};
+
+// Compression with a dictionary trained for a single sstable.
+//
+// All the streams of a shard which use the same dictionary, normally those
+// of a single sstable, share one instance, found by the dictionary's
+// contents. The dictionary is digested on first use of either direction.
+// The contexts are shared as well, which is safe since a chunk is
+// compressed or uncompressed without preemption.
+class zstd_dictionary_state : public enable_lw_shared_from_this<zstd_dictionary_state> {
+    struct key {
+        int compression_level;
+        size_t chunk_len;
+        bytes_view dictionary;
+        bool operator==(const key&) const = default;
+    };
+    struct key_hash {
+        size_t operator()(const key& k) const noexcept {
+            return std::hash<bytes_view>()(k.dictionary) ^ std::hash<int>()(k.compression_level) ^ std::hash<size_t>()(k.chunk_len);
+        }
+    };
+    // Instances in use on this shard, keyed by a view of their own dictionary
+    static thread_local std::unordered_map<key, zstd_dictionary_state*, key_hash> _instances;
+
+    int _compression_level;
+    size_t _chunk_len;
+    bytes _dictionary;
+    std::unique_ptr<ZSTD_CCtx, zstd_cctx_deleter> _cctx;
+    std::unique_ptr<ZSTD_CDict, zstd_cdict_deleter> _cdict;
+    std::unique_ptr<ZSTD_DCtx, zstd_dctx_deleter> _dctx;
+    std::unique_ptr<ZSTD_DDict, zstd_ddict_deleter> _ddict;
+
+    key get_key() const noexcept {
+        return key{_compression_level, _chunk_len, _dictionary};
+    }
+public:
+    zstd_dictionary_state(int compression_level, size_t chunk_len, bytes_view dict)
+        : _compression_level(compression_level)
+        , _chunk_len(chunk_len)
+        , _dictionary(to_bytes(dict))
+    {}
+
+    ~zstd_dictionary_state() {
+        _instances.erase(get_key());
+    }
+
+    static lw_shared_ptr<zstd_dictionary_state> get(int compression_level, size_t chunk_len, bytes_view dict) {
+        auto it = _instances.find(key{compression_level, chunk_len, dict});
+        if (it != _instances.end()) {
+            return it->second->shared_from_this();
+        }
+        auto state = make_lw_shared<zstd_dictionary_state>(compression_level, chunk_len, dict);
+        _instances.emplace(state->get_key(), state.get());
+        return state;
+    }
+
+    size_t compress(const char* input, size_t input_len, char* output, size_t output_len) {
+        if (!_cdict) {
+            // We assume that the uncompressed input length is always <= chunk_len.
+            auto cparams = ZSTD_getCParams(_compression_level, _chunk_len, _dictionary.size());
+            _cdict.reset(ZSTD_createCDict_advanced(_dictionary.data(), _dictionary.size(),
+                    ZSTD_dlm_byReference, ZSTD_dct_auto, cparams, ZSTD_defaultCMem));
+            _cctx.reset(ZSTD_createCCtx());
+            if (!_cdict || !_cctx) {
+                throw std::runtime_error("Unable to initialize ZSTD dictionary compression context");
+            }
+        }
+        return ZSTD_compress_usingCDict(_cctx.get(), output, output_len, input, input_len, _cdict.get());
+    }
+
+    size_t uncompress(const char* input, size_t input_len, char* output, size_t output_len) {
+        if (!_ddict) {
+            _ddict.reset(ZSTD_createDDict_byReference(_dictionary.data(), _dictionary.size()));
+            _dctx.reset(ZSTD_createDCtx());
+            if (!_ddict || !_dctx) {
+                throw std::runtime_error("Unable to initialize ZSTD dictionary decompression context");
+            }
+        }
+        return ZSTD_decompress_usingDDict(_dctx.get(), output, output_len, input, input_len, _ddict.get());
+    }
+};
+
+thread_local std::unordered_map<zstd_dictionary_state::key, zstd_dictionary_state*, zstd_dictionary_state::key_hash> zstd_dictionary_state::_instances;
+
 class zstd_processor : public compressor {
     int _compression_level = 3;
+    size_t _chunk_len;
+    size_t _dictionary_size = 0;
+    lw_shared_ptr<zstd_dictionary_state> _dictionary;
+
+    // The contexts are allocated on first use, as streams only compress or only
+    // uncompress, and streams using a dictionary use the dictionary's contexts.
 
     // Manages memory for the compression context.
-    std::unique_ptr<char[], free_deleter> _cctx_raw;
+    mutable std::unique_ptr<char[], free_deleter> _cctx_raw;
     // Compression context. Observer of _cctx_raw.
-    ZSTD_CCtx* _cctx;
+    mutable ZSTD_CCtx* _cctx = nullptr;
 
     // Manages memory for the decompression context.
-    std::unique_ptr<char[], free_deleter> _dctx_raw;
+    mutable std::unique_ptr<char[], free_deleter> _dctx_raw;
     // Decompression context. Observer of _dctx_raw.
-    ZSTD_DCtx* _dctx;
+    mutable ZSTD_DCtx* _dctx = nullptr;
+
+    ZSTD_CCtx* get_cctx() const;
+    ZSTD_DCtx* get_dctx() const;
 public:
     zstd_processor(const opt_getter&);
+    // A copy of base which compresses with the given dictionary
+    zstd_processor(const zstd_processor& base, lw_shared_ptr<zstd_dictionary_state> dictionary);
 
     size_t uncompress(const char* input, size_t input_len, char* output,
                     size_t output_len) const override;
@@ -42,6 +155,10 @@ class zstd_processor : public compressor {
 
     std::set<sstring> option_names() const override;
     std::map<sstring, sstring> options() const override;
+
+    size_t dictionary_size() const override;
+    bytes train_dictionary(const char* samples, const std::vector<size_t>& sample_sizes) const override;
+    ptr_type with_dictionary(bytes_view dict) const override;
 };
 
 zstd_processor::zstd_processor(const opt_getter& opts)
@@ -63,6 +180,22 @@ zstd_processor::zstd_processor(const opt_getter& opts)
         }
     }
 
+    auto dictionary_size_kb = opts(DICTIONARY_SIZE_KB);
+    if (dictionary_size_kb) {
+        size_t kb;
+        try {
+            kb = std::stoul(*dictionary_size_kb);
+        } catch (const std::exception& e) {
+            throw exceptions::syntax_exception(
+                format("Invalid integer value {} for {}", *dictionary_size_kb, DICTIONARY_SIZE_KB));
+        }
+        if (kb < 1 || kb > max_dictionary_size_kb) {
+            throw exceptions::configuration_exception(
+                format("{} must be between 1 and {}, got {}", DICTIONARY_SIZE_KB, max_dictionary_size_kb, *dictionary_size_kb));
+        }
+        _dictionary_size = kb * 1024;
+    }
+
     auto chunk_len_kb = opts(compression_parameters::CHUNK_LENGTH_KB);
     if (!chunk_len_kb) {
         chunk_len_kb = opts(compression_parameters::CHUNK_LENGTH_KB_ERR);
@@ -71,27 +204,48 @@ zstd_processor::zstd_processor(const opt_getter& opts)
        // This parameter has already been validated.
        ? std::stoi(*chunk_len_kb) * 1024
        : compression_parameters::DEFAULT_CHUNK_LENGTH;
+    _chunk_len = chunk_len;
+}
+
+zstd_processor::zstd_processor(const zstd_processor& base, lw_shared_ptr<zstd_dictionary_state> dictionary)
+    : compressor(COMPRESSOR_NAME)
+    , _compression_level(base._compression_level)
+    , _chunk_len(base._chunk_len)
+    , _dictionary_size(base._dictionary_size)
+    , _dictionary(std::move(dictionary))
+{}
 
-    // We assume that the uncompressed input length is always <= chunk_len.
-    auto cparams = ZSTD_getCParams(_compression_level, chunk_len, 0);
-    auto cctx_size = ZSTD_estimateCCtxSize_usingCParams(cparams);
-    // According to the ZSTD documentation, pointer to the context buffer must be 8-bytes aligned.
-    _cctx_raw = allocate_aligned_buffer<char>(cctx_size, 8);
-    _cctx = ZSTD_initStaticCCtx(_cctx_raw.get(), cctx_size);
+ZSTD_CCtx* zstd_processor::get_cctx() const {
     if (!_cctx) {
-        throw std::runtime_error("Unable to initialize ZSTD compression context");
+        // We assume that the uncompressed input length is always <= chunk_len.
+        auto cparams = ZSTD_getCParams(_compression_level, _chunk_len, 0);
+        auto cctx_size = ZSTD_estimateCCtxSize_usingCParams(cparams);
+        // According to the ZSTD documentation, pointer to the context buffer must be 8-bytes aligned.
+        _cctx_raw = allocate_aligned_buffer<char>(cctx_size, 8);
+        _cctx = ZSTD_initStaticCCtx(_cctx_raw.get(), cctx_size);
+        if (!_cctx) {
+            throw std::runtime_error("Unable to initialize ZSTD compression context");
+        }
     }
+    return _cctx;
+}
 
-    auto dctx_size = ZSTD_estimateDCtxSize();
-    _dctx_raw = allocate_aligned_buffer<char>(dctx_size, 8);
-    _dctx = ZSTD_initStaticDCtx(_dctx_raw.get(), dctx_size);
-    if (!_cctx) {
-        throw std::runtime_error("Unable to initialize ZSTD decompression context");
+ZSTD_DCtx* zstd_processor::get_dctx() const {
+    if (!_dctx) {
+        auto dctx_size = ZSTD_estimateDCtxSize();
+        _dctx_raw = allocate_aligned_buffer<char>(dctx_size, 8);
+        _dctx = ZSTD_initStaticDCtx(_dctx_raw.get(), dctx_size);
+        if (!_dctx) {
+            throw std::runtime_error("Unable to initialize ZSTD decompression context");
+        }
     }
+    return _dctx;
 }
 
 size_t zstd_processor::uncompress(const char* input, size_t input_len, char* output, size_t output_len) const {
-    auto ret = ZSTD_decompressDCtx(_dctx, output, output_len, input, input_len);
+    auto ret = _dictionary
+        ? _dictionary->uncompress(input, input_len, output, output_len)
+        : ZSTD_decompressDCtx(get_dctx(), output, output_len, input, input_len);
     if (ZSTD_isError(ret)) {
         throw std::runtime_error( format("ZSTD decompression failure: {}", ZSTD_getErrorName(ret)));
     }
@@ -100,7 +254,9 @@ size_t zstd_processor::uncompress(const char* input, size_t input_len, char* out
 
 
 size_t zstd_processor::compress(const char* input, size_t input_len, char* output, size_t output_len) const {
-    auto ret = ZSTD_compressCCtx(_cctx, output, output_len, input, input_len, _compression_level);
+    auto ret = _dictionary
+        ? _dictionary->compress(input, input_len, output, output_len)
+        : ZSTD_compressCCtx(get_cctx(), output, output_len, input, input_len, _compression_level);
     if (ZSTD_isError(ret)) {
         throw std::runtime_error( format("ZSTD compression failure: {}", ZSTD_getErrorName(ret)));
     }
@@ -112,11 +268,38 @@ size_t zstd_processor::compress_max_size(size_t input_len) const {
 }
 
 std::set<sstring> zstd_processor::option_names() const {
-    return {COMPRESSION_LEVEL};
+    return {COMPRESSION_LEVEL, DICTIONARY_SIZE_KB};
 }
 
 std::map<sstring, sstring> zstd_processor::options() const {
-    return {{COMPRESSION_LEVEL, std::to_string(_compression_level)}};
+    std::map<sstring, sstring> opts{{COMPRESSION_LEVEL, std::to_string(_compression_level)}};
+    if (_dictionary_size) {
+        opts.emplace(DICTIONARY_SIZE_KB, std::to_string(_dictionary_size / 1024));
+    }
+    return opts;
+}
+
+size_t zstd_processor::dictionary_size() const {
+    return _dictionary_size;
+}
+
+bytes zstd_processor::train_dictionary(const char* samples, const std::vector<size_t>& sample_sizes) const {
+    if (!_dictionary_size) {
+        return bytes();
+    }
+    bytes dict(bytes::initialized_later(), _dictionary_size);
+    auto ret = ZDICT_trainFromBuffer(dict.data(), dict.size(), samples, sample_sizes.data(), sample_sizes.size());
+    if (ZDICT_isError(ret)) {
+        // Typically too few or too uniform samples, the data is then
+        // compressed without a dictionary.
+        return bytes();
+    }
+    dict.resize(ret);
+    return dict;
+}
+
+compressor::ptr_type zstd_processor::with_dictionary(bytes_view dict) const {
+    return ::make_shared<zstd_processor>(*this, zstd_dictionary_state::get(_compression_level, _chunk_len, dict));
 }
 
 static const class_registrator<compressor, zstd_processor, const compressor::opt_getter&>